@@ -0,0 +1,657 @@
+/*
+	Katana Engine
+	Copyright  2001-2004 Eric Bryant, Inc.
+
+	File:		mathbench.cpp
+	Author:		Eric Bryant
+
+	Micro-benchmarks for the math library. Every operation is timed over large
+	arrays of randomized inputs, and reported in nanoseconds per operation and
+	millions of operations per second. Use it as the baseline before and after
+	optimizing any of the math routines.
+
+	The benchmark only depends on the math library, so it builds on its own:
+
+		Linux:		g++ -O2 -I../src -o mathbench mathbench.cpp ../src/math/?*.cpp
+					(add -msse2 or -mavx2 to enable the SIMD code paths)
+
+		Windows:	cl /O2 /EHsc /arch:SSE2 /I..\src mathbench.cpp ..\src\math\*.cpp
+
+	Usage:			mathbench [element count] [filter]
+
+	The element count (default 65536) is the size of the input arrays. If a filter
+	is given, only the benchmarks whose name contains it are run.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <new>
+#include <vector>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include "katana_config.h"
+#include "math/kmath.h"
+#include "math/point.h"
+#include "math/plane.h"
+#include "math/matrix.h"
+#include "math/quaternion.h"
+#include "math/bound.h"
+#include "math/box.h"
+#include "math/intersect.h"
+using namespace std;
+using namespace Katana;
+
+// ----------------------------------------------------
+// Types
+// ----------------------------------------------------
+
+/// Benchmark function, which performs the operation over the first count elements of the inputs
+typedef void (*BenchmarkFunction)( unsigned int count );
+
+///
+/// AlignedArray
+/// Array of 16 byte aligned elements. The Matrix4 can't be stored in a std::vector,
+/// since MSVC doesn't allow the aligned type to be passed by value (C2719).
+///
+template <class T>
+class AlignedArray
+{
+public:
+	AlignedArray() : m_memory( 0 ), m_data( 0 )					{}
+	~AlignedArray()												{ free( m_memory ); }
+
+	/// Reallocates the array, the elements are default constructed
+	void resize( unsigned int size )
+	{
+		free( m_memory );
+		m_memory = malloc( size * sizeof(T) + 15 );
+		m_data = reinterpret_cast<T *>( ( reinterpret_cast<size_t>( m_memory ) + 15 ) & ~size_t(15) );
+		for( unsigned int i = 0; i < size; i++ )
+			new( m_data + i ) T();
+	}
+
+	T & operator[]( unsigned int i )							{ return m_data[i]; }
+	const T & operator[]( unsigned int i ) const				{ return m_data[i]; }
+
+private:
+	/// Non-copyable
+	AlignedArray( const AlignedArray & );
+	AlignedArray & operator=( const AlignedArray & );
+
+private:
+	void *	m_memory;
+	T *		m_data;
+};
+
+// ----------------------------------------------------
+// Globals
+// ----------------------------------------------------
+
+/// Minimum time spent on each timed run (in seconds)
+const double MINIMUM_RUN_TIME = 0.1;
+
+/// Number of timed runs per benchmark (the fastest one is reported)
+const unsigned int TIMED_RUNS = 5;
+
+/// The results are accumulated here, so the compiler can't remove the benchmarked code
+volatile float g_sink = 0.f;
+
+/// Randomized inputs, initialized by CreateInputs()
+AlignedArray<Matrix4>	g_matricesA, g_matricesB, g_matricesResult;
+vector<Point3>			g_pointsA, g_pointsB, g_pointsC, g_pointsResult;
+vector<Quaternion>		g_quatsA, g_quatsB, g_quatsResult;
+vector<float>			g_interpolants;
+vector<Bound>			g_boundsA, g_boundsB;
+vector<AxisAlignedBox>	g_boxesA, g_boxesB;
+vector<OrientedBox>		g_orientedBoxes;
+vector<Plane>			g_planes;
+vector<float>			g_centerX, g_centerY, g_centerZ, g_radius;
+vector<unsigned int>	g_visibleMask, g_intersectMasks;
+Plane					g_frustum[MAX_FRUSTUM_PLANES];
+
+// ----------------------------------------------------
+// Local Functions
+// ----------------------------------------------------
+
+static double GetSeconds();
+static float RandomFloat( float min, float max );
+static Point3 RandomPoint( float range );
+static Quaternion RandomQuaternion();
+static void CreateInputs( unsigned int count );
+static void RunBenchmark( const char * name, BenchmarkFunction function, unsigned int count, const char * filter );
+
+// ----------------------------------------------------
+// Benchmarks
+// ----------------------------------------------------
+
+//
+// Matrix4
+//
+static void Bench_MatrixMultiply( unsigned int count )
+{
+	for( unsigned int i = 0; i < count; i++ )
+		g_matricesResult[i] = g_matricesA[i] * g_matricesB[i];
+	g_sink += g_matricesResult[ count - 1 ].m00;
+}
+
+static void Bench_MatrixMultiplyAssign( unsigned int count )
+{
+	for( unsigned int i = 0; i < count; i++ )
+	{
+		g_matricesResult[i] = g_matricesA[i];
+		g_matricesResult[i] *= g_matricesB[i];
+	}
+	g_sink += g_matricesResult[ count - 1 ].m00;
+}
+
+static void Bench_MatrixInverse( unsigned int count )
+{
+	for( unsigned int i = 0; i < count; i++ )
+	{
+		g_matricesResult[i] = g_matricesA[i];
+		g_matricesResult[i].inverse();
+	}
+	g_sink += g_matricesResult[ count - 1 ].m00;
+}
+
+static void Bench_MatrixTranspose( unsigned int count )
+{
+	for( unsigned int i = 0; i < count; i++ )
+	{
+		g_matricesResult[i] = g_matricesA[i];
+		g_matricesResult[i].transpose();
+	}
+	g_sink += g_matricesResult[ count - 1 ].m00;
+}
+
+//
+// Point3 transforms
+//
+static void Bench_PointTransformVector( unsigned int count )
+{
+	const Matrix4 & m = g_matricesA[0];
+	for( unsigned int i = 0; i < count; i++ )
+		g_pointsResult[i] = g_pointsA[i] * m;
+	g_sink += g_pointsResult[ count - 1 ].x;
+}
+
+static void Bench_PointTransformPoint( unsigned int count )
+{
+	const Matrix4 & m = g_matricesA[0];
+	for( unsigned int i = 0; i < count; i++ )
+	{
+		g_pointsResult[i] = g_pointsA[i];
+		g_pointsResult[i] *= m;
+	}
+	g_sink += g_pointsResult[ count - 1 ].x;
+}
+
+static void Bench_MatrixTransformPoints( unsigned int count )
+{
+	g_matricesA[0].transformPoints( &g_pointsA[0], &g_pointsResult[0], count );
+	g_sink += g_pointsResult[ count - 1 ].x;
+}
+
+static void Bench_MatrixTransformVectors( unsigned int count )
+{
+	g_matricesA[0].transformVectors( &g_pointsA[0], &g_pointsResult[0], count );
+	g_sink += g_pointsResult[ count - 1 ].x;
+}
+
+//
+// Quaternion
+//
+static void Bench_QuaternionToMatrix( unsigned int count )
+{
+	for( unsigned int i = 0; i < count; i++ )
+		g_quatsA[i].toMatrix( g_matricesResult[i] );
+	g_sink += g_matricesResult[ count - 1 ].m00;
+}
+
+static void Bench_QuaternionSlerp( unsigned int count )
+{
+	for( unsigned int i = 0; i < count; i++ )
+		g_quatsResult[i] = Quaternion::slerp( g_interpolants[i], g_quatsA[i], g_quatsB[i] );
+	g_sink += g_quatsResult[ count - 1 ].w;
+}
+
+static void Bench_QuaternionSlerpArray( unsigned int count )
+{
+	Quaternion::slerpArray( &g_interpolants[0], &g_quatsA[0], &g_quatsB[0], &g_quatsResult[0], count );
+	g_sink += g_quatsResult[ count - 1 ].w;
+}
+
+static void Bench_QuaternionSlerpArrayError( unsigned int count )
+{
+	Quaternion::slerpArray( &g_interpolants[0], &g_quatsA[0], &g_quatsB[0], &g_quatsResult[0], count, 0.001f );
+	g_sink += g_quatsResult[ count - 1 ].w;
+}
+
+static void Bench_QuaternionNlerp( unsigned int count )
+{
+	for( unsigned int i = 0; i < count; i++ )
+		g_quatsResult[i] = Quaternion::nlerp( g_interpolants[i], g_quatsA[i], g_quatsB[i] );
+	g_sink += g_quatsResult[ count - 1 ].w;
+}
+
+static void Bench_QuaternionNlerpArray( unsigned int count )
+{
+	Quaternion::nlerpArray( &g_interpolants[0], &g_quatsA[0], &g_quatsB[0], &g_quatsResult[0], count );
+	g_sink += g_quatsResult[ count - 1 ].w;
+}
+
+//
+// Bound and Plane
+//
+static void Bench_BoundTransform( unsigned int count )
+{
+	const Matrix4 & m = g_matricesA[0];
+	float sum = 0.f;
+	for( unsigned int i = 0; i < count; i++ )
+	{
+		Bound bound( g_boundsA[i] );
+		bound.transform( m );
+		sum += bound.getCenter().x;
+	}
+	g_sink += sum;
+}
+
+static void Bench_BoundFit( unsigned int count )
+{
+	Bound bound;
+	bound.fit( &g_pointsA[0], count );
+	g_sink += bound.getRadius();
+}
+
+static void Bench_OrientedBoxTransform( unsigned int count )
+{
+	const Matrix4 & m = g_matricesA[0];
+	float sum = 0.f;
+	for( unsigned int i = 0; i < count; i++ )
+	{
+		OrientedBox box( g_orientedBoxes[i] );
+		box.transform( m );
+		sum += box.m_center.x;
+	}
+	g_sink += sum;
+}
+
+static void Bench_PlaneWhichSide( unsigned int count )
+{
+	unsigned int sides = 0;
+	for( unsigned int i = 0; i < count; i++ )
+		sides += g_planes[i].whichSide( g_boundsA[i] );
+	g_sink += (float)sides;
+}
+
+//
+// Frustum culling. This is a copy of the loop of Camera::Cull(), the camera
+// itself can't be used here as it depends on the scene graph.
+//
+static void Bench_FrustumCull( unsigned int count )
+{
+	unsigned int visible = 0;
+	for( unsigned int i = 0; i < count; i++ )
+	{
+		const Point3 & center = g_boundsA[i].getCenter();
+		const float radius = g_boundsA[i].getRadius();
+
+		bool isVisible = true;
+		for( int plane = 0; plane < MAX_FRUSTUM_PLANES && isVisible; plane++ )
+			if ( g_frustum[plane].distance( center ) < -radius )
+				isVisible = false;
+
+		visible += isVisible;
+	}
+	g_sink += (float)visible;
+}
+
+static void Bench_FrustumCullWhichSide( unsigned int count )
+{
+	unsigned int visible = 0;
+	for( unsigned int i = 0; i < count; i++ )
+	{
+		bool isVisible = true;
+		for( int plane = 0; plane < MAX_FRUSTUM_PLANES && isVisible; plane++ )
+			if ( g_frustum[plane].whichSide( g_boundsA[i] ) == Plane::SIDE_BACK )
+				isVisible = false;
+
+		visible += isVisible;
+	}
+	g_sink += (float)visible;
+}
+
+static void Bench_FrustumCullOrientedBox( unsigned int count )
+{
+	unsigned int visible = 0;
+	for( unsigned int i = 0; i < count; i++ )
+	{
+		const OrientedBox & box = g_orientedBoxes[i];
+
+		bool isVisible = true;
+		for( int plane = 0; plane < MAX_FRUSTUM_PLANES && isVisible; plane++ )
+			if ( g_frustum[plane].distance( box.m_center ) < -box.getProjectedRadius( g_frustum[plane].m_normal ) )
+				isVisible = false;
+
+		visible += isVisible;
+	}
+	g_sink += (float)visible;
+}
+
+static void Bench_CullSpheres( unsigned int count )
+{
+	kmath::cullSpheres( &g_centerX[0], &g_centerY[0], &g_centerZ[0], &g_radius[0], count,
+						g_frustum, FRUSTUM_PLANE_MASK_ALL, &g_visibleMask[0] );
+	g_sink += (float)g_visibleMask[0];
+}
+
+static void Bench_CullSpheresMasks( unsigned int count )
+{
+	kmath::cullSpheres( &g_centerX[0], &g_centerY[0], &g_centerZ[0], &g_radius[0], count,
+						g_frustum, FRUSTUM_PLANE_MASK_ALL, &g_visibleMask[0], &g_intersectMasks[0] );
+	g_sink += (float)g_visibleMask[0];
+}
+
+//
+// kmath::testIntersect
+//
+static void Bench_IntersectBoxPoint( unsigned int count )
+{
+	unsigned int hits = 0;
+	for( unsigned int i = 0; i < count; i++ )
+		hits += kmath::testIntersect( g_boxesA[i], g_pointsA[i] );
+	g_sink += (float)hits;
+}
+
+static void Bench_IntersectBoxBox( unsigned int count )
+{
+	unsigned int hits = 0;
+	for( unsigned int i = 0; i < count; i++ )
+		hits += kmath::testIntersect( g_boxesA[i], g_boxesB[i] );
+	g_sink += (float)hits;
+}
+
+static void Bench_IntersectSpherePoint( unsigned int count )
+{
+	unsigned int hits = 0;
+	for( unsigned int i = 0; i < count; i++ )
+		hits += kmath::testIntersect( g_boundsA[i], g_pointsA[i] );
+	g_sink += (float)hits;
+}
+
+static void Bench_IntersectSphereSphere( unsigned int count )
+{
+	unsigned int hits = 0;
+	for( unsigned int i = 0; i < count; i++ )
+		hits += kmath::testIntersect( g_boundsA[i], g_boundsB[i] );
+	g_sink += (float)hits;
+}
+
+static void Bench_IntersectSphereTriangle( unsigned int count )
+{
+	unsigned int hits = 0;
+	for( unsigned int i = 0; i < count; i++ )
+		hits += kmath::testIntersect( g_boundsA[i], g_pointsA[i], g_pointsB[i], g_pointsC[i] );
+	g_sink += (float)hits;
+}
+
+static void Bench_IntersectBoxTriangle( unsigned int count )
+{
+	unsigned int hits = 0;
+	for( unsigned int i = 0; i < count; i++ )
+		hits += kmath::testIntersect( g_boxesA[i], g_pointsA[i], g_pointsB[i], g_pointsC[i] );
+	g_sink += (float)hits;
+}
+
+static void Bench_IntersectPointTriangle( unsigned int count )
+{
+	unsigned int hits = 0;
+	for( unsigned int i = 0; i < count; i++ )
+		hits += kmath::testIntersect( g_boundsA[i].getCenter(), g_pointsA[i], g_pointsB[i], g_pointsC[i] );
+	g_sink += (float)hits;
+}
+
+static void Bench_IntersectPlaneSphere( unsigned int count )
+{
+	unsigned int hits = 0;
+	for( unsigned int i = 0; i < count; i++ )
+		hits += kmath::testIntersect( g_planes[i], g_boundsA[i] );
+	g_sink += (float)hits;
+}
+
+static void Bench_IntersectPlaneBox( unsigned int count )
+{
+	unsigned int hits = 0;
+	for( unsigned int i = 0; i < count; i++ )
+		hits += kmath::testIntersect( g_planes[i], g_boxesA[i] );
+	g_sink += (float)hits;
+}
+
+// ----------------------------------------------------
+// main
+// ----------------------------------------------------
+
+int main( int argc, char ** argv )
+{
+	unsigned int count = argc > 1 ? (unsigned int)atoi( argv[1] ) : 65536;
+	const char * filter = argc > 2 ? argv[2] : NULL;
+	if ( count < 32 ) count = 32;
+
+	CreateInputs( count );
+
+#if defined(KATANA_MATH_AVX2)
+	const char * simd = "AVX2";
+#elif defined(KATANA_MATH_SSE2)
+	const char * simd = "SSE2";
+#else
+	const char * simd = "none";
+#endif
+
+	printf( "Katana math benchmark: %u elements, SIMD: %s\n\n", count, simd );
+	printf( "%-40s %12s %12s\n", "benchmark", "ns/op", "Mops/s" );
+	printf( "%-40s %12s %12s\n", "---------", "-----", "------" );
+
+	RunBenchmark( "Matrix4::operator*",					Bench_MatrixMultiply,				count, filter );
+	RunBenchmark( "Matrix4::operator*=",				Bench_MatrixMultiplyAssign,			count, filter );
+	RunBenchmark( "Matrix4::inverse",					Bench_MatrixInverse,				count, filter );
+	RunBenchmark( "Matrix4::transpose",					Bench_MatrixTranspose,				count, filter );
+	RunBenchmark( "Point3::operator*(Matrix4)",			Bench_PointTransformVector,			count, filter );
+	RunBenchmark( "Point3::operator*=(Matrix4)",		Bench_PointTransformPoint,			count, filter );
+	RunBenchmark( "Matrix4::transformVectors",			Bench_MatrixTransformVectors,		count, filter );
+	RunBenchmark( "Matrix4::transformPoints",			Bench_MatrixTransformPoints,		count, filter );
+	RunBenchmark( "Quaternion::toMatrix",				Bench_QuaternionToMatrix,			count, filter );
+	RunBenchmark( "Quaternion::slerp",					Bench_QuaternionSlerp,				count, filter );
+	RunBenchmark( "Quaternion::slerpArray",				Bench_QuaternionSlerpArray,			count, filter );
+	RunBenchmark( "Quaternion::slerpArray(0.001)",		Bench_QuaternionSlerpArrayError,	count, filter );
+	RunBenchmark( "Quaternion::nlerp",					Bench_QuaternionNlerp,				count, filter );
+	RunBenchmark( "Quaternion::nlerpArray",				Bench_QuaternionNlerpArray,			count, filter );
+	RunBenchmark( "Bound::transform(Matrix4)",			Bench_BoundTransform,				count, filter );
+	RunBenchmark( "Bound::fit (per point)",				Bench_BoundFit,						count, filter );
+	RunBenchmark( "OrientedBox::transform(Matrix4)",	Bench_OrientedBoxTransform,			count, filter );
+	RunBenchmark( "Plane::whichSide(Bound)",			Bench_PlaneWhichSide,				count, filter );
+	RunBenchmark( "Scalar cull loop (copy of Camera::Cull)",	Bench_FrustumCull,					count, filter );
+	RunBenchmark( "Frustum cull (Plane::whichSide)",	Bench_FrustumCullWhichSide,			count, filter );
+	RunBenchmark( "Frustum cull (OrientedBox)",		Bench_FrustumCullOrientedBox,		count, filter );
+	RunBenchmark( "kmath::cullSpheres",					Bench_CullSpheres,					count, filter );
+	RunBenchmark( "kmath::cullSpheres(masks)",			Bench_CullSpheresMasks,				count, filter );
+	RunBenchmark( "testIntersect(box, point)",			Bench_IntersectBoxPoint,			count, filter );
+	RunBenchmark( "testIntersect(box, box)",			Bench_IntersectBoxBox,				count, filter );
+	RunBenchmark( "testIntersect(sphere, point)",		Bench_IntersectSpherePoint,			count, filter );
+	RunBenchmark( "testIntersect(sphere, sphere)",		Bench_IntersectSphereSphere,		count, filter );
+	RunBenchmark( "testIntersect(sphere, triangle)",	Bench_IntersectSphereTriangle,		count, filter );
+	RunBenchmark( "testIntersect(box, triangle)",		Bench_IntersectBoxTriangle,			count, filter );
+	RunBenchmark( "testIntersect(point, triangle)",		Bench_IntersectPointTriangle,		count, filter );
+	RunBenchmark( "testIntersect(plane, sphere)",		Bench_IntersectPlaneSphere,			count, filter );
+	RunBenchmark( "testIntersect(plane, box)",			Bench_IntersectPlaneBox,			count, filter );
+
+	return 0;
+}
+
+// ----------------------------------------------------
+// Local Functions
+// ----------------------------------------------------
+
+//
+// GetSeconds
+// Returns a monotonic time in seconds
+//
+double GetSeconds()
+{
+#if defined(_WIN32)
+	LARGE_INTEGER frequency, counter;
+	QueryPerformanceFrequency( &frequency );
+	QueryPerformanceCounter( &counter );
+	return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+	timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+#endif
+}
+
+//
+// RandomFloat
+//
+float RandomFloat( float min, float max )
+{
+	return min + ( max - min ) * ( (float)rand() / (float)RAND_MAX );
+}
+
+//
+// RandomPoint
+//
+Point3 RandomPoint( float range )
+{
+	return Point3( RandomFloat( -range, range ), RandomFloat( -range, range ), RandomFloat( -range, range ) );
+}
+
+//
+// RandomQuaternion
+//
+Quaternion RandomQuaternion()
+{
+	Quaternion q( RandomFloat( -1.f, 1.f ), RandomFloat( -1.f, 1.f ), RandomFloat( -1.f, 1.f ), RandomFloat( -1.f, 1.f ) );
+	q.normalise();
+	return q;
+}
+
+//
+// CreateInputs
+// Fills the input arrays with reproducible random values
+//
+void CreateInputs( unsigned int count )
+{
+	srand( 1234 );
+
+	g_matricesA.resize( count ); g_matricesB.resize( count ); g_matricesResult.resize( count );
+	g_pointsA.resize( count ); g_pointsB.resize( count ); g_pointsC.resize( count ); g_pointsResult.resize( count );
+	g_quatsA.resize( count ); g_quatsB.resize( count ); g_quatsResult.resize( count );
+	g_interpolants.resize( count );
+	g_boundsA.resize( count ); g_boundsB.resize( count );
+	g_boxesA.resize( count ); g_boxesB.resize( count );
+	g_orientedBoxes.resize( count );
+	g_planes.resize( count );
+	g_centerX.resize( count ); g_centerY.resize( count ); g_centerZ.resize( count ); g_radius.resize( count );
+	g_visibleMask.resize( ( count + 31 ) / 32 );
+	g_intersectMasks.resize( count );
+
+	for( unsigned int i = 0; i < count; i++ )
+	{
+		// Rigid transformations (so they're invertible), like the world matrices of the scene
+		RandomQuaternion().toMatrix( g_matricesA[i] );
+		g_matricesA[i].m03 = g_matricesA[i].m13 = g_matricesA[i].m23 = 0.f;
+		g_matricesA[i].pos = RandomPoint( 100.f );
+		RandomQuaternion().toMatrix( g_matricesB[i] );
+		g_matricesB[i].m03 = g_matricesB[i].m13 = g_matricesB[i].m23 = 0.f;
+		g_matricesB[i].pos = RandomPoint( 100.f );
+
+		g_pointsA[i] = RandomPoint( 100.f );
+		g_pointsB[i] = g_pointsA[i] + RandomPoint( 10.f );
+		g_pointsC[i] = g_pointsA[i] + RandomPoint( 10.f );
+
+		// Half of the quaternion pairs are close together, like successive keyframes
+		g_quatsA[i] = RandomQuaternion();
+		if ( i & 1 )
+		{
+			g_quatsB[i] = g_quatsA[i] * Quaternion( RandomFloat( -0.1f, 0.1f ), Point3( 0.f, 1.f, 0.f ) );
+			g_quatsB[i].normalise();
+		}
+		else
+			g_quatsB[i] = RandomQuaternion();
+		g_interpolants[i] = RandomFloat( 0.f, 1.f );
+
+		g_boundsA[i] = Bound( RandomPoint( 1000.f ), RandomFloat( 1.f, 50.f ) );
+		g_boundsB[i] = Bound( g_boundsA[i].getCenter() + RandomPoint( 50.f ), RandomFloat( 1.f, 50.f ) );
+
+		const Point3 boxCenter = RandomPoint( 100.f );
+		const Point3 boxExtents( RandomFloat( 1.f, 10.f ), RandomFloat( 1.f, 10.f ), RandomFloat( 1.f, 10.f ) );
+		g_boxesA[i].setExtents( boxCenter, boxExtents );
+		g_boxesB[i].setExtents( boxCenter + RandomPoint( 15.f ), boxExtents );
+
+		g_orientedBoxes[i] = OrientedBox( g_boxesA[i] );
+		g_orientedBoxes[i].transform( g_matricesA[i] );
+
+		Point3 normal = RandomPoint( 1.f );
+		normal.getNormalized();
+		g_planes[i] = Plane( normal, RandomFloat( -100.f, 100.f ) );
+
+		g_centerX[i] = g_boundsA[i].getCenter().x;
+		g_centerY[i] = g_boundsA[i].getCenter().y;
+		g_centerZ[i] = g_boundsA[i].getCenter().z;
+		g_radius[i] = g_boundsA[i].getRadius();
+	}
+
+	// A 90 degree frustum looking down +Z, with the normals pointing inside
+	const float halfSqrt2 = 0.70710678f;
+	g_frustum[FRUSTUM_NEAR].set( 0.f, 0.f, 1.f, -1.f );
+	g_frustum[FRUSTUM_FAR].set( 0.f, 0.f, -1.f, 1000.f );
+	g_frustum[FRUSTUM_RIGHT].set( -halfSqrt2, 0.f, halfSqrt2, 0.f );
+	g_frustum[FRUSTUM_LEFT].set( halfSqrt2, 0.f, halfSqrt2, 0.f );
+	g_frustum[FRUSTUM_TOP].set( 0.f, -halfSqrt2, halfSqrt2, 0.f );
+	g_frustum[FRUSTUM_BOTTOM].set( 0.f, halfSqrt2, halfSqrt2, 0.f );
+}
+
+//
+// RunBenchmark
+// Times the benchmark and prints the fastest run
+//
+void RunBenchmark( const char * name, BenchmarkFunction function, unsigned int count, const char * filter )
+{
+	if ( filter && !strstr( name, filter ) )
+		return;
+
+	// Warm up the caches, and find how many passes fill the minimum run time
+	unsigned int passes = 1;
+	for( ;; )
+	{
+		const double start = GetSeconds();
+		for( unsigned int pass = 0; pass < passes; pass++ )
+			function( count );
+		if ( GetSeconds() - start >= MINIMUM_RUN_TIME )
+			break;
+		passes *= 2;
+	}
+
+	// Keep the fastest of the timed runs
+	double bestTime = 0.0;
+	for( unsigned int run = 0; run < TIMED_RUNS; run++ )
+	{
+		const double start = GetSeconds();
+		for( unsigned int pass = 0; pass < passes; pass++ )
+			function( count );
+		const double elapsed = GetSeconds() - start;
+
+		if ( run == 0 || elapsed < bestTime )
+			bestTime = elapsed;
+	}
+
+	const double operations = (double)passes * (double)count;
+	const double nanoseconds = bestTime * 1e9 / operations;
+
+	printf( "%-40s %12.2f %12.2f\n", name, nanoseconds, 1e3 / nanoseconds );
+}
@@ -0,0 +1,1197 @@
+/*
+	Katana Engine
+	Copyright  2001-2004 Eric Bryant, Inc.
+
+	File:		scenebench.cpp
+	Author:		Eric Bryant
+
+	Headless frame benchmark. A scene of configurable size is generated
+	procedurally (meshes sharing a few geometries, a flat or deep node
+	hierarchy, lights, animated objects, a terrain and a BSP scene), then
+	the camera flies along a fixed path while the frames are ticked like
+	GameEngine::OnTick() does. The NullRender backend only counts the
+	submissions, so the timings are those of the engine itself.
+
+	Every run with the same options builds the same scene and flies the
+	same path, so use it to reproduce scaling problems and to compare
+	builds without any game assets.
+
+	The benchmark links with the Katana library (build katana.vcproj first,
+	katana.h links the library automatically):
+
+		Windows:	cl /O2 /EHsc /I..\src /I<boost> /I<lua> scenebench.cpp /link /LIBPATH:..\build\Release
+
+	With -check, every tenth measured frame is also checked against brute force
+	references, outside of the timings: the objects returned by the spatial index,
+	the lights the light grid selects for every object, the objects the occlusion
+	buffer hides and the terrain patches the quadtree keeps. The failures are
+	reported after the timings, and the benchmark then exits with an error.
+
+	Usage:			scenebench [options]
+
+		-objects N		Number of meshes (default 10000)
+		-geometries N	Number of geometries shared by the meshes (default 16)
+		-depth N		Depth of the node hierarchy, 0 for a flat scene (default 0)
+		-branch N		Children per node of the hierarchy (default 4)
+		-lights N		Number of point lights (default 8)
+		-lightrange N	Range of the point lights in world units (default a quarter of the world)
+		-maxlights N	Lights assigned to each object (default 8, see LightGrid)
+		-animated N		Number of meshes moved by a controller (default 1000)
+		-terrain N		Vertices per side of the height field, 0 for none (default 129)
+		-cdlod			Draws the terrain with the chunked LOD instead of geomipmapping
+		-bsp N			Buildings in the BSP scene, 0 for none (default 400)
+		-world N		Size of the world in world units (default 8000)
+		-frames N		Number of measured frames (default 1000)
+		-warmup N		Number of frames ticked before measuring (default 60)
+		-threads N		Worker threads of the job system, 0 for none (default 0)
+		-parallel		Update the scene on the job system (see SceneGraph::setParallelUpdate)
+		-pipelined		Update the next frame while submitting (see GameEngine::setPipelined)
+		-index			Culls with the spatial index instead of the hierarchy (see SceneGraph::setCullingMode)
+		-occlusion		Hides the objects behind the BSP buildings (see SceneGraph::setOcclusionCulling)
+		-check			Checks the results of the culling and the light assignment (see above)
+		-seed N			Seed of the scene generator (default 1)
+		-record FILE	Records the statistics of every frame (see StatisticsRecorder)
+		-trace FILE		Profiles the measured frames and saves a Chrome trace (see Profiler)
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdarg.h>
+#include <algorithm>
+#include "katana.h"
+#include "render/render.h"
+#include "render/nullrender.h"
+#include "render/heightfield.h"
+#include "scene/lightgrid.h"
+#include "scene/spatialindex.h"
+#include "scene/occlusionbuffer.h"
+#include "scene/terrain.h"
+#include "scene/terrainpatch.h"
+#include "scene/terrainsettings.h"
+using namespace std;
+using namespace Katana;
+
+// ----------------------------------------------------
+// Types
+// ----------------------------------------------------
+
+///
+/// BenchOptions
+/// Size of the generated scene, and how the frames are run
+///
+struct BenchOptions
+{
+	unsigned int	objects;
+	unsigned int	geometries;
+	unsigned int	depth;
+	unsigned int	branch;
+	unsigned int	lights;
+	float			lightRange;
+	unsigned int	maxLights;
+	unsigned int	animated;
+	unsigned int	terrain;
+	bool			cdlod;
+	unsigned int	bsp;
+	float			world;
+	unsigned int	frames;
+	unsigned int	warmup;
+	unsigned int	threads;
+	bool			parallel;
+	bool			pipelined;
+	bool			index;
+	bool			occlusion;
+	bool			check;
+	unsigned int	seed;
+	const char *	record;
+	const char *	trace;
+};
+
+///
+/// BenchRegion
+/// A node of the generated hierarchy, and the square of the world it covers
+///
+struct BenchRegion
+{
+	shared_ptr<VisNode>	node;
+	Point3				center;
+	float				minX, maxX, minZ, maxZ;
+};
+
+///
+/// BenchFrame
+/// Measurements of a frame
+///
+struct BenchFrame
+{
+	double			tick;
+	double			update;
+	double			cull;
+	double			sort;
+	double			render;
+	unsigned int	objectsRendered;
+	unsigned int	objectsCulled;
+	unsigned int	objectsOccluded;
+	unsigned int	drawCalls;
+	unsigned int	primitives;
+	unsigned int	vertices;
+	unsigned int	stateChanges;
+	unsigned int	textureBinds;
+};
+
+///
+/// BenchContents
+/// The generated objects the checks compare against
+///
+struct BenchContents
+{
+	vector< shared_ptr<VisMesh> >	meshes;
+	vector< shared_ptr<Visible> >	lights;
+	vector< pair<Point3, Point3> >	buildings;		/// World space boxes of the BSP buildings (minimum, maximum)
+	shared_ptr<Terrain>				terrain;
+};
+
+///
+/// BenchCheck
+/// Results of a check over the measured frames
+///
+struct BenchCheck
+{
+	const char *	name;
+	unsigned int	tests;
+	unsigned int	failures;
+};
+
+///
+/// BenchController
+/// Spins its target around the Y axis and bobs it up and down. It only touches
+/// its target, so it's updated on the worker threads with the parallel update.
+///
+class BenchController : public Controller
+{
+	KDECLARE_RTTI;
+
+public:
+	/// Constructor
+	BenchController( shared_ptr<Visible> target, float speed, float phase );
+
+	/// Moves the target
+	virtual void OnUpdate( SceneContext * context );
+
+private:
+	Point3	m_origin;
+	float	m_speed;
+	float	m_phase;
+};
+
+KIMPLEMENT_RTTI( BenchController, Controller );
+
+// ----------------------------------------------------
+// Globals
+// ----------------------------------------------------
+
+/// Fixed time step of the ticks (in seconds)
+const float DELTA_TIME = 1.f / 60.f;
+
+/// Height of the camera path above the ground
+const float CAMERA_HEIGHT = 150.f;
+
+/// Height of the generated terrain (in world units)
+const float TERRAIN_HEIGHT = 400.f;
+
+/// Field of view of the camera
+const float CAMERA_FOV = kmath::PI / 4;
+
+/// The checks run on every CHECK_INTERVAL measured frames
+const unsigned int CHECK_INTERVAL = 10;
+
+/// Failures printed per check, the others are only counted
+const unsigned int CHECK_MAXIMUM_PRINTED = 5;
+
+/// Delta time passed to the pipelined update job
+float g_updateDeltaTime = 0.f;
+
+// ----------------------------------------------------
+// Local Functions
+// ----------------------------------------------------
+
+static double GetSeconds();
+static float RandomFloat( float min, float max );
+static bool ParseOptions( int argc, char ** argv, BenchOptions & options );
+static shared_ptr<Geometry> CreateSphere( float radius, unsigned int segments, unsigned int rings );
+static shared_ptr<Geometry> CreateCity( unsigned int buildings, float size );
+static shared_ptr<Heightfield> CreateHeightfield( unsigned int size, float world );
+static void CreateHierarchy( BenchRegion & region, unsigned int depth, unsigned int branch, unsigned int axis, vector<BenchRegion> & leaves );
+static void CreateScene( SceneGraph & scene, const BenchOptions & options, BenchContents & contents );
+static void MoveCamera( Camera & camera, float world, unsigned int frame, unsigned int frames );
+static void Tick( SceneGraph & scene, Render & render, Camera & camera, JobSystem * jobs, bool pipelined );
+static void UpdateFrame( Job * job, void * data );
+static void PrintTime( const char * name, vector<BenchFrame> & frames, double BenchFrame::*field );
+static void PrintCount( const char * name, const vector<BenchFrame> & frames, unsigned int BenchFrame::*field );
+static void Fail( BenchCheck & check, const char * format, ... );
+static void CheckSpatialIndex( SceneGraph & scene, const Camera & camera, const BenchContents & contents, float radius, BenchCheck & check );
+static void CheckLights( SceneGraph & scene, const BenchContents & contents, float world, BenchCheck & check );
+static void CheckOcclusion( SceneGraph & scene, const Camera & camera, const BenchContents & contents, BenchCheck & check );
+static void CheckTerrain( SceneGraph & scene, const Camera & camera, const BenchContents & contents, bool cdlod, BenchCheck & check );
+static bool IntersectSegmentBox( const Point3 & start, const Point3 & end, const Point3 & minimum, const Point3 & maximum );
+
+// ----------------------------------------------------
+// BenchController
+// ----------------------------------------------------
+
+//
+// Constructor
+//
+BenchController::BenchController( shared_ptr<Visible> target, float speed, float phase ) :
+	Controller( target ),
+	m_origin( target->getTranslation() ),
+	m_speed( speed ),
+	m_phase( phase )
+{
+	setThreadSafe( true );
+}
+
+//
+// OnUpdate
+//
+void BenchController::OnUpdate( SceneContext * context )
+{
+	const float angle = m_phase + context->gameTime * m_speed;
+
+	m_target->setTransform( m_origin + Point3( 0.f, 10.f * sinf( angle ), 0.f ),
+							Quaternion( angle, Point3( 0.f, 1.f, 0.f ) ) );
+}
+
+// ----------------------------------------------------
+// main
+// ----------------------------------------------------
+
+int main( int argc, char ** argv )
+{
+	BenchOptions options;
+	if ( !ParseOptions( argc, argv, options ) )
+		return 1;
+
+	// The renderer only counts the submissions
+	shared_ptr<NullRender> render( new NullRender );
+	RenderInfo info;
+	memset( &info, 0, sizeof(info) );
+	info.uiTargetWidth = 1024;
+	info.uiTargetHeight = 768;
+	info.uiTargetColorDepth = 32;
+	if ( !render->Initialize( info ) )
+		return 1;
+
+	// Same camera as GameEngine::OnStartup()
+	shared_ptr<Camera> camera( new Camera( CAMERA_FOV, 0.1f, 32000.f, float(info.uiTargetWidth) / info.uiTargetHeight ) );
+	render->SetViewport( *camera.get() );
+
+	// The debug output is left with its defaults, so it doesn't draw anything
+	shared_ptr<DebugOutput> debug( new DebugOutput );
+
+	shared_ptr<JobSystem> jobs;
+	if ( options.threads )
+	{
+		jobs.reset( new JobSystem );
+		jobs->initialize( options.threads );
+	}
+
+	SceneGraph scene( shared_ptr<VisNode>( new VisNode ) );
+	scene.setContext( render.get(), camera.get(), debug.get(), 0 );
+	scene.setJobSystem( jobs.get() );
+	scene.setParallelUpdate( options.parallel && jobs );
+	scene.getLightGrid()->setMaximumLights( options.maxLights );
+
+	// The spatial index covers the generated world
+	if ( options.index )
+	{
+		scene.setCullingMode( SceneGraph::CULL_SPATIAL_INDEX );
+		scene.getSpatialIndex()->setBounds( Point3( options.world * 0.5f, 0.f, options.world * 0.5f ), options.world * 0.5f );
+	}
+
+	// The buildings hide the objects behind them. The occlusion buffer is rasterized on the job system.
+	scene.setOcclusionCulling( options.occlusion );
+
+	const bool pipelined = options.pipelined && jobs && jobs->getThreadCount() > 1;
+
+	// Generate the scene
+	BenchContents contents;
+	const double createStart = GetSeconds();
+	CreateScene( scene, options, contents );
+	const double createTime = GetSeconds() - createStart;
+
+	printf( "Scene:    %d objects over %d geometries, ", options.objects, options.geometries );
+	if ( options.depth )
+		printf( "hierarchy of depth %d and branching %d\n", options.depth, options.branch );
+	else
+		printf( "flat hierarchy\n" );
+	printf( "          %d lights, %d animated, terrain %dx%d, %d BSP buildings (built in %.0f ms)\n",
+		options.lights, options.animated, options.terrain, options.terrain, options.bsp, createTime * 1e3 );
+	printf( "Frames:   %d (after %d warm-up), %d worker threads, parallel update %s, pipelined %s, %s culling, occlusion %s\n\n",
+		options.frames, options.warmup, jobs ? jobs->getThreadCount() - 1 : 0,
+		scene.getParallelUpdate() ? "on" : "off", pipelined ? "on" : "off", options.index ? "index" : "hierarchy",
+		options.occlusion ? "on" : "off" );
+
+	// Warm up: the buffers are uploaded and the caches filled during the first frames
+	unsigned int frame;
+	for( frame = 0; frame < options.warmup; frame++ )
+	{
+		MoveCamera( *camera.get(), options.world, frame, options.warmup + options.frames );
+		Tick( scene, *render.get(), *camera.get(), jobs.get(), pipelined );
+	}
+
+	if ( options.record && !scene.startRecording( options.record ) )
+		printf( "Failed to record the statistics to %s\n", options.record );
+
+	if ( options.trace )
+	{
+		Profiler::reset();
+		Profiler::setEnabled( true );
+	}
+
+	// The features which aren't used by the scene aren't checked
+	BenchCheck checks[] =
+	{
+		{ "spatial index", 0, 0 },
+		{ "light grid", 0, 0 },
+		{ "occlusion", 0, 0 },
+		{ "terrain", 0, 0 },
+	};
+
+	// Measure the frames
+	vector<BenchFrame> frames( options.frames );
+	for( frame = 0; frame < options.frames; frame++ )
+	{
+		MoveCamera( *camera.get(), options.world, options.warmup + frame, options.warmup + options.frames );
+
+		const double tickStart = GetSeconds();
+		Tick( scene, *render.get(), *camera.get(), jobs.get(), pipelined );
+		const double tickTime = GetSeconds() - tickStart;
+
+		const SceneStatistics & statistics = scene.getStatistics();
+		BenchFrame & result = frames[frame];
+		result.tick = tickTime * 1e3;
+		result.update = statistics.updateMilliseconds;
+		result.cull = statistics.cullMilliseconds;
+		result.sort = statistics.sortMilliseconds;
+		result.render = statistics.renderMilliseconds;
+		result.objectsRendered = statistics.objectsRenderedLastFrame;
+		result.objectsCulled = statistics.objectsCulledLastFrame;
+		result.objectsOccluded = statistics.objectsOccludedLastFrame;
+		result.drawCalls = statistics.drawCallsLastFrame;
+		result.primitives = statistics.primitivesLastFrame;
+		result.vertices = statistics.verticesLastFrame;
+		result.stateChanges = statistics.stateChangesLastFrame;
+		result.textureBinds = statistics.textureBindsLastFrame;
+
+		if ( options.check && frame % CHECK_INTERVAL == 0 )
+		{
+			if ( options.index )
+				CheckSpatialIndex( scene, *camera.get(), contents, options.world * 0.1f, checks[0] );
+			CheckLights( scene, contents, options.world, checks[1] );
+			if ( options.occlusion )
+				CheckOcclusion( scene, *camera.get(), contents, checks[2] );
+			CheckTerrain( scene, *camera.get(), contents, options.cdlod, checks[3] );
+		}
+	}
+
+	scene.stopRecording();
+
+	if ( options.trace )
+	{
+		Profiler::setEnabled( false );
+		if ( !Profiler::saveChromeTrace( options.trace ) )
+			printf( "Failed to save the trace to %s\n", options.trace );
+	}
+
+	if ( !options.frames )
+		return 0;
+
+	// Report the frame times
+	printf( "%-20s %10s %10s %10s %10s %10s %10s\n", "phase (ms)", "mean", "min", "p50", "p90", "p99", "max" );
+	PrintTime( "tick", frames, &BenchFrame::tick );
+	PrintTime( "update", frames, &BenchFrame::update );
+	PrintTime( "cull", frames, &BenchFrame::cull );
+	PrintTime( "sort", frames, &BenchFrame::sort );
+	PrintTime( "render", frames, &BenchFrame::render );
+
+	// Report the work done per frame
+	printf( "\n%-20s %10s %10s %10s\n", "per frame", "mean", "min", "max" );
+	PrintCount( "objects rendered", frames, &BenchFrame::objectsRendered );
+	PrintCount( "objects culled", frames, &BenchFrame::objectsCulled );
+	PrintCount( "objects occluded", frames, &BenchFrame::objectsOccluded );
+	PrintCount( "draw calls", frames, &BenchFrame::drawCalls );
+	PrintCount( "primitives", frames, &BenchFrame::primitives );
+	PrintCount( "vertices", frames, &BenchFrame::vertices );
+	PrintCount( "state changes", frames, &BenchFrame::stateChanges );
+	PrintCount( "texture binds", frames, &BenchFrame::textureBinds );
+
+	// Report the checks
+	unsigned int failures = 0;
+	if ( options.check )
+	{
+		printf( "\n%-20s %10s %10s\n", "check", "tests", "failures" );
+		for( unsigned int i = 0; i < sizeof(checks) / sizeof(checks[0]); i++ )
+		{
+			printf( "%-20s %10d %10d\n", checks[i].name, checks[i].tests, checks[i].failures );
+			failures += checks[i].failures;
+		}
+	}
+
+	// Release the scene before the renderer
+	scene.removeAllControllers();
+	scene.removeAllNodes();
+
+	return failures ? 1 : 0;
+}
+
+// ----------------------------------------------------
+// Local Functions
+// ----------------------------------------------------
+
+//
+// GetSeconds
+// Returns a monotonic time in seconds
+//
+double GetSeconds()
+{
+	return (double)SystemTimer::GetTicks() / (double)SystemTimer::GetTicksPerSecond();
+}
+
+//
+// RandomFloat
+//
+float RandomFloat( float min, float max )
+{
+	return min + ( max - min ) * ( (float)rand() / (float)RAND_MAX );
+}
+
+//
+// ParseOptions
+// Reads the options from the command line. Returns false if one isn't valid.
+//
+bool ParseOptions( int argc, char ** argv, BenchOptions & options )
+{
+	options.objects = 10000;
+	options.geometries = 16;
+	options.depth = 0;
+	options.branch = 4;
+	options.lights = 8;
+	options.lightRange = 0.f;
+	options.maxLights = LightGrid::DEFAULT_MAXIMUM_LIGHTS;
+	options.animated = 1000;
+	options.terrain = 129;
+	options.cdlod = false;
+	options.bsp = 400;
+	options.world = 8000.f;
+	options.frames = 1000;
+	options.warmup = 60;
+	options.threads = 0;
+	options.parallel = false;
+	options.pipelined = false;
+	options.index = false;
+	options.occlusion = false;
+	options.check = false;
+	options.seed = 1;
+	options.record = 0;
+	options.trace = 0;
+
+	for( int i = 1; i < argc; i++ )
+	{
+		const char * option = argv[i];
+		const char * value = i + 1 < argc ? argv[i + 1] : 0;
+
+		if ( !strcmp( option, "-parallel" ) )		{ options.parallel = true; continue; }
+		if ( !strcmp( option, "-pipelined" ) )		{ options.pipelined = true; continue; }
+		if ( !strcmp( option, "-index" ) )			{ options.index = true; continue; }
+		if ( !strcmp( option, "-occlusion" ) )		{ options.occlusion = true; continue; }
+		if ( !strcmp( option, "-cdlod" ) )			{ options.cdlod = true; continue; }
+		if ( !strcmp( option, "-check" ) )			{ options.check = true; continue; }
+
+		// The remaining options have a value
+		if ( !value )
+		{
+			printf( "Unknown option or missing value: %s\n", option );
+			return false;
+		}
+		i++;
+
+		if ( !strcmp( option, "-objects" ) )			options.objects = atoi( value );
+		else if ( !strcmp( option, "-geometries" ) )	options.geometries = atoi( value );
+		else if ( !strcmp( option, "-depth" ) )			options.depth = atoi( value );
+		else if ( !strcmp( option, "-branch" ) )		options.branch = atoi( value );
+		else if ( !strcmp( option, "-lights" ) )		options.lights = atoi( value );
+		else if ( !strcmp( option, "-lightrange" ) )	options.lightRange = (float)atof( value );
+		else if ( !strcmp( option, "-maxlights" ) )		options.maxLights = atoi( value );
+		else if ( !strcmp( option, "-animated" ) )		options.animated = atoi( value );
+		else if ( !strcmp( option, "-terrain" ) )		options.terrain = atoi( value );
+		else if ( !strcmp( option, "-bsp" ) )			options.bsp = atoi( value );
+		else if ( !strcmp( option, "-world" ) )			options.world = (float)atof( value );
+		else if ( !strcmp( option, "-frames" ) )		options.frames = atoi( value );
+		else if ( !strcmp( option, "-warmup" ) )		options.warmup = atoi( value );
+		else if ( !strcmp( option, "-threads" ) )		options.threads = atoi( value );
+		else if ( !strcmp( option, "-seed" ) )			options.seed = atoi( value );
+		else if ( !strcmp( option, "-record" ) )		options.record = value;
+		else if ( !strcmp( option, "-trace" ) )			options.trace = value;
+		else
+		{
+			printf( "Unknown option: %s\n", option );
+			return false;
+		}
+	}
+
+	if ( !options.geometries ) options.geometries = 1;
+	if ( options.branch < 2 ) options.branch = 2;
+	if ( options.animated > options.objects ) options.animated = options.objects;
+	if ( options.world < 1.f ) options.world = 1.f;
+
+	return true;
+}
+
+//
+// CreateSphere
+// Generates a sphere with normals, centered on the origin
+//
+shared_ptr<Geometry> CreateSphere( float radius, unsigned int segments, unsigned int rings )
+{
+	shared_ptr<Geometry> geometry( new Geometry );
+	geometry->m_primitiveType = TRIANGLE_LIST;
+	geometry->m_enabledBuffers = VERTEX | NORMALS | INDEX;
+	geometry->m_vertexBuffer.reset( new vector<float> );
+	geometry->m_normalBuffer.reset( new vector<float> );
+	geometry->m_indexBuffer.reset( new vector<unsigned short> );
+
+	unsigned int ring, segment;
+
+	// The seam vertices are duplicated, so each ring has segments + 1 vertices
+	for( ring = 0; ring <= rings; ring++ )
+	{
+		const float theta = kmath::PI * ring / rings;
+
+		for( segment = 0; segment <= segments; segment++ )
+		{
+			const float phi = 2.f * kmath::PI * segment / segments;
+			const Point3 normal( sinf( theta ) * cosf( phi ), cosf( theta ), sinf( theta ) * sinf( phi ) );
+
+			geometry->m_vertexBuffer->push_back( normal.x * radius );
+			geometry->m_vertexBuffer->push_back( normal.y * radius );
+			geometry->m_vertexBuffer->push_back( normal.z * radius );
+			geometry->m_normalBuffer->push_back( normal.x );
+			geometry->m_normalBuffer->push_back( normal.y );
+			geometry->m_normalBuffer->push_back( normal.z );
+		}
+	}
+
+	for( ring = 0; ring < rings; ring++ )
+	{
+		for( segment = 0; segment < segments; segment++ )
+		{
+			const unsigned short i0 = (unsigned short)( ring * ( segments + 1 ) + segment );
+			const unsigned short i1 = (unsigned short)( i0 + segments + 1 );
+
+			geometry->m_indexBuffer->push_back( i0 );
+			geometry->m_indexBuffer->push_back( i1 );
+			geometry->m_indexBuffer->push_back( i0 + 1 );
+
+			geometry->m_indexBuffer->push_back( i0 + 1 );
+			geometry->m_indexBuffer->push_back( i1 );
+			geometry->m_indexBuffer->push_back( i1 + 1 );
+		}
+	}
+
+	geometry->m_vertexCount = ( rings + 1 ) * ( segments + 1 );
+	geometry->m_indexCount = (unsigned int)geometry->m_indexBuffer->size();
+	geometry->m_primitiveCount = geometry->m_indexCount / 3;
+
+	return geometry;
+}
+
+//
+// CreateCity
+// Generates a grid of box shaped buildings of random heights, as a single mesh
+//
+shared_ptr<Geometry> CreateCity( unsigned int buildings, float size )
+{
+	// Eight vertices per building, which must be addressable by 16-bit indices
+	if ( buildings > 8192 ) buildings = 8192;
+
+	shared_ptr<Geometry> geometry( new Geometry );
+	geometry->m_primitiveType = TRIANGLE_LIST;
+	geometry->m_enabledBuffers = VERTEX | INDEX;
+	geometry->m_vertexBuffer.reset( new vector<float> );
+	geometry->m_indexBuffer.reset( new vector<unsigned short> );
+
+	// The sides of the boxes, as pairs of triangles over the corners
+	static const unsigned short faces[] =
+	{
+		0, 2, 1,  1, 2, 3,		// Bottom
+		4, 5, 6,  5, 7, 6,		// Top
+		0, 1, 4,  1, 5, 4,		// Front
+		2, 6, 3,  3, 6, 7,		// Back
+		0, 4, 2,  2, 4, 6,		// Left
+		1, 3, 5,  3, 7, 5,		// Right
+	};
+
+	const unsigned int blocks = (unsigned int)ceil( sqrt( (float)buildings ) );
+	const float blockSize = size / blocks;
+
+	for( unsigned int i = 0; i < buildings; i++ )
+	{
+		const float x = ( i % blocks ) * blockSize;
+		const float z = ( i / blocks ) * blockSize;
+		const float width = blockSize * RandomFloat( 0.3f, 0.8f );
+		const float height = RandomFloat( 20.f, 200.f );
+
+		for( unsigned int corner = 0; corner < 8; corner++ )
+		{
+			geometry->m_vertexBuffer->push_back( x + ( corner & 1 ? width : 0.f ) );
+			geometry->m_vertexBuffer->push_back( corner & 4 ? height : 0.f );
+			geometry->m_vertexBuffer->push_back( z + ( corner & 2 ? width : 0.f ) );
+		}
+
+		for( unsigned int index = 0; index < sizeof(faces) / sizeof(faces[0]); index++ )
+			geometry->m_indexBuffer->push_back( (unsigned short)( i * 8 + faces[index] ) );
+	}
+
+	geometry->m_vertexCount = buildings * 8;
+	geometry->m_indexCount = (unsigned int)geometry->m_indexBuffer->size();
+	geometry->m_primitiveCount = geometry->m_indexCount / 3;
+
+	return geometry;
+}
+
+//
+// CreateHeightfield
+// Generates rolling hills from a few octaves of sine waves
+//
+shared_ptr<Heightfield> CreateHeightfield( unsigned int size, float world )
+{
+	vector<unsigned short> heights( size * size );
+
+	// Random phases, so the seed changes the terrain
+	float phases[6];
+	for( unsigned int octave = 0; octave < 6; octave++ )
+		phases[octave] = RandomFloat( 0.f, 2.f * kmath::PI );
+
+	for( unsigned int z = 0; z < size; z++ )
+	{
+		for( unsigned int x = 0; x < size; x++ )
+		{
+			const float u = (float)x / ( size - 1 );
+			const float v = (float)z / ( size - 1 );
+
+			float height = 0.5f, amplitude = 0.25f, frequency = 2.f;
+			for( unsigned int octave = 0; octave < 3; octave++ )
+			{
+				height += amplitude * sinf( u * frequency * kmath::PI + phases[octave * 2] ) *
+									  cosf( v * frequency * kmath::PI + phases[octave * 2 + 1] );
+				amplitude *= 0.5f;
+				frequency *= 2.3f;
+			}
+
+			if ( height < 0.f ) height = 0.f;
+			if ( height > 1.f ) height = 1.f;
+			heights[ x + z * size ] = (unsigned short)( 255.f * height );
+		}
+	}
+
+	shared_ptr<Heightfield> heightfield( new Heightfield );
+	heightfield->create( &heights[0], size, size, (int)world, (int)world );
+	return heightfield;
+}
+
+//
+// CreateHierarchy
+// Splits the region among the children of its node, alternating the split axis, and
+// collects the leaves. The nodes are translated to the center of their region.
+//
+void CreateHierarchy( BenchRegion & region, unsigned int depth, unsigned int branch, unsigned int axis, vector<BenchRegion> & leaves )
+{
+	if ( !depth )
+	{
+		leaves.push_back( region );
+		return;
+	}
+
+	for( unsigned int i = 0; i < branch; i++ )
+	{
+		BenchRegion child = region;
+		if ( axis )
+		{
+			child.minZ = region.minZ + ( region.maxZ - region.minZ ) * i / branch;
+			child.maxZ = region.minZ + ( region.maxZ - region.minZ ) * ( i + 1 ) / branch;
+		}
+		else
+		{
+			child.minX = region.minX + ( region.maxX - region.minX ) * i / branch;
+			child.maxX = region.minX + ( region.maxX - region.minX ) * ( i + 1 ) / branch;
+		}
+
+		child.center = Point3( ( child.minX + child.maxX ) * 0.5f, 0.f, ( child.minZ + child.maxZ ) * 0.5f );
+		child.node.reset( new VisNode );
+		child.node->setTranslation( child.center - region.center );
+		region.node->attachChild( child.node );
+
+		CreateHierarchy( child, depth - 1, branch, !axis, leaves );
+	}
+}
+
+//
+// CreateScene
+// Generates the scene and attaches it to the scene graph
+//
+void CreateScene( SceneGraph & scene, const BenchOptions & options, BenchContents & contents )
+{
+	srand( options.seed );
+
+	unsigned int i;
+
+	// Everything is attached to a world node, which is added to the scene at the end
+	BenchRegion world;
+	world.node.reset( new VisNode );
+	world.center = Point3( options.world * 0.5f, 0.f, options.world * 0.5f );
+	world.minX = world.minZ = 0.f;
+	world.maxX = world.maxZ = options.world;
+	world.node->setTranslation( world.center );
+
+	vector<BenchRegion> leaves;
+	CreateHierarchy( world, options.depth, options.branch, 0, leaves );
+
+	// The shared geometries, from coarse to finely tessellated
+	vector< shared_ptr<Geometry> > geometries;
+	for( i = 0; i < options.geometries; i++ )
+	{
+		const unsigned int segments = 6 + ( i * 26 ) / options.geometries;
+		geometries.push_back( CreateSphere( RandomFloat( 2.f, 20.f ), segments, segments / 2 + 1 ) );
+	}
+
+	// The meshes are spread uniformly over the leaves of the hierarchy
+	vector< shared_ptr<VisMesh> > & meshes = contents.meshes;
+	for( i = 0; i < options.objects; i++ )
+	{
+		const BenchRegion & leaf = leaves[ rand() % leaves.size() ];
+		const Point3 position( RandomFloat( leaf.minX, leaf.maxX ), RandomFloat( 20.f, 250.f ), RandomFloat( leaf.minZ, leaf.maxZ ) );
+
+		shared_ptr<VisMesh> mesh( new VisMesh( geometries[ rand() % geometries.size() ] ) );
+		mesh->setTranslation( position - leaf.center );
+		mesh->setRotation( Quaternion( RandomFloat( 0.f, 2.f * kmath::PI ), Point3( 0.f, 1.f, 0.f ) ) );
+		leaf.node->attachChild( mesh );
+		meshes.push_back( mesh );
+	}
+
+	// The lights are carried by objects scattered over the world
+	for( i = 0; i < options.lights; i++ )
+	{
+		shared_ptr<PointLight> light( new PointLight );
+		light->setRange( options.lightRange > 0.f ? options.lightRange : options.world * 0.25f );
+
+		shared_ptr<Visible> lightObject( new Visible );
+		lightObject->setLight( light );
+		lightObject->setTranslation( Point3( RandomFloat( 0.f, options.world ), 300.f, RandomFloat( 0.f, options.world ) ) - world.center );
+		world.node->attachChild( lightObject );
+		contents.lights.push_back( lightObject );
+	}
+
+	// The terrain covers the world
+	if ( options.terrain >= 2 )
+	{
+		shared_ptr<Heightfield> heightfield = CreateHeightfield( options.terrain, options.world );
+
+		TerrainSettings settings;
+		settings.settingsFile = "scenebench";
+		settings.worldWidth = (unsigned int)options.world;
+		settings.worldHeight = (unsigned int)TERRAIN_HEIGHT;
+		settings.worldDepth = (unsigned int)options.world;
+		settings.lodType = options.cdlod ? TerrainSettings::CDLOD : TerrainSettings::GEOMIPMAP;
+		settings.blendType = TerrainSettings::BLEND_UNIFIED;
+		settings.maxScreenError = 4.f;
+		settings.maxTextureLayers = 0;
+
+		shared_ptr<Terrain> terrain( new Terrain );
+		if ( terrain->construct( settings, heightfield ) )
+		{
+			terrain->setTranslation( -world.center );
+			world.node->attachChild( terrain );
+			contents.terrain = terrain;
+		}
+		else
+			printf( "Failed to construct the terrain\n" );
+	}
+
+	// The BSP scene is a city block in the middle of the world
+	if ( options.bsp )
+	{
+		const float citySize = options.world * 0.25f;
+		shared_ptr<Geometry> buildings = CreateCity( options.bsp, citySize );
+		shared_ptr<BSPScene> city( new BSPScene( buildings ) );
+		city->setTranslation( Point3( -citySize * 0.5f, 0.f, -citySize * 0.5f ) );
+
+		// The boxes are coarse enough to be rasterized as they are
+		city->setOccluder( true );
+		city->setOccluderGeometry( buildings );
+		world.node->attachChild( city );
+
+		// Each building has eight corners, the first is the minimum and the last the maximum
+		const Point3 cityOrigin( ( options.world - citySize ) * 0.5f, 0.f, ( options.world - citySize ) * 0.5f );
+		const vector<float> & corners = *buildings->m_vertexBuffer;
+		for( i = 0; i < corners.size(); i += 24 )
+			contents.buildings.push_back( pair<Point3, Point3>( cityOrigin + Point3( corners[i], corners[i + 1], corners[i + 2] ),
+																cityOrigin + Point3( corners[i + 21], corners[i + 22], corners[i + 23] ) ) );
+	}
+
+	// Attaching the world attaches every node below it
+	scene.addNode( world.node );
+
+	// Animate some of the meshes
+	for( i = 0; i < options.animated; i++ )
+	{
+		const unsigned int index = (unsigned int)( (float)i * options.objects / options.animated );
+		scene.addController( shared_ptr<Controller>( new BenchController( meshes[index], RandomFloat( 0.5f, 2.f ), RandomFloat( 0.f, 2.f * kmath::PI ) ) ) );
+	}
+}
+
+//
+// MoveCamera
+// The camera circles the world twice over the run, weaving in and out and
+// looking ahead along the path
+//
+void MoveCamera( Camera & camera, float world, unsigned int frame, unsigned int frames )
+{
+	const float angle = 4.f * kmath::PI * frame / ( frames ? frames : 1 );
+	const float radius = world * ( 0.3f + 0.1f * sinf( angle * 3.f ) );
+
+	const Point3 position( world * 0.5f + radius * cosf( angle ),
+						   CAMERA_HEIGHT + 50.f * sinf( angle * 5.f ),
+						   world * 0.5f + radius * sinf( angle ) );
+
+	// Look along the tangent of the circle, turned a little toward the center
+	const float yaw = -angle - kmath::PI * 0.1f;
+	const float pitch = 0.15f;
+
+	camera.setTransform( position, Quaternion( yaw, Point3( 0.f, 1.f, 0.f ) ) * Quaternion( pitch, Point3( 1.f, 0.f, 0.f ) ) );
+}
+
+//
+// Tick
+// Runs a frame like GameEngine::OnTick(), without the input, physics and text display
+//
+void Tick( SceneGraph & scene, Render & render, Camera & camera, JobSystem * jobs, bool pipelined )
+{
+	Profiler::beginFrame();
+	KPROFILE( "scenebench::Tick" );
+
+	scene.setPipelined( pipelined );
+	scene.beginScene( &render, &camera, DELTA_TIME );
+
+	if ( pipelined )
+	{
+		// Update the next frame while this one is submitted
+		g_updateDeltaTime = DELTA_TIME;
+		Job * update = jobs->createJob( UpdateFrame, &scene );
+		jobs->run( update );
+
+		scene.endScene();
+
+		jobs->wait( update );
+		scene.endFrame();
+	}
+	else
+	{
+		scene.endScene();
+	}
+}
+
+//
+// UpdateFrame
+// Job which updates the scene in pipelined mode
+//
+void UpdateFrame( Job * job, void * data )
+{
+	SceneGraph * scene = reinterpret_cast<SceneGraph *>( data );
+	KPROFILE( "scenebench::UpdateFrame" );
+
+	scene->updateScene( g_updateDeltaTime );
+}
+
+//
+// PrintTime
+// Prints the mean, minimum, percentiles and maximum of a frame time
+//
+void PrintTime( const char * name, vector<BenchFrame> & frames, double BenchFrame::*field )
+{
+	vector<double> values;
+	double total = 0.0;
+	for( unsigned int i = 0; i < frames.size(); i++ )
+	{
+		values.push_back( frames[i].*field );
+		total += frames[i].*field;
+	}
+
+	sort( values.begin(), values.end() );
+
+	// Nearest rank percentiles
+	const unsigned int last = (unsigned int)values.size() - 1;
+	printf( "%-20s %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f\n", name,
+		total / values.size(),
+		values[0],
+		values[ (unsigned int)( last * 0.50 + 0.5 ) ],
+		values[ (unsigned int)( last * 0.90 + 0.5 ) ],
+		values[ (unsigned int)( last * 0.99 + 0.5 ) ],
+		values[last] );
+}
+
+//
+// PrintCount
+// Prints the mean, minimum and maximum of a frame counter
+//
+void PrintCount( const char * name, const vector<BenchFrame> & frames, unsigned int BenchFrame::*field )
+{
+	double total = 0.0;
+	unsigned int minimum = frames[0].*field, maximum = frames[0].*field;
+	for( unsigned int i = 0; i < frames.size(); i++ )
+	{
+		const unsigned int value = frames[i].*field;
+		total += value;
+		if ( value < minimum ) minimum = value;
+		if ( value > maximum ) maximum = value;
+	}
+
+	printf( "%-20s %10.0f %10d %10d\n", name, total / frames.size(), minimum, maximum );
+}
+
+//
+// Fail
+// Counts a failure of the check, and prints the first ones
+//
+void Fail( BenchCheck & check, const char * format, ... )
+{
+	if ( ++check.failures > CHECK_MAXIMUM_PRINTED )
+		return;
+
+	va_list args;
+	va_start( args, format );
+	printf( "%s check failed: ", check.name );
+	vprintf( format, args );
+	printf( "\n" );
+	va_end( args );
+}
+
+//
+// CheckSpatialIndex
+// Compares the meshes returned by the frustum and sphere queries of the spatial
+// index with the meshes whose bounds intersect the camera's frustum and a sphere
+// around the camera
+//
+void CheckSpatialIndex( SceneGraph & scene, const Camera & camera, const BenchContents & contents, float radius, BenchCheck & check )
+{
+	// The pipelined update may have moved objects since the frame was culled
+	SpatialIndex * index = scene.getSpatialIndex();
+	index->updateMoved();
+
+	vector<Visible *> inFrustum, inSphere;
+	const Bound sphere( camera.getTranslation(), radius );
+	index->queryFrustum( camera.getWorldPlanes(), FRUSTUM_PLANE_MASK_ALL, inFrustum );
+	index->querySphere( sphere, inSphere );
+
+	sort( inFrustum.begin(), inFrustum.end() );
+	sort( inSphere.begin(), inSphere.end() );
+
+	for( unsigned int i = 0; i < contents.meshes.size(); i++ )
+	{
+		Visible * mesh = contents.meshes[i].get();
+		const Bound & bound = mesh->getWorldBound();
+
+		const bool frustumExpected = camera.Cull( bound );
+		const bool frustumFound = binary_search( inFrustum.begin(), inFrustum.end(), mesh );
+		check.tests++;
+		if ( frustumExpected != frustumFound )
+			Fail( check, "mesh %d is %s by the frustum query", i, frustumFound ? "wrongly returned" : "missed" );
+
+		const float distance = ( bound.getCenter() - sphere.getCenter() ).getLength();
+		const bool sphereExpected = distance <= bound.getRadius() + radius;
+		const bool sphereFound = binary_search( inSphere.begin(), inSphere.end(), mesh );
+		check.tests++;
+		if ( sphereExpected != sphereFound )
+			Fail( check, "mesh %d is %s by the sphere query", i, sphereFound ? "wrongly returned" : "missed" );
+	}
+}
+
+//
+// CheckLights
+// Assigns the lights to every mesh with a grid of the default cell size, and with
+// a grid of a single cell which ranks every light. Both must select the same
+// lights, which must all reach the mesh, and the lights which reach the mesh
+// must only be left out when there are more than the maximum.
+//
+void CheckLights( SceneGraph & scene, const BenchContents & contents, float world, BenchCheck & check )
+{
+	if ( contents.lights.empty() )
+		return;
+
+	const unsigned int maximumLights = scene.getLightGrid()->getMaximumLights();
+	LightGrid grid, reference;
+	grid.setMaximumLights( maximumLights );
+	reference.setMaximumLights( maximumLights );
+	reference.setCellSize( world * 16.f );
+
+	vector<Point3> positions;
+	unsigned int i, j;
+	for( i = 0; i < contents.lights.size(); i++ )
+	{
+		Visible * lightObject = contents.lights[i].get();
+		const Matrix4 & transform = lightObject->getWorldTransform();
+		positions.push_back( Point3( transform.pos[0], transform.pos[1], transform.pos[2] ) );
+
+		grid.addLight( i, lightObject->getLight().get(), positions[i] );
+		reference.addLight( i, lightObject->getLight().get(), positions[i] );
+	}
+
+	grid.build();
+	reference.build();
+
+	vector<unsigned int> selected, expected;
+	for( i = 0; i < contents.meshes.size(); i++ )
+	{
+		const Bound & bound = contents.meshes[i]->getWorldBound();
+
+		selected.clear();
+		expected.clear();
+		grid.assign( bound, selected );
+		reference.assign( bound, expected );
+
+		check.tests++;
+		sort( selected.begin(), selected.end() );
+		sort( expected.begin(), expected.end() );
+		if ( selected != expected )
+		{
+			Fail( check, "mesh %d has %d lights from the grid, and %d from the single cell", i, (int)selected.size(), (int)expected.size() );
+			continue;
+		}
+
+		unsigned int reaching = 0;
+		for( j = 0; j < contents.lights.size(); j++ )
+		{
+			const float distance = ( positions[j] - bound.getCenter() ).getLength() - bound.getRadius();
+			const bool reaches = distance < contents.lights[j]->getLight()->getRange();
+			if ( reaches )
+				reaching++;
+
+			if ( !reaches && binary_search( selected.begin(), selected.end(), j ) )
+				Fail( check, "mesh %d is assigned light %d, which doesn't reach it", i, j );
+		}
+
+		const unsigned int count = reaching < maximumLights ? reaching : maximumLights;
+		if ( selected.size() != count )
+			Fail( check, "mesh %d is assigned %d lights, %d reach it", i, (int)selected.size(), reaching );
+	}
+}
+
+//
+// CheckOcclusion
+// Every mesh in the frustum which the occlusion buffer hides must have a building
+// between the camera and its center. The buildings are enlarged by two pixels of
+// the buffer, since it's rasterized at a low resolution.
+//
+void CheckOcclusion( SceneGraph & scene, const Camera & camera, const BenchContents & contents, BenchCheck & check )
+{
+	const OcclusionBuffer * buffer = scene.getOcclusionBuffer();
+	const Point3 & eye = camera.getTranslation();
+
+	// Size of a pixel at a distance of one, with the width of the screen covering the larger field of view
+	const float pixelSize = 2.f * tanf( CAMERA_FOV ) / buffer->getHeight();
+
+	for( unsigned int i = 0; i < contents.meshes.size(); i++ )
+	{
+		const Bound & bound = contents.meshes[i]->getWorldBound();
+		if ( !camera.Cull( bound ) || buffer->isVisible( bound ) )
+			continue;
+
+		const float margin = 2.f * pixelSize * ( bound.getCenter() - eye ).getLength();
+		const Point3 enlarge( margin, margin, margin );
+
+		bool hidden = false;
+		for( unsigned int j = 0; j < contents.buildings.size() && !hidden; j++ )
+			hidden = IntersectSegmentBox( eye, bound.getCenter(), contents.buildings[j].first - enlarge, contents.buildings[j].second + enlarge );
+
+		check.tests++;
+		if ( !hidden )
+			Fail( check, "mesh %d is hidden, but no building is in front of it", i );
+	}
+}
+
+//
+// CheckTerrain
+// The patches entirely in the frustum can't be culled by the quadtree, and every
+// active patch must be drawn
+//
+void CheckTerrain( SceneGraph & scene, const Camera & camera, const BenchContents & contents, bool cdlod, BenchCheck & check )
+{
+	if ( !contents.terrain )
+		return;
+
+	const Plane * planes = camera.getWorldPlanes();
+	const vector<TerrainPatch *> patches = contents.terrain->getTerrainPatches();
+	const int drawn = scene.getStatistics().terrainPatchesLastFrame;
+	bool anyInside = false;
+
+	for( unsigned int i = 0; i < patches.size(); i++ )
+	{
+		if ( !patches[i] ) continue;
+
+		// The bounds of the patches are in the terrain's space
+		Bound bound = patches[i]->getBound();
+		bound.transform( contents.terrain->getWorldTransform() );
+
+		bool inside = true;
+		for( int plane = 0; plane < MAX_FRUSTUM_PLANES && inside; plane++ )
+			inside = planes[plane].whichSide( bound ) == Plane::SIDE_FRONT;
+
+		if ( !inside ) continue;
+		anyInside = true;
+
+		// The chunked LOD selects its chunks without the patches
+		if ( cdlod ) continue;
+
+		check.tests++;
+		if ( !patches[i]->isVisible() )
+			Fail( check, "patch %d is in the frustum, but was culled", i );
+	}
+
+	check.tests++;
+	if ( cdlod && anyInside && !drawn )
+		Fail( check, "the terrain is in the frustum, but no chunk was drawn" );
+	else if ( !cdlod && drawn != (int)contents.terrain->getActivePatchCount() )
+		Fail( check, "%d patches were drawn out of %d active", drawn, contents.terrain->getActivePatchCount() );
+}
+
+//
+// IntersectSegmentBox
+// Returns true if the segment crosses the box (slab test)
+//
+bool IntersectSegmentBox( const Point3 & start, const Point3 & end, const Point3 & minimum, const Point3 & maximum )
+{
+	const Point3 direction = end - start;
+	float enter = 0.f, leave = 1.f;
+
+	for( int axis = 0; axis < 3; axis++ )
+	{
+		if ( fabsf( direction[axis] ) < 1e-6f )
+		{
+			if ( start[axis] < minimum[axis] || start[axis] > maximum[axis] )
+				return false;
+			continue;
+		}
+
+		float t0 = ( minimum[axis] - start[axis] ) / direction[axis];
+		float t1 = ( maximum[axis] - start[axis] ) / direction[axis];
+		if ( t0 > t1 ) std::swap( t0, t1 );
+
+		if ( t0 > enter ) enter = t0;
+		if ( t1 < leave ) leave = t1;
+		if ( enter > leave )
+			return false;
+	}
+
+	return true;
+}
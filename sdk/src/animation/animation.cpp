@@ -28,7 +28,8 @@ KIMPLEMENT_RTTI( Animation, Streamable );
 //
 // Copy Constructor
 //
-Animation::Animation( shared_ptr<Animation> animation )
+Animation::Animation( shared_ptr<Animation> animation ) :
+	m_interpolationError( animation->m_interpolationError )
 {
 	// Copy the tracks from the animation into our animation
 	for( vector< shared_ptr<AnimationTrack>  >::iterator iter = animation->m_animationTracks.begin();
@@ -94,21 +95,45 @@ bool Animation::advance( float deltaTime, Point3 & position, Quaternion & rotati
 		}
 	}	
 
-	// Iterate over the animation tracks to have it apply its keyframes
-	// to the input position and rotation.
-	for( vector< shared_ptr<AnimationTrack> >::iterator iter = m_animationTracks.begin();
-		 iter != m_animationTracks.end();
-		 iter++ )
+	// Retrieve the keyframes bounding the current time from every track, so their
+	// rotations can be interpolated in one batch
+	const unsigned int trackCount = (unsigned int)m_animationTracks.size();
+	m_trackInterpolants.resize( trackCount );
+	m_trackTranslations.resize( trackCount );
+	m_trackStartRotations.resize( trackCount );
+	m_trackEndRotations.resize( trackCount );
+	m_trackRotations.resize( trackCount );
+
+	unsigned int track;
+	for( track = 0; track < trackCount; track++ )
+	{
+		Keyframe key1, key2;
+		const float t = m_animationTracks[track]->getKeyframesAtTime( m_currentAnimationTime, key1, key2 );
+
+		// Linearlly interpolate the position
+		m_trackTranslations[track] = key1.m_translation + ( key2.m_translation - key1.m_translation ) * t;
+
+		m_trackInterpolants[track] = t;
+		m_trackStartRotations[track] = key1.m_rotation;
+		m_trackEndRotations[track] = key2.m_rotation;
+	}
+
+	// Interpolate the rotations. Keyframes which are close enough are nlerped instead of slerped.
+	Quaternion::slerpArray( &m_trackInterpolants[0], &m_trackStartRotations[0], &m_trackEndRotations[0],
+							&m_trackRotations[0], trackCount, m_interpolationError );
+
+	// Apply the interpolated keyframes to the input position and rotation
+	for( track = 0; track < trackCount; track++ )
 	{
-		// Retrieve the interpolated keyframe
-		Keyframe interpKey = ( *iter )->getInterpolatedKeyframe( m_currentAnimationTime );
+		// Normalize the rotation
+		m_trackRotations[track].normalise();
 
 		// Apply the keyframe (weighted) towards the position and rotation
 		// NOTE: Quaternion are identity quaternion by default ([X,Y,Z,W] = [0,0,0,1])
 		//		 So this is a slerp between the identity rotation and the final, interpolated rotation
 		// NOTE2: We explicitly check if the translation isn't zero, which means there is no change in translation
-		if ( interpKey.m_translation.getLength() ) position = interpKey.m_translation * fWeight;
-		rotation = rotation.slerp( fWeight, Quaternion(), interpKey.m_rotation );
+		if ( m_trackTranslations[track].getLength() ) position = m_trackTranslations[track] * fWeight;
+		rotation = Quaternion::slerp( fWeight, Quaternion(), m_trackRotations[track] );
 	}
 
 	return true;
@@ -79,6 +79,13 @@ public:
 	/// Gets the current animation time
 	float getAnimationTime() const;
 
+	/// Sets the maximum rotation error (in radians) allowed when interpolating the tracks. When the
+	/// keyframes are close enough, the cheaper nlerp is used instead of slerp. The default is 0 (always slerp).
+	void setInterpolationError( float maxError );
+
+	/// Gets the maximum rotation error allowed when interpolating the tracks
+	float getInterpolationError() const;
+
 	/// Advances the animation time (or rewinds if the deltaTime is negative).
 	/// This will adjust the animation time and apply the animation to the
 	/// inputs (position and rotation). The weighting is used to blend different animations.
@@ -109,6 +116,15 @@ private:
 	/// Enable or disable this animation
 	bool m_enabled;
 
+	/// Maximum rotation error (in radians) allowed when nlerp replaces slerp
+	float m_interpolationError;
+
+	/// Scratch arrays used to interpolate the keyframes of all the tracks in one batch
+	vector<float>		m_trackInterpolants;
+	vector<Point3>		m_trackTranslations;
+	vector<Quaternion>	m_trackStartRotations;
+	vector<Quaternion>	m_trackEndRotations;
+	vector<Quaternion>	m_trackRotations;
 };
 
 KIMPLEMENT_SCRIPT( Animation );
@@ -126,6 +142,7 @@ inline Animation::Animation()
 	, m_animationLength( 0 )
 	, m_canLoop( false )
 	, m_enabled( true )
+	, m_interpolationError( 0 )
 {}
 
 inline Animation::Animation( shared_ptr<AnimationTrack> defaultTrack )
@@ -134,6 +151,7 @@ inline Animation::Animation( shared_ptr<AnimationTrack> defaultTrack )
 	, m_animationLength( 0 )
 	, m_canLoop( false )
 	, m_enabled( true )
+	, m_interpolationError( 0 )
 { 
 	addTrack( defaultTrack );
 }
@@ -227,6 +245,22 @@ inline float Animation::getAnimationTime() const
 	return m_currentAnimationTime;
 }
 
+//
+// Animation::setInterpolationError
+//
+inline void Animation::setInterpolationError( float maxError )
+{
+	m_interpolationError = maxError;
+}
+
+//
+// Animation::getInterpolationError
+//
+inline float Animation::getInterpolationError() const
+{
+	return m_interpolationError;
+}
+
 } // Katana
 
 #endif // _ANIMATION_H
\ No newline at end of file
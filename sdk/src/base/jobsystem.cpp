@@ -0,0 +1,485 @@
+/*
+	Katana Engine
+	Copyright  2001-2004 Eric Bryant, Inc.
+
+	File:		jobsystem.cpp
+	Author:		Eric Bryant
+
+	Work-stealing job scheduler. Every thread (the main thread and the
+	worker threads) owns a queue of jobs. Threads run the jobs of their
+	own queue, newest first, and steal the oldest jobs from other queues
+	when their own queue is empty.
+*/
+
+#include "katana_core_includes.h"
+#include "log.h"
+#include "jobsystem.h"
+#include "system/systemthread.h"
+
+//
+// Macros
+//
+#ifdef _MSC_VER
+#define THREAD_LOCAL	__declspec(thread)
+#else
+#define THREAD_LOCAL	__thread
+#endif
+
+namespace Katana
+{
+
+///
+/// ParallelForRange
+/// Sub-range processed by a parallelFor() job
+///
+struct ParallelForRange
+{
+	ParallelForFunction	function;
+	void *				data;
+	unsigned int		begin;
+	unsigned int		end;
+	unsigned int		grainSize;
+};
+
+///
+/// Job
+/// A unit of work. The unfinished count starts at one for the job itself,
+/// and is incremented for every child job.
+///
+struct Job
+{
+	JobFunction			function;
+	void *				data;
+	Job *				parent;
+	volatile long		unfinished;
+	long				continuationCount;
+	Job *				continuations[JobSystem::MAX_CONTINUATIONS];
+	ParallelForRange	range;
+};
+
+///
+/// JobQueue
+/// Double ended queue of a thread, and the ring buffer its jobs are allocated from.
+/// The owner pushes and pops at the back, while the other threads steal from the front.
+///
+struct JobQueue
+{
+	SystemMutex		mutex;
+	Job *			jobs[JobSystem::MAX_JOBS_PER_THREAD];
+	unsigned int	front;
+	unsigned int	back;
+
+	Job				pool[JobSystem::MAX_JOBS_PER_THREAD];
+	volatile long	allocated;	/// Incremented atomically, the threads which aren't workers share the main thread's pool
+
+	unsigned int	random;		/// State of the generator which selects the steal victims
+
+	JobQueue( unsigned int seed ) : front( 0 ), back( 0 ), allocated( 0 ), random( seed * 2654435761u + 1 ) {}
+};
+
+///
+/// JobWorker
+/// A worker thread
+///
+struct JobWorker
+{
+	SystemThread	thread;
+	JobSystem *		system;
+	unsigned int	index;
+	bool			affinity;
+};
+
+}; // Katana
+
+//
+// Local Variables
+//
+static THREAD_LOCAL unsigned int g_threadIndex = 0;
+
+//
+// Local Functions
+//
+static unsigned int NextRandom( unsigned int & state );
+
+//
+// Constructor
+//
+JobSystem::JobSystem() :
+	m_workerCount( 0 ),
+	m_jobsAvailable( 0 ),
+	m_sleepingWorkers( 0 ),
+	m_running( 0 )
+{
+}
+
+//
+// Destructor
+//
+JobSystem::~JobSystem()
+{
+	shutdown();
+}
+
+//
+// initialize
+//
+bool JobSystem::initialize( unsigned int workerCount, bool setAffinity )
+{
+	if ( !m_queues.empty() )
+		return false;
+
+	const unsigned int processors = SystemThread::getProcessorCount();
+
+	// Leave one processor for the main thread
+	if ( !workerCount )
+		workerCount = processors - 1;
+	if ( workerCount > MAX_WORKER_THREADS )
+		workerCount = MAX_WORKER_THREADS;
+
+	// The thread calling initialize() is the main thread
+	g_threadIndex = 0;
+	if ( setAffinity )
+		SystemThread::setCurrentAffinity( 0 );
+
+	unsigned int i;
+	for( i = 0; i <= workerCount; i++ )
+		m_queues.push_back( new JobQueue( i ) );
+
+	m_jobsAvailable = new SystemSemaphore( 0 );
+	m_sleepingWorkers = 0;
+	m_running = 1;
+
+	// Every queue exists before the workers start stealing from them
+	m_workerCount = workerCount;
+
+	for( i = 0; i < workerCount; i++ )
+	{
+		JobWorker * worker = new JobWorker;
+		worker->system = this;
+		worker->index = i + 1;
+		worker->affinity = setAffinity && ( i + 1 < processors );
+
+		if ( !worker->thread.start( workerMain, worker ) )
+		{
+			// Keep going with the workers which did start. Their queues are empty,
+			// so stealing from the remaining ones is harmless.
+			KLOG( "JobSystem failed to start worker thread %d", i + 1 );
+			delete worker;
+			m_workerCount = i;
+			return false;
+		}
+
+		m_workers.push_back( worker );
+	}
+
+	KLOG( "JobSystem Initialization (%d worker threads, %d processors)", m_workerCount, processors );
+	return true;
+}
+
+//
+// shutdown
+//
+void JobSystem::shutdown()
+{
+	if ( m_queues.empty() )
+		return;
+
+	// Wake up every worker, so they see that they must exit
+	SystemThread::atomicExchange( &m_running, 0 );
+	m_jobsAvailable->signal( (unsigned int)m_workers.size() );
+
+	unsigned int i;
+	for( i = 0; i < m_workers.size(); i++ )
+	{
+		m_workers[i]->thread.join();
+		delete m_workers[i];
+	}
+
+	for( i = 0; i < m_queues.size(); i++ )
+		delete m_queues[i];
+
+	m_workers.clear();
+	m_queues.clear();
+	m_workerCount = 0;
+
+	delete m_jobsAvailable;
+	m_jobsAvailable = 0;
+}
+
+//
+// getThreadIndex
+//
+unsigned int JobSystem::getThreadIndex() const
+{
+	return g_threadIndex;
+}
+
+//
+// createJob
+//
+Job * JobSystem::createJob( JobFunction function, void * data )
+{
+	Job * job = allocateJob();
+	job->function = function;
+	job->data = data;
+	job->parent = 0;
+	job->unfinished = 1;
+	job->continuationCount = 0;
+	return job;
+}
+
+//
+// createChildJob
+//
+Job * JobSystem::createChildJob( Job * parent, JobFunction function, void * data )
+{
+	SystemThread::atomicIncrement( &parent->unfinished );
+
+	Job * job = createJob( function, data );
+	job->parent = parent;
+	return job;
+}
+
+//
+// addContinuation
+//
+bool JobSystem::addContinuation( Job * job, Job * continuation )
+{
+	if ( job->continuationCount >= MAX_CONTINUATIONS )
+		return false;
+
+	job->continuations[ job->continuationCount++ ] = continuation;
+	return true;
+}
+
+//
+// run
+//
+void JobSystem::run( Job * job )
+{
+	JobQueue & queue = *m_queues[ g_threadIndex ];
+
+	queue.mutex.lock();
+	if ( queue.back - queue.front >= MAX_JOBS_PER_THREAD )
+	{
+		// The queue is full, so execute the job right away
+		queue.mutex.unlock();
+		execute( job );
+		return;
+	}
+
+	queue.jobs[ queue.back++ % MAX_JOBS_PER_THREAD ] = job;
+	queue.mutex.unlock();
+
+	// Wake up a sleeping worker. The compare exchange is a full barrier, so either we see
+	// the worker sleeping, or the worker sees the job when it checks the queues again.
+	if ( SystemThread::atomicCompareExchange( &m_sleepingWorkers, 0, 0 ) > 0 )
+		m_jobsAvailable->signal();
+}
+
+//
+// isFinished
+//
+bool JobSystem::isFinished( const Job * job ) const
+{
+	// Read through a full barrier, so the job's results are visible once it's finished
+	return SystemThread::atomicCompareExchange( const_cast<volatile long *>( &job->unfinished ), 0, 0 ) == 0;
+}
+
+//
+// wait
+//
+void JobSystem::wait( const Job * job )
+{
+	while( !isFinished( job ) )
+	{
+		if ( Job * next = getJob() )
+			execute( next );
+		else
+			SystemThread::yield();
+	}
+}
+
+//
+// parallelFor
+//
+Job * JobSystem::parallelFor( ParallelForFunction function, void * data, unsigned int begin, unsigned int end, unsigned int grainSize )
+{
+	const unsigned int count = end > begin ? end - begin : 0;
+
+	// By default, split the range into a few pieces per thread to balance the load
+	if ( !grainSize )
+		grainSize = count / ( getThreadCount() * 4 );
+
+	// Limit the number of pieces, so the root job isn't recycled before it's finished
+	const unsigned int minimumGrainSize = count / ( MAX_JOBS_PER_THREAD / 4 ) + 1;
+	if ( grainSize < minimumGrainSize )
+		grainSize = minimumGrainSize;
+
+	Job * job = createJob( parallelForJob, this );
+	job->range.function = function;
+	job->range.data = data;
+	job->range.begin = begin;
+	job->range.end = end;
+	job->range.grainSize = grainSize;
+
+	run( job );
+	return job;
+}
+
+//
+// allocateJob
+//
+Job * JobSystem::allocateJob()
+{
+	// Threads which aren't workers use the main thread's queue, so they may allocate concurrently
+	JobQueue & queue = *m_queues[ g_threadIndex ];
+	const unsigned long index = (unsigned long)SystemThread::atomicIncrement( &queue.allocated ) - 1;
+	return &queue.pool[ index % MAX_JOBS_PER_THREAD ];
+}
+
+//
+// getJob
+//
+Job * JobSystem::getJob()
+{
+	const unsigned int threadIndex = g_threadIndex;
+	JobQueue & queue = *m_queues[ threadIndex ];
+
+	// Pop the newest job from our own queue, since its data is likely in the cache
+	queue.mutex.lock();
+	if ( queue.back != queue.front )
+	{
+		Job * job = queue.jobs[ --queue.back % MAX_JOBS_PER_THREAD ];
+		queue.mutex.unlock();
+		return job;
+	}
+	queue.mutex.unlock();
+
+	// Steal the oldest job of another queue, starting from a random one
+	const unsigned int threadCount = getThreadCount();
+	if ( threadCount < 2 )
+		return 0;
+
+	const unsigned int start = NextRandom( queue.random ) % threadCount;
+	for( unsigned int i = 0; i < threadCount; i++ )
+	{
+		const unsigned int victimIndex = ( start + i ) % threadCount;
+		if ( victimIndex == threadIndex )
+			continue;
+
+		JobQueue & victim = *m_queues[ victimIndex ];
+		victim.mutex.lock();
+		if ( victim.back != victim.front )
+		{
+			Job * job = victim.jobs[ victim.front++ % MAX_JOBS_PER_THREAD ];
+			victim.mutex.unlock();
+			return job;
+		}
+		victim.mutex.unlock();
+	}
+
+	return 0;
+}
+
+//
+// execute
+//
+void JobSystem::execute( Job * job )
+{
+	job->function( job, job->data );
+	finish( job );
+}
+
+//
+// finish
+//
+void JobSystem::finish( Job * job )
+{
+	if ( SystemThread::atomicDecrement( &job->unfinished ) != 0 )
+		return;
+
+	// Read the job before anyone can reuse it
+	Job * parent = job->parent;
+	for( long i = 0; i < job->continuationCount; i++ )
+		run( job->continuations[i] );
+
+	if ( parent )
+		finish( parent );
+}
+
+//
+// workerMain
+//
+void JobSystem::workerMain( void * data )
+{
+	JobWorker * worker = reinterpret_cast<JobWorker *>( data );
+	JobSystem * system = worker->system;
+
+	g_threadIndex = worker->index;
+	if ( worker->affinity )
+		SystemThread::setCurrentAffinity( worker->index );
+
+	while( system->m_running )
+	{
+		if ( Job * job = system->getJob() )
+		{
+			system->execute( job );
+			continue;
+		}
+
+		// Check the queues again after registering as sleeping, otherwise a job
+		// queued in between would not wake us up
+		SystemThread::atomicIncrement( &system->m_sleepingWorkers );
+		if ( Job * job = system->getJob() )
+		{
+			SystemThread::atomicDecrement( &system->m_sleepingWorkers );
+			system->execute( job );
+			continue;
+		}
+
+		system->m_jobsAvailable->wait();
+		SystemThread::atomicDecrement( &system->m_sleepingWorkers );
+	}
+}
+
+//
+// parallelForJob
+//
+void JobSystem::parallelForJob( Job * job, void * data )
+{
+	JobSystem * system = reinterpret_cast<JobSystem *>( data );
+	ParallelForRange range = job->range;
+
+	// Hand the upper halves to child jobs, which other threads may steal
+	while( range.end > range.begin && range.end - range.begin > range.grainSize )
+	{
+		const unsigned int middle = range.begin + ( range.end - range.begin ) / 2;
+
+		Job * child = system->createChildJob( job, parallelForJob, system );
+		child->range = range;
+		child->range.begin = middle;
+		system->run( child );
+
+		range.end = middle;
+	}
+
+	if ( range.end > range.begin )
+		range.function( range.data, range.begin, range.end );
+}
+
+// ----------------------------------------------------
+// Local Functions
+// ----------------------------------------------------
+
+//
+// NextRandom
+// Xorshift generator
+//
+unsigned int NextRandom( unsigned int & state )
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
@@ -0,0 +1,156 @@
+/*
+	Katana Engine
+	Copyright  2001-2004 Eric Bryant, Inc.
+
+	File:		jobsystem.h
+	Author:		Eric Bryant
+
+	Work-stealing job scheduler. Every thread (the main thread and the
+	worker threads) owns a queue of jobs. Threads run the jobs of their
+	own queue, newest first, and steal the oldest jobs from other queues
+	when their own queue is empty.
+*/
+
+#ifndef _JOBSYSTEM_H
+#define _JOBSYSTEM_H
+
+namespace Katana
+{
+
+//
+// Forward Declarations
+//
+struct Job;
+struct JobQueue;
+struct JobWorker;
+class SystemSemaphore;
+
+///
+/// JobFunction
+/// Function executed by a job. The job is passed so the function can create child jobs.
+///
+typedef void (*JobFunction)( Job * job, void * data );
+
+///
+/// ParallelForFunction
+/// Function executed by parallelFor() over a sub-range [begin, end)
+///
+typedef void (*ParallelForFunction)( void * data, unsigned int begin, unsigned int end );
+
+///
+/// JobSystem
+/// Schedules jobs across the worker threads. Jobs are created, optionally given child
+/// jobs and continuations, then run. A job is finished once its function and all of its
+/// children have returned; at that point its continuations are run. Threads waiting on
+/// a job execute other jobs instead of blocking.
+///
+/// Jobs are allocated from a ring buffer of the creating thread, and are recycled after
+/// MAX_JOBS_PER_THREAD allocations. A job must be finished (and no longer waited on) before
+/// its thread creates that many more jobs. Threads which aren't workers share the main
+/// thread's ring buffer, so this limit covers the jobs they create together.
+///
+class JobSystem
+{
+public:
+	enum
+	{
+		MAX_WORKER_THREADS = 63,		/// Maximum number of worker threads (besides the main thread)
+		MAX_JOBS_PER_THREAD = 4096,		/// Size of each thread's job ring buffer and queue
+		MAX_CONTINUATIONS = 8,			/// Maximum number of continuations per job
+	};
+
+public:
+	/// Constructor
+	JobSystem();
+
+	/// Destructor (stops the worker threads)
+	~JobSystem();
+
+	/// Starts the worker threads. A worker count of zero uses one worker per processor,
+	/// minus the main thread. If the affinity is enabled, the main thread is restricted to
+	/// the first processor, and each worker to the next one. Returns false if a worker failed
+	/// to start, in which case the jobs run on the threads which did.
+	bool initialize( unsigned int workerCount = 0, bool setAffinity = false );
+
+	/// Waits for the worker threads to finish their current job, and stops them.
+	void shutdown();
+
+	/// Returns the number of threads which execute jobs (the workers and the main thread)
+	unsigned int getThreadCount() const								{ return m_workerCount + 1; }
+
+	/// Returns the index of the calling thread (0 for the main thread, and for
+	/// any thread which isn't a worker)
+	unsigned int getThreadIndex() const;
+
+	/// Creates a job. It's not scheduled until run() is called.
+	Job * createJob( JobFunction function, void * data = 0 );
+
+	/// Creates a child job. The parent isn't finished until the child is finished. Children
+	/// must be created before the parent finishes (usually from within the parent's function).
+	Job * createChildJob( Job * parent, JobFunction function, void * data = 0 );
+
+	/// Adds a job which is run once the job is finished. Continuations must be added
+	/// before the job is run. Returns false if the job has too many continuations.
+	bool addContinuation( Job * job, Job * continuation );
+
+	/// Schedules the job on the calling thread's queue
+	void run( Job * job );
+
+	/// Returns whether the job (and all its children) are finished
+	bool isFinished( const Job * job ) const;
+
+	/// Executes other jobs until the job is finished
+	void wait( const Job * job );
+
+	/// Convenience function which runs the job and waits for it
+	void runAndWait( Job * job )									{ run( job ); wait( job ); }
+
+	/// Splits the range [begin, end) into sub-ranges of at most grainSize elements and
+	/// calls the function on them in parallel. A grain size of zero splits the range into
+	/// a few pieces per thread. The range is never split in more than MAX_JOBS_PER_THREAD / 4
+	/// pieces. The returned job is already running; wait on it.
+	Job * parallelFor( ParallelForFunction function, void * data, unsigned int begin, unsigned int end, unsigned int grainSize = 0 );
+
+private:
+	/// Allocates a job from the calling thread's ring buffer
+	Job * allocateJob();
+
+	/// Pops a job from the calling thread's queue, or steals one from another queue
+	Job * getJob();
+
+	/// Executes the job and finishes it
+	void execute( Job * job );
+
+	/// Decrements the job's unfinished count. Once it reaches zero, the continuations
+	/// are run and the parent is finished.
+	void finish( Job * job );
+
+	/// Main loop of the worker threads
+	static void workerMain( void * data );
+
+	/// Job function of parallelFor(), which splits the range in halves
+	static void parallelForJob( Job * job, void * data );
+
+private:
+	/// Number of worker threads
+	unsigned int		m_workerCount;
+
+	/// Queues and job ring buffers, one per thread (index 0 is the main thread)
+	vector<JobQueue *>	m_queues;
+
+	/// Worker threads
+	vector<JobWorker *>	m_workers;
+
+	/// Signaled when jobs are queued, to wake up the idle workers
+	SystemSemaphore *	m_jobsAvailable;
+
+	/// Number of workers which are sleeping on the semaphore
+	volatile long		m_sleepingWorkers;
+
+	/// Cleared when the workers must exit
+	volatile long		m_running;
+};
+
+}; // Katana
+
+#endif // _JOBSYSTEM_H
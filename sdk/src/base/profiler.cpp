@@ -0,0 +1,334 @@
+/*
+	Katana Engine
+	Copyright  2001-2004 Eric Bryant, Inc.
+
+	File:		profiler.cpp
+	Author:		Eric Bryant
+
+	Hierarchical CPU profiler. Code is instrumented with scoped markers,
+	which record their begin and end ticks into a ring buffer owned by
+	the calling thread. The events are summarized once per frame, and
+	can be saved in the Chrome trace format (chrome://tracing).
+*/
+
+#include <algorithm>
+#include "katana_core_includes.h"
+#include "kstring.h"
+#include "log.h"
+#include "profiler.h"
+#include "system/systemtimer.h"
+#include "system/systemthread.h"
+#include "system/systemfile.h"
+
+//
+// Macros
+//
+#ifdef _MSC_VER
+#define THREAD_LOCAL	__declspec(thread)
+#else
+#define THREAD_LOCAL	__thread
+#endif
+
+namespace Katana
+{
+
+///
+/// ProfileThread
+/// Ring buffer of the markers recorded by a thread. Only the owner writes to it.
+///
+struct ProfileThread
+{
+	ProfileEvent	events[Profiler::MAX_EVENTS_PER_THREAD];
+	unsigned long	count;						/// Number of markers recorded (the ring index is count % MAX_EVENTS_PER_THREAD)
+	unsigned long	stack[Profiler::MAX_DEPTH];	/// Marker numbers of the open markers
+	unsigned int	depth;						/// Number of open markers (including those too deep to be recorded)
+	unsigned int	index;						/// Registration order of the thread
+
+	ProfileThread( unsigned int threadIndex ) : count( 0 ), depth( 0 ), index( threadIndex ) {}
+};
+
+///
+/// ProfileEntry
+/// A summary entry, with the begin tick of its first call so the summary can be ordered
+///
+struct ProfileEntry
+{
+	ProfileSummary	summary;
+	kint64			first;
+
+	bool operator<( const ProfileEntry & entry ) const		{ return first < entry.first; }
+};
+
+}; // Katana
+
+//
+// Static Members
+//
+bool Profiler::m_enabled = false;
+
+//
+// Local Variables
+//
+static THREAD_LOCAL ProfileThread *	g_profileThread = 0;
+static ProfileThread *				g_threads[Profiler::MAX_THREADS];
+static volatile long				g_threadCount = 0;
+static volatile long				g_frame = 0;
+static kint64						g_frameBegin = 0;
+static float						g_frameMilliseconds = 0;
+static vector<ProfileSummary>		g_summary;
+
+//
+// Local Functions
+//
+static ProfileThread * GetProfileThread();
+static unsigned int GetThreadCount();
+
+//
+// setEnabled
+//
+void Profiler::setEnabled( bool enabled )
+{
+	if ( enabled && !m_enabled )
+		g_frameBegin = SystemTimer::GetTicks();
+
+	m_enabled = enabled;
+}
+
+//
+// begin
+//
+void Profiler::begin( const char * name )
+{
+	ProfileThread * thread = GetProfileThread();
+	if ( !thread )
+		return;
+
+	// Markers nested too deep are only counted, so they still close the right marker
+	if ( thread->depth < MAX_DEPTH )
+	{
+		ProfileEvent & event = thread->events[ thread->count % MAX_EVENTS_PER_THREAD ];
+		event.name = name;
+		event.depth = thread->depth;
+		event.frame = (unsigned int)g_frame;
+		event.end = 0;
+		event.begin = SystemTimer::GetTicks();
+
+		thread->stack[ thread->depth ] = thread->count++;
+	}
+
+	thread->depth++;
+}
+
+//
+// end
+//
+void Profiler::end()
+{
+	const kint64 ticks = SystemTimer::GetTicks();
+
+	ProfileThread * thread = GetProfileThread();
+	if ( !thread || !thread->depth )
+		return;
+
+	if ( --thread->depth >= MAX_DEPTH )
+		return;
+
+	// The marker is lost if the ring buffer wrapped around (or was reset) since it was opened
+	const unsigned long number = thread->stack[ thread->depth ];
+	if ( number < thread->count && thread->count - number <= MAX_EVENTS_PER_THREAD )
+		thread->events[ number % MAX_EVENTS_PER_THREAD ].end = ticks;
+}
+
+//
+// beginFrame
+//
+void Profiler::beginFrame()
+{
+	const kint64 ticks = SystemTimer::GetTicks();
+	const unsigned int frame = (unsigned int)g_frame;
+
+	SystemThread::atomicIncrement( &g_frame );
+
+	if ( g_frameBegin )
+		g_frameMilliseconds = (float)( ticks - g_frameBegin ) * 1000.0f / (float)SystemTimer::GetTicksPerSecond();
+	g_frameBegin = ticks;
+
+	g_summary.clear();
+	if ( !m_enabled )
+		return;
+
+	// Gather the markers of the previous frame, walking each ring buffer from the newest marker
+	vector<ProfileEntry> entries;
+	const float millisecondsPerTick = 1000.0f / (float)SystemTimer::GetTicksPerSecond();
+	const unsigned int threadCount = GetThreadCount();
+
+	for( unsigned int i = 0; i < threadCount; i++ )
+	{
+		ProfileThread * thread = g_threads[i];
+		if ( !thread )
+			continue;
+
+		const unsigned long count = thread->count;
+		const unsigned long oldest = count > MAX_EVENTS_PER_THREAD ? count - MAX_EVENTS_PER_THREAD : 0;
+
+		for( unsigned long number = count; number > oldest; number-- )
+		{
+			const ProfileEvent & event = thread->events[ ( number - 1 ) % MAX_EVENTS_PER_THREAD ];
+			if ( event.frame != frame )
+			{
+				if ( event.frame < frame )
+					break;
+				continue;
+			}
+			if ( !event.end )
+				continue;
+
+			// Accumulate the calls of the same marker at the same depth
+			unsigned int j;
+			for( j = 0; j < entries.size(); j++ )
+				if ( entries[j].summary.name == event.name && entries[j].summary.depth == event.depth )
+					break;
+
+			if ( j == entries.size() )
+			{
+				ProfileEntry entry;
+				entry.summary.name = event.name;
+				entry.summary.depth = event.depth;
+				entry.summary.calls = 0;
+				entry.summary.milliseconds = 0;
+				entry.first = event.begin;
+				entries.push_back( entry );
+			}
+
+			ProfileEntry & entry = entries[j];
+			entry.summary.calls++;
+			entry.summary.milliseconds += (float)( event.end - event.begin ) * millisecondsPerTick;
+			if ( event.begin < entry.first )
+				entry.first = event.begin;
+		}
+	}
+
+	std::sort( entries.begin(), entries.end() );
+
+	for( unsigned int j = 0; j < entries.size(); j++ )
+		g_summary.push_back( entries[j].summary );
+}
+
+//
+// getSummary
+//
+const vector<ProfileSummary> & Profiler::getSummary()
+{
+	return g_summary;
+}
+
+//
+// getFrameMilliseconds
+//
+float Profiler::getFrameMilliseconds()
+{
+	return g_frameMilliseconds;
+}
+
+//
+// saveChromeTrace
+//
+bool Profiler::saveChromeTrace( const char * fileName )
+{
+	SystemFile file( fileName, READ_WRITE, BINARY_FILE );
+	if ( !file.isValid() )
+	{
+		KLOG( "Profiler failed to save the trace %s", fileName );
+		return false;
+	}
+
+	// The trace timestamps are in microseconds
+	const double microsecondsPerTick = 1000000.0 / (double)SystemTimer::GetTicksPerSecond();
+	const unsigned int threadCount = GetThreadCount();
+
+	string trace = "{\"traceEvents\":[\n";
+	bool first = true;
+
+	for( unsigned int i = 0; i < threadCount; i++ )
+	{
+		ProfileThread * thread = g_threads[i];
+		if ( !thread )
+			continue;
+
+		const unsigned long count = thread->count;
+		const unsigned long oldest = count > MAX_EVENTS_PER_THREAD ? count - MAX_EVENTS_PER_THREAD : 0;
+
+		for( unsigned long number = oldest; number < count; number++ )
+		{
+			const ProfileEvent & event = thread->events[ number % MAX_EVENTS_PER_THREAD ];
+			if ( !event.end )
+				continue;
+
+			kstring line;
+			line.format( "%s{\"name\":\"%s\",\"cat\":\"katana\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+				first ? "" : ",\n",
+				event.name,
+				(double)event.begin * microsecondsPerTick,
+				(double)( event.end - event.begin ) * microsecondsPerTick,
+				thread->index );
+
+			trace += line;
+			first = false;
+		}
+	}
+
+	trace += "\n]}\n";
+
+	return file.writeBytes( (void *)trace.c_str(), (int)trace.size() );
+}
+
+//
+// reset
+//
+void Profiler::reset()
+{
+	const unsigned int threadCount = GetThreadCount();
+
+	for( unsigned int i = 0; i < threadCount; i++ )
+		if ( g_threads[i] )
+			g_threads[i]->count = 0;
+
+	g_summary.clear();
+}
+
+// ----------------------------------------------------
+// Local Functions
+// ----------------------------------------------------
+
+//
+// GetProfileThread
+// Returns the ring buffer of the calling thread, which is created the first time the
+// thread records a marker. Returns null once MAX_THREADS threads have been registered.
+//
+ProfileThread * GetProfileThread()
+{
+	if ( g_profileThread )
+		return g_profileThread;
+	if ( g_threadCount >= Profiler::MAX_THREADS )
+		return 0;
+
+	const long index = SystemThread::atomicIncrement( &g_threadCount ) - 1;
+	if ( index >= Profiler::MAX_THREADS )
+		return 0;
+
+	// The buffers are kept until the process exits, since the threads may outlive the profiler
+	g_profileThread = new ProfileThread( index );
+	g_threads[index] = g_profileThread;
+
+	return g_profileThread;
+}
+
+//
+// GetThreadCount
+// Returns the number of registered threads
+//
+unsigned int GetThreadCount()
+{
+	const long count = SystemThread::atomicCompareExchange( &g_threadCount, 0, 0 );
+	return count < Profiler::MAX_THREADS ? count : Profiler::MAX_THREADS;
+}
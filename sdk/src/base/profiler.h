@@ -0,0 +1,128 @@
+/*
+	Katana Engine
+	Copyright  2001-2004 Eric Bryant, Inc.
+
+	File:		profiler.h
+	Author:		Eric Bryant
+
+	Hierarchical CPU profiler. Code is instrumented with scoped markers,
+	which record their begin and end ticks into a ring buffer owned by
+	the calling thread. The events are summarized once per frame, and
+	can be saved in the Chrome trace format (chrome://tracing).
+*/
+
+#ifndef _PROFILER_H
+#define _PROFILER_H
+
+namespace Katana
+{
+
+///
+/// ProfileEvent
+/// A marker recorded by a thread. The ticks are SystemTimer ticks. The end is zero
+/// while the marker is still open.
+///
+struct ProfileEvent
+{
+	const char *	name;
+	kint64			begin;
+	kint64			end;
+	unsigned int	depth;
+	unsigned int	frame;
+};
+
+///
+/// ProfileSummary
+/// Total time spent in a marker during the last frame, over every call and thread
+///
+struct ProfileSummary
+{
+	const char *	name;
+	unsigned int	depth;
+	unsigned int	calls;
+	float			milliseconds;
+};
+
+///
+/// Profiler
+/// Collects the markers of every thread. Marker names must be string literals (or otherwise
+/// outlive the profiler), since only their pointers are recorded.
+///
+class Profiler
+{
+public:
+	enum
+	{
+		MAX_THREADS = 64,				/// Maximum number of threads which record markers
+		MAX_EVENTS_PER_THREAD = 16384,	/// Size of each thread's ring buffer
+		MAX_DEPTH = 32,					/// Maximum nesting of markers which are recorded
+	};
+
+public:
+	/// Enables or disables the recording of markers
+	static void setEnabled( bool enabled );
+
+	/// Returns whether markers are recorded
+	static bool isEnabled()											{ return m_enabled; }
+
+	/// Opens a marker on the calling thread
+	static void begin( const char * name );
+
+	/// Closes the last marker opened on the calling thread
+	static void end();
+
+	/// Starts a new frame, and summarizes the markers recorded during the previous frame.
+	/// Call it from the main thread while the other threads aren't recording.
+	static void beginFrame();
+
+	/// Returns the summary of the previous frame, ordered by the first call of each marker
+	static const vector<ProfileSummary> & getSummary();
+
+	/// Returns the duration of the previous frame
+	static float getFrameMilliseconds();
+
+	/// Saves the markers still held by the ring buffers in the Chrome trace format
+	static bool saveChromeTrace( const char * fileName );
+
+	/// Discards every recorded marker. Call it while the other threads aren't recording.
+	static void reset();
+
+private:
+	/// Whether markers are recorded
+	static bool m_enabled;
+};
+
+///
+/// ProfileScope
+/// Opens a marker for the lifetime of the object. Use the KPROFILE macro, which
+/// compiles out unless KATANA_PROFILER is defined.
+///
+class ProfileScope
+{
+public:
+	/// Constructor opens the marker
+	ProfileScope( const char * name ) : m_active( Profiler::isEnabled() )	{ if ( m_active ) Profiler::begin( name ); }
+
+	/// Destructor closes the marker
+	~ProfileScope()															{ if ( m_active ) Profiler::end(); }
+
+private:
+	/// Whether the marker was opened (so enabling the profiler mid-scope keeps the markers balanced)
+	bool m_active;
+};
+
+//
+// Macros
+//
+#define KPROFILE_CONCAT2( a, b )	a##b
+#define KPROFILE_CONCAT( a, b )		KPROFILE_CONCAT2( a, b )
+
+#ifdef KATANA_PROFILER
+#define KPROFILE( name )			Katana::ProfileScope KPROFILE_CONCAT( profileScope, __LINE__ )( name )
+#else
+#define KPROFILE( name )
+#endif
+
+}; // Katana
+
+#endif // _PROFILER_H
@@ -9,6 +9,7 @@
 	register tracing of objects, or debug rendering objects
 */
 
+#include "katana_config.h"
 #include "katana_core_includes.h"
 #include "katana_base_includes.h"
 #include "render/rendertypes.h"
@@ -18,7 +19,9 @@
 #include "scene/visible.h"
 #include "scene/camera.h"
 #include "scene/scenecontext.h"
+#include "scene/renderqueue.h"
 #include "scene/scenegraph.h"
+#include "base/profiler.h"
 #include "textdisplay.h"
 #include "debugoutput.h"
 
@@ -33,9 +36,19 @@ DebugOutput::DebugOutput()
 	, m_drawSceneStatistics( false )
 	, m_enableCulling( true )
 	, m_drawShadowVolumes( false )
+	, m_drawProfile( false )
 {
 }
 
+//
+// setDrawProfile
+//
+void DebugOutput::setDrawProfile( bool value )
+{
+	m_drawProfile = value;
+	Profiler::setEnabled( value );
+}
+
 //
 // addTrace
 //
@@ -53,17 +66,40 @@ void DebugOutput::OnDebugOutput( SceneContext * context )
 	for( vector<Visible *>::iterator iter_t = m_traceObjects.begin(); iter_t != m_traceObjects.end(); iter_t++ )
 		DisplayTraceInfo( (*iter_t), context );
 
+	// Vertical position of the next line of text
+	unsigned int y = 5;
+
 	// Display the scene statistics
 	if ( m_drawSceneStatistics )
 	{
 		const SceneStatistics & sceneStatistics = context->currentScene->getStatistics();
 		kstring fps; fps.format( "fps: %2.2f", sceneStatistics.framesPerSecond );
 //		kstring tps; tps.format( "tps: %2.2f", sceneStatistics.trianglesPerSecond );
-		kstring objects; objects.format( "objects: %d", sceneStatistics.objectsRenderedLastFrame );
-		context->textDisplay->drawText( 5, 5, fps.c_str() );
-		context->textDisplay->drawText( 5, 23, objects.c_str() );
+		kstring objects; objects.format( "objects: %d (culled: %d)", sceneStatistics.objectsRenderedLastFrame, sceneStatistics.objectsCulledLastFrame );
+		kstring draws; draws.format( "draws: %d  primitives: %d  states: %d",
+			sceneStatistics.drawCallsLastFrame, sceneStatistics.primitivesLastFrame, sceneStatistics.stateChangesLastFrame );
+		kstring times; times.format( "update: %2.2fms  cull: %2.2fms  sort: %2.2fms  render: %2.2fms",
+			sceneStatistics.updateMilliseconds, sceneStatistics.cullMilliseconds, sceneStatistics.sortMilliseconds, sceneStatistics.renderMilliseconds );
+		context->textDisplay->drawText( 5, y, fps.c_str() ); y += 18;
+		context->textDisplay->drawText( 5, y, objects.c_str() ); y += 18;
+		context->textDisplay->drawText( 5, y, draws.c_str() ); y += 18;
+		context->textDisplay->drawText( 5, y, times.c_str() ); y += 18;
 //		context->textDisplay->drawText( 5, 31, tps.c_str() );
 	}
+
+	// Display the profiler summary of the last frame, indenting the nested markers
+	if ( m_drawProfile )
+	{
+		const vector<ProfileSummary> & summary = Profiler::getSummary();
+		kstring frame; frame.format( "frame: %2.2fms", Profiler::getFrameMilliseconds() );
+		context->textDisplay->drawText( 5, y, frame.c_str() ); y += 18;
+
+		for( unsigned int i = 0; i < summary.size(); i++ )
+		{
+			kstring marker; marker.format( "%s: %2.2fms (%d)", summary[i].name, summary[i].milliseconds, summary[i].calls );
+			context->textDisplay->drawText( 5 + summary[i].depth * 12, y, marker.c_str() ); y += 18;
+		}
+	}
 }
 
 //
@@ -77,7 +113,7 @@ void DebugOutput::DisplayTraceInfo( Visible * object, SceneContext * context )
 		KLOG ("TRACE (%2.2fs): <%s>", context->gameTime * 0.001f, object->GetRTTI()->GetName() );
 
 		// Translation
-		KLOG2("translation: (%0.2f, %0.2f, %0.2f)", 
+		KLOG2("translation: (%0.2f, %0.2f, %0.2f)",
 				object->getTranslation().x, object->getTranslation().y, object->getTranslation().z );
 
 		// Rotation
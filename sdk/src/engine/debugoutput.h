@@ -73,6 +73,12 @@ public:
 	/// Gets whether to draw shadow volumes
 	bool getDrawShadowVolumes() const							{ return m_drawShadowVolumes; }
 
+	/// Sets whether to profile the frames and draw the profiler summary (see Profiler)
+	void setDrawProfile( bool value );
+
+	/// Gets whether to draw the profiler summary
+	bool getDrawProfile() const									{ return m_drawProfile; }
+
 	/// Adds a trace on a visible object. When it is dirty, it will write it's new transform to the log
 	void addTrace( Visible * object );
 
@@ -113,6 +119,9 @@ private:
 
 	/// Debugging value which determines whether to draw shadow volumes
 	bool	m_drawShadowVolumes;
+
+	/// Debugging value which determines whether the profiler summary of the last frame is displayed
+	bool	m_drawProfile;
 };
 
 }; // Katana
@@ -10,6 +10,7 @@
 	to receive events from the game engine.
 */
 
+#include "katana_config.h"
 #include "katana_core_includes.h"
 #include "katana_base_includes.h"
 #include "input/inputsystem.h"
@@ -17,11 +18,14 @@
 #include "render/rendertypes.h"
 #include "render/render.h"
 #include "scene/scenecontext.h"
+#include "scene/renderqueue.h"
 #include "scene/scenegraph.h"
 #include "scene/visible.h"
 #include "scene/visnode.h"
 #include "scene/camera.h"
 #include "system/systemtimer.h"
+#include "base/jobsystem.h"
+#include "base/profiler.h"
 #include "gameengine.h"
 #include "application.h"
 #include "textdisplay.h"
@@ -39,6 +43,8 @@ GameEngine::GameEngine()
 	, m_scaleDeltaTime( 1 )
 	, m_fixedStepTime( 0 )
 	, m_deltaTimeClamp( DELTA_TIME_CLAMP )
+	, m_pipelined( false )
+	, m_updateDeltaTime( 0 )
 {
 }
 
@@ -72,6 +78,7 @@ bool GameEngine::OnStartup()
 
 	// Setup the context for the scene graph
 	m_scene->setContext( m_currentRenderer.get(), m_currentCamera.get(), m_debug.get(), m_textdisplay.get() );
+	m_scene->setJobSystem( m_jobs.get() );
 
 	return true;
 }
@@ -81,6 +88,10 @@ bool GameEngine::OnStartup()
 //
 bool GameEngine::OnTick()
 {
+	// Summarize the markers of the previous frame, before any marker of this frame is opened
+	Profiler::beginFrame();
+	KPROFILE( "GameEngine::OnTick" );
+
 	// Get the delta time from the timer
 	float deltaTime = m_gameTimer.GetElapsedSeconds() * m_scaleDeltaTime;
 
@@ -99,14 +110,44 @@ bool GameEngine::OnTick()
 	// Clamp the delta time if it's above the threshold
 	if ( deltaTime > m_deltaTimeClamp ) deltaTime = m_deltaTimeClamp;
 
-	// Call update on all objects and gather the renderable objects
-	m_scene->beginScene( m_currentRenderer.get(), m_currentCamera.get(), deltaTime );
+	// Pipelining needs worker threads to run the update on. When it's switched on, no previous
+	// frame ran the update for this one, so the pipeline is primed by updating this frame
+	// synchronously (the scene graph does the same). When it's switched off, the last
+	// pipelined frame already ran this frame's update.
+	const bool pipelined = m_pipelined && m_jobs && m_jobs->getThreadCount() > 1;
+	const bool switched = pipelined != m_scene->getPipelined();
+	m_scene->setPipelined( pipelined );
 
-	// Step the physics system forward by the delta time
-	m_physics->integrate( deltaTime );
+	// Call update on all objects and gather the renderable objects. When pipelined,
+	// the objects were already updated while the previous frame was rendered.
+	m_scene->beginScene( m_currentRenderer.get(), m_currentCamera.get(), deltaTime );
 
-	// Actually render the objects
-	m_scene->endScene();
+	if ( pipelined )
+	{
+		if ( switched )
+			m_physics->integrate( deltaTime );
+
+		// Update the scene and the physics of the next frame while this one is rendered
+		m_updateDeltaTime = deltaTime;
+		Job * update = m_jobs->createJob( UpdateFrame, this );
+		m_jobs->run( update );
+
+		// Actually render the objects
+		m_scene->endScene();
+
+		// The update must be done before the input and scripts run again
+		m_jobs->wait( update );
+		m_scene->endFrame();
+	}
+	else
+	{
+		// Step the physics system forward by the delta time
+		if ( !switched )
+			m_physics->integrate( deltaTime );
+
+		// Actually render the objects
+		m_scene->endScene();
+	}
 
 	// Notify the text display system actually draw the text within its queue
 	m_textdisplay->flushTextQueue( &m_scene->getContext() );
@@ -115,4 +156,17 @@ bool GameEngine::OnTick()
 	m_fixedStepTime = 0.f;
 
 	return true;
-}
\ No newline at end of file
+}
+
+//
+// UpdateFrame
+//
+void GameEngine::UpdateFrame( Job * job, void * data )
+{
+	GameEngine * engine = reinterpret_cast<GameEngine *>( data );
+	KPROFILE( "GameEngine::UpdateFrame" );
+
+	// Same order as a regular tick: the scene, then the physics
+	engine->m_scene->updateScene( engine->m_updateDeltaTime );
+	engine->m_physics->integrate( engine->m_updateDeltaTime );
+}
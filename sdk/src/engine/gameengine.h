@@ -29,6 +29,8 @@ class ScriptEngine;
 class SystemTimer;
 class PhysicsSystem;
 class TextDisplay;
+class JobSystem;
+struct Job;
 
 //
 // Constants
@@ -73,6 +75,17 @@ public:
 	/// Returns the current renderer
 	shared_ptr<Render> getCurrentRender()			{ return m_currentRenderer; }
 
+	/// Enables pipelined frames: the next frame is updated on a worker thread while the
+	/// current frame is submitted. This needs a job system with worker threads, and the
+	/// nodes' updates must follow the contract of Visible::OnUpdate(). The frames are a tick
+	/// behind: each tick renders the update made during the previous tick. So the first tick after
+	/// this is switched on primes the pipeline by updating the scene and the physics synchronously
+	/// before building its frame, and the first tick after it's switched off skips its update.
+	void setPipelined( bool pipelined )				{ m_pipelined = pipelined; }
+
+	/// Returns whether the frames are pipelined
+	bool getPipelined() const						{ return m_pipelined; }
+
 public:
 
 	/// Event is called when the game engine is initially started
@@ -81,6 +94,10 @@ public:
 	/// Event is called when the game needs to update itself
 	virtual bool OnTick();
 
+protected:
+	/// Job which updates the scene and the physics of the next frame, in pipelined mode
+	static void UpdateFrame( Job * job, void * data );
+
 public:
 	/// Scene Graph Manager
 	shared_ptr<SceneGraph>		m_scene;
@@ -106,6 +123,9 @@ public:
 	/// The text display system
 	shared_ptr<TextDisplay>		m_textdisplay;
 
+	/// The job system
+	shared_ptr<JobSystem>		m_jobs;
+
 	/// High resolution game timer which keeps track of game time
 	SystemTimer					m_gameTimer;
 
@@ -120,6 +140,12 @@ public:
 
 	/// Clamp time. When the delta time is above this time, it will be clamped to this time
 	float						m_deltaTimeClamp;
+
+	/// Flags whether the frames are pipelined
+	bool						m_pipelined;
+
+	/// Delta time of the pipelined update
+	float						m_updateDeltaTime;
 };
 
 KIMPLEMENT_SCRIPT( GameEngine );
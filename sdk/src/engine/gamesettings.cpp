@@ -24,6 +24,9 @@ GameSettings::GameSettings()
 	, fullscreen( false )
 	, displayStartupDialog( true )
 	, fontTextureName( "./textures/font_arial_10pts.tga" )
+	, jobThreadCount( 0 )
+	, jobThreadAffinity( false )
+	, pipelinedFrames( false )
 {
 }
 
@@ -34,6 +37,9 @@ GameSettings::GameSettings( const char * szSettingsFile )
 	, fullscreen( false )
 	, displayStartupDialog( true )
 	, fontTextureName( "./textures/font_arial_10pts.tga" )
+	, jobThreadCount( 0 )
+	, jobThreadAffinity( false )
+	, pipelinedFrames( false )
 {
 	loadSettings( szSettingsFile );
 }
@@ -79,6 +85,12 @@ bool GameSettings::loadSettings( const char * szSettingsFile )
 			XML_Node font = engine.getNode( "font" );
 				fontTextureName = font.getAttributeString( "texture" );
 				fontCharacterSizes = font.getAttributeString( "fontwidths" );
+			XML_Node jobs = engine.getNode( "jobs" );
+				jobThreadCount = jobs.getAttributeInteger( "threads" );
+				jobThreadAffinity = jobs.getAttributeBoolean( "affinity" );
+				pipelinedFrames = jobs.getAttributeBoolean( "pipelined" );
+			XML_Node statistics = engine.getNode( "statistics" );
+				statisticsFile = statistics.getAttributeString( "file" );
 
 		// SCRIPT
 		XML_Node script = katana.getNode( "script" );
@@ -122,6 +134,12 @@ bool GameSettings::saveSettings( const char * szSettingsFile )
 			XML_Node font( engine, "font" );
 				font.addAttribute( "texture", fontTextureName );
 				font.addAttribute( "fontwidths", fontCharacterSizes );
+			XML_Node jobs( engine, "jobs" );
+				jobs.addAttribute( "threads", (long)jobThreadCount );
+				jobs.addAttribute( "affinity", jobThreadAffinity );
+				jobs.addAttribute( "pipelined", pipelinedFrames );
+			XML_Node statistics( engine, "statistics" );
+				statistics.addAttribute( "file", statisticsFile );
 
 		XML_Node script( katana, "script" );
 			script.addAttribute( "default", startupScript );
@@ -51,6 +51,10 @@ public:
 	bool					displayStartupDialog;	/// Boolean flag which determines whether to display the startup dialog
 	string					fontTextureName;		/// Default texture which contains font information
 	string					fontCharacterSizes;		/// Data file which stores the font sizes for each character
+	unsigned int			jobThreadCount;			/// Number of job system worker threads (zero uses one per extra processor)
+	bool					jobThreadAffinity;		/// Restricts each job system thread to its own processor
+	bool					pipelinedFrames;		/// Updates the next frame while the current one is rendered
+	string					statisticsFile;			/// Records the scene statistics of every frame to this file (.csv or .json)
 
 protected:
 	shared_ptr<SystemXML> m_settingsFile;		/// Internal settings file used to load and save the engine configuration
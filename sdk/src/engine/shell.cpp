@@ -11,12 +11,14 @@
 #include "katana_core_includes.h"
 #include "katana_base_includes.h"
 #include "base/comptr.h"
+#include "base/jobsystem.h"
 #include "system/systemtimer.h"
 #include "render/rendertypes.h"
 #include "render/render.h"
 #include "input/inputsystem.h"
 #include "physics/physicssystem.h"
 #include "scene/scenecontext.h"
+#include "scene/renderqueue.h"
 #include "scene/scenegraph.h"
 #include "system/systeminfo.h"
 #include "system/systemdialog.h"
@@ -33,6 +35,7 @@
 //
 const char * DEFAULT_KATANA_SCRIPT			= "katana.ks";
 const char * DEFAULT_KATANA_CONFIGURATION	= "katana.xml";
+const char * NULL_RENDER_DEVICE_NAME		= "Null Device";
 
 //
 // External variables
@@ -48,6 +51,7 @@ shared_ptr<GameSettings>	katana_settings;
 shared_ptr<Console>			katana_console;
 shared_ptr<PhysicsSystem>	katana_physics;
 shared_ptr<TextDisplay>		katana_text;
+shared_ptr<JobSystem>		katana_jobs;
 
 //
 // Katana_Init
@@ -69,8 +73,16 @@ bool Katana::Katana_Init()
 	SystemInfo systemInfo;
 	systemInfo.queryAllSystemInfo();
 
+	// The null renderer runs the engine without a GPU. It isn't one of the adapters, so it's
+	// only selected through the settings, and the startup dialog isn't displayed.
+	const bool nullRender = ( katana_settings->deviceName == NULL_RENDER_DEVICE_NAME );
+
 	// Only display the startup dialog if this setting is true
-	if ( katana_settings->displayStartupDialog )
+	if ( nullRender )
+	{
+		KLOG("Using the null render device");
+	}
+	else if ( katana_settings->displayStartupDialog )
 	{
 		// System dialog which queries the user on application resolution and startup script
 		KatanaStartupDialog dialog( systemInfo );
@@ -92,6 +104,9 @@ bool Katana::Katana_Init()
 	// Startup the Application
 	katana_app->Startup();
 
+	// Select the render driver
+	Info.eDriver = nullRender ? RenderInfo::NULL_RENDER : RenderInfo::DIRECTX9;
+
 	// Create the Renderer
 	if ( !katana_render ) katana_render.reset( Render::CreateRenderer( Info ) );
 
@@ -139,6 +154,19 @@ bool Katana::Katana_Init()
 	// Store the input system within the game engine
 	katana_game->m_input = katana_input;
 
+	// Create the Job System
+	if ( !katana_jobs ) katana_jobs.reset( new JobSystem );
+
+	// Start the worker threads
+	if ( !katana_jobs->initialize( katana_settings->jobThreadCount, katana_settings->jobThreadAffinity ) )
+	{
+		KLOG2( "!WARNING: Job System failed to start its worker threads" );
+	}
+
+	// Store the job system within the game engine
+	katana_game->m_jobs = katana_jobs;
+	katana_game->setPipelined( katana_settings->pipelinedFrames );
+
 	// Create the Physics System
 	if ( !katana_physics ) katana_physics.reset( new PhysicsSystem );
 
@@ -174,6 +202,12 @@ bool Katana::Katana_Init()
 	// Get a reference to the scene graph
 	if ( !katana_scene ) katana_scene = katana_game->getScene();
 
+	// Record the scene statistics of every frame, if requested
+	if ( !katana_settings->statisticsFile.empty() && !katana_scene->startRecording( katana_settings->statisticsFile.c_str() ) )
+	{
+		KLOG2( "!WARNING: Unable to record the scene statistics to '%s'.", katana_settings->statisticsFile.c_str() );
+	}
+
 	// Store the Render and Game within the Application
 	katana_app->m_spGameEngine = katana_game;
 	katana_app->m_spRenderer = katana_render;
@@ -224,6 +258,7 @@ bool Katana::Katana_Shutdown()
 	katana_debug.reset();
 	katana_settings.reset();
 	katana_console.reset();
+	katana_jobs.reset();
 
 	return true;
 }
\ No newline at end of file
@@ -43,5 +43,6 @@ extern shared_ptr<Katana::GameSettings>		katana_settings;	/// Global game engine
 extern shared_ptr<Katana::Console>			katana_console;		/// The katana engine debugging console
 extern shared_ptr<Katana::PhysicsSystem>	katana_physics;		/// The physics system
 extern shared_ptr<Katana::TextDisplay>		katana_text;		/// The text display system
+extern shared_ptr<Katana::JobSystem>		katana_jobs;		/// The job system which runs work on the worker threads
 
 #endif _SHELL_H
\ No newline at end of file
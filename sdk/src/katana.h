@@ -49,6 +49,15 @@
 	#include <boost/enable_shared_from_this.hpp>
 	using namespace boost;
 
+	// 64-bit integer types
+	#ifdef _MSC_VER
+		typedef __int64				kint64;
+		typedef unsigned __int64	kuint64;
+	#else
+		typedef long long			kint64;
+		typedef unsigned long long	kuint64;
+	#endif
+
 	// Include files for the Katana SDK
 
 	// Core Libraries
@@ -68,6 +77,8 @@
 	#include "base/kistream.h"
 	#include "base/kostream.h"
 	#include "base/kexport.h"
+	#include "base/jobsystem.h"
+	#include "base/profiler.h"
 
 	// Math Libraries
 	#include "math/kmath.h"
@@ -82,6 +93,8 @@
 	#include "system/systemtimer.h"
 	#include "system/systemfile.h"
 	#include "system/systemdialog.h"
+	#include "system/systemthread.h"
+	#include "system/systemmappedfile.h"
 
 	// Scripting Libraries
 	#include "script/scriptengine.h"
@@ -115,6 +128,7 @@
 	#include "scene/vismesh.h"
 	#include "scene/visnode.h"
 	#include "scene/scenecontext.h"
+	#include "scene/renderqueue.h"
 	#include "scene/scenegraph.h"
 	#include "scene/bspscene.h"
 	#include "scene/zone.h"
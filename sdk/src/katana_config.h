@@ -26,6 +26,11 @@
 #define LUABIND_NO_EXCEPTIONS
 
 
+// Define this parameter to compile the profiler markers (KPROFILE) into the engine. The markers only
+// record while the profiler is enabled (see Profiler::setEnabled), otherwise they cost a single branch.
+#define KATANA_PROFILER
+
+
 // Define one of these parameters to determine which Physics SDK to use. Currently, the choices are 
 // TOKAMAK and ODE (Open Dynamics Engine). You must define one (and only one) of these defines; currently
 // there is no option to NOT use a Physics Engine.
@@ -34,10 +39,24 @@
 
 
 // Define these paramters to determine which render systems to enable. They are displayed during the
-// initial dialog to allow clients to select the render device
+// initial dialog to allow clients to select the render device. The null device is the only one
+// available on non-Windows platforms; it counts submissions instead of drawing them.
 #define RENDER_NULL_DEVICE
+#ifdef _WIN32
 #define RENDER_DIRECTX8_DEVICE
 #define RENDER_DIRECTX9_DEVICE
+#endif
+
+
+// Define these parameters to enable the SIMD code paths within the math library. They default to
+// the instruction sets targeted by the compiler (/arch:SSE2, -msse2, -mavx2). If neither is defined,
+// portable scalar code is used.
+#if defined(__AVX2__)
+#define KATANA_MATH_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#define KATANA_MATH_SSE2
+#endif
 
 
 #endif // _KATANA_CONFIG_H_
\ No newline at end of file
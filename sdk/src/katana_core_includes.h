@@ -46,6 +46,15 @@ typedef void * WindowHandle;
 typedef void * DialogHandle;
 typedef void * FileHandle;
 
+// 64-bit integer types
+#ifdef _MSC_VER
+typedef __int64				kint64;
+typedef unsigned __int64	kuint64;
+#else
+typedef long long			kint64;
+typedef unsigned long long	kuint64;
+#endif
+
 // Use the katana namespace by default
 namespace Katana {};
 using namespace Katana;
@@ -8,14 +8,27 @@
 	Represents a bounding volume (used for culling).
 */
 
+#include "katana_config.h"
+#include "kmath.h"
 #include "point.h"
 #include "matrix.h"
 #include "quaternion.h"
 #include "bound.h"
 #include "box.h"
 #include <math.h>
+#if defined(KATANA_MATH_SSE2)
+#include <emmintrin.h>
+#endif
 using namespace Katana;
 
+//
+// Local Functions
+//
+#if defined(KATANA_MATH_SSE2)
+static void FindExtremalPointsSSE( const Point3 * points, unsigned int count, unsigned int * minIndex, unsigned int * maxIndex,
+								   float * minProjection, float * maxProjection );
+#endif
+
 //
 // Constructor
 //
@@ -56,6 +69,100 @@ void Bound::transform( const Matrix4 & transform )
 	m_center *= transform;
 }
 
+//
+// fit
+//
+void Bound::fit( const Point3 * points, unsigned int count )
+{
+	if ( !points || !count )
+		return;
+
+	// The extremal points are searched along the three axes and the four diagonals
+	const int DIRECTIONS = 7;
+	static const float directions[DIRECTIONS][3] =
+	{
+		{ 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 },
+		{ 1, 1, 1 }, { 1, 1, -1 }, { 1, -1, 1 }, { 1, -1, -1 },
+	};
+
+	unsigned int minIndex[DIRECTIONS], maxIndex[DIRECTIONS];
+	float minProjection[DIRECTIONS], maxProjection[DIRECTIONS];
+
+	int dir;
+	for( dir = 0; dir < DIRECTIONS; dir++ )
+	{
+		minIndex[dir] = maxIndex[dir] = 0;
+		minProjection[dir] = maxProjection[dir] = points[0].x * directions[dir][0] + points[0].y * directions[dir][1] + points[0].z * directions[dir][2];
+	}
+
+	unsigned int i = 1;
+
+#if defined(KATANA_MATH_SSE2)
+	// Search the groups of four points with SSE, the remaining points are searched below
+	if ( count >= 4 )
+	{
+		FindExtremalPointsSSE( points, count & ~3, minIndex, maxIndex, minProjection, maxProjection );
+		i = count & ~3;
+	}
+#endif
+
+	for( ; i < count; i++ )
+	{
+		const Point3 & point = points[i];
+		for( dir = 0; dir < DIRECTIONS; dir++ )
+		{
+			const float projection = point.x * directions[dir][0] + point.y * directions[dir][1] + point.z * directions[dir][2];
+			if ( projection < minProjection[dir] ) { minProjection[dir] = projection; minIndex[dir] = i; }
+			if ( projection > maxProjection[dir] ) { maxProjection[dir] = projection; maxIndex[dir] = i; }
+		}
+	}
+
+	// Start with the sphere spanning the most distant pair of extremal points
+	int widest = 0;
+	float widestSqr = -1.f;
+	for( dir = 0; dir < DIRECTIONS; dir++ )
+	{
+		const float distanceSqr = ( points[ maxIndex[dir] ] - points[ minIndex[dir] ] ).getSqrLength();
+		if ( distanceSqr > widestSqr )
+		{
+			widestSqr = distanceSqr;
+			widest = dir;
+		}
+	}
+
+	Point3 center = ( points[ minIndex[widest] ] + points[ maxIndex[widest] ] ) * 0.5f;
+	float radius = sqrtf( widestSqr ) * 0.5f;
+	float radiusSqr = radius * radius;
+
+	// Grow the sphere to include the points outside of it. The new sphere
+	// touches the far side of the old sphere and the outside point.
+	for( i = 0; i < count; i++ )
+	{
+		const Point3 offset = points[i] - center;
+		const float distanceSqr = offset.getSqrLength();
+		if ( distanceSqr > radiusSqr )
+		{
+			const float distance = sqrtf( distanceSqr );
+			const float newRadius = ( radius + distance ) * 0.5f;
+			center += offset * ( ( newRadius - radius ) / distance );
+			radius = newRadius;
+			radiusSqr = radius * radius;
+		}
+	}
+
+	// The growth steps overestimate the radius, so shrink it to the farthest point
+	float maxDistanceSqr = 0.f;
+	for( i = 0; i < count; i++ )
+	{
+		const float distanceSqr = ( points[i] - center ).getSqrLength();
+		if ( distanceSqr > maxDistanceSqr )
+			maxDistanceSqr = distanceSqr;
+	}
+
+	m_center = center;
+	m_radius = sqrtf( maxDistanceSqr );
+}
+
 //
 // expand
 //
@@ -78,4 +185,97 @@ void Bound::expand( const Bound & bv )
 		
 		set( m_center + t * centerDiff, (1 + bv.m_radius + m_radius)/2 );
 	}
-}
\ No newline at end of file
+}
+// ------------------------------------------------------
+// Local Functions
+// ------------------------------------------------------
+
+#if defined(KATANA_MATH_SSE2)
+
+//
+// FindExtremalPointsSSE
+// Searches the extremal points of Bound::fit along its seven directions, four points at a
+// time. The count must be a multiple of four. Each lane keeps its own extremes, which are
+// merged at the end. Ties go to the lowest index, so the result matches the scalar search.
+//
+void FindExtremalPointsSSE( const Point3 * points, unsigned int count, unsigned int * minIndex, unsigned int * maxIndex,
+							float * minProjection, float * maxProjection )
+{
+	const int DIRECTIONS = 7;
+
+	__m128 minValues[DIRECTIONS], maxValues[DIRECTIONS];
+	__m128i minIndices[DIRECTIONS], maxIndices[DIRECTIONS];
+
+	const __m128i step = _mm_set1_epi32( 4 );
+	__m128i indices = _mm_set_epi32( 3, 2, 1, 0 );
+
+	for( unsigned int i = 0; i < count; i += 4, indices = _mm_add_epi32( indices, step ) )
+	{
+		// Load four points (twelve floats) and split them into one register per coordinate
+		const float * p = &points[i].x;
+		const __m128 a = _mm_loadu_ps( p );			// x0 y0 z0 x1
+		const __m128 b = _mm_loadu_ps( p + 4 );		// y1 z1 x2 y2
+		const __m128 c = _mm_loadu_ps( p + 8 );		// z2 x3 y3 z3
+
+		const __m128 x = _mm_shuffle_ps( a, _mm_shuffle_ps( b, c, _MM_SHUFFLE( 1, 1, 2, 2 ) ), _MM_SHUFFLE( 2, 0, 3, 0 ) );
+		const __m128 y = _mm_shuffle_ps( _mm_shuffle_ps( a, b, _MM_SHUFFLE( 0, 0, 1, 1 ) ), _mm_shuffle_ps( b, c, _MM_SHUFFLE( 2, 2, 3, 3 ) ), _MM_SHUFFLE( 2, 0, 2, 0 ) );
+		const __m128 z = _mm_shuffle_ps( _mm_shuffle_ps( a, b, _MM_SHUFFLE( 1, 1, 2, 2 ) ), _mm_shuffle_ps( c, c, _MM_SHUFFLE( 3, 3, 0, 0 ) ), _MM_SHUFFLE( 2, 0, 2, 0 ) );
+
+		// Project them on the axes and the diagonals
+		const __m128 xPlusY = _mm_add_ps( x, y );
+		const __m128 xMinusY = _mm_sub_ps( x, y );
+		const __m128 projections[DIRECTIONS] =
+		{
+			x, y, z,
+			_mm_add_ps( xPlusY, z ), _mm_sub_ps( xPlusY, z ), _mm_add_ps( xMinusY, z ), _mm_sub_ps( xMinusY, z ),
+		};
+
+		for( int dir = 0; dir < DIRECTIONS; dir++ )
+		{
+			if ( i == 0 )
+			{
+				minValues[dir] = maxValues[dir] = projections[dir];
+				minIndices[dir] = maxIndices[dir] = indices;
+				continue;
+			}
+
+			const __m128i less = _mm_castps_si128( _mm_cmplt_ps( projections[dir], minValues[dir] ) );
+			const __m128i greater = _mm_castps_si128( _mm_cmpgt_ps( projections[dir], maxValues[dir] ) );
+
+			minValues[dir] = _mm_min_ps( projections[dir], minValues[dir] );
+			maxValues[dir] = _mm_max_ps( projections[dir], maxValues[dir] );
+			minIndices[dir] = _mm_or_si128( _mm_and_si128( less, indices ), _mm_andnot_si128( less, minIndices[dir] ) );
+			maxIndices[dir] = _mm_or_si128( _mm_and_si128( greater, indices ), _mm_andnot_si128( greater, maxIndices[dir] ) );
+		}
+	}
+
+	// Merge the extremes of the four lanes
+	for( int dir = 0; dir < DIRECTIONS; dir++ )
+	{
+		float minLanes[4], maxLanes[4];
+		unsigned int minLaneIndices[4], maxLaneIndices[4];
+		_mm_storeu_ps( minLanes, minValues[dir] );
+		_mm_storeu_ps( maxLanes, maxValues[dir] );
+		_mm_storeu_si128( (__m128i *)minLaneIndices, minIndices[dir] );
+		_mm_storeu_si128( (__m128i *)maxLaneIndices, maxIndices[dir] );
+
+		minProjection[dir] = minLanes[0]; minIndex[dir] = minLaneIndices[0];
+		maxProjection[dir] = maxLanes[0]; maxIndex[dir] = maxLaneIndices[0];
+
+		for( int lane = 1; lane < 4; lane++ )
+		{
+			if ( minLanes[lane] < minProjection[dir] || ( minLanes[lane] == minProjection[dir] && minLaneIndices[lane] < minIndex[dir] ) )
+			{
+				minProjection[dir] = minLanes[lane];
+				minIndex[dir] = minLaneIndices[lane];
+			}
+			if ( maxLanes[lane] > maxProjection[dir] || ( maxLanes[lane] == maxProjection[dir] && maxLaneIndices[lane] < maxIndex[dir] ) )
+			{
+				maxProjection[dir] = maxLanes[lane];
+				maxIndex[dir] = maxLaneIndices[lane];
+			}
+		}
+	}
+}
+
+#endif
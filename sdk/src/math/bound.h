@@ -72,6 +72,12 @@ public:
 	/// Expands the bounding region by another bounding region (sphere expansion)
 	void expand( const Bound & bv );
 
+	/// Fits a tight sphere around the set of points. The initial sphere spans the two
+	/// most distant extremal points along seven directions, and is grown to include
+	/// every point (Ritter's method). The radius is then shrunk to the farthest point.
+	/// The result is usually within a few percent of the minimal sphere.
+	void fit( const Point3 * points, unsigned int count );
+
 	/// Transform the bounding region. Note as the bounds internally is a sphere,
 	/// it is currently unaffected by the rotation, however, the center will be rotated
 	void transform( const Matrix4 & transform );
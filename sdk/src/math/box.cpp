@@ -5,15 +5,28 @@
 	File:		box.cpp
 	Author:		Eric Bryant
 
-	Axis Aligned Bounding Box
-	TODO: Object Aligned Bounding Box
+	Axis Aligned and Oriented Bounding Boxes
 */
 
+#include "kmath.h"
 #include "point.h"
+#include "matrix.h"
 #include "bound.h"
 #include "box.h"
+#include <math.h>
 using namespace Katana;
 
+// ----------------------------------------------------
+// Local Functions
+// ----------------------------------------------------
+
+static void JacobiEigenvectors( double covariance[3][3], double eigenvectors[3][3] );
+static void ProjectPoints( const Point3 * points, unsigned int count, const Point3 axis[3], Point3 & minimum, Point3 & maximum );
+
+// ----------------------------------------------------
+// AxisAlignedBox
+// ----------------------------------------------------
+
 //
 // AxisAlignedBox::getOctant
 //
@@ -60,4 +73,222 @@ AxisAlignedBox AxisAlignedBox::getOctant( Octant octant )
 	}
 
 	return AxisAlignedBox( vNewCenter - vExtents, vNewCenter + vExtents );
-}
\ No newline at end of file
+}
+
+// ----------------------------------------------------
+// OrientedBox
+// ----------------------------------------------------
+
+//
+// OrientedBox::transform
+//
+void OrientedBox::transform( const Matrix4 & transform )
+{
+	m_center *= transform;
+
+	for( int i = 0; i < 3; i++ )
+	{
+		// Rotate the axis, and move any scale into the extents
+		Point3 axis = m_axis[i] * transform;
+		const float length = axis.getLength();
+		if ( length > kmath::EPSILSON )
+		{
+			m_axis[i] = axis * ( 1.f / length );
+			m_extents[i] *= length;
+		}
+	}
+}
+
+//
+// OrientedBox::fit
+//
+void OrientedBox::fit( const Point3 * points, unsigned int count )
+{
+	if ( !points || !count )
+		return;
+
+	// Compute the mean of the points
+	double mean[3] = { 0, 0, 0 };
+	unsigned int i;
+	for( i = 0; i < count; i++ )
+	{
+		mean[0] += points[i].x;
+		mean[1] += points[i].y;
+		mean[2] += points[i].z;
+	}
+	mean[0] /= count; mean[1] /= count; mean[2] /= count;
+
+	// Compute the covariance matrix of the points
+	double covariance[3][3] = { { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 } };
+	for( i = 0; i < count; i++ )
+	{
+		const double d[3] = { points[i].x - mean[0], points[i].y - mean[1], points[i].z - mean[2] };
+		for( int row = 0; row < 3; row++ )
+			for( int col = row; col < 3; col++ )
+				covariance[row][col] += d[row] * d[col];
+	}
+	covariance[1][0] = covariance[0][1];
+	covariance[2][0] = covariance[0][2];
+	covariance[2][1] = covariance[1][2];
+
+	// The eigenvectors of the covariance matrix are the principal axes of the points
+	double eigenvectors[3][3];
+	JacobiEigenvectors( covariance, eigenvectors );
+
+	Point3 axis[3];
+	axis[0] = Point3( (float)eigenvectors[0][0], (float)eigenvectors[1][0], (float)eigenvectors[2][0] );
+	axis[1] = Point3( (float)eigenvectors[0][1], (float)eigenvectors[1][1], (float)eigenvectors[2][1] );
+	axis[0].getNormalized();
+	axis[1].getNormalized();
+
+	// Keep the axes orthonormal and right handed
+	axis[2] = axis[0].getCross( axis[1] );
+	axis[2].getNormalized();
+	axis[1] = axis[2].getCross( axis[0] );
+
+	Point3 minimum, maximum;
+	ProjectPoints( points, count, axis, minimum, maximum );
+
+	// The principal axes aren't always the best fit (for example, with boxes whose
+	// points are evenly distributed), so fall back to the axis aligned box if it's smaller
+	Point3 worldAxis[3] = { Point3( 1, 0, 0 ), Point3( 0, 1, 0 ), Point3( 0, 0, 1 ) };
+	Point3 worldMinimum, worldMaximum;
+	ProjectPoints( points, count, worldAxis, worldMinimum, worldMaximum );
+
+	const Point3 size = maximum - minimum;
+	const Point3 worldSize = worldMaximum - worldMinimum;
+	if ( worldSize.x * worldSize.y * worldSize.z <= size.x * size.y * size.z )
+	{
+		axis[0] = worldAxis[0]; axis[1] = worldAxis[1]; axis[2] = worldAxis[2];
+		minimum = worldMinimum;
+		maximum = worldMaximum;
+	}
+
+	// The center is the middle of the projected extents, transformed back to world space
+	const Point3 middle = ( minimum + maximum ) * 0.5f;
+	set( axis[0] * middle.x + axis[1] * middle.y + axis[2] * middle.z,
+		 axis[0], axis[1], axis[2],
+		 ( maximum - minimum ) * 0.5f );
+}
+
+//
+// OrientedBox::getCorners
+//
+void OrientedBox::getCorners( Point3 * corners ) const
+{
+	const Point3 x = m_axis[0] * m_extents.x;
+	const Point3 y = m_axis[1] * m_extents.y;
+	const Point3 z = m_axis[2] * m_extents.z;
+
+	corners[0] = m_center - x - y - z;		// Bottom Front Left
+	corners[1] = m_center - x + y - z;		// Top Front Left
+	corners[2] = m_center + x + y - z;		// Top Front Right
+	corners[3] = m_center + x - y - z;		// Bottom Front Right
+	corners[4] = m_center + x - y + z;		// Bottom Back Right
+	corners[5] = m_center + x + y + z;		// Top Back Right
+	corners[6] = m_center - x + y + z;		// Top Back Left
+	corners[7] = m_center - x - y + z;		// Bottom Back Left
+}
+
+// ----------------------------------------------------
+// Local Functions
+// ----------------------------------------------------
+
+//
+// JacobiEigenvectors
+// Diagonalizes the symmetric matrix with Jacobi rotations. On return, the columns
+// of the eigenvectors matrix are sorted by decreasing eigenvalue.
+//
+void JacobiEigenvectors( double a[3][3], double v[3][3] )
+{
+	int i, j;
+	for( i = 0; i < 3; i++ )
+		for( j = 0; j < 3; j++ )
+			v[i][j] = ( i == j ) ? 1.0 : 0.0;
+
+	for( int sweep = 0; sweep < 32; sweep++ )
+	{
+		// Stop once the off diagonal elements are negligible
+		const double offDiagonal = fabs( a[0][1] ) + fabs( a[0][2] ) + fabs( a[1][2] );
+		const double diagonal = fabs( a[0][0] ) + fabs( a[1][1] ) + fabs( a[2][2] );
+		if ( offDiagonal <= 1e-12 * diagonal || offDiagonal == 0.0 )
+			break;
+
+		for( int p = 0; p < 2; p++ )
+		{
+			for( int q = p + 1; q < 3; q++ )
+			{
+				if ( a[p][q] == 0.0 )
+					continue;
+
+				// Compute the rotation which zeros a[p][q]
+				const double theta = ( a[q][q] - a[p][p] ) / ( 2.0 * a[p][q] );
+				double t = 1.0 / ( fabs( theta ) + sqrt( theta * theta + 1.0 ) );
+				if ( theta < 0.0 ) t = -t;
+				const double c = 1.0 / sqrt( t * t + 1.0 );
+				const double s = t * c;
+
+				// Apply the rotation to the matrix (A' = Jt * A * J)
+				for( int k = 0; k < 3; k++ )
+				{
+					const double akp = a[k][p], akq = a[k][q];
+					a[k][p] = c * akp - s * akq;
+					a[k][q] = s * akp + c * akq;
+				}
+				for( int k = 0; k < 3; k++ )
+				{
+					const double apk = a[p][k], aqk = a[q][k];
+					a[p][k] = c * apk - s * aqk;
+					a[q][k] = s * apk + c * aqk;
+				}
+
+				// Accumulate the rotation into the eigenvectors
+				for( int k = 0; k < 3; k++ )
+				{
+					const double vkp = v[k][p], vkq = v[k][q];
+					v[k][p] = c * vkp - s * vkq;
+					v[k][q] = s * vkp + c * vkq;
+				}
+			}
+		}
+	}
+
+	// Sort the eigenvectors by decreasing eigenvalue
+	for( i = 0; i < 2; i++ )
+	{
+		int largest = i;
+		for( j = i + 1; j < 3; j++ )
+			if ( a[j][j] > a[largest][largest] )
+				largest = j;
+
+		if ( largest != i )
+		{
+			double temp = a[i][i]; a[i][i] = a[largest][largest]; a[largest][largest] = temp;
+			for( int k = 0; k < 3; k++ )
+			{
+				temp = v[k][i]; v[k][i] = v[k][largest]; v[k][largest] = temp;
+			}
+		}
+	}
+}
+
+//
+// ProjectPoints
+// Finds the minimum and maximum of the points projected onto the axes
+//
+void ProjectPoints( const Point3 * points, unsigned int count, const Point3 axis[3], Point3 & minimum, Point3 & maximum )
+{
+	minimum = maximum = Point3( points[0].getDot( axis[0] ), points[0].getDot( axis[1] ), points[0].getDot( axis[2] ) );
+
+	for( unsigned int i = 1; i < count; i++ )
+	{
+		const Point3 projected( points[i].getDot( axis[0] ), points[i].getDot( axis[1] ), points[i].getDot( axis[2] ) );
+
+		if ( projected.x < minimum.x ) minimum.x = projected.x;
+		if ( projected.x > maximum.x ) maximum.x = projected.x;
+		if ( projected.y < minimum.y ) minimum.y = projected.y;
+		if ( projected.y > maximum.y ) maximum.y = projected.y;
+		if ( projected.z < minimum.z ) minimum.z = projected.z;
+		if ( projected.z > maximum.z ) maximum.z = projected.z;
+	}
+}
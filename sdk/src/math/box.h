@@ -5,8 +5,7 @@
 	File:		box.h
 	Author:		Eric Bryant
 
-	Axis Aligned Bounding Box
-	TODO: Object Aligned Bounding Box
+	Axis Aligned and Oriented Bounding Boxes
 */
 
 #ifndef _BOX_H
@@ -17,6 +16,7 @@ namespace Katana
 
 // Forward Declarations
 class Bound;
+class Matrix4;
 
 /// Useful for octree construction, these are the octants
 /// of an octree
@@ -88,6 +88,56 @@ public:
 	Point3 m_minimum, m_maximum; /// Extents of the bounding box
 };
 
+///
+/// OrientedBox
+/// An Oriented Bounding Box, which is represented by a center, three orthonormal
+/// axes and the half lengths of the box along each axis. Unlike the bounding sphere,
+/// it follows the rotation of the object, so long thin objects (walls, bridges, etc.)
+/// are tightly enclosed.
+///
+class OrientedBox
+{
+public:
+	/// Default Constructor (which creates an invalid box)
+	OrientedBox();
+
+	/// Constructor which takes a center, the axes and the half lengths along them
+	OrientedBox( const Point3 & center, const Point3 & axisX, const Point3 & axisY, const Point3 & axisZ, const Point3 & extents );
+
+	/// Constructor which takes an Axis Aligned Bounding Box
+	OrientedBox( const AxisAlignedBox & aabb );
+
+	/// Sets the center, the axes and the half lengths along them
+	void set( const Point3 & center, const Point3 & axisX, const Point3 & axisY, const Point3 & axisZ, const Point3 & extents );
+
+	/// Returns whether the box is valid (a flat box is valid, but a point isn't)
+	bool isValid() const									{ return m_extents.x > 0 || m_extents.y > 0 || m_extents.z > 0; }
+
+	/// Returns the radius of the sphere which encloses the box
+	float getRadius() const									{ return m_extents.getLength(); }
+
+	/// Returns the half length of the box projected onto a direction. This is the
+	/// "radius" of the box to use when testing it against a plane with this normal.
+	float getProjectedRadius( const Point3 & direction ) const;
+
+	/// Transforms the box by a matrix. The scale of the matrix (if any) is moved
+	/// into the extents, so the axes stay unit length.
+	void transform( const Matrix4 & transform );
+
+	/// Fits the box around the set of points. The axes are the principal components
+	/// of the points (the eigenvectors of their covariance matrix). If the axis aligned
+	/// box of the points is smaller, it is used instead.
+	void fit( const Point3 * points, unsigned int count );
+
+	/// Given a pointer to an array of points, it will fill it with the 8 corners of the box
+	void getCorners( Point3 * corners ) const;
+
+public:
+	Point3 m_center;		/// Center of the box
+	Point3 m_axis[3];		/// Orthonormal axes of the box
+	Point3 m_extents;		/// Half lengths of the box along each axis
+};
+
 //
 // Inline
 //
@@ -194,6 +244,52 @@ inline void AxisAlignedBox::getCorners( Point3 * corners, bool bCloseBox )
 	}
 }
 
+//
+// OrientedBox::constructors
+//
+inline OrientedBox::OrientedBox() :
+	m_center( 0, 0, 0 ), m_extents( 0, 0, 0 )
+{
+	m_axis[0] = Point3( 1, 0, 0 );
+	m_axis[1] = Point3( 0, 1, 0 );
+	m_axis[2] = Point3( 0, 0, 1 );
+}
+
+inline OrientedBox::OrientedBox( const Point3 & center, const Point3 & axisX, const Point3 & axisY, const Point3 & axisZ, const Point3 & extents )
+{
+	set( center, axisX, axisY, axisZ, extents );
+}
+
+inline OrientedBox::OrientedBox( const AxisAlignedBox & aabb ) :
+	m_center( aabb.getCenter() ), m_extents( aabb.getExtents() )
+{
+	m_axis[0] = Point3( 1, 0, 0 );
+	m_axis[1] = Point3( 0, 1, 0 );
+	m_axis[2] = Point3( 0, 0, 1 );
+}
+
+//
+// OrientedBox::set
+//
+inline void OrientedBox::set( const Point3 & center, const Point3 & axisX, const Point3 & axisY, const Point3 & axisZ, const Point3 & extents )
+{
+	m_center = center;
+	m_axis[0] = axisX;
+	m_axis[1] = axisY;
+	m_axis[2] = axisZ;
+	m_extents = extents;
+}
+
+//
+// OrientedBox::getProjectedRadius
+//
+inline float OrientedBox::getProjectedRadius( const Point3 & direction ) const
+{
+	return m_extents.x * kmath::fabs( direction.getDot( m_axis[0] ) ) +
+		   m_extents.y * kmath::fabs( direction.getDot( m_axis[1] ) ) +
+		   m_extents.z * kmath::fabs( direction.getDot( m_axis[2] ) );
+}
+
 } // Katana
 
 #endif // _BOX_H
\ No newline at end of file
@@ -10,10 +10,14 @@
 	Intersection testing functions
 */
 
-#include "katana_core_includes.h"
-#include "katana_base_includes.h"
+#include "kmath.h"
+#include "point.h"
+#include "plane.h"
+#include "bound.h"
+#include "box.h"
 #include "intersect.h"
 #include <math.h>
+using namespace Katana;
 
 // --------------------------------------------------------------
 // Macros
@@ -65,7 +69,7 @@ void projectBox (const Point3 & rkD, const AxisAlignedBox & rkBox,
 //
 // Box vs. Point Intersection
 //
-bool testIntersect( AxisAlignedBox & aabb, Point3 & point )
+bool kmath::testIntersect( const AxisAlignedBox & aabb, const Point3 & point )
 {
 	if ( point >= aabb.m_minimum && point <= aabb.m_maximum )
 		return true;
@@ -76,7 +80,7 @@ bool testIntersect( AxisAlignedBox & aabb, Point3 & point )
 //
 // Box vs. Box Intersection
 //
-bool testIntersect( AxisAlignedBox & a, AxisAlignedBox & b )
+bool kmath::testIntersect( const AxisAlignedBox & a, const AxisAlignedBox & b )
 {
 	if ( a.m_maximum.x < b.m_minimum.x )
 		return false;
@@ -179,7 +183,7 @@ bool kmath::testIntersect( const Bound & bound, const Point3 & vert0, const Poin
 			{
 				//				u = 0.0f;
 				//				v = 0.0f;
-				SqrDist = (float)unsigned long(-1);
+				SqrDist = (float)(unsigned long)(-1);
 			}
 			else
 			{
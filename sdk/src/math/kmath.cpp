@@ -8,12 +8,27 @@
 	General math routines
 */
 
+#include "katana_config.h"
 #include "kmath.h"
-#include "Point.h"
-#include "Matrix.h"
+#include "point.h"
+#include "matrix.h"
+#include "plane.h"
 #include <math.h>
+#include <string.h>
+#if defined(KATANA_MATH_AVX2)
+#include <immintrin.h>
+#elif defined(KATANA_MATH_SSE2)
+#include <emmintrin.h>
+#endif
 using namespace Katana;
 
+//
+// Local Functions
+//
+static void cullSpheresScalar( const float * centerX, const float * centerY, const float * centerZ, const float * radius,
+							   unsigned int first, unsigned int count, const Plane * planes, unsigned int planeMask,
+							   unsigned int * visibleMask, unsigned int * intersectMasks );
+
 //
 // createProjection
 //
@@ -33,4 +48,149 @@ void kmath::createProjection( float fov, float nearp, float farp, float aspect,
 	projMatrix.m[2][2] = Q;
 	projMatrix.m[2][3] = 1.0f;
 	projMatrix.m[3][2] = -Q*nearp;
-}
\ No newline at end of file
+}
+
+//
+// cullSpheres
+//
+void kmath::cullSpheres( const float * centerX, const float * centerY, const float * centerZ, const float * radius,
+						 unsigned int count, const Plane * planes, unsigned int planeMask,
+						 unsigned int * visibleMask, unsigned int * intersectMasks )
+{
+	// Clear the visibility bits, they're or'ed in below
+	memset( visibleMask, 0, ( ( count + 31 ) / 32 ) * sizeof(unsigned int) );
+
+	unsigned int i = 0;
+
+#if defined(KATANA_MATH_AVX2) || defined(KATANA_MATH_SSE2)
+	// Gather the active planes, so the inner loop doesn't need to check the mask
+	unsigned int activePlanes[32];
+	unsigned int activePlaneCount = 0;
+	for( unsigned int plane = 0; plane < 32; plane++ )
+		if ( planeMask & ( 1u << plane ) )
+			activePlanes[activePlaneCount++] = plane;
+#endif
+
+#if defined(KATANA_MATH_AVX2)
+	// Test eight spheres at a time. The lane count divides 32, so the
+	// visibility bits of a group never straddle two words.
+	for( ; i + 8 <= count; i += 8 )
+	{
+		const __m256 x = _mm256_loadu_ps( centerX + i );
+		const __m256 y = _mm256_loadu_ps( centerY + i );
+		const __m256 z = _mm256_loadu_ps( centerZ + i );
+		const __m256 r = _mm256_loadu_ps( radius + i );
+		const __m256 negR = _mm256_sub_ps( _mm256_setzero_ps(), r );
+
+		// The plane masks of the lanes stay in a register
+		__m256 culled = _mm256_setzero_ps();
+		__m256i intersect = _mm256_set1_epi32( (int)planeMask );
+
+		for( unsigned int p = 0; p < activePlaneCount; p++ )
+		{
+			const Plane & plane = planes[ activePlanes[p] ];
+			const Point3 & normal = plane.getNormal();
+
+			// Signed distance from the plane to the centers
+			__m256 distance = _mm256_add_ps( _mm256_mul_ps( x, _mm256_set1_ps( normal.x ) ),
+											 _mm256_mul_ps( y, _mm256_set1_ps( normal.y ) ) );
+			distance = _mm256_add_ps( distance, _mm256_mul_ps( z, _mm256_set1_ps( normal.z ) ) );
+			distance = _mm256_add_ps( distance, _mm256_set1_ps( plane.getConstant() ) );
+
+			// Completely behind the plane
+			culled = _mm256_or_ps( culled, _mm256_cmp_ps( distance, negR, _CMP_LT_OQ ) );
+
+			// Completely in front of the plane, the children don't need to test it
+			const __m256i inside = _mm256_castps_si256( _mm256_cmp_ps( distance, r, _CMP_GT_OQ ) );
+			intersect = _mm256_andnot_si256( _mm256_and_si256( inside, _mm256_set1_epi32( (int)( 1u << activePlanes[p] ) ) ), intersect );
+		}
+
+		const unsigned int visible = ~_mm256_movemask_ps( culled ) & 0xFF;
+		visibleMask[ i >> 5 ] |= visible << ( i & 31 );
+
+		if ( intersectMasks )
+			_mm256_storeu_si256( reinterpret_cast<__m256i *>( intersectMasks + i ), intersect );
+	}
+#elif defined(KATANA_MATH_SSE2)
+	// Test four spheres at a time. The lane count divides 32, so the
+	// visibility bits of a group never straddle two words.
+	for( ; i + 4 <= count; i += 4 )
+	{
+		const __m128 x = _mm_loadu_ps( centerX + i );
+		const __m128 y = _mm_loadu_ps( centerY + i );
+		const __m128 z = _mm_loadu_ps( centerZ + i );
+		const __m128 r = _mm_loadu_ps( radius + i );
+		const __m128 negR = _mm_sub_ps( _mm_setzero_ps(), r );
+
+		// The plane masks of the lanes stay in a register
+		__m128 culled = _mm_setzero_ps();
+		__m128i intersect = _mm_set1_epi32( (int)planeMask );
+
+		for( unsigned int p = 0; p < activePlaneCount; p++ )
+		{
+			const Plane & plane = planes[ activePlanes[p] ];
+			const Point3 & normal = plane.getNormal();
+
+			// Signed distance from the plane to the centers
+			__m128 distance = _mm_add_ps( _mm_mul_ps( x, _mm_set1_ps( normal.x ) ),
+										  _mm_mul_ps( y, _mm_set1_ps( normal.y ) ) );
+			distance = _mm_add_ps( distance, _mm_mul_ps( z, _mm_set1_ps( normal.z ) ) );
+			distance = _mm_add_ps( distance, _mm_set1_ps( plane.getConstant() ) );
+
+			// Completely behind the plane
+			culled = _mm_or_ps( culled, _mm_cmplt_ps( distance, negR ) );
+
+			// Completely in front of the plane, the children don't need to test it
+			const __m128i inside = _mm_castps_si128( _mm_cmpgt_ps( distance, r ) );
+			intersect = _mm_andnot_si128( _mm_and_si128( inside, _mm_set1_epi32( (int)( 1u << activePlanes[p] ) ) ), intersect );
+		}
+
+		const unsigned int visible = ~_mm_movemask_ps( culled ) & 0xF;
+		visibleMask[ i >> 5 ] |= visible << ( i & 31 );
+
+		if ( intersectMasks )
+			_mm_storeu_si128( reinterpret_cast<__m128i *>( intersectMasks + i ), intersect );
+	}
+#endif
+
+	// Test the remaining spheres one at a time
+	cullSpheresScalar( centerX, centerY, centerZ, radius, i, count, planes, planeMask, visibleMask, intersectMasks );
+}
+
+//
+// cullSpheresScalar
+// Portable version of the culling kernel, used for the spheres which don't fill a SIMD register
+//
+void cullSpheresScalar( const float * centerX, const float * centerY, const float * centerZ, const float * radius,
+						unsigned int first, unsigned int count, const Plane * planes, unsigned int planeMask,
+						unsigned int * visibleMask, unsigned int * intersectMasks )
+{
+	for( unsigned int i = first; i < count; i++ )
+	{
+		const Point3 center( centerX[i], centerY[i], centerZ[i] );
+		unsigned int intersect = planeMask;
+		bool visible = true;
+
+		for( unsigned int plane = 0; plane < 32 && visible; plane++ )
+		{
+			const unsigned int planeBit = 1u << plane;
+			if ( !( planeMask & planeBit ) ) continue;
+
+			const float distance = planes[plane].distance( center );
+
+			// Completely behind the plane
+			if ( distance < -radius[i] )
+				visible = false;
+
+			// Completely in front of the plane
+			else if ( distance > radius[i] )
+				intersect &= ~planeBit;
+		}
+
+		if ( visible )
+			visibleMask[ i >> 5 ] |= 1u << ( i & 31 );
+
+		if ( intersectMasks )
+			intersectMasks[i] = intersect;
+	}
+}
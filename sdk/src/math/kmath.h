@@ -18,6 +18,7 @@ namespace Katana
 // Forward Declarations
 //
 class Matrix4;
+class Plane;
 
 namespace kmath
 {
@@ -126,6 +127,22 @@ namespace kmath
 	///
 	void createProjection( float fov, float nearp, float farp, float aspect, Matrix4 & projMatrix );
 
+	///
+	/// cullSpheres
+	/// Culls an array of bounding spheres against a set of planes. The spheres are stored
+	/// as a structure of arrays (centerX, centerY, centerZ, radius), so they can be tested
+	/// several at a time using SIMD instructions.
+	///
+	/// Only the planes whose bit is set in the plane mask are tested (bit i = planes[i]).
+	/// Bit j of visibleMask[j / 32] is set if sphere j is not completely behind any of the
+	/// planes; the visible mask must hold at least (count + 31) / 32 words. If intersectMasks
+	/// isn't NULL, it receives for every sphere the plane mask without the planes the sphere
+	/// is completely in front of.
+	///
+	void cullSpheres( const float * centerX, const float * centerY, const float * centerZ, const float * radius,
+					  unsigned int count, const Plane * planes, unsigned int planeMask,
+					  unsigned int * visibleMask, unsigned int * intersectMasks = 0 );
+
 	//
 	// fabs
 	//
@@ -8,13 +8,40 @@
 	Represents a matrix
 */
 
+#include "katana_config.h"
 #include "kmath.h"
 #include "point.h"
 #include "matrix.h"
 #include <memory.h>
 #include <math.h>
+#if defined(KATANA_MATH_SSE2)
+#include <emmintrin.h>
+#endif
 using namespace Katana;
 
+#if defined(KATANA_MATH_SSE2)
+
+// ------------------------------------------------------
+// Macros
+// ------------------------------------------------------
+
+// The rows are loaded and stored unaligned. Matrices embedded in heap allocated objects
+// aren't guaranteed to be aligned, and the unaligned instructions are as fast when they are.
+#define SHUFFLE(a, b, x, y, z, w)	_mm_shuffle_ps( a, b, _MM_SHUFFLE( w, z, y, x ) )
+#define SWIZZLE(a, x, y, z, w)		SHUFFLE( a, a, x, y, z, w )
+
+// ------------------------------------------------------
+// Local Functions
+// ------------------------------------------------------
+
+static void Multiply( const Matrix4 & a, const Matrix4 & b, Matrix4 & result );
+static inline __m128 Mat2Mul( __m128 a, __m128 b );
+static inline __m128 Mat2AdjMul( __m128 a, __m128 b );
+static inline __m128 Mat2MulAdj( __m128 a, __m128 b );
+static inline void StorePoint3( Point3 & dest, __m128 value );
+
+#endif
+
 //
 // Constructor
 //
@@ -70,10 +97,24 @@ void Matrix4::setZero()
 //
 Matrix4 & Matrix4::transpose()
 {
+#if defined(KATANA_MATH_SSE2)
+	__m128 row0 = _mm_loadu_ps( &s[ 0] );
+	__m128 row1 = _mm_loadu_ps( &s[ 4] );
+	__m128 row2 = _mm_loadu_ps( &s[ 8] );
+	__m128 row3 = _mm_loadu_ps( &s[12] );
+
+	_MM_TRANSPOSE4_PS( row0, row1, row2, row3 );
+
+	_mm_storeu_ps( &s[ 0], row0 );
+	_mm_storeu_ps( &s[ 4], row1 );
+	_mm_storeu_ps( &s[ 8], row2 );
+	_mm_storeu_ps( &s[12], row3 );
+#else
 	set( m00, m10, m20, m30,
 		 m01, m11, m21, m31,
 		 m02, m12, m22, m32,
 		 m03, m13, m23, m33 );
+#endif
 
 	return *this;
 }
@@ -83,6 +124,67 @@ Matrix4 & Matrix4::transpose()
 //
 Matrix4 & Matrix4::inverse()
 {
+#if defined(KATANA_MATH_SSE2)
+	// Invert the matrix by splitting it into four 2x2 blocks:
+	//
+	//	| A B |-1		     1   | X Y |
+	//	| C D |		=	---- | Z W |
+	//					|M|
+	//
+	// Each 2x2 block is stored in a register as (m00, m01, m10, m11), and A# denotes the adjugate.
+	const __m128 row0 = _mm_loadu_ps( &s[ 0] );
+	const __m128 row1 = _mm_loadu_ps( &s[ 4] );
+	const __m128 row2 = _mm_loadu_ps( &s[ 8] );
+	const __m128 row3 = _mm_loadu_ps( &s[12] );
+
+	const __m128 A = _mm_movelh_ps( row0, row1 );
+	const __m128 B = _mm_movehl_ps( row1, row0 );
+	const __m128 C = _mm_movelh_ps( row2, row3 );
+	const __m128 D = _mm_movehl_ps( row3, row2 );
+
+	// Determinants of the blocks (|A|, |B|, |C|, |D|)
+	const __m128 detSub = _mm_sub_ps(
+		_mm_mul_ps( SHUFFLE( row0, row2, 0, 2, 0, 2 ), SHUFFLE( row1, row3, 1, 3, 1, 3 ) ),
+		_mm_mul_ps( SHUFFLE( row0, row2, 1, 3, 1, 3 ), SHUFFLE( row1, row3, 0, 2, 0, 2 ) ) );
+
+	const __m128 detA = SWIZZLE( detSub, 0, 0, 0, 0 );
+	const __m128 detB = SWIZZLE( detSub, 1, 1, 1, 1 );
+	const __m128 detC = SWIZZLE( detSub, 2, 2, 2, 2 );
+	const __m128 detD = SWIZZLE( detSub, 3, 3, 3, 3 );
+
+	const __m128 D_C = Mat2AdjMul( D, C );		// D#C
+	const __m128 A_B = Mat2AdjMul( A, B );		// A#B
+
+	__m128 X = _mm_sub_ps( _mm_mul_ps( detD, A ), Mat2Mul( B, D_C ) );		// X# = |D|A - B(D#C)
+	__m128 W = _mm_sub_ps( _mm_mul_ps( detA, D ), Mat2Mul( C, A_B ) );		// W# = |A|D - C(A#B)
+	__m128 Y = _mm_sub_ps( _mm_mul_ps( detB, C ), Mat2MulAdj( D, A_B ) );	// Y# = |B|C - D(A#B)#
+	__m128 Z = _mm_sub_ps( _mm_mul_ps( detC, B ), Mat2MulAdj( A, D_C ) );	// Z# = |C|B - A(D#C)#
+
+	// |M| = |A||D| + |B||C| - tr((A#B)(D#C))
+	__m128 trace = _mm_mul_ps( A_B, SWIZZLE( D_C, 0, 2, 1, 3 ) );
+	trace = _mm_add_ps( trace, _mm_movehl_ps( trace, trace ) );
+	trace = _mm_add_ss( trace, SWIZZLE( trace, 1, 1, 1, 1 ) );
+
+	float fDet;
+	_mm_store_ss( &fDet, _mm_sub_ss( _mm_add_ss( _mm_mul_ss( detA, detD ), _mm_mul_ss( detB, detC ) ), trace ) );
+	if ( fabs(fDet) <= kmath::LARGE_EPSILON )
+		return *this; // No Inverse
+
+	// The sign pattern of the adjugate is folded into the reciprocal
+	const __m128 rcpDet = _mm_div_ps( _mm_setr_ps( 1.f, -1.f, -1.f, 1.f ), _mm_set1_ps( fDet ) );
+	X = _mm_mul_ps( X, rcpDet );
+	Y = _mm_mul_ps( Y, rcpDet );
+	Z = _mm_mul_ps( Z, rcpDet );
+	W = _mm_mul_ps( W, rcpDet );
+
+	// Apply the adjugate while storing the blocks back into rows
+	_mm_storeu_ps( &s[ 0], SHUFFLE( X, Y, 3, 1, 3, 1 ) );
+	_mm_storeu_ps( &s[ 4], SHUFFLE( X, Y, 2, 0, 2, 0 ) );
+	_mm_storeu_ps( &s[ 8], SHUFFLE( Z, W, 3, 1, 3, 1 ) );
+	_mm_storeu_ps( &s[12], SHUFFLE( Z, W, 2, 0, 2, 0 ) );
+
+	return *this;
+#else
 	float fA0 = s[ 0]*s[ 5] - s[ 1]*s[ 4];
 	float fA1 = s[ 0]*s[ 6] - s[ 2]*s[ 4];
 	float fA2 = s[ 0]*s[ 7] - s[ 3]*s[ 4];
@@ -126,6 +228,7 @@ Matrix4 & Matrix4::inverse()
 	}
 
 	return ( *this = kInv );
+#endif
 }
 
 //
@@ -133,6 +236,10 @@ Matrix4 & Matrix4::inverse()
 //
 Matrix4 & Matrix4::operator*=(const Matrix4 & mat)
 {
+#if defined(KATANA_MATH_SSE2)
+	Multiply( *this, mat, *this );
+	return *this;
+#else
 	set(
 		s[ 0] * mat.s[ 0] + s[ 1] * mat.s[ 4] + s[ 2] * mat.s[ 8] + s[ 3] * mat.s[12], // s0
 		s[ 0] * mat.s[ 1] + s[ 1] * mat.s[ 5] + s[ 2] * mat.s[ 9] + s[ 3] * mat.s[13], // s1
@@ -155,32 +262,71 @@ Matrix4 & Matrix4::operator*=(const Matrix4 & mat)
 		s[12] * mat.s[ 3] + s[13] * mat.s[ 7] + s[14] * mat.s[11] + s[15] * mat.s[15]  // s15
 		);
 
-	return*this;
+	return *this;
+#endif
 }
 
 Matrix4 Matrix4::operator*(const Matrix4 & mat) const
 {
-	return Matrix4(
-		s[ 0] * mat.s[ 0] + s[ 1] * mat.s[ 4] + s[ 2] * mat.s[ 8] + s[ 3] * mat.s[12], // s0
-		s[ 0] * mat.s[ 1] + s[ 1] * mat.s[ 5] + s[ 2] * mat.s[ 9] + s[ 3] * mat.s[13], // s1
-		s[ 0] * mat.s[ 2] + s[ 1] * mat.s[ 6] + s[ 2] * mat.s[10] + s[ 3] * mat.s[14], // s2
-		s[ 0] * mat.s[ 3] + s[ 1] * mat.s[ 7] + s[ 2] * mat.s[11] + s[ 3] * mat.s[15], // s3
+	Matrix4 result( *this );
+	return ( result *= mat );
+}
 
-		s[ 4] * mat.s[ 0] + s[ 5] * mat.s[ 4] + s[ 6] * mat.s[ 8] + s[ 7] * mat.s[12], // s4
-		s[ 4] * mat.s[ 1] + s[ 5] * mat.s[ 5] + s[ 6] * mat.s[ 9] + s[ 7] * mat.s[13], // s5
-		s[ 4] * mat.s[ 2] + s[ 5] * mat.s[ 6] + s[ 6] * mat.s[10] + s[ 7] * mat.s[14], // s6
-		s[ 4] * mat.s[ 3] + s[ 5] * mat.s[ 7] + s[ 6] * mat.s[11] + s[ 7] * mat.s[15], // s7
+//
+// transformPoints
+//
+void Matrix4::transformPoints( const Point3 * src, Point3 * dest, unsigned int count ) const
+{
+#if defined(KATANA_MATH_SSE2)
+	// The columns of the rotation, so each point is a sum of scaled columns
+	__m128 col0 = _mm_loadu_ps( &s[ 0] );
+	__m128 col1 = _mm_loadu_ps( &s[ 4] );
+	__m128 col2 = _mm_loadu_ps( &s[ 8] );
+	__m128 col3 = _mm_loadu_ps( &s[12] );
+	_MM_TRANSPOSE4_PS( col0, col1, col2, col3 );
 
-		s[ 8] * mat.s[ 0] + s[ 9] * mat.s[ 4] + s[10] * mat.s[ 8] + s[11] * mat.s[12], // s8
-		s[ 8] * mat.s[ 1] + s[ 9] * mat.s[ 5] + s[10] * mat.s[ 9] + s[11] * mat.s[13], // s9
-		s[ 8] * mat.s[ 2] + s[ 9] * mat.s[ 6] + s[10] * mat.s[10] + s[11] * mat.s[14], // s10
-		s[ 8] * mat.s[ 3] + s[ 9] * mat.s[ 7] + s[10] * mat.s[11] + s[11] * mat.s[15], // s11
+	const __m128 translation = _mm_setr_ps( pos.x, pos.y, pos.z, 0.f );
 
-		s[12] * mat.s[ 0] + s[13] * mat.s[ 4] + s[14] * mat.s[ 8] + s[15] * mat.s[12], // s12
-		s[12] * mat.s[ 1] + s[13] * mat.s[ 5] + s[14] * mat.s[ 9] + s[15] * mat.s[13], // s13
-		s[12] * mat.s[ 2] + s[13] * mat.s[ 6] + s[14] * mat.s[10] + s[15] * mat.s[14], // s14
-		s[12] * mat.s[ 3] + s[13] * mat.s[ 7] + s[14] * mat.s[11] + s[15] * mat.s[15]  // s15
-	);
+	for( unsigned int i = 0; i < count; i++ )
+	{
+		__m128 result = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( src[i].x ), col0 ), translation );
+		result = _mm_add_ps( result, _mm_mul_ps( _mm_set1_ps( src[i].y ), col1 ) );
+		result = _mm_add_ps( result, _mm_mul_ps( _mm_set1_ps( src[i].z ), col2 ) );
+		StorePoint3( dest[i], result );
+	}
+#else
+	for( unsigned int i = 0; i < count; i++ )
+	{
+		dest[i] = src[i];
+		dest[i] *= *this;
+	}
+#endif
+}
+
+//
+// transformVectors
+//
+void Matrix4::transformVectors( const Point3 * src, Point3 * dest, unsigned int count ) const
+{
+#if defined(KATANA_MATH_SSE2)
+	// The columns of the rotation, so each vector is a sum of scaled columns
+	__m128 col0 = _mm_loadu_ps( &s[ 0] );
+	__m128 col1 = _mm_loadu_ps( &s[ 4] );
+	__m128 col2 = _mm_loadu_ps( &s[ 8] );
+	__m128 col3 = _mm_loadu_ps( &s[12] );
+	_MM_TRANSPOSE4_PS( col0, col1, col2, col3 );
+
+	for( unsigned int i = 0; i < count; i++ )
+	{
+		__m128 result = _mm_mul_ps( _mm_set1_ps( src[i].x ), col0 );
+		result = _mm_add_ps( result, _mm_mul_ps( _mm_set1_ps( src[i].y ), col1 ) );
+		result = _mm_add_ps( result, _mm_mul_ps( _mm_set1_ps( src[i].z ), col2 ) );
+		StorePoint3( dest[i], result );
+	}
+#else
+	for( unsigned int i = 0; i < count; i++ )
+		dest[i] = src[i] * *this;
+#endif
 }
 
 //
@@ -213,4 +359,78 @@ void Matrix4::makeRotation( float angle, const Point3 & axis )
     m[2][0] = xzm+ysin;
     m[2][1] = yzm-xsin;
     m[2][2] = z2*omcs+cs;
-}
\ No newline at end of file
+}
+
+#if defined(KATANA_MATH_SSE2)
+
+// ------------------------------------------------------
+// Local Functions
+// ------------------------------------------------------
+
+//
+// Multiply
+// Row major product, the result may be either of the sources
+//
+void Multiply( const Matrix4 & a, const Matrix4 & b, Matrix4 & result )
+{
+	const __m128 b0 = _mm_loadu_ps( &b.s[ 0] );
+	const __m128 b1 = _mm_loadu_ps( &b.s[ 4] );
+	const __m128 b2 = _mm_loadu_ps( &b.s[ 8] );
+	const __m128 b3 = _mm_loadu_ps( &b.s[12] );
+
+	__m128 rows[4];
+	for( int i = 0; i < 4; i++ )
+	{
+		const __m128 row = _mm_loadu_ps( &a.s[ i * 4 ] );
+		rows[i] = _mm_add_ps( _mm_add_ps( _mm_mul_ps( SWIZZLE( row, 0, 0, 0, 0 ), b0 ),
+										  _mm_mul_ps( SWIZZLE( row, 1, 1, 1, 1 ), b1 ) ),
+							  _mm_add_ps( _mm_mul_ps( SWIZZLE( row, 2, 2, 2, 2 ), b2 ),
+										  _mm_mul_ps( SWIZZLE( row, 3, 3, 3, 3 ), b3 ) ) );
+	}
+
+	// Only store once all the rows are computed, in case we're writing into a source
+	for( int i = 0; i < 4; i++ )
+		_mm_storeu_ps( &result.s[ i * 4 ], rows[i] );
+}
+
+//
+// Mat2Mul
+// 2x2 product AB
+//
+__m128 Mat2Mul( __m128 a, __m128 b )
+{
+	return _mm_add_ps( _mm_mul_ps( a, SWIZZLE( b, 0, 3, 0, 3 ) ),
+					   _mm_mul_ps( SWIZZLE( a, 1, 0, 3, 2 ), SWIZZLE( b, 2, 1, 2, 1 ) ) );
+}
+
+//
+// Mat2AdjMul
+// 2x2 product of the adjugate of A with B (A#B)
+//
+__m128 Mat2AdjMul( __m128 a, __m128 b )
+{
+	return _mm_sub_ps( _mm_mul_ps( SWIZZLE( a, 3, 3, 0, 0 ), b ),
+					   _mm_mul_ps( SWIZZLE( a, 1, 1, 2, 2 ), SWIZZLE( b, 2, 3, 0, 1 ) ) );
+}
+
+//
+// Mat2MulAdj
+// 2x2 product of A with the adjugate of B (AB#)
+//
+__m128 Mat2MulAdj( __m128 a, __m128 b )
+{
+	return _mm_sub_ps( _mm_mul_ps( a, SWIZZLE( b, 3, 0, 3, 0 ) ),
+					   _mm_mul_ps( SWIZZLE( a, 1, 0, 3, 2 ), SWIZZLE( b, 2, 1, 2, 1 ) ) );
+}
+
+//
+// StorePoint3
+// Stores the xyz components, without writing past the point
+//
+void StorePoint3( Point3 & dest, __m128 value )
+{
+	_mm_storel_pi( (__m64 *)&dest.x, value );
+	_mm_store_ss( &dest.z, _mm_movehl_ps( value, value ) );
+}
+
+#endif
@@ -15,11 +15,55 @@
 namespace Katana
 {
 
+//
+// Matrices are aligned on 16 bytes, so each row fits a SIMD register
+//
+#if defined(_MSC_VER)
+	#define KMATH_ALIGN16	__declspec(align(16))
+#elif defined(__GNUC__)
+	#define KMATH_ALIGN16	__attribute__((aligned(16)))
+#else
+	#define KMATH_ALIGN16
+#endif
+
+///
+/// MatrixRow
+/// Row of the matrix, when viewed as a coordinate frame. Members with constructors
+/// aren't allowed inside the anonymous union of Matrix4 (only MSVC accepts them),
+/// so the row is a plain structure which is layout compatible with Point4 and converts to it.
+///
+struct MatrixRow
+{
+	/// Operator overload for indexing
+	float & operator[] (int i)								{ return (&x)[i]; }
+	const float & operator[] (int i) const					{ return (&x)[i]; }
+
+	/// Conversion to a point (the row starts with x, y, z like Point3)
+	operator Point3 & ()									{ return *reinterpret_cast<Point3 *>( this ); }
+	operator const Point3 & () const						{ return *reinterpret_cast<const Point3 *>( this ); }
+
+	/// Assignment (the same as assigning to a Point4)
+	MatrixRow & operator= (const Point3 & pt)				{ x = pt.x; y = pt.y; z = pt.z; w = 1.f; return *this; }
+	MatrixRow & operator= (const Point4 & pt)				{ x = pt.x; y = pt.y; z = pt.z; w = pt.w; return *this; }
+
+	/// Negation
+	Point3 operator-() const								{ return Point3( -x, -y, -z ); }
+
+	/// Addition and subtraction of a point
+	Point3 operator+ (const Point3 & pt) const				{ return Point3( x + pt.x, y + pt.y, z + pt.z ); }
+	Point3 operator- (const Point3 & pt) const				{ return Point3( x - pt.x, y - pt.y, z - pt.z ); }
+
+	/// Return the Cross Product
+	Point3 getCross(const Point3 & pt) const				{ return Point3( y*pt.z-z*pt.y, z*pt.x-x*pt.z, x*pt.y-y*pt.x ); }
+
+	float x, y, z, w;
+};
+
 ///
 /// Matrix4
 /// Represents a 4x4 Homogeneous Matrix
 ///
-class Matrix4
+class KMATH_ALIGN16 Matrix4
 {
 public:
 	/// Constructor
@@ -52,6 +96,14 @@ public:
 	Matrix4 & operator*=(const Matrix4 & m);
 	Matrix4	  operator*(const Matrix4 & m) const;
 
+	/// Transforms an array of points by the rotation and translation (same as Point3::operator*=).
+	/// The source and destination may be the same array.
+	void transformPoints( const Point3 * src, Point3 * dest, unsigned int count ) const;
+
+	/// Transforms an array of vectors by the rotation only (same as Point3::operator*).
+	/// The source and destination may be the same array.
+	void transformVectors( const Point3 * src, Point3 * dest, unsigned int count ) const;
+
 	/// Set operator which sets all the row in the matrix at one time
 	void set(float m00, float m01, float m02, float m03,
 			 float m10, float m11, float m12, float m13,
@@ -75,10 +127,10 @@ public:
         };
 		struct 				// As a coordinate frame
 		{
-			Point4 right;
-			Point4 up;
-			Point4 at;
-			Point4 pos;
+			MatrixRow right;
+			MatrixRow up;
+			MatrixRow at;
+			MatrixRow pos;
 		};
 	};
 };
@@ -33,6 +33,19 @@ enum FrustumPlanes
 	MAX_FRUSTUM_PLANES,
 };
 
+//
+// FrustumPlaneMask
+// One bit per frustum plane, used to skip the planes a bound is already known
+// to be fully inside of during hierarchical culling. The masks are unsigned,
+// since the culled flag is the sign bit.
+//
+const unsigned int FRUSTUM_PLANE_MASK_ALL = ( 1u << MAX_FRUSTUM_PLANES ) - 1;
+
+// Set by the batched culling when the bound has already been tested
+// against the planes in the mask, or was found to be outside of them
+const unsigned int FRUSTUM_PLANE_MASK_TESTED = 1u << 30;
+const unsigned int FRUSTUM_PLANE_MASK_CULLED = 1u << 31;
+
 ///
 /// Plane
 ///
@@ -62,6 +75,12 @@ public:
 	/// Returns the distance from a point to the plane
 	float distance( const Point3 & point ) const								{ return m_normal.getDot( point ) + m_constant; }
 
+	/// Returns the normal of the plane
+	const Point3 & getNormal() const											{ return m_normal; }
+
+	/// Returns the constant (distance from the origin) of the plane
+	float getConstant() const													{ return m_constant; }
+
 	/// Sets the plane given a normal and constant
 	void set( const Point3 & normal, float constant )							{ m_normal = normal; m_constant = constant; }
 
@@ -167,9 +167,11 @@ Point3 Point3::getCross(const Point3 & pt) const
 //
 Point3& Point3::operator*= (const Matrix4 & m)
 {
-    x = m.m[0][0]*x+m.m[0][1]*y+m.m[0][2]*z;
-	y = m.m[1][0]*x+m.m[1][1]*y+m.m[1][2]*z;
-    z = m.m[2][0]*x+m.m[2][1]*y+m.m[2][2]*z;
+	// Use temporaries, otherwise y and z would be computed from the transformed x and y
+	const float tx = x, ty = y, tz = z;
+	x = m.m[0][0]*tx+m.m[0][1]*ty+m.m[0][2]*tz;
+	y = m.m[1][0]*tx+m.m[1][1]*ty+m.m[1][2]*tz;
+	z = m.m[2][0]*tx+m.m[2][1]*ty+m.m[2][2]*tz;
 	*this += m.pos;
 	return *this;
 }
@@ -218,9 +220,11 @@ Point4::Point4(const Point4& pt) :
 
 Point4 & Point4::operator*= (const Matrix4 & m)
 {
-	x = m.m[0][0]*x+m.m[0][1]*y+m.m[0][2]*z;
-	y = m.m[1][0]*x+m.m[1][1]*y+m.m[1][2]*z;
-	z = m.m[2][0]*x+m.m[2][1]*y+m.m[2][2]*z;
+	// Use temporaries, otherwise y and z would be computed from the transformed x and y
+	const float tx = x, ty = y, tz = z;
+	x = m.m[0][0]*tx+m.m[0][1]*ty+m.m[0][2]*tz;
+	y = m.m[1][0]*tx+m.m[1][1]*ty+m.m[1][2]*tz;
+	z = m.m[2][0]*tx+m.m[2][1]*ty+m.m[2][2]*tz;
 	return *this;
 }
 
@@ -10,12 +10,31 @@
 	Represents a 4d quaternion [(x,y,z),w]
 */
 
+#include "katana_config.h"
 #include "kmath.h"
 #include "point.h"
 #include "matrix.h"
 #include "quaternion.h"
 #include <math.h>
+#if defined(KATANA_MATH_SSE2)
+#include <emmintrin.h>
+#endif
 using namespace Katana;
+
+//
+// Local Functions
+//
+static float getNlerpThreshold( float maxError );
+#if defined(KATANA_MATH_SSE2)
+static inline void LoadQuaternions( const Quaternion * quats, __m128 & x, __m128 & y, __m128 & z, __m128 & w );
+static inline void StoreQuaternions( Quaternion * quats, __m128 x, __m128 y, __m128 z, __m128 w );
+static inline void NlerpQuaternions( __m128 t, __m128 & x1, __m128 & y1, __m128 & z1, __m128 & w1,
+									 __m128 x2, __m128 y2, __m128 z2, __m128 w2 );
+static inline void SlerpQuaternions( __m128 t, __m128 dot, __m128 & x1, __m128 & y1, __m128 & z1, __m128 & w1,
+									 __m128 x2, __m128 y2, __m128 z2, __m128 w2 );
+static inline __m128 ArcCosine( __m128 x );
+static inline __m128 Sine( __m128 x );
+#endif
     
 //
 // toMatrix
@@ -171,4 +190,267 @@ Quaternion Quaternion::Squad( float fT,	const Quaternion& rkP, const Quaternion&
 	Quaternion kSlerpP = slerp(fT, rkP, rkQ, shortestPath);
 	Quaternion kSlerpQ = slerp(fT, rkA, rkB);
 	return slerp(fSlerpT, kSlerpP ,kSlerpQ);
-}
\ No newline at end of file
+}
+
+//
+// nlerp
+//
+Quaternion Quaternion::nlerp( float fT, const Quaternion & q1, const Quaternion & q2 )
+{
+	// Interpolate towards whichever of q2 or -q2 is closer (they're the same rotation)
+	const float fSign = q1.dot(q2) < 0.0f ? -1.0f : 1.0f;
+
+	Quaternion t( q1 + fT * ( fSign * q2 - q1 ) );
+	t.normalise();
+	return t;
+}
+
+//
+// nlerpArray
+//
+void Quaternion::nlerpArray( const float * fT, const Quaternion * q1, const Quaternion * q2, Quaternion * result, unsigned int count )
+{
+	unsigned int i = 0;
+
+#if defined(KATANA_MATH_SSE2)
+	// Interpolate four pairs at a time
+	for( ; i + 4 <= count; i += 4 )
+	{
+		__m128 x1, y1, z1, w1, x2, y2, z2, w2;
+		LoadQuaternions( q1 + i, x1, y1, z1, w1 );
+		LoadQuaternions( q2 + i, x2, y2, z2, w2 );
+
+		NlerpQuaternions( _mm_loadu_ps( fT + i ), x1, y1, z1, w1, x2, y2, z2, w2 );
+		StoreQuaternions( result + i, x1, y1, z1, w1 );
+	}
+#endif
+
+	// Interpolate the remaining pairs one at a time
+	for( ; i < count; i++ )
+		result[i] = nlerp( fT[i], q1[i], q2[i] );
+}
+
+//
+// slerpArray
+//
+void Quaternion::slerpArray( const float * fT, const Quaternion * q1, const Quaternion * q2, Quaternion * result, unsigned int count,
+							 float maxError )
+{
+	// Pairs whose dot product is at least this are close enough to be nlerped
+	const float fThreshold = getNlerpThreshold( maxError );
+
+	unsigned int i = 0;
+
+#if defined(KATANA_MATH_SSE2)
+	const __m128 threshold = _mm_set1_ps( fThreshold );
+
+	// Interpolate four pairs at a time. Since nlerp is only used for pairs which are
+	// less than 90 degrees apart, the pairs which aren't flipped by slerp aren't flipped by nlerp.
+	for( ; i + 4 <= count; i += 4 )
+	{
+		__m128 x1, y1, z1, w1, x2, y2, z2, w2;
+		LoadQuaternions( q1 + i, x1, y1, z1, w1 );
+		LoadQuaternions( q2 + i, x2, y2, z2, w2 );
+		const __m128 t = _mm_loadu_ps( fT + i );
+
+		__m128 dot = _mm_add_ps( _mm_mul_ps( x1, x2 ), _mm_mul_ps( y1, y2 ) );
+		dot = _mm_add_ps( dot, _mm_add_ps( _mm_mul_ps( z1, z2 ), _mm_mul_ps( w1, w2 ) ) );
+		const __m128 nlerpMask = _mm_cmpge_ps( dot, threshold );
+		const int nlerpLanes = _mm_movemask_ps( nlerpMask );
+
+		// Only do the work of whichever interpolations are needed
+		if ( nlerpLanes == 0 )
+		{
+			SlerpQuaternions( t, dot, x1, y1, z1, w1, x2, y2, z2, w2 );
+		}
+		else if ( nlerpLanes == 0xf )
+		{
+			NlerpQuaternions( t, x1, y1, z1, w1, x2, y2, z2, w2 );
+		}
+		else
+		{
+			__m128 nx = x1, ny = y1, nz = z1, nw = w1;
+			NlerpQuaternions( t, nx, ny, nz, nw, x2, y2, z2, w2 );
+			SlerpQuaternions( t, dot, x1, y1, z1, w1, x2, y2, z2, w2 );
+
+			x1 = _mm_or_ps( _mm_and_ps( nlerpMask, nx ), _mm_andnot_ps( nlerpMask, x1 ) );
+			y1 = _mm_or_ps( _mm_and_ps( nlerpMask, ny ), _mm_andnot_ps( nlerpMask, y1 ) );
+			z1 = _mm_or_ps( _mm_and_ps( nlerpMask, nz ), _mm_andnot_ps( nlerpMask, z1 ) );
+			w1 = _mm_or_ps( _mm_and_ps( nlerpMask, nw ), _mm_andnot_ps( nlerpMask, w1 ) );
+		}
+
+		StoreQuaternions( result + i, x1, y1, z1, w1 );
+	}
+#endif
+
+	// Interpolate the remaining pairs one at a time
+	for( ; i < count; i++ )
+	{
+		if ( q1[i].dot( q2[i] ) >= fThreshold )
+			result[i] = nlerp( fT[i], q1[i], q2[i] );
+		else
+			result[i] = slerp( fT[i], q1[i], q2[i] );
+	}
+}
+
+// ------------------------------------------------------
+// Local Functions
+// ------------------------------------------------------
+
+//
+// getNlerpThreshold
+// Returns the smallest dot product where nlerp is within the error bound of slerp
+//
+float getNlerpThreshold( float maxError )
+{
+	// Never nlerp (the dot product of unit quaternions can't exceed one)
+	if ( maxError <= 0.0f )
+		return 2.0f;
+
+	// For quaternions which are an angle a apart, the rotation nlerp produces is at most 0.04 a^3
+	// away from slerp's (the error peaks around t = 0.2 and t = 0.8). This holds up to 90 degrees,
+	// which is as far as we'll nlerp.
+	float fAngle = (float)pow( maxError / 0.04f, 1.0f / 3.0f );
+	if ( fAngle > kmath::PI * 0.5f )
+		fAngle = kmath::PI * 0.5f;
+
+	return (float)cos( fAngle );
+}
+
+#if defined(KATANA_MATH_SSE2)
+
+//
+// LoadQuaternions
+// Loads four quaternions, with one register per component
+//
+void LoadQuaternions( const Quaternion * quats, __m128 & x, __m128 & y, __m128 & z, __m128 & w )
+{
+	x = _mm_loadu_ps( &quats[0].x );
+	y = _mm_loadu_ps( &quats[1].x );
+	z = _mm_loadu_ps( &quats[2].x );
+	w = _mm_loadu_ps( &quats[3].x );
+	_MM_TRANSPOSE4_PS( x, y, z, w );
+}
+
+//
+// StoreQuaternions
+// Stores four quaternions, from one register per component
+//
+void StoreQuaternions( Quaternion * quats, __m128 x, __m128 y, __m128 z, __m128 w )
+{
+	_MM_TRANSPOSE4_PS( x, y, z, w );
+	_mm_storeu_ps( &quats[0].x, x );
+	_mm_storeu_ps( &quats[1].x, y );
+	_mm_storeu_ps( &quats[2].x, z );
+	_mm_storeu_ps( &quats[3].x, w );
+}
+
+//
+// NlerpQuaternions
+// Nlerps four pairs of quaternions, the result is written into the first quaternions
+//
+void NlerpQuaternions( __m128 t, __m128 & x1, __m128 & y1, __m128 & z1, __m128 & w1,
+					   __m128 x2, __m128 y2, __m128 z2, __m128 w2 )
+{
+	// Flip the second quaternions which are more than 90 degrees away,
+	// by copying the sign of the dot product into them
+	__m128 dot = _mm_add_ps( _mm_mul_ps( x1, x2 ), _mm_mul_ps( y1, y2 ) );
+	dot = _mm_add_ps( dot, _mm_add_ps( _mm_mul_ps( z1, z2 ), _mm_mul_ps( w1, w2 ) ) );
+	const __m128 sign = _mm_and_ps( dot, _mm_set1_ps( -0.0f ) );
+
+	x1 = _mm_add_ps( x1, _mm_mul_ps( t, _mm_sub_ps( _mm_xor_ps( x2, sign ), x1 ) ) );
+	y1 = _mm_add_ps( y1, _mm_mul_ps( t, _mm_sub_ps( _mm_xor_ps( y2, sign ), y1 ) ) );
+	z1 = _mm_add_ps( z1, _mm_mul_ps( t, _mm_sub_ps( _mm_xor_ps( z2, sign ), z1 ) ) );
+	w1 = _mm_add_ps( w1, _mm_mul_ps( t, _mm_sub_ps( _mm_xor_ps( w2, sign ), w1 ) ) );
+
+	// Normalise the results
+	__m128 length = _mm_add_ps( _mm_mul_ps( x1, x1 ), _mm_mul_ps( y1, y1 ) );
+	length = _mm_sqrt_ps( _mm_add_ps( length, _mm_add_ps( _mm_mul_ps( z1, z1 ), _mm_mul_ps( w1, w1 ) ) ) );
+
+	const __m128 factor = _mm_div_ps( _mm_set1_ps( 1.0f ), length );
+	x1 = _mm_mul_ps( x1, factor );
+	y1 = _mm_mul_ps( y1, factor );
+	z1 = _mm_mul_ps( z1, factor );
+	w1 = _mm_mul_ps( w1, factor );
+}
+
+//
+// SlerpQuaternions
+// Slerps four pairs of quaternions whose dot products are given, the result is written into the
+// first quaternions. This is the same arithmetic as slerp(), without taking the shortest path.
+//
+void SlerpQuaternions( __m128 t, __m128 dot, __m128 & x1, __m128 & y1, __m128 & z1, __m128 & w1,
+					   __m128 x2, __m128 y2, __m128 z2, __m128 w2 )
+{
+	const __m128 one = _mm_set1_ps( 1.0f );
+
+	// Rounding can push the dot product of (nearly) equal quaternions past one
+	dot = _mm_max_ps( _mm_min_ps( dot, one ), _mm_set1_ps( -1.0f ) );
+	const __m128 angle = ArcCosine( dot );
+
+	const __m128 invSin = _mm_div_ps( one, Sine( angle ) );
+	__m128 coeff0 = _mm_mul_ps( Sine( _mm_mul_ps( _mm_sub_ps( one, t ), angle ) ), invSin );
+	__m128 coeff1 = _mm_mul_ps( Sine( _mm_mul_ps( t, angle ) ), invSin );
+
+	// The pairs which are (nearly) the same are left at the first quaternion
+	const __m128 same = _mm_cmplt_ps( angle, _mm_set1_ps( kmath::LARGE_EPSILON ) );
+	coeff0 = _mm_or_ps( _mm_and_ps( same, one ), _mm_andnot_ps( same, coeff0 ) );
+	coeff1 = _mm_andnot_ps( same, coeff1 );
+
+	x1 = _mm_add_ps( _mm_mul_ps( coeff0, x1 ), _mm_mul_ps( coeff1, x2 ) );
+	y1 = _mm_add_ps( _mm_mul_ps( coeff0, y1 ), _mm_mul_ps( coeff1, y2 ) );
+	z1 = _mm_add_ps( _mm_mul_ps( coeff0, z1 ), _mm_mul_ps( coeff1, z2 ) );
+	w1 = _mm_add_ps( _mm_mul_ps( coeff0, w1 ), _mm_mul_ps( coeff1, w2 ) );
+}
+
+//
+// ArcCosine
+// Returns the arc cosine of four values within [-1,1], to within 1e-7 radians
+// (Abramowitz and Stegun, formula 4.4.46)
+//
+__m128 ArcCosine( __m128 x )
+{
+	// acos(x) = pi - acos(-x), so only |x| is approximated
+	const __m128 signBit = _mm_set1_ps( -0.0f );
+	const __m128 negative = _mm_cmplt_ps( x, _mm_setzero_ps() );
+	const __m128 a = _mm_andnot_ps( signBit, x );
+
+	__m128 poly = _mm_set1_ps( -0.0012624911f );
+	poly = _mm_add_ps( _mm_mul_ps( poly, a ), _mm_set1_ps(  0.0066700901f ) );
+	poly = _mm_add_ps( _mm_mul_ps( poly, a ), _mm_set1_ps( -0.0170881256f ) );
+	poly = _mm_add_ps( _mm_mul_ps( poly, a ), _mm_set1_ps(  0.0308918810f ) );
+	poly = _mm_add_ps( _mm_mul_ps( poly, a ), _mm_set1_ps( -0.0501743046f ) );
+	poly = _mm_add_ps( _mm_mul_ps( poly, a ), _mm_set1_ps(  0.0889789874f ) );
+	poly = _mm_add_ps( _mm_mul_ps( poly, a ), _mm_set1_ps( -0.2145988016f ) );
+	poly = _mm_add_ps( _mm_mul_ps( poly, a ), _mm_set1_ps(  1.5707963050f ) );
+
+	const __m128 angle = _mm_mul_ps( _mm_sqrt_ps( _mm_sub_ps( _mm_set1_ps( 1.0f ), a ) ), poly );
+	const __m128 reflected = _mm_sub_ps( _mm_set1_ps( kmath::PI ), angle );
+	return _mm_or_ps( _mm_and_ps( negative, reflected ), _mm_andnot_ps( negative, angle ) );
+}
+
+//
+// Sine
+// Returns the sine of four values, to within 1e-7 for angles of a few turns
+//
+__m128 Sine( __m128 x )
+{
+	// Reduce the angle to [-pi/2,pi/2] by subtracting the nearest multiple of pi,
+	// each odd multiple flips the sign of the sine
+	const __m128i k = _mm_cvtps_epi32( _mm_mul_ps( x, _mm_set1_ps( 1.0f / kmath::PI ) ) );
+	const __m128 r = _mm_sub_ps( x, _mm_mul_ps( _mm_cvtepi32_ps( k ), _mm_set1_ps( kmath::PI ) ) );
+	const __m128 sign = _mm_castsi128_ps( _mm_slli_epi32( k, 31 ) );
+
+	// Taylor series up to r^11
+	const __m128 r2 = _mm_mul_ps( r, r );
+	__m128 poly = _mm_set1_ps( -1.0f / 39916800.0f );
+	poly = _mm_add_ps( _mm_mul_ps( poly, r2 ), _mm_set1_ps(  1.0f / 362880.0f ) );
+	poly = _mm_add_ps( _mm_mul_ps( poly, r2 ), _mm_set1_ps( -1.0f / 5040.0f ) );
+	poly = _mm_add_ps( _mm_mul_ps( poly, r2 ), _mm_set1_ps(  1.0f / 120.0f ) );
+	poly = _mm_add_ps( _mm_mul_ps( poly, r2 ), _mm_set1_ps( -1.0f / 6.0f ) );
+	poly = _mm_add_ps( _mm_mul_ps( poly, r2 ), _mm_set1_ps(  1.0f ) );
+
+	return _mm_xor_ps( _mm_mul_ps( poly, r ), sign );
+}
+
+#endif
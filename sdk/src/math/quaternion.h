@@ -66,6 +66,22 @@ public:
 	static Quaternion Squad (float fT, const Quaternion& rkP, const Quaternion& rkA, 
 							 const Quaternion& rkB, const Quaternion& rkQ, bool shortestPath = false);
 
+	/// Nlerps (Normalised Linear Interpolation) between two quaternions, along the shortest path.
+	/// This is much cheaper than slerp, but the angular velocity isn't constant.
+	static Quaternion nlerp( float fT, const Quaternion & q1, const Quaternion & q2 );
+
+public:
+	/// Nlerps between arrays of quaternion pairs, each with its own interpolant.
+	/// The result may be either of the source arrays.
+	static void nlerpArray( const float * fT, const Quaternion * q1, const Quaternion * q2, Quaternion * result, unsigned int count );
+
+	/// Slerps between arrays of quaternion pairs, each with its own interpolant. The pairs which are
+	/// close enough that nlerp deviates from slerp by less than maxError (an angle, in radians)
+	/// are nlerped instead. The result may be either of the source arrays. With SSE2, four pairs are slerped
+	/// at a time using polynomial approximations of acos and sin, which agree with slerp() to about 1e-5.
+	static void slerpArray( const float * fT, const Quaternion * q1, const Quaternion * q2, Quaternion * result, unsigned int count,
+							float maxError = 0.f );
+
 public:
 	float x, y, z, w;
 };
@@ -20,6 +20,7 @@ Author:		Eric Bryant
 #include "katana_base_includes.h"
 #include "render/rendertypes.h"
 #include "render/geometry.h"
+#include "base/profiler.h"
 #include "physicssystem.h"
 #include "rigidbody.h"
 #include <ode/ode.h>
@@ -103,6 +104,8 @@ bool PhysicsSystem::terminate()
 //
 void PhysicsSystem::integrate( float deltaTime )
 {
+	KPROFILE( "PhysicsSystem::integrate" );
+
 	// Resolve all collisions within the ODE Space
 	dSpaceCollide( ODE_SPACE, 0, &frictionModel );
 
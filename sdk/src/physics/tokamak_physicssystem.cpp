@@ -14,6 +14,7 @@
 #ifdef PHYSICS_USE_TOKAMAK
 #include "katana_core_includes.h"
 #include "katana_base_includes.h"
+#include "base/profiler.h"
 #include "physicssystem.h"
 #include "rigidbody.h"
 #include "render/rendertypes.h"
@@ -72,6 +73,8 @@ bool PhysicsSystem::terminate()
 //
 void PhysicsSystem::integrate( float deltaTime )
 {
+	KPROFILE( "PhysicsSystem::integrate" );
+
 	// Advance the simulation by the delta time 
 	// (NOTE: Advance takes milliseconds, convert from seconds)
 	TOKAMAK_SIMULATION->Advance( deltaTime * 10 );
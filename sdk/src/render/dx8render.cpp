@@ -169,6 +169,9 @@ bool DX8Render::BeginFrame()
 		return false;
 	}
 
+	// Start counting a new frame
+	BeginFrameStatistics();
+
 	return true;
 }
 
@@ -187,6 +190,9 @@ bool DX8Render::EndFrame()
 	// Swap the Buffers
 	SwapBuffers();
 
+	// Store the counters of the finished frame
+	EndFrameStatistics();
+
 	return true;
 }
 
@@ -212,6 +218,8 @@ bool DX8Render::SetViewport(Camera & Cam)
 	// Store the Projection Matrix
 	m_pD3DDevice->SetTransform(D3DTS_PROJECTION, &matProjection);
 
+	m_frameStatistics.matrixChanges++;
+
 	return true;
 }
 
@@ -258,6 +266,8 @@ bool DX8Render::SetMatrix(MatrixType eType, MatrixFunction eFunct, const Matrix4
 			return false;
 	}
 
+	m_frameStatistics.matrixChanges++;
+
 	return true;
 }
 
@@ -266,6 +276,7 @@ bool DX8Render::SetMatrix(MatrixType eType, MatrixFunction eFunct, const Matrix4
 //
 bool DX8Render::SetState(RenderState * pState)
 {
+	m_frameStatistics.stateChanges++;
 	return m_apStateManager->SetState( pState );
 }
 
@@ -345,6 +356,8 @@ bool DX8Render::RenderGeometry(Geometry * geom)
 	// Restore the z buffering state
 	m_pD3DDevice->SetRenderState( D3DRS_ZENABLE, dwZBuffer );
 
+	CountGeometry( geom );
+
 	return true;
 }
 
@@ -449,8 +462,8 @@ bool DX8Render::RenderVB(VertexBuffer * pVB)
 		if ( pNativeIB == NULL )
 			return false;
 
-		// Setup index source for next render
-		hr = m_pD3DDevice->SetIndices(pNativeIB, 0);
+		// Setup index source for next render. DirectX 8 takes the base vertex index here.
+		hr = m_pD3DDevice->SetIndices(pNativeIB, pVB->getVertexOffset());
 		if ( FAILED(hr) )
 			return false;
 
@@ -473,6 +486,8 @@ bool DX8Render::RenderVB(VertexBuffer * pVB)
 		}
 	}
 
+	CountVB( pVB, pVB->isBufferEnabled(INDEX) );
+
 	return true;
 }
 
@@ -540,8 +555,8 @@ bool DX8Render::RenderVB(VertexBuffer * pVB, IndexBuffer * pIB)
 	// Get the primitive type (the PrimitiveType enumeration corresponds to D3DPRIMITIVETYPE)
 	D3DPRIMITIVETYPE primitiveType = (D3DPRIMITIVETYPE)pVB->getPrimitiveType();
 
-	// Setup index source for next render
-	hr = m_pD3DDevice->SetIndices(pNativeIB, 0);
+	// Setup index source for next render. DirectX 8 takes the base vertex index here.
+	hr = m_pD3DDevice->SetIndices(pNativeIB, pVB->getVertexOffset());
 	if ( FAILED(hr) )
 		return false;
 
@@ -564,6 +579,8 @@ bool DX8Render::RenderVB(VertexBuffer * pVB, IndexBuffer * pIB)
 		return false;
 	}
 
+	CountVB( pVB, true );
+
 	return true;
 }
 
@@ -637,6 +654,8 @@ VertexBuffer * DX8Render::CreateVB(BufferTypes eEnabledBuffers,
 		pVB->SetNativeIndices(pDX8IB);
 	}
 
+	m_frameStatistics.buffersCreated++;
+
 	return pVB;
 }
 
@@ -681,6 +700,8 @@ IndexBuffer * DX8Render::CreateIB(BufferCreationFlags eCreationFlags,
 	// Setup the native DX8 IndexBuffer inside the DX8 VB Wrapper
 	pIB->SetNativeIndices(pDX8IB);
 
+	m_frameStatistics.buffersCreated++;
+
 	return pIB;
 }
 
@@ -726,6 +747,8 @@ bool DX8Render::BindTexture(Texture * pTexture)
 		return false;
 	}
 
+	m_frameStatistics.textureBinds++;
+
 	return true;
 }
 
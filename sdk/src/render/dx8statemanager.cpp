@@ -41,6 +41,7 @@ D3DLIGHTTYPE	__ConvertToLightType( const Light * light );
 //
 DX8StateManager::DX8StateManager() :
 	m_bPreviousLightState(true),
+	m_enabledLights(0),
 	m_bPreviousCullState(true),
 	m_bPreviousZWrite(false),
 	m_bPreviousZTest(false),
@@ -236,6 +237,14 @@ bool DX8StateManager::SetLightState( LightState * light )
 		m_pD3DDevice->LightEnable( index, light->getEnableLights() ? TRUE: FALSE );
 	}
 
+	// Each object has its own lights, so disable the lights left over from the previous object
+	if ( light->getEnableLights() )
+	{
+		for( unsigned int unused = (unsigned int)lights.size(); unused < m_enabledLights; unused++ )
+			m_pD3DDevice->LightEnable( unused, FALSE );
+		m_enabledLights = (unsigned int)lights.size();
+	}
+
 	// Enable or disable DirectX8 lighting
 	m_pD3DDevice->SetRenderState( D3DRS_LIGHTING, light->getEnableLights() ? TRUE : FALSE );
 
@@ -83,6 +83,7 @@ private:
 
 	/// Cache of previous render states
 	bool		m_bPreviousLightState;
+	unsigned int	m_enabledLights;
 	bool		m_bPreviousCullState;
 	bool		m_bPreviousZWrite;
 	bool		m_bPreviousZTest;
@@ -161,6 +161,9 @@ bool DX9Render::BeginFrame()
 		return false;
 	}
 
+	// Start counting a new frame
+	BeginFrameStatistics();
+
 	return true;
 }
 
@@ -179,6 +182,9 @@ bool DX9Render::EndFrame()
 	// Swap the Buffers
 	SwapBuffers();
 
+	// Store the counters of the finished frame
+	EndFrameStatistics();
+
 	return true;
 }
 
@@ -204,6 +210,8 @@ bool DX9Render::SetViewport(Camera & Cam)
 	// Store the Projection Matrix
 	m_pD3DDevice->SetTransform(D3DTS_PROJECTION, &matProjection);
 
+	m_frameStatistics.matrixChanges++;
+
 	return true;
 }
 
@@ -250,6 +258,8 @@ bool DX9Render::SetMatrix(MatrixType eType, MatrixFunction eFunct, const Matrix4
 		return false;
 	}
 
+	m_frameStatistics.matrixChanges++;
+
 	return true;
 }
 
@@ -258,6 +268,7 @@ bool DX9Render::SetMatrix(MatrixType eType, MatrixFunction eFunct, const Matrix4
 //
 bool DX9Render::SetState(RenderState * pState)
 {
+	m_frameStatistics.stateChanges++;
 	return m_apStateManager->SetState( pState );
 }
 
@@ -350,6 +361,8 @@ bool DX9Render::RenderGeometry(Geometry * geom)
 	// Restore the z buffering state
 	m_pD3DDevice->SetRenderState( D3DRS_ZENABLE, dwZBuffer );
 
+	CountGeometry( geom );
+
 	return true;
 }
 
@@ -466,6 +479,8 @@ bool DX9Render::RenderVB(VertexBuffer * pVB)
 		}
 	}
 
+	CountVB( pVB, pVB->isBufferEnabled(INDEX) );
+
 	return true;
 }
 
@@ -548,6 +563,8 @@ bool DX9Render::RenderVB(VertexBuffer * pVB, IndexBuffer * pIB)
 		return false;
 	}
 
+	CountVB( pVB, true );
+
 	return true;
 }
 
@@ -622,6 +639,8 @@ VertexBuffer * DX9Render::CreateVB(BufferTypes eEnabledBuffers,
 		pVB->SetNativeIndices( pDX9IB );
 	}
 
+	m_frameStatistics.buffersCreated++;
+
 	return pVB;
 }
 
@@ -667,6 +686,8 @@ IndexBuffer * DX9Render::CreateIB(BufferCreationFlags eCreationFlags,
 	// Setup the native DX9 IndexBuffer inside the DX9 VB Wrapper
 	pIB->SetNativeIndices( pDX9IB );
 
+	m_frameStatistics.buffersCreated++;
+
 	return pIB;
 }
 
@@ -712,6 +733,8 @@ bool DX9Render::BindTexture(Texture * pTexture)
 		return false;
 	}
 
+	m_frameStatistics.textureBinds++;
+
 	return true;
 }
 
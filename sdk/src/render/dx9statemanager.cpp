@@ -61,6 +61,7 @@ const char * DX9StateManager::PS_ENTRY_POINT = "pixel_main";
 //
 DX9StateManager::DX9StateManager() 
 	: m_bPreviousLightState( true )
+	, m_enabledLights( 0 )
 	, m_bPreviousCullState( true )
 	, m_bPreviousZWrite( false )
 	, m_bPreviousZTest( false )
@@ -315,6 +316,11 @@ bool DX9StateManager::SetLightState( LightState * pLight )
 			m_pD3DDevice->LightEnable( index, pLight->getEnableLights() ? TRUE: FALSE );
 		}
 
+		// Each object has its own lights, so disable the lights left over from the previous object
+		for( unsigned int unused = (unsigned int)lights.size(); unused < m_enabledLights; unused++ )
+			m_pD3DDevice->LightEnable( unused, FALSE );
+		m_enabledLights = (unsigned int)lights.size();
+
 		// Enable or disable DirectX8 lighting
 		m_pD3DDevice->SetRenderState( D3DRS_LIGHTING, pLight->getEnableLights() ? TRUE : FALSE );
 
@@ -148,8 +148,8 @@ void Geometry::createBox( shared_ptr<Geometry> spGeometry, Point3 & vMin, Point3
 //
 // createSphere
 //
-// Static function which finds the sphere containing the points in the Geometry using 
-// average of the values.
+// Static function which finds a tight sphere containing the points in the Geometry
+// (see Bound::fit).
 //
 void Geometry::createSphere( shared_ptr<Geometry> spGeometry, Point3 & vCenter, float & fRadius )
 {
@@ -159,29 +159,29 @@ void Geometry::createSphere( shared_ptr<Geometry> spGeometry, Point3 & vCenter,
 		const Point3 * pPoints = reinterpret_cast<const Point3 *>( &spGeometry->m_vertexBuffer->front() );
 		const unsigned int uiPointCount = spGeometry->m_vertexBuffer->size() / 3;
 
-		// Compute the Average of Points
-		vCenter = pPoints[0];
+		Bound bound;
+		bound.fit( pPoints, uiPointCount );
 
-		for( unsigned uiIndex = 1; uiIndex < uiPointCount; uiIndex++ )
-			vCenter += pPoints[uiIndex];
-
-		float fInvQuantity = 1.f / uiPointCount;
-		vCenter *= fInvQuantity;
-
-		// Compute the Smallest Radius from Pt to Average
-		float fRadiusSqr = 0.f, fMaxRadiusSqr = 0.f;
-		Point3 ptDiff;
+		vCenter = bound.m_center;
+		fRadius = bound.m_radius;
+	}
+}
 
-		for(uiIndex = 0; uiIndex < uiPointCount; uiIndex++)
-		{
-			ptDiff = pPoints[uiIndex] - vCenter;
-			fRadiusSqr = ptDiff.getSqrLength();
-			if ( fRadiusSqr > fMaxRadiusSqr )
-				fMaxRadiusSqr = fRadiusSqr;
-		}
+//
+// createOrientedBox
+//
+// Static function which finds the oriented box containing the points in the Geometry,
+// aligned to the principal axes of the points.
+//
+void Geometry::createOrientedBox( shared_ptr<Geometry> spGeometry, OrientedBox & box )
+{
+	if ( spGeometry && spGeometry->m_vertexBuffer && spGeometry->m_vertexBuffer->size() )
+	{
+		// Reinterpret out vertex buffer points (which are floats) to Point3s
+		const Point3 * pPoints = reinterpret_cast<const Point3 *>( &spGeometry->m_vertexBuffer->front() );
+		const unsigned int uiPointCount = spGeometry->m_vertexBuffer->size() / 3;
 
-		// Store the radius
-		fRadius = sqrt( fMaxRadiusSqr );
+		box.fit( pPoints, uiPointCount );
 	}
 }
 
@@ -77,10 +77,14 @@ struct Geometry
 	/// of points in the Geometry.
 	static void createBox( shared_ptr<Geometry> spGeometry, Point3 & vMin, Point3 & vMax );
 
-	/// Static function which finds the sphere containing the points in the Geometry using 
-	/// average of the values.
+	/// Static function which finds a tight sphere containing the points in the Geometry
+	/// (see Bound::fit).
 	static void createSphere( shared_ptr<Geometry> spGeometry, Point3 & vCenter, float & fRadius );
 
+	/// Static function which finds the oriented box containing the points in the Geometry,
+	/// aligned to the principal axes of the points.
+	static void createOrientedBox( shared_ptr<Geometry> spGeometry, OrientedBox & box );
+
 	/// Static function which finds cylinder containing the points in the Geometry
 	static void createCylinder( shared_ptr<Geometry> spGeometry, Point3 & vCenter, Point3 & vDirection, float & fHeight, float & fRadius );
 
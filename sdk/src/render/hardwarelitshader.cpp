@@ -33,27 +33,68 @@ KIMPLEMENT_RTTI( HardwareLitShader, Shader );
 // HardwareLitShader
 // ------------------------------------------------------------------
 
+//
+// Constructor
+//
+HardwareLitShader::HardwareLitShader() :
+	m_bTextureMaps( true ),
+	m_bBlending( true ),
+	m_bLighting( true )
+{
+}
+
 //
 // OnPreRender
-// Called for every object which needs to render with this shader.
+// Called once before a batch of objects is rendered with this shader.
 //
 bool HardwareLitShader::OnPreRender( SceneContext * context )
 {
-	// Get a pointer to the currently rendered object
-	Visible * pCurrentVisibleObject = context->currentVisibleObject;
+	// Setup the lights of the first object of the batch
+	SetLights( context );
+
+	// Call the base class to execute the pre render states
+	return Shader::OnPreRender( context );
+}
+
+//
+// OnRenderObject
+// Called for every object which needs to render with this shader.
+//
+bool HardwareLitShader::OnRenderObject( SceneContext * context )
+{
+	// Get the material of the currently rendered object
+	const shared_ptr<Material> & material = context->currentMaterial;
 
 	// Store this world view matrix with the render device. This is so
 	// the next step in rendering, Visible::OnRender(), will already have 
 	// the current world view matrix set.
-	context->currentRenderer->SetMatrix( MODELVIEW, STORE, pCurrentVisibleObject->getWorldMatrix() );
+	context->currentRenderer->SetMatrix( MODELVIEW, STORE, *context->currentWorldMatrix );
+
+	// Every object has its own lights, which only need updating when they differ from the last object's
+	if ( context->currentLightsChanged )
+		SetLights( context );
+
+	// The render queue is sorted by material, so the texture and material
+	// states only need updating when the material differs from the last object.
+	// The material states are also needed once lights are enabled.
+	if ( !context->currentMaterialChanged )
+	{
+		if ( context->currentLightsChanged && m_bLighting && context->currentLights.size() && material )
+		{
+			MaterialState materialState( material );
+			context->currentRenderer->SetState( &materialState );
+		}
+
+		return true;
+	}
 
 	// If texture mapping is allowed, then grab the diffuse texture from
 	// the visible object's material and set this as the target texture map
-	if ( m_bTextureMaps && pCurrentVisibleObject->getMaterial() )
+	if ( m_bTextureMaps && material )
 	{
 		// Generate the texture states. The state will be responsible for setting the appropate texture slots
 		// TODO: Support blending
-		MultitextureState multiTextureState( pCurrentVisibleObject->getMaterial() );
+		MultitextureState multiTextureState( material );
 
 		// Setup the textures within the renderer
 		context->currentRenderer->SetState( &multiTextureState );
@@ -65,17 +106,25 @@ bool HardwareLitShader::OnPreRender( SceneContext * context )
 		context->currentRenderer->SetState( &MultitextureState() );
 	}
 
-	// If lighting is enabled, then setup the material states and the lighting parameters
-	if ( m_bLighting && context->currentLights.size() )
+	// If lighting is enabled, then setup the material states (if applicable)
+	if ( m_bLighting && context->currentLights.size() && material )
 	{
-		// First, generate the material state (if applicable)
-		if ( pCurrentVisibleObject->getMaterial() )
-		{
-			MaterialState materialState( pCurrentVisibleObject->getMaterial() );
-			context->currentRenderer->SetState( &materialState );
-		}
+		MaterialState materialState( material );
+		context->currentRenderer->SetState( &materialState );
+	}
 
-		// Next, tell the renderer to light the scene using vertex lighting
+	return true;
+}
+
+//
+// SetLights
+// Sets the lights of the current object within the renderer
+//
+void HardwareLitShader::SetLights( SceneContext * context )
+{
+	if ( m_bLighting && context->currentLights.size() )
+	{
+		// Tell the renderer to light the object using vertex lighting
 		LightState lightState( context->currentLights );
 		context->currentRenderer->SetState( &lightState );
 	}
@@ -84,9 +133,6 @@ bool HardwareLitShader::OnPreRender( SceneContext * context )
 		// If there are no lights or if it's disabled, turn off lighting
 		context->currentRenderer->SetState( &LightState() );
 	}
-
-	// Call the base class to execute the pre render states
-	return Shader::OnPreRender( context );
 }
 
 // ------------------------------------------------------------------------
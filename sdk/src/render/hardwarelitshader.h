@@ -27,6 +27,8 @@ class HardwareLitShader
 	KDECLARE_SCRIPT;
 
 public:
+	/// Constructor
+	HardwareLitShader();
 
 	/// Enables texture mapping. This is TRUE by default.
 	void enableTextures( bool enable );
@@ -41,6 +43,11 @@ public:
 
 	// Shader Interface 
 	virtual bool OnPreRender( SceneContext * context );
+	virtual bool OnRenderObject( SceneContext * context );
+
+protected:
+	/// Sets the lights of the current object within the renderer
+	void SetLights( SceneContext * context );
 
 protected:
 	bool	m_bTextureMaps;	/// Are texture maps used?
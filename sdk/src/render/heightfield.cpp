@@ -9,6 +9,8 @@
 */
 
 #include <math.h>
+#include <string.h>
+#include <limits.h>
 
 #include "katana_core_includes.h"
 #include "katana_base_includes.h"
@@ -120,6 +122,33 @@ bool Heightfield::loadFromTexture( const char * szHeightMapFile )
 	return true;
 }
 
+//
+// create
+//
+bool Heightfield::create( const unsigned short * heights, unsigned int width, unsigned int height, int worldWidth, int worldHeight )
+{
+	if ( !heights || width < 2 || height < 2 ) return false;
+
+	// Release any previous height map
+	delete [] m_heightMapData;
+	delete [] m_heightmapNormals;
+	m_heightmapNormals = NULL;
+
+	// Copy the heights
+	m_heightMapData = new unsigned short[ width * height ];
+	memcpy( m_heightMapData, heights, width * height * sizeof(unsigned short) );
+
+	// Store the dimensions
+	m_dataWidth = width;
+	m_dataHeight = height;
+	m_worldScaleWidth = worldWidth / float(m_dataWidth);
+	m_worldScaleHeight = worldHeight / float(m_dataHeight);
+
+	computeNormals();
+
+	return true;
+}
+
 //
 // getHeightAt
 //
@@ -203,11 +232,57 @@ Point3 Heightfield::getNormalAt( unsigned int x, unsigned int z ) const
 //
 int Heightfield::convertToTriangles( float heightScale )
 {
+	// The indices are 16-bit, which limits the number of vertices
+	if ( !isValid() || m_dataWidth * m_dataHeight > USHRT_MAX + 1 ) return 0;
+
 	// Setup the geometry parameters
 	m_enabledBuffers = VERTEX | INDEX;
 	m_primitiveType = TRIANGLE_LIST;
 
-	return 0;
+	unsigned int x, z;
+
+	// One vertex per height sample
+	m_vertexBuffer.reset( new vector<float> );
+	m_vertexBuffer->reserve( m_dataWidth * m_dataHeight * 3 );
+
+	for( z = 0; z < m_dataHeight; z++ )
+	{
+		for( x = 0; x < m_dataWidth; x++ )
+		{
+			m_vertexBuffer->push_back( x * m_worldScaleWidth );
+			m_vertexBuffer->push_back( getHeightAt( x, z ) * heightScale );
+			m_vertexBuffer->push_back( z * m_worldScaleHeight );
+		}
+	}
+
+	// Two triangles per cell
+	m_indexBuffer.reset( new vector<unsigned short> );
+	m_indexBuffer->reserve( ( m_dataWidth - 1 ) * ( m_dataHeight - 1 ) * 6 );
+
+	for( z = 0; z < m_dataHeight - 1; z++ )
+	{
+		for( x = 0; x < m_dataWidth - 1; x++ )
+		{
+			const unsigned short i00 = (unsigned short)( x + z * m_dataWidth );
+			const unsigned short i10 = i00 + 1;
+			const unsigned short i01 = (unsigned short)( i00 + m_dataWidth );
+			const unsigned short i11 = i01 + 1;
+
+			m_indexBuffer->push_back( i00 );
+			m_indexBuffer->push_back( i01 );
+			m_indexBuffer->push_back( i10 );
+
+			m_indexBuffer->push_back( i10 );
+			m_indexBuffer->push_back( i01 );
+			m_indexBuffer->push_back( i11 );
+		}
+	}
+
+	m_vertexCount = m_dataWidth * m_dataHeight;
+	m_indexCount = (unsigned int)m_indexBuffer->size();
+	m_primitiveCount = m_indexCount / 3;
+
+	return m_primitiveCount;
 }
 
 //
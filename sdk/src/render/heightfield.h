@@ -41,6 +41,10 @@ public:
 	/// Loads height map data from a texture
 	bool loadFromTexture( const char * szHeightMapFile );
 
+	/// Creates the height map from raw heights (width x height samples, row by row).
+	/// This is used for procedurally generated height maps.
+	bool create( const unsigned short * heights, unsigned int width, unsigned int height, int worldWidth, int worldHeight );
+
 	/// Checks whether the height field contains valid data
 	bool isValid() const							{ return m_heightMapData != 0; }
 
@@ -71,7 +75,8 @@ public:
 
 	/// Convert the height map into triangles suitable for rendering. Because this derives
 	/// from Geometry, you can render this height field by passing it to a VisMesh(Geometry *).
-	/// Returns the number of triangles generated.
+	/// Returns the number of triangles generated (zero if the height field has more vertices
+	/// than 16-bit indices can address).
 	int convertToTriangles( float heightScale = 1.0 );
 
 private:
@@ -0,0 +1,147 @@
+/*
+	Katana Engine
+	Copyright  2001-2004 Eric Bryant, Inc.
+
+	File:		nullindexbuffer.cpp
+	Author:		Eric Bryant
+
+	Null Index Buffer (system memory only)
+*/
+
+#include "katana_core_includes.h"
+#include "katana_base_includes.h"
+#include "rendertypes.h"
+#include "indexbuffer.h"
+#include "nullindexbuffer.h"
+
+// -------------------------------------------
+// NullIndexBuffer
+// -------------------------------------------
+
+//
+// Constructor
+//
+NullIndexBuffer::NullIndexBuffer(unsigned int uiIndexCount, BufferCreationFlags eCreationFlags) :
+	IndexBuffer(uiIndexCount, eCreationFlags),
+	m_uploadedBytes(0)
+{
+	// The base class leaves the lock/upload flags uninitialized
+	m_bLocked = false;
+	m_bUploaded = false;
+}
+
+//
+// Destructor
+//
+NullIndexBuffer::~NullIndexBuffer()
+{
+	Unlock();
+}
+
+//
+// Initialize
+//
+bool NullIndexBuffer::Initialize()
+{
+	// Allocate the system memory buffer
+	m_indexData.resize( m_indexCount );
+	m_uploadedBytes = 0;
+
+	return true;
+}
+
+//
+// Lock
+//
+bool NullIndexBuffer::Lock()
+{
+	return LockRange( 0, getActiveIndexCount() );
+}
+
+//
+// LockRange
+//
+bool NullIndexBuffer::LockRange(unsigned int uiStartIndex, unsigned int uiIndexCount)
+{
+	if ( uiStartIndex + uiIndexCount > m_indexData.size() )
+		return false;
+
+	// Store the address of the locked index buffer
+	m_hwIndexBufferData.set( m_indexData.empty() ? 0 : &m_indexData[uiStartIndex], uiIndexCount );
+	m_bLocked = true;
+
+	return true;
+}
+
+//
+// Unlock
+//
+bool NullIndexBuffer::Unlock()
+{
+	if ( false == m_bLocked )
+		return false;
+
+	// Everything written between Lock() and Unlock() is considered uploaded
+	m_uploadedBytes += m_hwIndexBufferData.size() * sizeof(unsigned short);
+
+	m_hwIndexBufferData.reset();
+	m_bLocked = false;
+
+	// We can assume that we've successfully uploaded the index buffer
+	m_bUploaded = true;
+
+	return true;
+}
+
+//
+// UploadBuffers
+//
+bool NullIndexBuffer::UploadBuffers()
+{
+	// For static buffers, this only needs to happen once.
+	if ( true == m_bUploaded )
+		return true;
+
+	// Lock the Buffer to get a pointer to the system memory buffer
+	if ( false == Lock() )
+		return false;
+
+	// Packs the index buffers
+	PackIndexBuffer();
+
+	// Unlock the Buffer
+	if ( false == Unlock() )
+		return false;
+
+	return true;
+}
+
+//
+// TakeUploadedBytes
+//
+unsigned int NullIndexBuffer::TakeUploadedBytes()
+{
+	unsigned int uiBytes = m_uploadedBytes;
+	m_uploadedBytes = 0;
+	return uiBytes;
+}
+
+//
+// PackIndexBuffer
+//
+void NullIndexBuffer::PackIndexBuffer()
+{
+	if ( m_hwIndexBufferData.empty() || !m_spIndexBuffer )
+		return;
+
+	// Only copy the indices the source buffer contains
+	unsigned int uiIndexCount = m_hwIndexBufferData.size();
+	if ( uiIndexCount > m_spIndexBuffer->size() )
+		uiIndexCount = m_spIndexBuffer->size();
+
+	// Store the Index Data inside the buffer
+	for (unsigned int uiIndex = 0; uiIndex < uiIndexCount; uiIndex++)
+	{
+		m_hwIndexBufferData[uiIndex] = m_spIndexBuffer->at(uiIndex);
+	}
+}
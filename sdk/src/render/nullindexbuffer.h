@@ -0,0 +1,54 @@
+/*
+	Katana Engine
+	Copyright  2001-2004 Eric Bryant, Inc.
+
+	File:		nullindexbuffer.h
+	Author:		Eric Bryant
+
+	Null Index Buffer (system memory only)
+*/
+
+#ifndef _NULLINDEXBUFFER_H
+#define _NULLINDEXBUFFER_H
+
+namespace Katana
+{
+
+class NullIndexBuffer : public IndexBuffer
+{
+public:
+	/// Constructor
+	NullIndexBuffer( unsigned int uiIndexCount, BufferCreationFlags eCreationFlags );
+
+	/// Destructor
+	virtual ~NullIndexBuffer();
+
+	/// Initialize the vertex buffer as necessary
+	virtual bool Initialize();
+
+	/// Lock/Unlock the vertex buffers
+	virtual bool Lock();
+	virtual bool LockRange(unsigned int uiStartIndex, unsigned int uiIndexCount);
+	virtual bool Unlock();
+
+	/// Packs the indices into the system memory buffer
+	virtual bool UploadBuffers();
+
+	/// Returns the number of bytes written since the last call, and clears the count
+	unsigned int TakeUploadedBytes();
+
+private:
+	/// Packs the index buffer into a flat array
+	void PackIndexBuffer();
+
+private:
+	/// System memory copy of the indices
+	vector<unsigned short>	m_indexData;
+
+	/// Number of bytes written through Lock()/Unlock() not yet reported to the renderer
+	unsigned int			m_uploadedBytes;
+};
+
+}; // Katana
+
+#endif // _NULLINDEXBUFFER_H
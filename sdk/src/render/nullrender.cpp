@@ -0,0 +1,319 @@
+/*
+	Katana Engine
+	Copyright  2001-2004 Eric Bryant, Inc.
+
+	File:		nullrender.cpp
+	Author:		Eric Bryant
+
+	Concrete Render class which does not touch any hardware. All the submissions
+	are counted instead of drawn, which makes it possible to run the frame loop
+	headless and measure the CPU cost of a frame.
+*/
+
+#include <string.h>
+#include "katana_config.h"
+#include "katana_core_includes.h"
+#include "katana_base_includes.h"
+#include "rendertypes.h"
+#include "geometry.h"
+#include "indexbuffer.h"
+#include "vertexbuffer.h"
+#include "render.h"
+#include "nullrender.h"
+#include "nullvertexbuffer.h"
+#include "nullindexbuffer.h"
+
+//
+// Constructor
+//
+NullRender::NullRender() :
+	m_bInit(false),
+	m_bInFrame(false),
+	m_backgroundColor(0.f, 0.f, 0.f, 1.f)
+{
+}
+
+//
+// Destructor
+//
+NullRender::~NullRender()
+{
+	Shutdown();
+}
+
+//
+// Initialize
+//
+bool NullRender::Initialize(RenderInfo & Info)
+{
+	// Plug the RenderInfo as the target rendering parameters
+	m_RenderInfo = Info;
+
+	// Report the capabilities of the "device"
+	m_RenderInfo.eDriver = RenderInfo::NULL_RENDER;
+	m_RenderInfo.iMaximumTextureUnits = MAX_TEXTURE_PASSES;
+	m_RenderInfo.iMaximumTexutreSize = 4096;
+	m_RenderInfo.iMaximumHardwareLights = 8;
+	m_RenderInfo.iMaximumClipPlanes = 6;
+	m_RenderInfo.bSupportCubeMaps = true;
+	m_RenderInfo.bSupportProjectedTextures = true;
+	m_RenderInfo.uiMaxViewWidth = Info.uiTargetWidth;
+	m_RenderInfo.uiMaxViewHeight = Info.uiTargetHeight;
+	m_RenderInfo.uiMaxColorDepth = Info.uiTargetColorDepth;
+
+	strncpy( m_RenderInfo.szDriverName, "Null Renderer", RenderInfo::MAX_NAME_SIZE );
+	strncpy( m_RenderInfo.szDriverVersion, "1.0", RenderInfo::MAX_NAME_SIZE );
+	strncpy( m_RenderInfo.szVendorName, "Katana", RenderInfo::MAX_NAME_SIZE );
+	m_RenderInfo.szExtensions[0] = 0;
+	m_RenderInfo.szVertexShaderProfile[0] = 0;
+	m_RenderInfo.szPixelShaderProfile[0] = 0;
+
+	// Copy the capabilities back to the client
+	Info = m_RenderInfo;
+
+	// Start with fresh counters
+	resetStatistics();
+
+	// We are now ready to go
+	m_bInit = true;
+	m_isInitialized = true;
+
+	// Logging Activity
+	KLOG("Null Renderer Initialization (%dx%dx%d)", m_RenderInfo.uiTargetWidth, m_RenderInfo.uiTargetHeight, m_RenderInfo.uiTargetColorDepth);
+
+	return true;
+}
+
+//
+// Shutdown
+//
+bool NullRender::Shutdown()
+{
+	// Makes no sense to shutdown if we aren't initialized
+	if ( false == m_bInit )
+		return false;
+
+	// Log Activity
+	KLOG("Null Renderer Shutdown (%d frames, %d draw calls, %d primitives)",
+		m_totalStatistics.frames, m_totalStatistics.drawCalls, m_totalStatistics.primitives);
+
+	m_bInit = false;
+	m_isInitialized = false;
+
+	return true;
+}
+
+//
+// BeginFrame
+//
+bool NullRender::BeginFrame()
+{
+	if ( true == m_bInFrame )
+	{
+		SetError(UNKNOWN_ERROR, "NullRender::BeginFrame() called twice without EndFrame().");
+		return false;
+	}
+
+	// Start counting a new frame
+	BeginFrameStatistics();
+	m_bInFrame = true;
+
+	return true;
+}
+
+//
+// EndFrame
+//
+bool NullRender::EndFrame()
+{
+	if ( false == m_bInFrame )
+	{
+		SetError(UNKNOWN_ERROR, "NullRender::EndFrame() called without BeginFrame().");
+		return false;
+	}
+
+	// Store the counters of the finished frame
+	EndFrameStatistics();
+	m_bInFrame = false;
+
+	return true;
+}
+
+//
+// SetViewport
+//
+bool NullRender::SetViewport(Camera & Cam)
+{
+	m_frameStatistics.matrixChanges++;
+	return true;
+}
+
+//
+// SetMatrix
+//
+bool NullRender::SetMatrix(MatrixType eType, MatrixFunction eFunct, const Matrix4 & Mat)
+{
+	// Validate the enumerations the same way the hardware renderers do
+	if ( eType != TEXTURE && eType != MODELVIEW && eType != PROJECTION )
+		return false;
+
+	if ( eFunct != MULTIPLY && eFunct != STORE && eFunct != PUSH && eFunct != POP )
+		return false;
+
+	m_frameStatistics.matrixChanges++;
+	return true;
+}
+
+//
+// SetState
+//
+bool NullRender::SetState(RenderState * pState)
+{
+	if ( pState == NULL )
+		return false;
+
+	m_frameStatistics.stateChanges++;
+	return true;
+}
+
+//
+// RenderGeometry
+//
+bool NullRender::RenderGeometry(Geometry * geom)
+{
+	// No Primitives to Render, Don't Bother
+	if ( !geom || geom->m_primitiveCount == 0 || !geom->m_vertexBuffer || !geom->m_vertexBuffer->size() ) return false;
+
+	CountGeometry( geom );
+
+	return true;
+}
+
+//
+// RenderVB
+//
+bool NullRender::RenderVB(VertexBuffer * pVB)
+{
+	// Check if the VB is valid
+	if ( pVB == NULL )
+		return false;
+
+	// Update the Vertex Buffer
+	if ( false == pVB->UploadBuffers() )
+		return false;
+
+	// NOTE: This is unsafe, but we can't do a safe dynamic cast because
+	//		 VertexBuffer inherits PROTECTED from RTTI
+	NullVertexBuffer * pNullVB = static_cast<NullVertexBuffer *>(pVB);
+
+	// Collect the bytes written into the buffer since it was last drawn
+	m_frameStatistics.bytesUploaded += pNullVB->TakeUploadedBytes();
+
+	CountVB( pVB, pVB->isBufferEnabled(INDEX) );
+
+	return true;
+}
+
+//
+// RenderVB
+//
+bool NullRender::RenderVB(VertexBuffer * pVB, IndexBuffer * pIB)
+{
+	if ( pVB == NULL || pIB == NULL )
+		return false;
+
+	// Update the Vertex Buffer
+	if ( false == pVB->UploadBuffers() )
+		return false;
+
+	// Update the Index Buffer
+	if ( false == pIB->UploadBuffers() )
+		return false;
+
+	// NOTE: This is unsafe, but we can't do a safe dynamic cast because
+	//		 VertexBuffer inherits PROTECTED from RTTI
+	NullVertexBuffer * pNullVB = static_cast<NullVertexBuffer *>(pVB);
+	NullIndexBuffer * pNullIB = static_cast<NullIndexBuffer *>(pIB);
+
+	// Collect the bytes written into the buffers since they were last drawn
+	m_frameStatistics.bytesUploaded += pNullVB->TakeUploadedBytes();
+	m_frameStatistics.bytesUploaded += pNullIB->TakeUploadedBytes();
+
+	CountVB( pVB, true );
+
+	return true;
+}
+
+//
+// CreateVB
+//
+VertexBuffer * NullRender::CreateVB(BufferTypes eEnabledBuffers,
+									BufferCreationFlags eCreationFlags,
+									unsigned int uiVertexCount,
+									unsigned int uiIndexCount)
+{
+	// Create the system memory vertex buffer
+	NullVertexBuffer * pVB = new NullVertexBuffer( uiVertexCount, uiIndexCount, eEnabledBuffers, eCreationFlags );
+	if ( NULL == pVB )
+	{
+		SetError(UNABLE_TO_CREATE_VB, "Creation of NullVertexBuffer failed.");
+		return 0;
+	}
+
+	// Allocate the system memory buffers
+	pVB->Initialize();
+
+	m_frameStatistics.buffersCreated++;
+
+	return pVB;
+}
+
+//
+// CreateIB
+//
+IndexBuffer * NullRender::CreateIB(BufferCreationFlags eCreationFlags,
+								   unsigned int uiIndexCount)
+{
+	// Create the system memory index buffer
+	NullIndexBuffer * pIB = new NullIndexBuffer( uiIndexCount, eCreationFlags );
+	if ( NULL == pIB )
+	{
+		SetError(UNABLE_TO_CREATE_VB, "Creation of NullIndexBuffer failed.");
+		return 0;
+	}
+
+	// Allocate the system memory buffer
+	pIB->Initialize();
+
+	m_frameStatistics.buffersCreated++;
+
+	return pIB;
+}
+
+//
+// BindTexture
+//
+bool NullRender::BindTexture(Texture * pTexture)
+{
+	if ( pTexture == NULL )
+		return false;
+
+	m_frameStatistics.textureBinds++;
+	return true;
+}
+
+//
+// GrabScreenBuffer
+//
+bool NullRender::GrabScreenBuffer(char * pBuffer, unsigned int uiLeft, unsigned uiTop, unsigned uiRight, unsigned int uiBottom)
+{
+	return false; // There is no screen buffer
+}
+
+//
+// SetBackgroundColor
+//
+void NullRender::SetBackgroundColor(ColorA & color)
+{
+	m_backgroundColor = color;
+}
@@ -0,0 +1,95 @@
+/*
+	Katana Engine
+	Copyright  2001-2004 Eric Bryant, Inc.
+
+	File:		nullrender.h
+	Author:		Eric Bryant
+
+	Concrete Render class which does not touch any hardware. All the submissions
+	are counted instead of drawn, which makes it possible to run the frame loop
+	headless and measure the CPU cost of a frame.
+*/
+
+#ifndef _NULLRENDER_H
+#define _NULLRENDER_H
+
+namespace Katana
+{
+
+///
+/// NullRender
+/// Concrete Render class which keeps all buffers on the CPU and
+/// counts the submissions instead of drawing them.
+///
+class NullRender : public Render
+{
+public:
+	/// Constructor
+	NullRender();
+
+	/// Destructor
+	virtual ~NullRender();
+
+	/// Startup the renderer
+	virtual bool Initialize(RenderInfo & Info);
+
+	/// Shutdown the renderer
+	virtual bool Shutdown();
+
+	/// Begin frame (analogous to OGL glBegin/glEnd)
+	virtual bool BeginFrame();
+
+	/// End frame (analogous to OGL glBegin/glEnd)
+	virtual bool EndFrame();
+
+	/// Setup a new viewport
+	virtual bool SetViewport(Camera & Cam);
+
+	/// Setup the parameters of a matrix
+	virtual bool SetMatrix(MatrixType eType, MatrixFunction eFunct, const Matrix4 & Mat);
+
+	/// Sets a render state (alpha blend, etc.)
+	virtual bool SetState(RenderState * pState);
+
+	/// Renders a geometry primitive
+	virtual bool RenderGeometry(Geometry * geom);
+
+	/// Renders a Vertex Buffer
+	virtual bool RenderVB(VertexBuffer * pVB);
+
+	/// Renders a Vertex Buffer with an explicit Index Buffer
+	virtual bool RenderVB(VertexBuffer * pVB, IndexBuffer * pIB);
+
+	/// Creates a blank vertex buffer
+	virtual VertexBuffer * CreateVB(BufferTypes eEnabledBuffers = VERTEX | TEXTURE_0 | INDEX,
+		BufferCreationFlags eCreationFlags = STATIC | WRITE_ONLY,
+		unsigned int uiVertexCount = 512,
+		unsigned int uiIndexCount = 512);
+
+	/// Creates a blank index buffer
+	virtual IndexBuffer *  CreateIB(BufferCreationFlags eCreationFlags = STATIC | WRITE_ONLY,
+		unsigned int uiIndexCount = 512);
+
+	/// Binds the texture for the next render pass
+	virtual bool BindTexture(Texture * pTexture);
+
+	/// Grabs an image from the current screen buffer
+	virtual bool GrabScreenBuffer(char * pBuffer, unsigned int uiLeft, unsigned uiTop, unsigned uiRight, unsigned int uiBottom);
+
+	/// Sets the color of the background
+	virtual void SetBackgroundColor(ColorA & color);
+
+private:
+	/// Is the renderer initialized
+	bool					m_bInit;
+
+	/// Are we between BeginFrame() and EndFrame()
+	bool					m_bInFrame;
+
+	/// The background color (unused, stored for completeness)
+	ColorA					m_backgroundColor;
+};
+
+} // Katana
+
+#endif // _NULLRENDER_H
@@ -0,0 +1,280 @@
+/*
+	Katana Engine
+	Copyright  2001-2004 Eric Bryant, Inc.
+
+	File:		nullvertexbuffer.cpp
+	Author:		Eric Bryant
+
+	Null Vertex Buffer (system memory only)
+*/
+
+#include "katana_core_includes.h"
+#include "katana_base_includes.h"
+#include "rendertypes.h"
+#include "geometry.h"
+#include "vertexbuffer.h"
+#include "nullvertexbuffer.h"
+
+// ----------------------------------------------------
+// Macros
+// ----------------------------------------------------
+
+#define CHECK_FLAG(var, flag) (var&flag) == flag
+
+// ----------------------------------------------------
+// Local Functions
+// ----------------------------------------------------
+
+static void PackFloats( char *& pDest, const shared_ptr< vector<float> > & spSource, unsigned int uiVertex, unsigned int uiStride );
+static void PackColor( char *& pDest, const shared_ptr< vector<float> > & spSource, unsigned int uiVertex );
+
+// ----------------------------------------------------
+// NullVertexBuffer
+// ----------------------------------------------------
+
+//
+// Constructor
+//
+NullVertexBuffer::NullVertexBuffer(unsigned int uiVertexCount,
+								   unsigned int uiIndexCount,
+								   BufferTypes eEnabledBuffers,
+								   BufferCreationFlags eCreationFlags) :
+	VertexBuffer(uiVertexCount, uiIndexCount, eEnabledBuffers, eCreationFlags),
+	m_uploadedBytes(0)
+{
+}
+
+//
+// Destructor
+//
+NullVertexBuffer::~NullVertexBuffer()
+{
+	Unlock();
+}
+
+//
+// Initialize
+//
+bool NullVertexBuffer::Initialize()
+{
+	// Allocate the system memory buffers
+	m_vertexData.resize( m_vertexCount * GetVertexStride() );
+
+	if ( true == isBufferEnabled(INDEX) )
+		m_indexData.resize( m_indexCount );
+
+	m_uploadedBytes = 0;
+
+	return true;
+}
+
+//
+// Lock
+//
+bool NullVertexBuffer::Lock()
+{
+	return LockRange( 0, getActiveVertexCount(), 0, isBufferEnabled(INDEX) ? getActiveIndexCount() : 0 );
+}
+
+//
+// LockRange
+//
+bool NullVertexBuffer::LockRange( unsigned int uiStartVertex, unsigned int uiVertexCount,
+								  unsigned int uiStartIndex,  unsigned int uiIndexCount )
+{
+	const unsigned int uiStride = GetVertexStride();
+
+	// Check the range against the system memory buffer
+	if ( !uiStride || ( uiStartVertex + uiVertexCount ) * uiStride > m_vertexData.size() )
+		return false;
+
+	// Store the address of the locked vertex buffer
+	m_hwVertexBufferData.set( m_vertexData.empty() ? 0 : &m_vertexData[uiStartVertex * uiStride], uiVertexCount * uiStride );
+
+	// Lock the Index Buffer
+	if ( true == isBufferEnabled(INDEX) && uiIndexCount )
+	{
+		if ( uiStartIndex + uiIndexCount > m_indexData.size() )
+			return false;
+
+		// Store the address of the locked index buffer
+		m_hwIndexBufferData.set( &m_indexData[uiStartIndex], uiIndexCount );
+	}
+
+	m_isLocked = true;
+
+	return true;
+}
+
+//
+// Unlock
+//
+bool NullVertexBuffer::Unlock()
+{
+	if ( false == m_isLocked )
+		return false;
+
+	// Everything written between Lock() and Unlock() is considered uploaded
+	m_uploadedBytes += m_hwVertexBufferData.size();
+	m_uploadedBytes += m_hwIndexBufferData.size() * sizeof(unsigned short);
+
+	m_hwVertexBufferData.reset();
+	m_hwIndexBufferData.reset();
+	m_isLocked = false;
+
+	// We can assume that we've successfully uploaded the vertex buffer
+	m_bUploaded = true;
+
+	return true;
+}
+
+//
+// UploadBuffers
+//
+bool NullVertexBuffer::UploadBuffers()
+{
+	// For static buffers, this only needs to happen once.
+	if ( true == m_bUploaded )
+		return true;
+
+	// Lock the Buffer to get a pointer to the system memory buffer
+	if ( false == Lock() )
+		return false;
+
+	// Packs the vertex and index buffers
+	PackVertexBuffer();
+	PackIndexBuffer();
+
+	// Unlock the Buffer
+	if ( false == Unlock() )
+		return false;
+
+	return true;
+}
+
+//
+// GetVertexStride
+//
+unsigned int NullVertexBuffer::GetVertexStride() const
+{
+	unsigned int uiStride = 0;
+
+	if ( CHECK_FLAG(m_enabledBuffers, VERTEX) )		uiStride += sizeof(float) * 3;
+	if ( CHECK_FLAG(m_enabledBuffers, VERTEX_T) )	uiStride += sizeof(float) * 4;
+	if ( CHECK_FLAG(m_enabledBuffers, NORMALS) )	uiStride += sizeof(float) * 3;
+	if ( CHECK_FLAG(m_enabledBuffers, COLOR) )		uiStride += sizeof(unsigned int);
+	if ( CHECK_FLAG(m_enabledBuffers, TEXTURE_0) )	uiStride += sizeof(float) * 2;
+	if ( CHECK_FLAG(m_enabledBuffers, TEXTURE_1) )	uiStride += sizeof(float) * 2;
+	if ( CHECK_FLAG(m_enabledBuffers, TEXTURE_2) )	uiStride += sizeof(float) * 2;
+	if ( CHECK_FLAG(m_enabledBuffers, TEXTURE_3) )	uiStride += sizeof(float) * 2;
+	if ( CHECK_FLAG(m_enabledBuffers, TANGENT_S) )	uiStride += sizeof(float) * 3;
+	if ( CHECK_FLAG(m_enabledBuffers, TANGENT_T) )	uiStride += sizeof(float) * 3;
+	if ( CHECK_FLAG(m_enabledBuffers, TANGENT_ST) )	uiStride += sizeof(float) * 3;
+
+	return uiStride;
+}
+
+//
+// TakeUploadedBytes
+//
+unsigned int NullVertexBuffer::TakeUploadedBytes()
+{
+	unsigned int uiBytes = m_uploadedBytes;
+	m_uploadedBytes = 0;
+	return uiBytes;
+}
+
+//
+// PackVertexBuffer
+//
+void NullVertexBuffer::PackVertexBuffer()
+{
+	if ( m_hwVertexBufferData.empty() )
+		return;
+
+	const unsigned int uiStride = GetVertexStride();
+
+	// Don't pack more vertices than the source buffer contains
+	unsigned int uiVertexCount = m_hwVertexBufferData.size() / uiStride;
+	if ( CHECK_FLAG(m_enabledBuffers, VERTEX) && m_vertexBuffer && ( m_vertexBuffer->size() / VERTEX_STRIDE ) < uiVertexCount )
+		uiVertexCount = m_vertexBuffer->size() / VERTEX_STRIDE;
+
+	// Interleave the enabled buffers in the same order as the stride is computed
+	char * pDest = m_hwVertexBufferData.begin();
+	for ( unsigned int uiVertex = 0; uiVertex < uiVertexCount; uiVertex++ )
+	{
+		char * pVertex = pDest + uiVertex * uiStride;
+
+		if ( CHECK_FLAG(m_enabledBuffers, VERTEX) )		PackFloats( pVertex, m_vertexBuffer, uiVertex, 3 );
+		if ( CHECK_FLAG(m_enabledBuffers, VERTEX_T) )	PackFloats( pVertex, m_vertexBuffer, uiVertex, 4 );
+		if ( CHECK_FLAG(m_enabledBuffers, NORMALS) )	PackFloats( pVertex, m_normalBuffer, uiVertex, NORMAL_STRIDE );
+		if ( CHECK_FLAG(m_enabledBuffers, COLOR) )		PackColor( pVertex, m_colorBuffer, uiVertex );
+		if ( CHECK_FLAG(m_enabledBuffers, TEXTURE_0) )	PackFloats( pVertex, m_texture0Buffer, uiVertex, TEXTURE_STRIDE );
+		if ( CHECK_FLAG(m_enabledBuffers, TEXTURE_1) )	PackFloats( pVertex, m_texture1Buffer, uiVertex, TEXTURE_STRIDE );
+		if ( CHECK_FLAG(m_enabledBuffers, TEXTURE_2) )	pVertex += sizeof(float) * TEXTURE_STRIDE;
+		if ( CHECK_FLAG(m_enabledBuffers, TEXTURE_3) )	pVertex += sizeof(float) * TEXTURE_STRIDE;
+		if ( CHECK_FLAG(m_enabledBuffers, TANGENT_S) )	PackFloats( pVertex, m_tangentBasisS, uiVertex, 3 );
+		if ( CHECK_FLAG(m_enabledBuffers, TANGENT_T) )	PackFloats( pVertex, m_tangentBasisT, uiVertex, 3 );
+		if ( CHECK_FLAG(m_enabledBuffers, TANGENT_ST) )	PackFloats( pVertex, m_tangentBasisST, uiVertex, 3 );
+	}
+}
+
+//
+// PackIndexBuffer
+//
+void NullVertexBuffer::PackIndexBuffer()
+{
+	// Index buffer is enabled?
+	if ( false == isBufferEnabled(INDEX) || m_hwIndexBufferData.empty() || !m_indexBuffer )
+		return;
+
+	// Grab the Total Index Count
+	unsigned int uiIndexCount = m_hwIndexBufferData.size();
+	if ( uiIndexCount > m_indexBuffer->size() )
+		uiIndexCount = m_indexBuffer->size();
+
+	// Store the Index Data inside the buffer
+	if ( uiIndexCount )
+		memcpy( m_hwIndexBufferData.begin(), &m_indexBuffer->front(), uiIndexCount * sizeof(unsigned short) );
+}
+
+// ----------------------------------------------------
+// Local Functions
+// ----------------------------------------------------
+
+//
+// PackFloats
+//
+void PackFloats( char *& pDest, const shared_ptr< vector<float> > & spSource, unsigned int uiVertex, unsigned int uiStride )
+{
+	const unsigned int uiBytes = uiStride * sizeof(float);
+
+	if ( spSource && ( uiVertex + 1 ) * uiStride <= spSource->size() )
+		memcpy( pDest, &spSource->at( uiVertex * uiStride ), uiBytes );
+	else
+		memset( pDest, 0, uiBytes );
+
+	pDest += uiBytes;
+}
+
+//
+// PackColor
+//
+void PackColor( char *& pDest, const shared_ptr< vector<float> > & spSource, unsigned int uiVertex )
+{
+	// Packed 32-bit ARGB, like a D3DCOLOR (an unsigned long is 64 bits on LP64 platforms)
+	unsigned int dwColor = 0xFFFFFFFF;
+
+	// Convert the float color into a packed ARGB value
+	if ( spSource && ( uiVertex + 1 ) * VertexBuffer::COLOR_STRIDE <= spSource->size() )
+	{
+		const float * pColor = &spSource->at( uiVertex * VertexBuffer::COLOR_STRIDE );
+		dwColor = ( (unsigned int)( pColor[3] * 255 ) << 24 ) |
+				  ( (unsigned int)( pColor[0] * 255 ) << 16 ) |
+				  ( (unsigned int)( pColor[1] * 255 ) << 8 ) |
+				  ( (unsigned int)( pColor[2] * 255 ) );
+	}
+
+	memcpy( pDest, &dwColor, sizeof(dwColor) );
+	pDest += sizeof(dwColor);
+}
@@ -0,0 +1,71 @@
+/*
+	Katana Engine
+	Copyright  2001-2004 Eric Bryant, Inc.
+
+	File:		nullvertexbuffer.h
+	Author:		Eric Bryant
+
+	Null Vertex Buffer (system memory only)
+*/
+
+#ifndef _NULLVERTEXBUFFER_H
+#define _NULLVERTEXBUFFER_H
+
+namespace Katana
+{
+
+//
+// NullVertexBuffer
+//
+class NullVertexBuffer : public VertexBuffer
+{
+public:
+	/// Constructor
+	NullVertexBuffer( unsigned int uiVertexCount,
+					  unsigned int uiIndexCount,
+					  BufferTypes eEnabledBuffers,
+					  BufferCreationFlags eCreationFlags );
+
+	/// Destructor
+	virtual ~NullVertexBuffer();
+
+	// Initialize the vertex buffer as necessary
+	virtual bool Initialize();
+
+	// Lock/Unlock the vertex buffers
+	virtual bool Lock();
+	virtual bool LockRange(unsigned int uiStartVertex, unsigned int uiVertexCount, unsigned int uiStartIndex = 0,  unsigned int uiIndexCount = 0);
+	virtual bool Unlock();
+
+	// Packs the arrays into the system memory buffers
+	virtual bool UploadBuffers();
+
+public: // Public Interfaces
+
+	/// Returns the size of one interleaved vertex
+	unsigned int GetVertexStride() const;
+
+	/// Returns the number of bytes written since the last call, and clears the count
+	unsigned int TakeUploadedBytes();
+
+private:
+	/// Packs the vertex buffer into a flat interleaved array
+	void PackVertexBuffer();
+
+	/// Packs the index buffer into a flat array
+	void PackIndexBuffer();
+
+private:
+	/// System memory copy of the interleaved vertices
+	vector<char>			m_vertexData;
+
+	/// System memory copy of the indices
+	vector<unsigned short>	m_indexData;
+
+	/// Number of bytes written through Lock()/Unlock() not yet reported to the renderer
+	unsigned int			m_uploadedBytes;
+};
+
+}; // Katana
+
+#endif // _NULLVERTEXBUFFER_H
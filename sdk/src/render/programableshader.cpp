@@ -60,19 +60,26 @@ ProgramableShader::ProgramableShader( const char * szShaderFile )
 
 //
 // OnPreRender
-// Called for every object which needs to render with this shader
-// It preprocesses the shader by setting the appropiate shader constants
+// Called once before a batch of objects is rendered with this shader
 //
 bool ProgramableShader::OnPreRender( SceneContext * context )
 {
 	// Check that we have a valid shader state
 	if ( !m_shaderState ) return false;
 
-	// Get a pointer to the currently rendered object
-	Visible * pCurrentVisibleObject = context->currentVisibleObject;
+	// Call the base class to execute the pre render states
+	return Shader::OnPreRender( context );
+}
 
+//
+// OnRenderObject
+// Called for every object which needs to render with this shader
+// It preprocesses the shader by setting the appropiate shader constants
+//
+bool ProgramableShader::OnRenderObject( SceneContext * context )
+{
 	// Calculate the commonly used matrices
-	const Matrix4 modelViewMatrix = pCurrentVisibleObject->getWorldMatrix();
+	const Matrix4 modelViewMatrix = *context->currentWorldMatrix;
 	const Matrix4 modelViewMatrixIT = Matrix4( modelViewMatrix ).inverse().transpose();
 	const Matrix4 modelViewProjectionMatrix = modelViewMatrix * context->currentCamera->getProjection();
 
@@ -86,7 +93,8 @@ bool ProgramableShader::OnPreRender( SceneContext * context )
 	vshaderConstants[VERTEX_CONST_WORLDVIEW_IT] = modelViewMatrixIT;
 
 	// Store the eye position in object space
-	vshaderConstants[VERTEX_CONST_EYE_POSITION] = context->currentCamera->getWorldMatrix().pos;
+	const MatrixRow & eyePosition = context->currentCamera->getWorldMatrix().pos;
+	vshaderConstants[VERTEX_CONST_EYE_POSITION] = Point4( eyePosition.x, eyePosition.y, eyePosition.z, eyePosition.w );
 
 	// This structure mimics a Matrix4 which is what the shader takes as an argument
 	static struct MaterialConstant {
@@ -97,7 +105,7 @@ bool ProgramableShader::OnPreRender( SceneContext * context )
 	} materialConstant;
 
 	// Grab the diffuse texture from the visible object's material and set this as the target texture map
-	shared_ptr<Material> material = pCurrentVisibleObject->getMaterial();
+	shared_ptr<Material> material = context->currentMaterial;
 	if ( material )
 	{
 		// Generate the texture states. The state will be responsible for setting the appropate texture slots
@@ -166,12 +174,9 @@ bool ProgramableShader::OnPreRender( SceneContext * context )
 		}
 	}
 
-	// Tell the renderer to render the scene using this shader
-	if ( !context->currentRenderer->SetState( m_shaderState.get() ) )
-		return false;
-
-	// Call the base class to execute the pre render states
-	return Shader::OnPreRender( context );
+	// Tell the renderer to render the scene using this shader (the constants
+	// are per-object, so the state is resubmitted for every object)
+	return context->currentRenderer->SetState( m_shaderState.get() );
 /*
 	// Check whether we have an active vertex shader set
 	if ( context->currentVertexShader.expired() ) return false;
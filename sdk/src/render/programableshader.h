@@ -39,6 +39,7 @@ public:
 
 	// Shader Interface 
 	virtual bool OnPreRender( SceneContext * context );
+	virtual bool OnRenderObject( SceneContext * context );
 	virtual bool OnPostRender( SceneContext * context );
 
 protected:
@@ -13,10 +13,16 @@
 #include "katana_base_includes.h"
 #include "base/comptr.h"
 #include "rendertypes.h"
+#include "geometry.h"
+#include "vertexbuffer.h"
 #include "render.h"
+#include "nullrender.h"
 #include "dx8render.h"
 #include "dx9render.h"
 
+// Macros
+#define CHECK_FLAG(var, flag) (var&flag) == flag
+
 // Static Types
 std::string					Render::m_strLastErrorString;
 Render::RenderErrorValues	Render::m_eLastError;
@@ -39,13 +45,24 @@ Render::~Render()
 /// use this method to create a valid renderer.
 Render * Render::CreateRenderer( RenderInfo & Info )
 {
+#ifdef RENDER_NULL_DEVICE
+	// The null renderer is used to run the engine headless (or to see if
+	// the application is CPU bound)
+	if ( Info.eDriver == RenderInfo::NULL_RENDER )
+		return new NullRender();
+#endif
+
 #ifdef RENDER_DIRECTX9_DEVICE
 	return new DX9Render();
 #else
 #ifdef RENDER_DIRECTX8_DEVICE
 	return new DX8Render();
 #else
-#error Undefined Renderer: choose RENDER_DIRECTX8_DEVICE and/or RENDER_DIRECTX9_DEVICE in katana_config.h
+#ifdef RENDER_NULL_DEVICE
+	return new NullRender();
+#else
+#error Undefined Renderer: choose RENDER_NULL_DEVICE, RENDER_DIRECTX8_DEVICE and/or RENDER_DIRECTX9_DEVICE in katana_config.h
+#endif
 #endif
 #endif
 }
@@ -79,4 +96,135 @@ void Render::SetError(RenderErrorValues eError, const char * szErrorString)
 const RenderInfo & Render::GetRenderInfo()
 {
 	return m_RenderInfo;
+}
+
+//
+// resetStatistics
+//
+void Render::resetStatistics()
+{
+	m_frameStatistics.reset();
+	m_lastFrameStatistics.reset();
+	m_totalStatistics.reset();
+}
+
+//
+// BeginFrameStatistics
+//
+void Render::BeginFrameStatistics()
+{
+	m_frameStatistics.reset();
+}
+
+//
+// EndFrameStatistics
+//
+void Render::EndFrameStatistics()
+{
+	m_frameStatistics.frames = 1;
+	m_lastFrameStatistics = m_frameStatistics;
+	m_totalStatistics.accumulate( m_frameStatistics );
+}
+
+//
+// CountGeometry
+//
+void Render::CountGeometry( Geometry * geom )
+{
+	// The geometry is drawn from user memory, so the whole buffer is copied every call
+	unsigned int uiBytes = geom->m_vertexBuffer->size() * sizeof(float);
+	if ( CHECK_FLAG( geom->m_enabledBuffers, COLOR ) && geom->m_colorBuffer )
+		uiBytes += ( geom->m_colorBuffer->size() / VertexBuffer::COLOR_STRIDE ) * sizeof(unsigned int);
+
+	m_frameStatistics.drawCalls++;
+	m_frameStatistics.primitives += geom->m_primitiveCount;
+	m_frameStatistics.vertices += GetVertexCount( geom->m_primitiveType, geom->m_primitiveCount );
+	m_frameStatistics.bytesUploaded += uiBytes;
+}
+
+//
+// CountVB
+//
+void Render::CountVB( VertexBuffer * pVB, bool bIndexed )
+{
+	if ( false == bIndexed && pVB->getPrimitiveType() == TRIANGLE_STRIP )
+	{
+		// Multiple triangle strips are drawn with one call per strip
+		m_frameStatistics.drawCalls += pVB->getPrimitiveCount();
+		m_frameStatistics.primitives += pVB->getPrimitiveCount() * pVB->getTriangleStripCount();
+		m_frameStatistics.vertices += pVB->getPrimitiveCount() * GetVertexCount( TRIANGLE_STRIP, pVB->getTriangleStripCount() );
+	}
+	else
+	{
+		m_frameStatistics.drawCalls++;
+		m_frameStatistics.primitives += pVB->getPrimitiveCount();
+
+		if ( true == bIndexed )
+		{
+			m_frameStatistics.vertices += pVB->getActiveVertexCount();
+			m_frameStatistics.indices += GetVertexCount( pVB->getPrimitiveType(), pVB->getPrimitiveCount() );
+		}
+		else
+		{
+			m_frameStatistics.vertices += GetVertexCount( pVB->getPrimitiveType(), pVB->getPrimitiveCount() );
+		}
+	}
+}
+
+//
+// GetVertexCount
+//
+unsigned int Render::GetVertexCount( PrimitiveType eType, unsigned int uiPrimitiveCount )
+{
+	if ( !uiPrimitiveCount )
+		return 0;
+
+	switch ( eType )
+	{
+	case POINTS:			return uiPrimitiveCount;
+	case LINES:				return uiPrimitiveCount * 2;
+	case LINESTRIP:			return uiPrimitiveCount + 1;
+	case TRIANGLE_LIST:		return uiPrimitiveCount * 3;
+	case TRIANGLE_STRIP:	return uiPrimitiveCount + 2;
+	case TRIANGLE_FAN:		return uiPrimitiveCount + 2;
+	default:				return 0;
+	}
+}
+
+// --------------------------------------------------------
+// RenderStatistics
+// --------------------------------------------------------
+
+//
+// reset
+//
+void RenderStatistics::reset()
+{
+	frames = 0;
+	drawCalls = 0;
+	primitives = 0;
+	vertices = 0;
+	indices = 0;
+	stateChanges = 0;
+	matrixChanges = 0;
+	textureBinds = 0;
+	buffersCreated = 0;
+	bytesUploaded = 0;
+}
+
+//
+// accumulate
+//
+void RenderStatistics::accumulate( const RenderStatistics & stats )
+{
+	frames += stats.frames;
+	drawCalls += stats.drawCalls;
+	primitives += stats.primitives;
+	vertices += stats.vertices;
+	indices += stats.indices;
+	stateChanges += stats.stateChanges;
+	matrixChanges += stats.matrixChanges;
+	textureBinds += stats.textureBinds;
+	buffersCreated += stats.buffersCreated;
+	bytesUploaded += stats.bytesUploaded;
 }
\ No newline at end of file
@@ -33,6 +33,33 @@ enum MatrixType
 	PROJECTION,
 };
 
+///
+/// RenderStatistics
+/// Counters gathered by the renderers for every submission
+///
+struct RenderStatistics
+{
+	/// Constructor
+	RenderStatistics()											{ reset(); }
+
+	/// Clears all the counters
+	void reset();
+
+	/// Accumulates the counters from another set of statistics
+	void accumulate( const RenderStatistics & stats );
+
+	unsigned int	frames;				/// Number of BeginFrame()/EndFrame() pairs
+	unsigned int	drawCalls;			/// Number of draw calls issued by RenderGeometry()/RenderVB()
+	unsigned int	primitives;			/// Number of primitives submitted
+	unsigned int	vertices;			/// Number of vertices submitted
+	unsigned int	indices;			/// Number of indices submitted
+	unsigned int	stateChanges;		/// Number of SetState() calls
+	unsigned int	matrixChanges;		/// Number of SetMatrix()/SetViewport() calls
+	unsigned int	textureBinds;		/// Number of BindTexture() calls
+	unsigned int	buffersCreated;		/// Number of vertex and index buffers created
+	unsigned int	bytesUploaded;		/// Number of bytes written into vertex/index buffers (or drawn from user memory)
+};
+
 ///
 /// Render
 /// Pure Interface for any renderable device
@@ -128,11 +155,38 @@ public:
 	/// Get the render info
 	const RenderInfo & GetRenderInfo();
 
+	/// Returns the counters of the frame currently being submitted
+	const RenderStatistics & getFrameStatistics() const			{ return m_frameStatistics; }
+
+	/// Returns the counters of the last completed frame
+	const RenderStatistics & getLastFrameStatistics() const		{ return m_lastFrameStatistics; }
+
+	/// Returns the counters accumulated since Initialize() or the last resetStatistics()
+	const RenderStatistics & getTotalStatistics() const			{ return m_totalStatistics; }
+
+	/// Clears all the counters
+	void resetStatistics();
+
 protected:
 
 	/// Sets the current error condition
 	static void SetError(RenderErrorValues eError, const char * szErrorString);
 
+	/// Starts counting a new frame. Called by BeginFrame().
+	void BeginFrameStatistics();
+
+	/// Stores the counters of the finished frame. Called by EndFrame().
+	void EndFrameStatistics();
+
+	/// Counts a RenderGeometry() draw call, whose buffers are drawn from user memory
+	void CountGeometry( Geometry * geom );
+
+	/// Counts a RenderVB() draw call. Non-indexed triangle strips are drawn with one call per strip.
+	void CountVB( VertexBuffer * pVB, bool bIndexed );
+
+	/// Computes the number of vertices referenced by a primitive count
+	static unsigned int GetVertexCount( PrimitiveType eType, unsigned int uiPrimitiveCount );
+
 protected:
 	/// Has the renderer been initialized properly
 	bool m_isInitialized;	
@@ -140,6 +194,11 @@ protected:
 	/// Information about the render driver
 	RenderInfo	m_RenderInfo;
 
+	/// Counters for the current, last and all frames
+	RenderStatistics	m_frameStatistics;
+	RenderStatistics	m_lastFrameStatistics;
+	RenderStatistics	m_totalStatistics;
+
 	/// Last Error Message
 	static std::string			m_strLastErrorString;
 	static RenderErrorValues	m_eLastError;
@@ -11,15 +11,112 @@
 #include "katana_core_includes.h"
 #include "katana_base_includes.h"
 #include "scene/scenecontext.h"
+#include "scene/visible.h"
+#include "scene/renderqueue.h"
 #include "rendertypes.h"
 #include "render.h"
 #include "shader.h"
+#include "system/systemthread.h"
 
 //
 // RTTI Definition
 // 
 KIMPLEMENT_ROOT_RTTI( Shader );
 
+//
+// Sort identifiers
+//
+// Every shader receives a unique sort identifier. The render queue groups
+// objects by this identifier to minimize the shader switches. Identifiers
+// of destroyed shaders are reused, so the identifiers stay within the
+// render queue's shader field. Shaders may be created by the worker threads,
+// so the allocation is guarded by a spin lock. The lock and the counter are
+// constant initialized, but the free list has a constructor, so it's a function
+// local static: shaders created by the static constructors of other files would
+// otherwise use it before it's constructed. It's only reached with the lock held,
+// so its construction on first use isn't raced.
+//
+static volatile long			s_sortIDLock = 0;
+static unsigned int				s_nextSortID = 0;
+
+static vector<unsigned int>& freeSortIDs()
+{
+	static vector<unsigned int> s_freeSortIDs;
+	return s_freeSortIDs;
+}
+
+static unsigned int AllocateSortID()
+{
+	while( SystemThread::atomicExchange( &s_sortIDLock, 1 ) != 0 )
+		SystemThread::yield();
+
+	vector<unsigned int> & freeIDs = freeSortIDs();
+
+	unsigned int sortID;
+	if ( !freeIDs.empty() )
+	{
+		sortID = freeIDs.back();
+		freeIDs.pop_back();
+	}
+	else
+		sortID = s_nextSortID++;
+
+	SystemThread::atomicExchange( &s_sortIDLock, 0 );
+
+	if ( sortID > ( 1u << RenderQueue::SHADER_BITS ) - 1 )
+		KLOG( "Too many shaders, shader %d will share its render queue batch", sortID );
+
+	return sortID;
+}
+
+static void ReleaseSortID( unsigned int sortID )
+{
+	while( SystemThread::atomicExchange( &s_sortIDLock, 1 ) != 0 )
+		SystemThread::yield();
+
+	freeSortIDs().push_back( sortID );
+
+	SystemThread::atomicExchange( &s_sortIDLock, 0 );
+}
+
+//
+// Constructor
+//
+Shader::Shader() :
+	m_sortID( AllocateSortID() )
+{
+}
+
+//
+// Copy Constructor
+//
+Shader::Shader( const Shader & shader ) :
+	Streamable( shader ),
+	m_preRenderStates( shader.m_preRenderStates ),
+	m_postRenderStates( shader.m_postRenderStates ),
+	m_sortID( AllocateSortID() )
+{
+}
+
+//
+// Destructor
+//
+Shader::~Shader()
+{
+	ReleaseSortID( m_sortID );
+}
+
+//
+// operator=
+//
+Shader & Shader::operator=( const Shader & shader )
+{
+	// The sort identifier belongs to this shader, so it isn't copied
+	m_preRenderStates = shader.m_preRenderStates;
+	m_postRenderStates = shader.m_postRenderStates;
+	return *this;
+}
+
 //
 // OnPreRender
 //
@@ -36,6 +133,17 @@ bool Shader::OnPreRender( SceneContext * context )
 	return true;
 }
 
+//
+// OnRenderObject
+//
+bool Shader::OnRenderObject( SceneContext * context )
+{
+	// Transform the current object from local space into world space
+	context->currentRenderer->SetMatrix( MODELVIEW, STORE, *context->currentWorldMatrix );
+
+	return true;
+}
+
 //
 // OnPostRender
 //
@@ -35,21 +35,40 @@ class Shader
 	KDECLARE_SCRIPT;
 
 public:
+	/// Constructor
+	Shader();
 
-	/// Called for every object which needs to render with this shader.
-	/// Use this function to setup the renderstate (like transforming the object
-	/// from local space to world space).
+	/// Copy Constructor (the copy receives its own sort identifier)
+	Shader( const Shader & shader );
+
+	/// Destructor, which releases the sort identifier
+	virtual ~Shader();
+
+	/// Assignment, which copies the render states but keeps the sort identifier
+	Shader & operator=( const Shader & shader );
+
+	/// Called once before a batch of objects is rendered with this shader.
+	/// The render queue is sorted by shader, so use this function to setup
+	/// the renderstates shared by all objects within the batch.
 	///
 	/// If this is a multipass shader, then returning false means an additional
 	/// pass is needed, while true means the shader has completed all passes.
 	///
 	virtual bool OnPreRender( SceneContext * context );
 
-	/// Called after an object has used this shader.
+	/// Called for every object which needs to render with this shader.
+	/// Use this function to setup the per-object renderstates (like transforming
+	/// the object from local space to world space).
+	virtual bool OnRenderObject( SceneContext * context );
+
+	/// Called after a batch of objects has used this shader.
 	virtual bool OnPostRender( SceneContext * context );
 
 public:
 
+	/// Returns the identifier used to sort the render queue by shader
+	unsigned int getSortID() const								{ return m_sortID; }
+
 	/// Adds a render state to the PreRender collection
 	void addPreRenderState( shared_ptr<RenderState> renderState );
 
@@ -70,6 +89,12 @@ protected:
 	/// Render states which are executed during OnPostRender
 	vector< shared_ptr<RenderState> > m_postRenderStates;
 
+private:
+
+	/// Unique identifier of this shader, used as the render queue sort key.
+	/// Identifiers are reused once their shader is destroyed.
+	unsigned int m_sortID;
+
 };
 
 KIMPLEMENT_SCRIPT( Shader );
@@ -59,7 +59,7 @@ public:
 	void setPrimitveCount(unsigned int primitiveCount)			{ m_primitiveCount = primitiveCount; }
 
 	/// Sets the active vertex count
-	void setActiveVertexCount(unsigned int vertexCount)			{ m_activeIndexCount = vertexCount; }
+	void setActiveVertexCount(unsigned int vertexCount)			{ m_activeVertexCount = vertexCount; }
 
 	/// Sets the active index count
 	void setActiveIndexCount(unsigned int indexCount)			{ m_activeIndexCount = indexCount; }
@@ -90,6 +90,9 @@ bool BSPNodeConstructor::makeBSP()
 	for( unsigned int i = 0; i < root.faceCount; i++ )
 		m_triangleIndexList.push_back( i );
 
+	// Fit the bounding sphere to the geometry
+	calculateNodeBound( root );
+
 	// Add the root node to the collection of BSP nodes
 	m_bspNodes.push_back( root );
 
@@ -158,6 +161,9 @@ void BSPNodeConstructor::recursiveBuildTree( unsigned int uiNodeIndex )
 				}
 			}
 
+			// Fit the bounding sphere to the triangles of this node
+			calculateNodeBound( childNode );
+
 			// Add the new node to the collection of BSP nodes
 			m_bspNodes.push_back( childNode );
 
@@ -237,4 +243,32 @@ bool BSPNodeConstructor::triangleBoxIntersection( shared_ptr<Geometry> geometry,
 
 	// Perform the intersection test
 	return kmath::testIntersect( box, vert0, vert1, vert2 );
-}
\ No newline at end of file
+}
+
+//
+// calculateNodeBound
+// Fits the node's bounding sphere to the vertices of its triangles
+//
+void BSPNodeConstructor::calculateNodeBound( BSPNode & node )
+{
+	if ( !node.faceCount )
+		return;
+
+	// Reinterpret out vertex buffer points (which are floats) to Point3s
+	const Point3 * pPoints = reinterpret_cast<const Point3 *>( &m_geometry->m_vertexBuffer->front() );
+	const vector<unsigned short> & indices = *m_geometry->m_indexBuffer;
+
+	// Gather the vertices of the node's triangles
+	m_boundPoints.clear();
+	for( unsigned int j = 0; j < node.faceCount; j++ )
+	{
+		unsigned short uiTriIdx = m_triangleIndexList[node.faceIndex + j];
+		m_boundPoints.push_back( pPoints[ indices[uiTriIdx*3+0] ] );
+		m_boundPoints.push_back( pPoints[ indices[uiTriIdx*3+1] ] );
+		m_boundPoints.push_back( pPoints[ indices[uiTriIdx*3+2] ] );
+	}
+
+	// The triangles of the node are a subset of its parent's triangles, so culling
+	// the parent's sphere still culls everything the node contains.
+	node.bound.fit( &m_boundPoints[0], m_boundPoints.size() );
+}
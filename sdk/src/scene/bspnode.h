@@ -27,12 +27,15 @@ struct BSPNode
 	short			neighbors[6];	/// Because this is an octree-style BSP node, these are the six neighbors.
 	Plane			plane;			/// Plane which divides the BSP node in half-space
 	AxisAlignedBox	box;			/// The box is used for occlusion culling and triangle intersection testing. It is more accurate
-	Bound			bound;			/// This is the bounding volume (sphere) used for visibility testing
+	Bound			bound;			/// This is the bounding volume (sphere) used for visibility testing. It is fitted to the
+									/// node's triangles, so it can be much smaller than the sphere around the box.
 	short			material;		/// Index referencing the material to use to render this node
 	unsigned short	faceIndex;		/// The first index of this leaf's faces. -1 if this node is not a leaf
 	unsigned short  faceCount;		/// The number of faces belonging to this leaf
 	short			zone;			/// The zone index this node belongs to
+	unsigned int	cullPlane;		/// The frustum plane which culled this node last frame (tested first next frame)
 
+	BSPNode();				/// Constructor
 	bool isLeaf() const;	/// Function returns true if this node is a leaf
 	bool isBSP() const;		/// Function returns true if this node is acting as a BSP
 };
@@ -69,6 +72,10 @@ private:
 	/// at the given index.
 	bool triangleBoxIntersection( shared_ptr<Geometry> geometry, const AxisAlignedBox & box, unsigned short uiStartTriIdx );
 
+	/// Fits the node's bounding sphere to the vertices of its triangles. Nodes without
+	/// triangles keep the sphere around their box.
+	void calculateNodeBound( BSPNode & node );
+
 private:
 	int										m_zone;					/// Parent zone
 	shared_ptr<Geometry>					m_geometry;				/// Geometry used for construction
@@ -81,6 +88,7 @@ private:
 	bool									m_allowDuplicateTris;	/// Flags whether we allow duplicate triangles (default is false)
 	vector<bool>							m_triangleReferenceList;/// The bitarray keeps track of when triangles are added to 
 																	/// nodes to avoid duplicated
+	vector<Point3>							m_boundPoints;			/// Scratch list of the vertices of a node's triangles
 };
 
 
@@ -96,6 +104,7 @@ inline BSPNode::BSPNode()
 	, material( -1 )
 	, faceCount( 0 )
 	, zone( 0 )
+	, cullPlane( 0 )
 {
 	children[0] = children[1] = children[2] = children[3] =
 	children[4] = children[5] = children[6] = children[7] =
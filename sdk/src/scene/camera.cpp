@@ -12,6 +12,7 @@
 
 #include "katana_core_includes.h"
 #include "katana_base_includes.h"
+#include "scenecontext.h"
 #include "visible.h"
 #include "camera.h"
 
@@ -20,10 +21,16 @@
 //
 KIMPLEMENT_RTTI( Camera, Visible );
 
+//
+// Globals
+//
+static unsigned int g_lastViewRevision = 0;		// Shared by all cameras, so their revisions never collide
+
 //
 // Constructor
 //
-Camera::Camera()
+Camera::Camera() :
+	m_viewRevision(0)
 {
 	m_worldViewMatrix.setIdentity();
 }
@@ -32,7 +39,7 @@ Camera::Camera()
 // Constructor with defaults
 //
 Camera::Camera(float fov, float nearp, float farp, float aspect) :
-	m_fov(fov), m_nearPlane(nearp), m_farPlane(farp), m_aspectRatio(aspect)
+	m_fov(fov), m_nearPlane(nearp), m_farPlane(farp), m_aspectRatio(aspect), m_viewRevision(0)
 {
 	m_fovy = fov * aspect;
 	kmath::createProjection( fov, nearp, farp, aspect, m_projectionMatrix );
@@ -46,7 +53,7 @@ bool Camera::Cull( const Bound & bound ) const
 	int iPositivePlanes = 0;
 	for( int i = 0; i < MAX_FRUSTUM_PLANES; i++ )
 	{
-		if ( m_planes[i].whichSide( bound ) != Plane::SIDE_BACK ) 
+		if ( m_worldPlanes[i].whichSide( bound ) != Plane::SIDE_BACK ) 
 			iPositivePlanes++;
 	}
 
@@ -62,7 +69,7 @@ bool Camera::Cull( const Bound & bound, IntersectionType & intersection ) const
 	int iPositivePlanes = 0;
 	for( int i = 0; i < MAX_FRUSTUM_PLANES; i++ )
 	{
-		if ( m_planes[i].whichSide( bound ) != Plane::SIDE_BACK ) 
+		if ( m_worldPlanes[i].whichSide( bound ) != Plane::SIDE_BACK ) 
 			iPositivePlanes++;
 		else
 			return false;
@@ -76,20 +83,88 @@ bool Camera::Cull( const Bound & bound, IntersectionType & intersection ) const
 	return true;
 }
 
+bool Camera::Cull( const Bound & bound, unsigned int & planeMask, unsigned int & lastCullPlane ) const
+{
+	const Point3 & center = bound.getCenter();
+	const float radius = bound.getRadius();
+
+	// Start with the plane which culled this bound last time. Objects tend to stay
+	// on the same side of the frustum from frame to frame.
+	unsigned int plane = lastCullPlane < MAX_FRUSTUM_PLANES ? lastCullPlane : 0;
+
+	for( int i = 0; i < MAX_FRUSTUM_PLANES; i++, plane = ( plane + 1 ) % MAX_FRUSTUM_PLANES )
+	{
+		const unsigned int planeBit = 1u << plane;
+
+		// Skip the planes our parent is fully inside of
+		if ( !( planeMask & planeBit ) ) continue;
+
+		float distance = m_worldPlanes[plane].distance( center );
+
+		// The bound is completely behind this plane, so it's culled
+		if ( distance < -radius )
+		{
+			lastCullPlane = plane;
+			return false;
+		}
+
+		// The bound is completely in front of this plane, its children don't need to test it
+		if ( distance > radius )
+			planeMask &= ~planeBit;
+	}
+
+	return true;
+}
+
+bool Camera::Cull( const OrientedBox & box, unsigned int & planeMask, unsigned int & lastCullPlane ) const
+{
+	unsigned int plane = lastCullPlane < MAX_FRUSTUM_PLANES ? lastCullPlane : 0;
+
+	for( int i = 0; i < MAX_FRUSTUM_PLANES; i++, plane = ( plane + 1 ) % MAX_FRUSTUM_PLANES )
+	{
+		const unsigned int planeBit = 1u << plane;
+
+		// Skip the planes our parent is fully inside of
+		if ( !( planeMask & planeBit ) ) continue;
+
+		const Plane & worldPlane = m_worldPlanes[plane];
+		float distance = worldPlane.distance( box.m_center );
+		float radius = box.getProjectedRadius( worldPlane.m_normal );
+
+		// The box is completely behind this plane, so it's culled
+		if ( distance < -radius )
+		{
+			lastCullPlane = plane;
+			return false;
+		}
+
+		// The box is completely in front of this plane, its children don't need to test it
+		if ( distance > radius )
+			planeMask &= ~planeBit;
+	}
+
+	return true;
+}
+
 //
 // OnPreRender
 //
 bool Camera::OnPreRender(SceneContext * context)
 {
-	// Cache whether the camera's position was dirty. Visible::OnPreRender
-	// will set the camera to undirty.
-	bool wasDirty = m_isDirty;
+	// Only recalculate the view when the camera has moved
+	if ( !updateWorldTransform() )
+		return true;
 
-	// Call the base class. This will update the worldview matrix.
-	Visible::OnPreRender( context );
+	// Calculate the view matrix. The scene's current camera is this camera,
+	// so this mirrors how Visible::OnPreRender concatenates the view.
+	m_worldViewMatrix = m_worldMatrix;
+	m_worldViewMatrix *= context->currentCamera->getWorldMatrix();
 
-	// If the camera has moved, update the clip planes
-	if ( wasDirty ) updateClipPlanes();
+	// Let the visible objects know the view matrix has changed
+	m_viewRevision = ++g_lastViewRevision;
+
+	// The camera has moved, update the clip planes
+	updateClipPlanes();
 
 	return true;
 }
@@ -150,4 +225,18 @@ void Camera::updateClipPlanes()
 	m_planes[FRUSTUM_TOP]	.normalize();
 	m_planes[FRUSTUM_FAR]	.normalize();
 	m_planes[FRUSTUM_NEAR]	.normalize();
+
+	// Transform the planes into world space. A view space point is v = R * w + T,
+	// (where R and T are the rotation and translation of the view matrix),
+	// so the plane N.v + D = 0 becomes (Rt * N).w + (N.T + D) = 0 in world space.
+	const Matrix4 & viewMatrix = m_worldViewMatrix;
+	for( int i = 0; i < MAX_FRUSTUM_PLANES; i++ )
+	{
+		const Point3 & normal = m_planes[i].getNormal();
+
+		m_worldPlanes[i].set( viewMatrix.m[0][0] * normal.x + viewMatrix.m[1][0] * normal.y + viewMatrix.m[2][0] * normal.z,
+							  viewMatrix.m[0][1] * normal.x + viewMatrix.m[1][1] * normal.y + viewMatrix.m[2][1] * normal.z,
+							  viewMatrix.m[0][2] * normal.x + viewMatrix.m[1][2] * normal.y + viewMatrix.m[2][2] * normal.z,
+							  normal.getDot( viewMatrix.pos ) + m_planes[i].getConstant() );
+	}
 }
\ No newline at end of file
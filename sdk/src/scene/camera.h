@@ -47,6 +47,12 @@ public:
 	/// Retrieve the project matrix (computed during the constructor)
 	const Matrix4 & getProjection() const			{ return m_projectionMatrix; }
 
+	/// Retrieve the distance to the near clip plane
+	float getNearPlane() const						{ return m_nearPlane; }
+
+	/// Retrieve the distance to the far clip plane
+	float getFarPlane() const						{ return m_farPlane; }
+
 	/// Checks whether the bounding volume is culled by the camera's view frustum.
 	/// This function returns true if the bounding volume is full or partially culled
 	/// by this camera's frustum, and false if there is no intersection.
@@ -58,13 +64,32 @@ public:
 	/// returns the intersection type
 	bool Cull( const Bound & bound, IntersectionType & intersection ) const;
 
-	/// Returns the given plane
-	Plane getClipPlanes( FrustumPlanes planeIndex )	const { return m_planes[planeIndex]; }
+	/// Checks whether the bounding volume is culled by the camera's view frustum, only
+	/// testing the planes set within the plane mask. On return, the planes which the bound
+	/// is fully inside of are removed from the mask, so the bound's children can skip them.
+	/// The last plane which culled the bound is tested first, and is updated if the bound is culled.
+	/// Like the other Cull() functions, this returns false if the bound is outside the frustum.
+	bool Cull( const Bound & bound, unsigned int & planeMask, unsigned int & lastCullPlane ) const;
+
+	/// Same as above, but tests an oriented box. The box is tested against each plane
+	/// using its radius projected onto the plane's normal.
+	bool Cull( const OrientedBox & box, unsigned int & planeMask, unsigned int & lastCullPlane ) const;
+
+	/// Returns the given plane (in world space)
+	Plane getClipPlanes( FrustumPlanes planeIndex )	const { return m_worldPlanes[planeIndex]; }
+
+	/// Returns all of the clipping planes (in world space), indexed by FrustumPlanes
+	const Plane * getWorldPlanes() const			{ return m_worldPlanes; }
+
+	/// Returns an identifier which changes every time the camera's view matrix changes.
+	/// Visible objects use it to determine whether their world view matrix is up to date.
+	unsigned int getViewRevision() const			{ return m_viewRevision; }
 
 public:
 
-	/// OnPreRender will recalculate the clip planes. This operation happens during OnPreRender
-	/// instead of OnUpdate because Visible::OnPreRender is when the world matrices are recalculated
+	/// OnPreRender will recalculate the view matrix and clip planes if the camera has moved.
+	/// This operation happens during OnPreRender instead of OnUpdate because
+	/// Visible::OnPreRender is when the world matrices are recalculated
 	virtual bool OnPreRender(SceneContext * context);
 
 protected:
@@ -79,7 +104,17 @@ protected:
 	float	m_farPlane;
 	float	m_aspectRatio;
 	Matrix4	m_projectionMatrix;
+
+	/// Clip planes in view space (from the projection matrix)
 	Plane	m_planes[MAX_FRUSTUM_PLANES];
+
+	/// Clip planes in world space (the view space planes transformed by the view matrix).
+	/// Culling against these means the visible objects don't have to transform their
+	/// bounds into view space every time the camera moves.
+	Plane	m_worldPlanes[MAX_FRUSTUM_PLANES];
+
+	/// Changes every time the view matrix changes
+	unsigned int	m_viewRevision;
 };
 
 KIMPLEMENT_SCRIPT( Camera );
@@ -32,10 +32,10 @@ class Controller : public RTTI
 
 public:
 	/// Constructor
-	Controller()										{}
+	Controller() : m_threadSafe( false )				{}
 
 	/// Constructor takes a visible object as a parameter. A controller
-	Controller( shared_ptr<Visible> target)				{ m_target = target; }
+	Controller( shared_ptr<Visible> target) : m_threadSafe( false )		{ m_target = target; }
 
 	/// Called by the scene graph when it is first attached to the scene graph
 	virtual bool OnAttach( SceneContext * context )		{ return true; }
@@ -46,10 +46,22 @@ public:
 	/// Called by the scene graph every game update
 	virtual void OnUpdate( SceneContext * context )		{};
 
+	/// Flags the controller as safe to update on a worker thread. A thread-safe controller
+	/// may only modify its target, and only read the context. With the scene's parallel update,
+	/// the thread-safe controllers are updated concurrently after the nodes, and the others
+	/// are updated afterwards on the main thread in their usual order.
+	void setThreadSafe( bool threadSafe )				{ m_threadSafe = threadSafe; }
+
+	/// Returns whether the controller is safe to update on a worker thread
+	bool isThreadSafe() const							{ return m_threadSafe; }
+
 protected:
 
 	/// The target object of the controller's operation
 	shared_ptr<Visible>	m_target;
+
+	/// Can this controller be updated on a worker thread
+	bool				m_threadSafe;
 };
 
 KIMPLEMENT_SCRIPT( Controller );
@@ -17,6 +17,7 @@
 #include "visible.h"
 #include "controller.h"
 #include "scenecontext.h"
+#include "renderqueue.h"
 #include "scenegraph.h"
 #include "keyboardcontroller.h"
 #include "input/inputmessages.h"
@@ -63,6 +64,7 @@ KeyboardController::KeyboardController()
 	, m_showStatsChar	( 0x21 )
 	, m_enableCullChar	( 0x2e )
 	, m_showShadowChar	( 0x1f )
+	, m_showProfileChar	( 0x13 )
 {
 }
 
@@ -229,6 +231,12 @@ bool KeyboardController::OnMessage( Message * message )
 				katana_debug->setDrawShadowVolumes( !katana_debug->getDrawShadowVolumes() );
 			}
 
+			// Check for displaying the profiler summary
+			if ( keyboard->keys.at( m_showProfileChar ) )
+			{
+				katana_debug->setDrawProfile( !katana_debug->getDrawProfile() );
+			}
+
 			// Check for console
 			if ( keyboard->keys.at( m_showConsoleChar ) )	
 			{
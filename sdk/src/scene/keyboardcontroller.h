@@ -58,6 +58,7 @@ public:
 	void setShowStatistics( char key )				{ m_showStatsChar = key; }
 	void setEnableCull( char key )					{ m_enableCullChar = key; }
 	void setShowShadow( char key )					{ m_showShadowChar = key; }
+	void setShowProfile( char key )					{ m_showProfileChar = key; }
 
 	/// Manage custom keyboard callbacks
 	void addKeyCallback( char key, KeyboardMappedFunction funct );
@@ -90,6 +91,7 @@ protected:
 	char m_showStatsChar;	/// Keypress which displays the scene statistics (default is 'F')
 	char m_enableCullChar;	/// Keypress which enabled frustum culling (default is 'C')
 	char m_showShadowChar;	/// Keypress which displays all shadow volumes (default is 'S')
+	char m_showProfileChar;	/// Keypress which displays the profiler summary (default is 'R')
 
 	/// Custom keyboard mappings between keys and their correspinding callbacks
 	std::map<char,KeyboardMappedFunction> m_customCharMaps;
@@ -0,0 +1,303 @@
+/*
+	Katana Engine
+	Copyright  2001-2004 Eric Bryant, Inc.
+
+	File:		lightgrid.cpp
+	Author:		Eric Bryant
+
+	Assigns the lights of a frame to the objects they affect. The ranges
+	of the local lights are binned into a uniform grid, so each object only
+	tests the lights of the cells its bounds overlap, and keeps the most
+	significant of them.
+*/
+
+#include <float.h>
+#include <math.h>
+#include <algorithm>
+#include "katana_core_includes.h"
+#include "katana_base_includes.h"
+#include "render/light.h"
+#include "lightgrid.h"
+
+//
+// Static Members
+//
+const float LightGrid::DEFAULT_CELL_SIZE = 256.f;
+
+//
+// Local Functions
+//
+static bool SortCandidates( const pair<float, unsigned int> & a, const pair<float, unsigned int> & b );
+
+//
+// Constructor
+//
+LightGrid::LightGrid() :
+	m_maximumLights( DEFAULT_MAXIMUM_LIGHTS ),
+	m_minimumCellSize( DEFAULT_CELL_SIZE ),
+	m_cellSize( DEFAULT_CELL_SIZE ),
+	m_stamp( 0 )
+{
+	m_cells[0] = m_cells[1] = m_cells[2] = 0;
+}
+
+//
+// clear
+//
+void LightGrid::clear()
+{
+	m_lights.clear();
+	m_cellStart.clear();
+	m_cellLights.clear();
+	m_cells[0] = m_cells[1] = m_cells[2] = 0;
+}
+
+//
+// addLight
+//
+void LightGrid::addLight( unsigned int index, const Light * light, const Point3 & position )
+{
+	GridLight gridLight;
+	gridLight.index = index;
+	gridLight.position = position;
+	gridLight.range = light->getRange();
+	gridLight.global = KIsDerivedFromClass<DirectionLight>( light ) || KIsDerivedFromClass<AmbientLight>( light );
+
+	const ColorA diffuse = light->getDiffuse();
+	gridLight.brightness = diffuse.r > diffuse.g ? diffuse.r : diffuse.g;
+	if ( diffuse.b > gridLight.brightness ) gridLight.brightness = diffuse.b;
+
+	// Without attenuation, only the range reduces the light's significance
+	gridLight.attenuation[0] = 1.f;
+	gridLight.attenuation[1] = 0.f;
+	gridLight.attenuation[2] = 0.f;
+
+	if ( const PointLight * pointLight = KDynamicCast<PointLight>( light ) )
+	{
+		gridLight.attenuation[0] = pointLight->getConstantAttenuation();
+		gridLight.attenuation[1] = pointLight->getLinearAttenuation();
+		gridLight.attenuation[2] = pointLight->getQuadraticAttenuation();
+	}
+
+	m_lights.push_back( gridLight );
+}
+
+//
+// build
+//
+void LightGrid::build()
+{
+	m_cellStart.clear();
+	m_cellLights.clear();
+	m_cells[0] = m_cells[1] = m_cells[2] = 0;
+
+	// Find the box which contains the ranges of the local lights
+	Point3 minimum( FLT_MAX, FLT_MAX, FLT_MAX );
+	Point3 maximum( -FLT_MAX, -FLT_MAX, -FLT_MAX );
+
+	unsigned int i;
+	int axis;
+	for( i = 0; i < m_lights.size(); i++ )
+	{
+		const GridLight & light = m_lights[i];
+		if ( light.global )
+			continue;
+
+		for( axis = 0; axis < 3; axis++ )
+		{
+			if ( light.position[axis] - light.range < minimum[axis] ) minimum[axis] = light.position[axis] - light.range;
+			if ( light.position[axis] + light.range > maximum[axis] ) maximum[axis] = light.position[axis] + light.range;
+		}
+	}
+
+	// Are there any local lights?
+	if ( minimum.x > maximum.x )
+		return;
+
+	// Enlarge the cells if the lights span too many of them
+	float extent = 0;
+	for( axis = 0; axis < 3; axis++ )
+		if ( maximum[axis] - minimum[axis] > extent )
+			extent = maximum[axis] - minimum[axis];
+
+	m_cellSize = m_minimumCellSize > 0 ? m_minimumCellSize : DEFAULT_CELL_SIZE;
+	if ( extent / m_cellSize > MAXIMUM_CELLS_PER_AXIS )
+		m_cellSize = extent / MAXIMUM_CELLS_PER_AXIS;
+
+	m_origin = minimum;
+	for( axis = 0; axis < 3; axis++ )
+	{
+		m_cells[axis] = (int)ceilf( ( maximum[axis] - minimum[axis] ) / m_cellSize );
+		if ( m_cells[axis] < 1 ) m_cells[axis] = 1;
+		if ( m_cells[axis] > MAXIMUM_CELLS_PER_AXIS ) m_cells[axis] = MAXIMUM_CELLS_PER_AXIS;
+	}
+
+	// Count the lights of every cell, then store them. The first pass counts into m_cellStart[cell + 1].
+	const unsigned int cellCount = m_cells[0] * m_cells[1] * m_cells[2];
+	m_cellStart.resize( cellCount + 1, 0 );
+
+	for( int pass = 0; pass < 2; pass++ )
+	{
+		for( i = 0; i < m_lights.size(); i++ )
+		{
+			const GridLight & light = m_lights[i];
+			if ( light.global )
+				continue;
+
+			int first[3], last[3];
+			for( axis = 0; axis < 3; axis++ )
+				GetCellRange( light.position[axis] - light.range, light.position[axis] + light.range, axis, first[axis], last[axis] );
+
+			for( int z = first[2]; z <= last[2]; z++ )
+				for( int y = first[1]; y <= last[1]; y++ )
+					for( int x = first[0]; x <= last[0]; x++ )
+					{
+						const unsigned int cell = ( z * m_cells[1] + y ) * m_cells[0] + x;
+						if ( pass == 0 )
+							m_cellStart[cell + 1]++;
+						else
+							m_cellLights[ m_cellStart[cell]++ ] = i;
+					}
+		}
+
+		if ( pass == 0 )
+		{
+			// Turn the counts into offsets
+			for( unsigned int cell = 0; cell < cellCount; cell++ )
+				m_cellStart[cell + 1] += m_cellStart[cell];
+			m_cellLights.resize( m_cellStart[cellCount] );
+		}
+		else
+		{
+			// Filling the cells advanced every offset to the start of the next cell
+			for( unsigned int cell = cellCount; cell > 0; cell-- )
+				m_cellStart[cell] = m_cellStart[cell - 1];
+			m_cellStart[0] = 0;
+		}
+	}
+
+	m_lightStamps.resize( m_lights.size(), m_stamp );
+}
+
+//
+// assign
+//
+void LightGrid::assign( const Bound & bound, vector<unsigned int> & lights )
+{
+	if ( !m_maximumLights || m_lights.empty() )
+		return;
+
+	m_candidates.clear();
+	m_lightStamps.resize( m_lights.size(), m_stamp );
+	m_stamp++;
+
+	// Objects without bounds are affected by every light
+	const float radius = bound.getRadius() > 0 ? bound.getRadius() : FLT_MAX;
+	const Point3 & center = bound.getCenter();
+
+	// Find the cells the bounds overlap. If there are more cells than lights,
+	// testing every light is cheaper.
+	int first[3], last[3];
+	bool inside = m_cells[0] != 0;
+	unsigned int cellCount = 1;
+	for( int axis = 0; axis < 3 && inside; axis++ )
+	{
+		inside = GetCellRange( center[axis] - radius, center[axis] + radius, axis, first[axis], last[axis] );
+		cellCount *= last[axis] - first[axis] + 1;
+	}
+
+	unsigned int i;
+	float significance;
+
+	if ( inside && cellCount < m_lights.size() )
+	{
+		for( int z = first[2]; z <= last[2]; z++ )
+			for( int y = first[1]; y <= last[1]; y++ )
+				for( int x = first[0]; x <= last[0]; x++ )
+				{
+					const unsigned int cell = ( z * m_cells[1] + y ) * m_cells[0] + x;
+					for( unsigned int j = m_cellStart[cell]; j < m_cellStart[cell + 1]; j++ )
+					{
+						const unsigned int light = m_cellLights[j];
+						if ( m_lightStamps[light] == m_stamp )
+							continue;
+
+						m_lightStamps[light] = m_stamp;
+						if ( RankLight( m_lights[light], bound, significance ) )
+							m_candidates.push_back( pair<float, unsigned int>( significance, light ) );
+					}
+				}
+	}
+	else if ( inside )
+	{
+		for( i = 0; i < m_lights.size(); i++ )
+			if ( !m_lights[i].global && RankLight( m_lights[i], bound, significance ) )
+				m_candidates.push_back( pair<float, unsigned int>( significance, i ) );
+	}
+
+	// The global lights affect everything, and come first
+	for( i = 0; i < m_lights.size(); i++ )
+		if ( m_lights[i].global )
+			m_candidates.push_back( pair<float, unsigned int>( FLT_MAX, i ) );
+
+	// Keep the most significant lights
+	const unsigned int count = (unsigned int)m_candidates.size() < m_maximumLights ? (unsigned int)m_candidates.size() : m_maximumLights;
+	std::partial_sort( m_candidates.begin(), m_candidates.begin() + count, m_candidates.end(), SortCandidates );
+
+	for( i = 0; i < count; i++ )
+		lights.push_back( m_lights[ m_candidates[i].second ].index );
+}
+
+//
+// GetCellRange
+//
+bool LightGrid::GetCellRange( float minimum, float maximum, int axis, int & first, int & last ) const
+{
+	// Compute the cells in floating point, since the bounds may be huge
+	const float firstCell = floorf( ( minimum - m_origin[axis] ) / m_cellSize );
+	const float lastCell = floorf( ( maximum - m_origin[axis] ) / m_cellSize );
+
+	if ( lastCell < 0 || firstCell > m_cells[axis] - 1 )
+		return false;
+
+	first = firstCell < 0 ? 0 : (int)firstCell;
+	last = lastCell > m_cells[axis] - 1 ? m_cells[axis] - 1 : (int)lastCell;
+	return true;
+}
+
+//
+// RankLight
+//
+bool LightGrid::RankLight( const GridLight & light, const Bound & bound, float & significance ) const
+{
+	// Objects without bounds are always reached, at the light's position
+	float distance = 0;
+	if ( bound.getRadius() > 0 )
+	{
+		distance = ( light.position - bound.getCenter() ).getLength() - bound.getRadius();
+		if ( distance < 0 )
+			distance = 0;
+	}
+
+	if ( distance >= light.range )
+		return false;
+
+	// Attenuated brightness at the closest point of the bounds, faded out towards the range
+	const float attenuation = light.attenuation[0] + light.attenuation[1] * distance + light.attenuation[2] * distance * distance;
+	significance = light.brightness * ( 1.f - distance / light.range ) / ( attenuation > 0.001f ? attenuation : 0.001f );
+
+	return true;
+}
+
+// ----------------------------------------------------
+// Local Functions
+// ----------------------------------------------------
+
+//
+// SortCandidates
+// Orders the lights by decreasing significance
+//
+bool SortCandidates( const pair<float, unsigned int> & a, const pair<float, unsigned int> & b )
+{
+	return a.first > b.first;
+}
@@ -0,0 +1,123 @@
+/*
+	Katana Engine
+	Copyright  2001-2004 Eric Bryant, Inc.
+
+	File:		lightgrid.h
+	Author:		Eric Bryant
+
+	Assigns the lights of a frame to the objects they affect. The ranges
+	of the local lights are binned into a uniform grid, so each object only
+	tests the lights of the cells its bounds overlap, and keeps the most
+	significant of them.
+*/
+
+#ifndef _LIGHTGRID_H
+#define _LIGHTGRID_H
+
+namespace Katana
+{
+
+//
+// Forward Declarations
+//
+class Light;
+
+///
+/// LightGrid
+/// Directional and ambient lights affect every object. Point and spot lights only affect
+/// the objects their range intersects, ranked by their attenuated brightness at the object.
+///
+class LightGrid
+{
+public:
+	enum
+	{
+		DEFAULT_MAXIMUM_LIGHTS = 8,			/// Lights per object (what the fixed function pipeline can enable at once)
+		MAXIMUM_CELLS_PER_AXIS = 32,		/// The cells are enlarged so the grid never exceeds this resolution
+	};
+
+	/// Default (minimum) size of a cell, in world units
+	static const float DEFAULT_CELL_SIZE;
+
+public:
+	/// Constructor
+	LightGrid();
+
+	/// Sets the maximum number of lights assigned to an object
+	void setMaximumLights( unsigned int count )						{ m_maximumLights = count; }
+
+	/// Returns the maximum number of lights assigned to an object
+	unsigned int getMaximumLights() const							{ return m_maximumLights; }
+
+	/// Sets the minimum size of a cell. Cells are enlarged if the lights span too many of them.
+	void setCellSize( float size )									{ m_minimumCellSize = size; }
+
+	/// Returns the minimum size of a cell
+	float getCellSize() const										{ return m_minimumCellSize; }
+
+	/// Removes the lights of the previous frame
+	void clear();
+
+	/// Adds a light of the frame, given its world position. The index identifies the light
+	/// in the lists returned by assign().
+	void addLight( unsigned int index, const Light * light, const Point3 & position );
+
+	/// Bins the local lights into the grid. Must be called after the lights are added.
+	void build();
+
+	/// Appends to the list the indices of the most significant lights which affect the bounds,
+	/// in decreasing significance
+	void assign( const Bound & bound, vector<unsigned int> & lights );
+
+	/// Returns the number of lights added
+	unsigned int getLightCount() const								{ return (unsigned int)m_lights.size(); }
+
+private:
+	///
+	/// GridLight
+	/// A light of the frame, with what the assignment needs to rank it
+	///
+	struct GridLight
+	{
+		unsigned int	index;
+		Point3			position;
+		float			range;
+		float			brightness;			/// Brightest component of the diffuse color
+		float			attenuation[3];		/// Constant, linear and quadratic attenuation (point lights only)
+		bool			global;				/// Directional and ambient lights affect everything
+	};
+
+	/// Returns the range of cells covered along an axis. Returns false if it's outside the grid.
+	bool GetCellRange( float minimum, float maximum, int axis, int & first, int & last ) const;
+
+	/// Ranks a local light against the bounds. Returns false if the light doesn't reach them.
+	bool RankLight( const GridLight & light, const Bound & bound, float & significance ) const;
+
+private:
+	/// Maximum number of lights per object
+	unsigned int					m_maximumLights;
+
+	/// Minimum size of a cell
+	float							m_minimumCellSize;
+
+	/// The lights of the frame
+	vector<GridLight>				m_lights;
+
+	/// Minimum corner, size of a cell, and number of cells along each axis of the grid
+	Point3							m_origin;
+	float							m_cellSize;
+	int								m_cells[3];
+
+	/// Lights of every cell. The lights of cell i are m_cellLights[ m_cellStart[i] .. m_cellStart[i+1] ).
+	vector<unsigned int>			m_cellStart;
+	vector<unsigned int>			m_cellLights;
+
+	/// Scratch memory of assign(). Lights already ranked for the current object are stamped.
+	vector<unsigned int>			m_lightStamps;
+	unsigned int					m_stamp;
+	vector< pair<float, unsigned int> >	m_candidates;
+};
+
+}; // Katana
+
+#endif // _LIGHTGRID_H
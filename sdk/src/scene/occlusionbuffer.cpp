@@ -0,0 +1,555 @@
+/*
+	Katana Engine
+	Copyright  2001-2004 Eric Bryant, Inc.
+
+	File:		occlusionbuffer.cpp
+	Author:		Eric Bryant
+
+	Small depth buffer rasterized on the CPU from the occluders of the
+	scene. The buffer is split into tiles, and a hierarchy of the nearest
+	and farthest depth of the tiles lets the bounds of the other objects
+	be rejected without touching most of the pixels.
+*/
+
+#include <float.h>
+#include <math.h>
+#include <algorithm>
+#include "katana_config.h"
+#include "katana_core_includes.h"
+#include "katana_base_includes.h"
+#include "render/rendertypes.h"
+#include "render/geometry.h"
+#include "visible.h"
+#include "camera.h"
+#include "occlusionbuffer.h"
+#include "base/jobsystem.h"
+#include "base/profiler.h"
+#if defined(KATANA_MATH_SSE2)
+#include <emmintrin.h>
+#endif
+
+//
+// Constructor
+//
+OcclusionBuffer::OcclusionBuffer() :
+	m_width( 0 ),
+	m_height( 0 ),
+	m_tilesX( 0 ),
+	m_tilesY( 0 ),
+	m_nearPlane( 1.f ),
+	m_rendered( false )
+{
+	setResolution( DEFAULT_WIDTH, DEFAULT_HEIGHT );
+}
+
+//
+// setResolution
+//
+void OcclusionBuffer::setResolution( unsigned int width, unsigned int height )
+{
+	m_tilesX = width > TILE_SIZE ? ( width + TILE_SIZE - 1 ) / TILE_SIZE : 1;
+	m_tilesY = height > TILE_SIZE ? ( height + TILE_SIZE - 1 ) / TILE_SIZE : 1;
+	m_width = m_tilesX * TILE_SIZE;
+	m_height = m_tilesY * TILE_SIZE;
+
+	m_depth.assign( m_width * m_height, 0.f );
+	m_rowTriangles.resize( m_tilesY );
+	m_triangles.clear();
+	m_rendered = false;
+
+	// Halve the tiles until a single cell covers the buffer
+	m_levels.clear();
+	unsigned int levelWidth = m_tilesX, levelHeight = m_tilesY;
+	for( ;; )
+	{
+		m_levels.push_back( Level() );
+		Level & level = m_levels.back();
+		level.width = levelWidth;
+		level.height = levelHeight;
+		level.minimum.resize( levelWidth * levelHeight, 0.f );
+		level.maximum.resize( levelWidth * levelHeight, 0.f );
+
+		if ( levelWidth == 1 && levelHeight == 1 )
+			break;
+
+		levelWidth = ( levelWidth + 1 ) / 2;
+		levelHeight = ( levelHeight + 1 ) / 2;
+	}
+}
+
+//
+// begin
+//
+void OcclusionBuffer::begin( const Camera & camera )
+{
+	m_triangles.clear();
+	for( unsigned int row = 0; row < m_tilesY; row++ )
+		m_rowTriangles[row].clear();
+	m_rendered = false;
+
+	// The frustum planes are the clip space planes w+x, w-x, w+y and w-y, each normalized.
+	// For a symmetric frustum, their sums and differences give back x, y and w, with w
+	// scaled to the view depth.
+	const Plane * planes = camera.getWorldPlanes();
+	const Plane & left = planes[FRUSTUM_LEFT];
+	const Plane & right = planes[FRUSTUM_RIGHT];
+	const Plane & top = planes[FRUSTUM_TOP];
+	const Plane & bottom = planes[FRUSTUM_BOTTOM];
+
+	float horizontal = ( left.getNormal() + right.getNormal() ).getLength();
+	float vertical = ( bottom.getNormal() + top.getNormal() ).getLength();
+	horizontal = horizontal > 0 ? 1.f / horizontal : 1.f;
+	vertical = vertical > 0 ? 1.f / vertical : 1.f;
+
+	m_clipX = Plane( ( left.getNormal() - right.getNormal() ) * horizontal, ( left.getConstant() - right.getConstant() ) * horizontal );
+	m_clipY = Plane( ( bottom.getNormal() - top.getNormal() ) * vertical, ( bottom.getConstant() - top.getConstant() ) * vertical );
+	m_clipW = Plane( ( left.getNormal() + right.getNormal() ) * horizontal, ( left.getConstant() + right.getConstant() ) * horizontal );
+
+	m_nearPlane = camera.getNearPlane() > 0 ? camera.getNearPlane() : 0.001f;
+}
+
+//
+// addOccluder
+//
+void OcclusionBuffer::addOccluder( const Geometry & geometry, const Matrix4 & worldMatrix )
+{
+	if ( !geometry.m_vertexBuffer || geometry.m_vertexBuffer->size() < 9 )
+		return;
+
+	// Transform the vertices into clip space once, the triangles share them
+	const unsigned int vertexCount = (unsigned int)geometry.m_vertexBuffer->size() / 3;
+	m_worldVertices.resize( vertexCount );
+	m_clipVertices.resize( vertexCount );
+	worldMatrix.transformPoints( reinterpret_cast<const Point3 *>( &geometry.m_vertexBuffer->front() ), &m_worldVertices[0], vertexCount );
+
+	unsigned int i;
+	for( i = 0; i < vertexCount; i++ )
+	{
+		ClipVertex & vertex = m_clipVertices[i];
+		vertex.x = m_clipX.distance( m_worldVertices[i] );
+		vertex.y = m_clipY.distance( m_worldVertices[i] );
+		vertex.w = m_clipW.distance( m_worldVertices[i] );
+	}
+
+	// Walk the triangles. Their winding doesn't matter, both sides of an occluder hide what's behind it.
+	const unsigned short * indices = ( geometry.m_indexBuffer && !geometry.m_indexBuffer->empty() ) ? &geometry.m_indexBuffer->front() : 0;
+	const unsigned int count = indices ? (unsigned int)geometry.m_indexBuffer->size() : vertexCount;
+
+	unsigned int step;
+	switch( geometry.m_primitiveType )
+	{
+	case TRIANGLE_LIST:		step = 3; break;
+	case TRIANGLE_STRIP:
+	case TRIANGLE_FAN:		step = 1; break;
+	default:				return;
+	}
+
+	for( i = 0; i + 2 < count; i += step )
+	{
+		unsigned int a = geometry.m_primitiveType == TRIANGLE_FAN ? 0 : i;
+		unsigned int b = i + 1, c = i + 2;
+		if ( indices )
+		{
+			a = indices[a];
+			b = indices[b];
+			c = indices[c];
+		}
+
+		if ( a < vertexCount && b < vertexCount && c < vertexCount )
+			AddTriangle( m_clipVertices[a], m_clipVertices[b], m_clipVertices[c] );
+	}
+}
+
+//
+// render
+//
+void OcclusionBuffer::render( JobSystem * jobSystem )
+{
+	m_rendered = true;
+	if ( m_triangles.empty() )
+		return;
+
+	// Every row of tiles owns its pixels and tiles, so the rows are rendered in parallel
+	if ( jobSystem && m_tilesY > 1 )
+		jobSystem->wait( jobSystem->parallelFor( RenderRows, this, 0, m_tilesY ) );
+	else
+		RenderRows( this, 0, m_tilesY );
+
+	// Build the coarser levels from the tiles
+	for( unsigned int index = 1; index < m_levels.size(); index++ )
+	{
+		const Level & below = m_levels[index - 1];
+		Level & level = m_levels[index];
+
+		for( unsigned int y = 0; y < level.height; y++ )
+			for( unsigned int x = 0; x < level.width; x++ )
+			{
+				float minimum = FLT_MAX, maximum = 0.f;
+				for( unsigned int childY = y * 2; childY < y * 2 + 2 && childY < below.height; childY++ )
+					for( unsigned int childX = x * 2; childX < x * 2 + 2 && childX < below.width; childX++ )
+					{
+						const unsigned int child = childY * below.width + childX;
+						if ( below.minimum[child] < minimum ) minimum = below.minimum[child];
+						if ( below.maximum[child] > maximum ) maximum = below.maximum[child];
+					}
+
+				level.minimum[ y * level.width + x ] = minimum;
+				level.maximum[ y * level.width + x ] = maximum;
+			}
+	}
+}
+
+//
+// isVisible
+//
+bool OcclusionBuffer::isVisible( const Bound & bound ) const
+{
+	// Objects without bounds are always visible
+	const float radius = bound.getRadius();
+	if ( !m_rendered || m_triangles.empty() || radius <= 0 )
+		return true;
+
+	// The box around the sphere must be entirely in front of the near plane
+	const Point3 & center = bound.getCenter();
+	const float w = m_clipW.distance( center );
+	if ( w - radius * 1.7320508f <= m_nearPlane )
+		return true;
+
+	// The projection of the box around the sphere contains the projection of the sphere
+	const float x = m_clipX.distance( center );
+	const float y = m_clipY.distance( center );
+	float minimumX = FLT_MAX, maximumX = -FLT_MAX, minimumY = FLT_MAX, maximumY = -FLT_MAX;
+
+	for( int corner = 0; corner < 8; corner++ )
+	{
+		const Point3 offset( corner & 1 ? radius : -radius, corner & 2 ? radius : -radius, corner & 4 ? radius : -radius );
+		const float inverseW = 1.f / ( w + m_clipW.getNormal().getDot( offset ) );
+		const float screenX = ( x + m_clipX.getNormal().getDot( offset ) ) * inverseW;
+		const float screenY = ( y + m_clipY.getNormal().getDot( offset ) ) * inverseW;
+
+		if ( screenX < minimumX ) minimumX = screenX;
+		if ( screenX > maximumX ) maximumX = screenX;
+		if ( screenY < minimumY ) minimumY = screenY;
+		if ( screenY > maximumY ) maximumY = screenY;
+	}
+
+	// Find the pixels the rectangle overlaps (the screen's y axis points down)
+	const float left = ( minimumX * 0.5f + 0.5f ) * m_width;
+	const float right = ( maximumX * 0.5f + 0.5f ) * m_width;
+	const float top = ( 0.5f - maximumY * 0.5f ) * m_height;
+	const float bottom = ( 0.5f - minimumY * 0.5f ) * m_height;
+
+	if ( right <= 0 || bottom <= 0 || left >= m_width || top >= m_height )
+		return true;
+
+	int rect[4];
+	rect[0] = left > 0 ? (int)left : 0;
+	rect[1] = top > 0 ? (int)top : 0;
+	rect[2] = right < m_width ? (int)ceilf( right ) - 1 : m_width - 1;
+	rect[3] = bottom < m_height ? (int)ceilf( bottom ) - 1 : m_height - 1;
+
+	// The nearest point of the sphere is compared against the occluders
+	const float depth = 1.f / ( w - radius );
+
+	const unsigned int topLevel = (unsigned int)m_levels.size() - 1;
+	const Level & level = m_levels[topLevel];
+	for( unsigned int cellY = 0; cellY < level.height; cellY++ )
+		for( unsigned int cellX = 0; cellX < level.width; cellX++ )
+			if ( TestCell( topLevel, cellX, cellY, rect, depth ) )
+				return true;
+
+	return false;
+}
+
+//
+// AddTriangle
+//
+void OcclusionBuffer::AddTriangle( const ClipVertex & a, const ClipVertex & b, const ClipVertex & c )
+{
+	// Most triangles are entirely in front of the near plane
+	if ( a.w >= m_nearPlane && b.w >= m_nearPlane && c.w >= m_nearPlane )
+	{
+		AddScreenTriangle( a, b, c );
+		return;
+	}
+
+	// Clip the triangle, which leaves up to four vertices
+	const ClipVertex * input[3] = { &a, &b, &c };
+	ClipVertex clipped[4];
+	unsigned int count = 0;
+
+	for( int i = 0; i < 3; i++ )
+	{
+		const ClipVertex & current = *input[i];
+		const ClipVertex & next = *input[ ( i + 1 ) % 3 ];
+		const bool currentInside = current.w >= m_nearPlane;
+
+		if ( currentInside )
+			clipped[count++] = current;
+
+		if ( currentInside != ( next.w >= m_nearPlane ) )
+		{
+			const float t = ( m_nearPlane - current.w ) / ( next.w - current.w );
+			ClipVertex & vertex = clipped[count++];
+			vertex.x = current.x + ( next.x - current.x ) * t;
+			vertex.y = current.y + ( next.y - current.y ) * t;
+			vertex.w = m_nearPlane;
+		}
+	}
+
+	if ( count >= 3 )
+		AddScreenTriangle( clipped[0], clipped[1], clipped[2] );
+	if ( count == 4 )
+		AddScreenTriangle( clipped[0], clipped[2], clipped[3] );
+}
+
+//
+// AddScreenTriangle
+//
+void OcclusionBuffer::AddScreenTriangle( const ClipVertex & a, const ClipVertex & b, const ClipVertex & c )
+{
+	const ClipVertex * vertices[3] = { &a, &b, &c };
+	ScreenTriangle triangle;
+
+	int i;
+	for( i = 0; i < 3; i++ )
+	{
+		const float inverseW = 1.f / vertices[i]->w;
+		triangle.x[i] = ( vertices[i]->x * inverseW * 0.5f + 0.5f ) * m_width;
+		triangle.y[i] = ( 0.5f - vertices[i]->y * inverseW * 0.5f ) * m_height;
+		triangle.z[i] = inverseW;
+	}
+
+	// Skip the degenerate triangles, and make the others counter clockwise on the screen
+	const float area = ( triangle.x[1] - triangle.x[0] ) * ( triangle.y[2] - triangle.y[0] ) -
+					   ( triangle.x[2] - triangle.x[0] ) * ( triangle.y[1] - triangle.y[0] );
+	if ( fabsf( area ) < 0.0001f )
+		return;
+
+	if ( area < 0 )
+	{
+		std::swap( triangle.x[1], triangle.x[2] );
+		std::swap( triangle.y[1], triangle.y[2] );
+		std::swap( triangle.z[1], triangle.z[2] );
+	}
+
+	// Find the pixel centers the bounds of the triangle contain
+	const float minimumX = std::min( triangle.x[0], std::min( triangle.x[1], triangle.x[2] ) );
+	const float maximumX = std::max( triangle.x[0], std::max( triangle.x[1], triangle.x[2] ) );
+	const float minimumY = std::min( triangle.y[0], std::min( triangle.y[1], triangle.y[2] ) );
+	const float maximumY = std::max( triangle.y[0], std::max( triangle.y[1], triangle.y[2] ) );
+
+	if ( maximumX < 0.5f || minimumX > m_width - 0.5f || maximumY < 0.5f || minimumY > m_height - 0.5f )
+		return;
+
+	const int firstRow = minimumY > 0.5f ? (int)ceilf( minimumY - 0.5f ) : 0;
+	const int lastRow = maximumY < m_height - 0.5f ? (int)floorf( maximumY - 0.5f ) : m_height - 1;
+	if ( firstRow > lastRow || ceilf( minimumX - 0.5f ) > floorf( maximumX - 0.5f ) )
+		return;
+
+	// Bin the triangle into the rows of tiles it covers
+	const unsigned int index = (unsigned int)m_triangles.size();
+	m_triangles.push_back( triangle );
+
+	for( i = firstRow / TILE_SIZE; i <= lastRow / TILE_SIZE; i++ )
+		m_rowTriangles[i].push_back( index );
+}
+
+//
+// RenderRow
+//
+void OcclusionBuffer::RenderRow( unsigned int row )
+{
+	const int firstRow = row * TILE_SIZE;
+	const int lastRow = firstRow + TILE_SIZE - 1;
+
+	// Clear the pixels of the row, then draw the triangles which overlap it
+	std::fill( m_depth.begin() + firstRow * m_width, m_depth.begin() + ( lastRow + 1 ) * m_width, 0.f );
+
+	const vector<unsigned int> & triangles = m_rowTriangles[row];
+	for( unsigned int i = 0; i < triangles.size(); i++ )
+		RasterizeTriangle( m_triangles[ triangles[i] ], firstRow, lastRow );
+
+	// Find the farthest and nearest depth of every tile of the row
+	Level & tiles = m_levels[0];
+	for( unsigned int tile = 0; tile < m_tilesX; tile++ )
+	{
+		const float * pixels = &m_depth[ firstRow * m_width + tile * TILE_SIZE ];
+
+#if defined(KATANA_MATH_SSE2)
+		__m128 minimum = _mm_set1_ps( FLT_MAX );
+		__m128 maximum = _mm_setzero_ps();
+		for( int y = 0; y < TILE_SIZE; y++, pixels += m_width )
+			for( int x = 0; x < TILE_SIZE; x += 4 )
+			{
+				const __m128 depth = _mm_loadu_ps( pixels + x );
+				minimum = _mm_min_ps( minimum, depth );
+				maximum = _mm_max_ps( maximum, depth );
+			}
+
+		float minimums[4], maximums[4];
+		_mm_storeu_ps( minimums, minimum );
+		_mm_storeu_ps( maximums, maximum );
+		tiles.minimum[ row * m_tilesX + tile ] = std::min( std::min( minimums[0], minimums[1] ), std::min( minimums[2], minimums[3] ) );
+		tiles.maximum[ row * m_tilesX + tile ] = std::max( std::max( maximums[0], maximums[1] ), std::max( maximums[2], maximums[3] ) );
+#else
+		float minimum = FLT_MAX, maximum = 0.f;
+		for( int y = 0; y < TILE_SIZE; y++, pixels += m_width )
+			for( int x = 0; x < TILE_SIZE; x++ )
+			{
+				if ( pixels[x] < minimum ) minimum = pixels[x];
+				if ( pixels[x] > maximum ) maximum = pixels[x];
+			}
+
+		tiles.minimum[ row * m_tilesX + tile ] = minimum;
+		tiles.maximum[ row * m_tilesX + tile ] = maximum;
+#endif
+	}
+}
+
+//
+// RasterizeTriangle
+//
+void OcclusionBuffer::RasterizeTriangle( const ScreenTriangle & triangle, int firstRow, int lastRow )
+{
+	// Edge functions a*x + b*y + c, which are positive inside the triangle
+	float a[3], b[3], c[3];
+	int i;
+	for( i = 0; i < 3; i++ )
+	{
+		const int j = ( i + 1 ) % 3;
+		a[i] = triangle.y[i] - triangle.y[j];
+		b[i] = triangle.x[j] - triangle.x[i];
+		c[i] = -( a[i] * triangle.x[i] + b[i] * triangle.y[i] );
+	}
+
+	// The inverse depth is linear across the screen
+	const float area = b[0] * ( triangle.y[2] - triangle.y[0] ) + a[0] * ( triangle.x[2] - triangle.x[0] );
+	const float dzdx = ( ( triangle.z[1] - triangle.z[0] ) * ( triangle.y[2] - triangle.y[0] ) - ( triangle.z[2] - triangle.z[0] ) * ( triangle.y[1] - triangle.y[0] ) ) / area;
+	const float dzdy = ( ( triangle.z[2] - triangle.z[0] ) * ( triangle.x[1] - triangle.x[0] ) - ( triangle.z[1] - triangle.z[0] ) * ( triangle.x[2] - triangle.x[0] ) ) / area;
+	const float z0 = triangle.z[0] - dzdx * triangle.x[0] - dzdy * triangle.y[0];
+
+	// Never nearer than the nearest corner, which rounding could produce near the edges
+	const float nearest = std::max( triangle.z[0], std::max( triangle.z[1], triangle.z[2] ) );
+
+	// Clamp the bounds of the triangle to the rows and the buffer
+	const float minimumX = std::min( triangle.x[0], std::min( triangle.x[1], triangle.x[2] ) );
+	const float maximumX = std::max( triangle.x[0], std::max( triangle.x[1], triangle.x[2] ) );
+	const float minimumY = std::min( triangle.y[0], std::min( triangle.y[1], triangle.y[2] ) );
+	const float maximumY = std::max( triangle.y[0], std::max( triangle.y[1], triangle.y[2] ) );
+
+	const int firstX = minimumX > 0.5f ? (int)ceilf( minimumX - 0.5f ) : 0;
+	const int lastX = maximumX < m_width - 0.5f ? (int)floorf( maximumX - 0.5f ) : m_width - 1;
+	const int firstY = minimumY > firstRow + 0.5f ? (int)ceilf( minimumY - 0.5f ) : firstRow;
+	const int lastY = maximumY < lastRow + 0.5f ? (int)floorf( maximumY - 0.5f ) : lastRow;
+
+#if defined(KATANA_MATH_SSE2)
+	// Four pixels at a time, starting on a multiple of four (the buffer's width is)
+	const __m128 offsets = _mm_setr_ps( 0.5f, 1.5f, 2.5f, 3.5f );
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 edgeA0 = _mm_set1_ps( a[0] ), edgeA1 = _mm_set1_ps( a[1] ), edgeA2 = _mm_set1_ps( a[2] );
+	const __m128 depthX = _mm_set1_ps( dzdx );
+	const __m128 depthMaximum = _mm_set1_ps( nearest );
+	const int startX = firstX & ~3;
+
+	for( int y = firstY; y <= lastY; y++ )
+	{
+		const float centerY = y + 0.5f;
+		const __m128 row0 = _mm_set1_ps( b[0] * centerY + c[0] );
+		const __m128 row1 = _mm_set1_ps( b[1] * centerY + c[1] );
+		const __m128 row2 = _mm_set1_ps( b[2] * centerY + c[2] );
+		const __m128 rowDepth = _mm_set1_ps( z0 + dzdy * centerY );
+		float * pixels = &m_depth[ y * m_width ];
+
+		for( int x = startX; x <= lastX; x += 4 )
+		{
+			const __m128 centerX = _mm_add_ps( _mm_set1_ps( (float)x ), offsets );
+			const __m128 edge0 = _mm_add_ps( _mm_mul_ps( edgeA0, centerX ), row0 );
+			const __m128 edge1 = _mm_add_ps( _mm_mul_ps( edgeA1, centerX ), row1 );
+			const __m128 edge2 = _mm_add_ps( _mm_mul_ps( edgeA2, centerX ), row2 );
+
+			const __m128 inside = _mm_and_ps( _mm_and_ps( _mm_cmpge_ps( edge0, zero ), _mm_cmpge_ps( edge1, zero ) ), _mm_cmpge_ps( edge2, zero ) );
+			if ( !_mm_movemask_ps( inside ) )
+				continue;
+
+			const __m128 previous = _mm_loadu_ps( pixels + x );
+			__m128 depth = _mm_min_ps( _mm_add_ps( _mm_mul_ps( depthX, centerX ), rowDepth ), depthMaximum );
+			depth = _mm_max_ps( previous, depth );
+			_mm_storeu_ps( pixels + x, _mm_or_ps( _mm_and_ps( inside, depth ), _mm_andnot_ps( inside, previous ) ) );
+		}
+	}
+#else
+	for( int y = firstY; y <= lastY; y++ )
+	{
+		const float centerY = y + 0.5f;
+		float * pixels = &m_depth[ y * m_width ];
+
+		for( int x = firstX; x <= lastX; x++ )
+		{
+			const float centerX = x + 0.5f;
+			if ( a[0] * centerX + b[0] * centerY + c[0] < 0 ||
+				 a[1] * centerX + b[1] * centerY + c[1] < 0 ||
+				 a[2] * centerX + b[2] * centerY + c[2] < 0 )
+				continue;
+
+			const float depth = std::min( z0 + dzdx * centerX + dzdy * centerY, nearest );
+			if ( depth > pixels[x] )
+				pixels[x] = depth;
+		}
+	}
+#endif
+}
+
+//
+// RenderRows
+//
+void OcclusionBuffer::RenderRows( void * data, unsigned int begin, unsigned int end )
+{
+	KPROFILE( "OcclusionBuffer::RenderRows" );
+
+	OcclusionBuffer * buffer = static_cast<OcclusionBuffer *>( data );
+	for( unsigned int row = begin; row < end; row++ )
+		buffer->RenderRow( row );
+}
+
+//
+// TestCell
+//
+bool OcclusionBuffer::TestCell( unsigned int level, unsigned int x, unsigned int y, const int * rect, float depth ) const
+{
+	// Only the part of the cell within the rectangle matters
+	const int size = TILE_SIZE << level;
+	const int left = x * size, top = y * size;
+	const int right = left + size - 1, bottom = top + size - 1;
+	if ( right < rect[0] || left > rect[2] || bottom < rect[1] || top > rect[3] )
+		return false;
+
+	// Behind every pixel of the cell, or in front of all of them?
+	const Level & cells = m_levels[level];
+	const unsigned int cell = y * cells.width + x;
+	if ( depth < cells.minimum[cell] )
+		return false;
+	if ( depth > cells.maximum[cell] )
+		return true;
+
+	// Compare the pixels of a tile
+	if ( level == 0 )
+	{
+		const int lastX = std::min( right, rect[2] ), lastY = std::min( bottom, rect[3] );
+		for( int pixelY = std::max( top, rect[1] ); pixelY <= lastY; pixelY++ )
+			for( int pixelX = std::max( left, rect[0] ); pixelX <= lastX; pixelX++ )
+				if ( depth >= m_depth[ pixelY * m_width + pixelX ] )
+					return true;
+
+		return false;
+	}
+
+	// Otherwise the children decide
+	const Level & children = m_levels[level - 1];
+	for( unsigned int childY = y * 2; childY < y * 2 + 2 && childY < children.height; childY++ )
+		for( unsigned int childX = x * 2; childX < x * 2 + 2 && childX < children.width; childX++ )
+			if ( TestCell( level - 1, childX, childY, rect, depth ) )
+				return true;
+
+	return false;
+}
@@ -0,0 +1,167 @@
+/*
+	Katana Engine
+	Copyright  2001-2004 Eric Bryant, Inc.
+
+	File:		occlusionbuffer.h
+	Author:		Eric Bryant
+
+	Small depth buffer rasterized on the CPU from the occluders of the
+	scene. The buffer is split into tiles, and a hierarchy of the nearest
+	and farthest depth of the tiles lets the bounds of the other objects
+	be rejected without touching most of the pixels.
+*/
+
+#ifndef _OCCLUSIONBUFFER_H
+#define _OCCLUSIONBUFFER_H
+
+namespace Katana
+{
+
+//
+// Forward Declarations
+//
+class Camera;
+class JobSystem;
+struct Geometry;
+
+///
+/// OcclusionBuffer
+/// The buffer stores the inverse view depth of the nearest occluder at every pixel (zero where
+/// there is none), which is linear across the screen. Rows of tiles are rasterized independently,
+/// so they can be split across the job system's worker threads. Nothing is drawn by the renderer.
+///
+class OcclusionBuffer
+{
+public:
+	enum
+	{
+		DEFAULT_WIDTH = 256,			/// Default resolution of the buffer, independent of the screen's
+		DEFAULT_HEIGHT = 128,
+		TILE_SIZE = 8,					/// Width and height of a tile, in pixels
+	};
+
+public:
+	/// Constructor
+	OcclusionBuffer();
+
+	/// Sets the resolution of the buffer. It is rounded up to whole tiles.
+	void setResolution( unsigned int width, unsigned int height );
+
+	/// Returns the width of the buffer
+	unsigned int getWidth() const									{ return m_width; }
+
+	/// Returns the height of the buffer
+	unsigned int getHeight() const									{ return m_height; }
+
+	/// Starts a new frame seen from the camera, discarding the previous occluders
+	void begin( const Camera & camera );
+
+	/// Adds the triangles of an occluder, transformed by its world matrix. They're clipped
+	/// against the near plane and binned into the rows of tiles they cover.
+	void addOccluder( const Geometry & geometry, const Matrix4 & worldMatrix );
+
+	/// Rasterizes the occluders and builds the depth hierarchy. The rows of tiles are
+	/// rasterized in parallel if a job system is given.
+	void render( JobSystem * jobSystem = 0 );
+
+	/// Returns false if the bounds are entirely hidden behind the occluders. Bounds which
+	/// cross the near plane, or which are tested before render(), are always visible.
+	bool isVisible( const Bound & bound ) const;
+
+	/// Returns the number of occluder triangles rasterized in the frame
+	unsigned int getTriangleCount() const							{ return (unsigned int)m_triangles.size(); }
+
+	/// Returns the inverse view depth of a pixel (zero if no occluder covers it)
+	float getDepth( unsigned int x, unsigned int y ) const			{ return m_depth[ y * m_width + x ]; }
+
+private:
+	///
+	/// ClipVertex
+	/// A vertex in the camera's clip space: the screen coordinates are x/w and y/w
+	///
+	struct ClipVertex
+	{
+		float			x, y, w;
+	};
+
+	///
+	/// ScreenTriangle
+	/// A clipped triangle, in pixels, with the inverse depth at its corners
+	///
+	struct ScreenTriangle
+	{
+		float			x[3];
+		float			y[3];
+		float			z[3];
+	};
+
+	///
+	/// Level
+	/// A level of the depth hierarchy. Every cell keeps the farthest and nearest depth of
+	/// its pixels. The cells of the first level are the tiles, every other level halves the
+	/// resolution of the previous one.
+	///
+	struct Level
+	{
+		unsigned int	width;
+		unsigned int	height;
+		vector<float>	minimum;
+		vector<float>	maximum;
+	};
+
+private:
+	/// Clips a triangle against the near plane, projects it and bins it
+	void AddTriangle( const ClipVertex & a, const ClipVertex & b, const ClipVertex & c );
+
+	/// Projects a clipped triangle to the screen and bins it into the rows of tiles it covers
+	void AddScreenTriangle( const ClipVertex & a, const ClipVertex & b, const ClipVertex & c );
+
+	/// Rasterizes the triangles of a row of tiles, and computes the depth range of its tiles
+	void RenderRow( unsigned int row );
+
+	/// Rasterizes a triangle within a range of rows of the buffer
+	void RasterizeTriangle( const ScreenTriangle & triangle, int firstRow, int lastRow );
+
+	/// Job function which renders a range of the rows of tiles
+	static void RenderRows( void * data, unsigned int begin, unsigned int end );
+
+	/// Tests a cell of the hierarchy, and its children if the cell doesn't decide
+	bool TestCell( unsigned int level, unsigned int x, unsigned int y, const int * rect, float depth ) const;
+
+private:
+	/// Resolution of the buffer, in pixels and in tiles
+	unsigned int					m_width;
+	unsigned int					m_height;
+	unsigned int					m_tilesX;
+	unsigned int					m_tilesY;
+
+	/// Linear functions which map a world position to the clip space of the camera
+	/// (the distances to these planes are x, y and w)
+	Plane							m_clipX;
+	Plane							m_clipY;
+	Plane							m_clipW;
+
+	/// Near plane distance of the camera
+	float							m_nearPlane;
+
+	/// Inverse depth of every pixel
+	vector<float>					m_depth;
+
+	/// The depth hierarchy, the tiles are the first level
+	vector<Level>					m_levels;
+
+	/// The occluder triangles of the frame, and the triangles overlapping every row of tiles
+	vector<ScreenTriangle>			m_triangles;
+	vector< vector<unsigned int> >	m_rowTriangles;
+
+	/// Scratch memory for the occluder vertices, in world and clip space
+	vector<Point3>					m_worldVertices;
+	vector<ClipVertex>				m_clipVertices;
+
+	/// Has render() been called since begin()
+	bool							m_rendered;
+};
+
+}; // Katana
+
+#endif // _OCCLUSIONBUFFER_H
@@ -0,0 +1,107 @@
+/*
+	Katana Engine
+	Copyright  2001-2004 Eric Bryant, Inc.
+
+	File:		renderqueue.cpp
+	Author:		Eric Bryant
+
+	Sorted queue of visible objects. Every queued object carries a 64-bit
+	key packed from its render states, and the queue is radix sorted on the
+	keys so objects sharing shaders, materials and textures are drawn together.
+*/
+
+#include <string.h>
+#include "katana_core_includes.h"
+#include "renderqueue.h"
+
+//
+// Macros
+//
+#define BITMASK(bits)	( ( RenderSortKey(1) << (bits) ) - 1 )
+
+//
+// sort
+//
+void RenderQueue::sort()
+{
+	const unsigned int count = (unsigned int)m_entries.size();
+	if ( count < 2 ) return;
+
+	// Build the histograms of all eight bytes in one pass over the keys
+	unsigned int histogram[8][256];
+	memset( histogram, 0, sizeof(histogram) );
+
+	unsigned int i;
+	for( i = 0; i < count; i++ )
+	{
+		RenderSortKey key = m_entries[i].key;
+		for( unsigned int pass = 0; pass < 8; pass++, key >>= 8 )
+			histogram[pass][ key & 0xFF ]++;
+	}
+
+	m_scratch.resize( count );
+	Entry * src = &m_entries[0];
+	Entry * dst = &m_scratch[0];
+
+	for( unsigned int pass = 0; pass < 8; pass++ )
+	{
+		unsigned int * bucket = histogram[pass];
+		const unsigned int shift = pass * 8;
+
+		// If every key has the same byte, this pass wouldn't move anything
+		if ( bucket[ ( src[0].key >> shift ) & 0xFF ] == count )
+			continue;
+
+		// Convert the counts into starting offsets
+		unsigned int offset = 0;
+		for( i = 0; i < 256; i++ )
+		{
+			unsigned int bucketCount = bucket[i];
+			bucket[i] = offset;
+			offset += bucketCount;
+		}
+
+		// Scatter the entries into their buckets (this keeps the sort stable)
+		for( i = 0; i < count; i++ )
+			dst[ bucket[ ( src[i].key >> shift ) & 0xFF ]++ ] = src[i];
+
+		std::swap( src, dst );
+	}
+
+	// If the last pass wrote to the scratch buffer, it now holds the sorted entries
+	if ( src != &m_entries[0] )
+		m_entries.swap( m_scratch );
+}
+
+//
+// makeKey
+//
+RenderSortKey RenderQueue::makeKey( unsigned int shaderID, int materialID, int textureID, float depth, float maxDepth, bool translucent )
+{
+	// Quantize the depth into a bucket
+	RenderSortKey depthBucket = 0;
+	if ( maxDepth > 0.f && depth > 0.f )
+	{
+		float normalized = depth / maxDepth;
+		if ( normalized > 1.f ) normalized = 1.f;
+		depthBucket = RenderSortKey( normalized * BITMASK(DEPTH_BITS) );
+	}
+
+	const RenderSortKey shader = RenderSortKey( shaderID ) & BITMASK(SHADER_BITS);
+	const RenderSortKey material = RenderSortKey( materialID ) & BITMASK(MATERIAL_BITS);
+	const RenderSortKey texture = RenderSortKey( textureID ) & BITMASK(TEXTURE_BITS);
+
+	// Translucent objects are sorted back to front, regardless of their states
+	if ( translucent )
+		return ( RenderSortKey(1) << 63 ) |
+			   ( ( BITMASK(DEPTH_BITS) - depthBucket ) << 47 ) |
+			   ( shader << 32 ) |
+			   ( material << 16 ) |
+			   texture;
+
+	// Opaque objects are grouped by state, then front to back
+	return ( shader << 48 ) |
+		   ( material << 32 ) |
+		   ( texture << 16 ) |
+		   depthBucket;
+}
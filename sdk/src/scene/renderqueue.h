@@ -0,0 +1,139 @@
+/*
+	Katana Engine
+	Copyright  2001-2004 Eric Bryant, Inc.
+
+	File:		renderqueue.h
+	Author:		Eric Bryant
+
+	Sorted queue of visible objects. Every queued object carries a 64-bit
+	key packed from its render states, and the queue is radix sorted on the
+	keys so objects sharing shaders, materials and textures are drawn together.
+*/
+
+#ifndef _RENDERQUEUE_H
+#define _RENDERQUEUE_H
+
+namespace Katana
+{
+
+//
+// Forward Declarations
+//
+class Visible;
+class Shader;
+class Material;
+class Light;
+
+///
+/// RenderSortKey
+/// Packed render state of a queued object. Opaque objects are grouped by
+/// shader, material and texture and then sorted front to back. Translucent
+/// objects are always drawn after the opaque ones, back to front.
+///
+///	Opaque:			[63] 0 | [62-48] shader | [47-32] material | [31-16] texture | [15-0] depth
+///	Translucent:	[63] 1 | [62-47] inverted depth | [46-32] shader | [31-16] material | [15-0] texture
+///
+typedef kuint64 RenderSortKey;
+
+///
+/// RenderQueue
+///
+class RenderQueue
+{
+public:
+	enum
+	{
+		SHADER_BITS = 15,
+		MATERIAL_BITS = 16,
+		TEXTURE_BITS = 16,
+		DEPTH_BITS = 16,
+	};
+
+	///
+	/// Entry
+	/// A sort key along with the index of the queued object it refers to
+	///
+	struct Entry
+	{
+		RenderSortKey	key;		/// Packed render state
+		unsigned int	index;		/// Index of the object in the client's queue
+	};
+
+public:
+	/// Clears the queue (the memory is kept for the next frame)
+	void clear()												{ m_entries.clear(); }
+
+	/// Adds an object index with its sort key
+	void push( RenderSortKey key, unsigned int index );
+
+	/// Sorts the queue by ascending keys. This is a stable LSD radix sort;
+	/// byte passes where every key has the same value are skipped.
+	void sort();
+
+	/// Returns the number of queued objects
+	unsigned int size() const									{ return (unsigned int)m_entries.size(); }
+
+	/// Returns the sorted entry
+	const Entry & operator[]( unsigned int i ) const			{ return m_entries[i]; }
+
+public:
+	/// Packs the render state into a sort key. The depth is normalized from [0, maxDepth].
+	static RenderSortKey makeKey( unsigned int shaderID, int materialID, int textureID, float depth, float maxDepth, bool translucent );
+
+private:
+	/// The queued entries
+	vector<Entry>	m_entries;
+
+	/// Scratch memory used during the radix sort
+	vector<Entry>	m_scratch;
+};
+
+///
+/// RenderPacket
+/// Everything endScene() needs to submit a frame, captured at the end of beginScene().
+/// The world matrices, materials and lights are copied, so the packet stays valid while
+/// the next frame is being updated.
+///
+struct RenderPacket
+{
+	///
+	/// Item
+	/// An object to render, with its render states at the time the packet was built
+	///
+	struct Item
+	{
+		Visible *				visible;			/// The object (the scene keeps it attached until the packet is consumed)
+		Shader *				shader;				/// Shader which renders the object
+		shared_ptr<Material>	material;			/// Material of the object
+		float					worldMatrix[16];	/// World matrix of the object (kept unaligned, so items can be stored in a vector)
+		unsigned int			lightBegin;			/// First of the object's lights in lightIndices
+		unsigned int			lightCount;			/// Number of lights affecting the object
+	};
+
+	vector<Item>				items;				/// Objects to render, sorted by render state
+	vector<Item>				shadowCasters;		/// Objects which cast stencil shadows
+	vector< shared_ptr<Light> >	lights;				/// Lights of the frame
+	vector<unsigned int>		lightIndices;		/// Lights of every object, as indices into the lights of the frame
+
+	/// Clears the packet (the memory is kept for the next frame)
+	void clear()									{ items.clear(); shadowCasters.clear(); lights.clear(); lightIndices.clear(); }
+};
+
+//
+// Inline
+//
+
+//
+// RenderQueue::push
+//
+inline void RenderQueue::push( RenderSortKey key, unsigned int index )
+{
+	Entry entry;
+	entry.key = key;
+	entry.index = index;
+	m_entries.push_back( entry );
+}
+
+}; // Katana
+
+#endif // _RENDERQUEUE_H
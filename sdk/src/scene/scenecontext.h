@@ -28,6 +28,9 @@ class VisNode;
 class Visible;
 class TextDisplay;
 class SceneGraph;
+class JobSystem;
+class Material;
+struct SceneStatistics;
 
 ///
 /// SceneContext
@@ -46,8 +49,15 @@ struct SceneContext
 	const Camera *				currentCamera;
 	const Matrix4 *				currentViewMatrix;
 	Visible *					currentVisibleObject;
+	const Matrix4 *				currentWorldMatrix;
+	shared_ptr<Material>		currentMaterial;
+	bool						currentMaterialChanged;
 	VisNode *					currentParent;
+	unsigned int				currentPlaneMask;
 	vector< shared_ptr<Light> > currentLights;
+	bool						currentLightsChanged;
+	JobSystem *					jobSystem;
+	SceneStatistics *			statistics;
 };
 
 ///
@@ -62,6 +72,24 @@ struct SceneStatistics
 	int		totalTrianglesRendered;				/// Total triangles rendered within the lifetime of the game
 	float	framesPerSecond;					/// Number of frames the game is rendering per second
 	int		trianglesPerSecond;					/// Number of triangles the game is rendering per second
+
+	int		objectsCulledLastFrame;				/// Objects rejected by OnPreRender() within the last frame (culled or hidden)
+	int		objectsOccludedLastFrame;			/// Objects hidden by the occluders within the last frame (also counted as culled)
+	int		drawCallsLastFrame;					/// Draw calls issued to the renderer within the last frame
+	int		primitivesLastFrame;				/// Primitives (of any type) submitted within the last frame
+	int		verticesLastFrame;					/// Vertices submitted within the last frame
+	int		bytesUploadedLastFrame;				/// Bytes written into vertex/index buffers within the last frame
+	int		stateChangesLastFrame;				/// Render state changes within the last frame
+	int		textureBindsLastFrame;				/// Texture binds within the last frame
+	int		terrainTrianglesLastFrame;			/// Terrain triangles (including the stitching degenerates) within the last frame
+	int		terrainPatchesLastFrame;			/// Active terrain patches within the last frame
+	int		shadowVolumesRebuiltLastFrame;		/// Shadow volumes extruded again within the last frame
+
+	float	frameMilliseconds;					/// Time between the last two beginScene() calls
+	float	updateMilliseconds;					/// Time spent updating the nodes and controllers within the last frame
+	float	cullMilliseconds;					/// Time spent gathering the visible objects within the last frame
+	float	sortMilliseconds;					/// Time spent sorting the render queue within the last frame
+	float	renderMilliseconds;					/// Time spent submitting the render queue within the last frame
 };
 
 } // Katana
@@ -11,22 +11,40 @@
 	renders them to the current render device.
 */
 
+#include <float.h>
+#include <string.h>
+#include "katana_config.h"
 #include "katana_core_includes.h"
 #include "katana_base_includes.h"
 #include "engine/debugoutput.h"
+#include "render/texture.h"
 #include "render/rendertypes.h"
 #include "render/render.h"
 #include "render/material.h"
 #include "render/shader.h"
 #include "render/hardwarelitshader.h"
 #include "render/stencilshadowshader.h"
+#include "render/geometry.h"
 #include "visible.h"
 #include "camera.h"
 #include "visnode.h"
 #include "controller.h"
 #include "scenecontext.h"
+#include "renderqueue.h"
 #include "scenegraph.h"
+#include "statisticsrecorder.h"
+#include "spatialindex.h"
+#include "lightgrid.h"
+#include "occlusionbuffer.h"
 #include "system/systemtimer.h"
+#include "base/jobsystem.h"
+#include "base/profiler.h"
+
+//
+// Local Functions
+//
+static void ResetFrameStatistics( SceneStatistics & statistics );
+static float GetMilliseconds( kint64 beginTick, kint64 endTick );
 
 //
 // Constructor
@@ -35,6 +53,15 @@ SceneGraph::SceneGraph( shared_ptr<VisNode> root )
 {
 	// Store the root
 	m_rootNode = root;
+	m_pendingRemoveAll = false;
+	m_inFrame = false;
+	m_parallelUpdate = false;
+	m_pipelined = false;
+	m_pipelineChanged = false;
+	m_updatingContext = NULL;
+	m_frameTick = 0;
+	m_cullingMode = CULL_HIERARCHY;
+	m_occlusionCulling = false;
 
 	// Seed the context
 	m_context.currentViewMatrix = NULL;
@@ -46,6 +73,13 @@ SceneGraph::SceneGraph( shared_ptr<VisNode> root )
 	m_context.gameTime = 0.f;
 	m_context.renderPass = 0;
 	m_context.frameCount = 0;
+	m_context.currentPlaneMask = FRUSTUM_PLANE_MASK_ALL;
+	m_context.currentVisibleObject = NULL;
+	m_context.currentWorldMatrix = NULL;
+	m_context.currentMaterialChanged = true;
+	m_context.currentLightsChanged = true;
+	m_context.jobSystem = NULL;
+	m_context.statistics = &m_statistics;
 
 	// Zero out the scene statistics
 	memset( &m_statistics, 0, sizeof( SceneStatistics ) );
@@ -53,6 +87,15 @@ SceneGraph::SceneGraph( shared_ptr<VisNode> root )
 	// Setup the default shaders
 	m_defaultShader.reset( new HardwareLitShader() );
 	m_stencilShadowShader.reset( new StencilShadowShader() );
+
+	// The spatial index covers the scene's world bounds by default
+	m_spatialIndex.reset( new SpatialIndex() );
+
+	// Every object is lit by its most significant lights
+	m_lightGrid.reset( new LightGrid() );
+
+	// The occlusion buffer is only rendered if the occlusion culling is enabled
+	m_occlusionBuffer.reset( new OcclusionBuffer() );
 }
 
 //
@@ -68,6 +111,14 @@ SceneGraph::~SceneGraph()
 //
 void SceneGraph::addNode( shared_ptr<Visible> node )
 { 
+	// While a pipelined frame is in progress, the update runs alongside the render
+	// submission, which may not be disturbed by the attachment
+	if ( m_pipelined && m_inFrame )
+	{
+		m_pendingAdditions.push_back( node );
+		return;
+	}
+
 	// If the attachment was successful
 	if ( node->OnAttach( &m_context ) ) 
 	{
@@ -81,11 +132,22 @@ void SceneGraph::addNode( shared_ptr<Visible> node )
 //
 void SceneGraph::removeNode( shared_ptr<Visible> node )
 {
+	// The render queue holds raw pointers during the frame, so the node
+	// must stay attached until the frame completes
+	if ( m_inFrame )
+	{
+		m_pendingRemovals.push_back( node );
+		return;
+	}
+
 	// Inform the node that is going to be detached
 	node->OnDetach( &m_context ); 
 
 	// Detach the node from the root node
 	m_rootNode->detachChild( node ); 
+
+	// The node may have been an occluder
+	m_occluders.clear();
 }
 
 //
@@ -93,12 +155,37 @@ void SceneGraph::removeNode( shared_ptr<Visible> node )
 //
 void SceneGraph::removeAllNodes()
 {
+	// Defer the removal until the frame completes
+	if ( m_inFrame )
+	{
+		m_pendingRemoveAll = true;
+		return;
+	}
+
 	// Detach the root node, which recursively detaches
 	// the children nodes
 	m_rootNode->OnDetach( &m_context );
 
 	// Detach all children from the root
 	m_rootNode->detachAllChildren(); 
+	m_occluders.clear();
+}
+
+//
+// setCullingMode
+//
+void SceneGraph::setCullingMode( CullingMode mode )
+{
+	if ( mode == m_cullingMode )
+		return;
+
+	m_cullingMode = mode;
+
+	// Register the whole scene once, the objects keep the index up to date from then on
+	if ( mode == CULL_SPATIAL_INDEX )
+		m_spatialIndex->insert( m_rootNode.get() );
+	else
+		m_spatialIndex->clear();
 }
 
 //
@@ -173,6 +260,15 @@ float g_fTime = 0;
 //
 void SceneGraph::beginScene( Render * render, Camera * camera, float deltaTime )
 {
+	KPROFILE( "SceneGraph::beginScene" );
+
+	// Start counting a new frame
+	const kint64 frameTick = SystemTimer::GetTicks();
+	ResetFrameStatistics( m_statistics );
+	if ( m_frameTick )
+		m_statistics.frameMilliseconds = GetMilliseconds( m_frameTick, frameTick );
+	m_frameTick = frameTick;
+
 	// Update the context
 	m_context.currentCamera = camera;
 	m_context.currentRenderer = render;
@@ -201,12 +297,17 @@ void SceneGraph::beginScene( Render * render, Camera * camera, float deltaTime )
 			camera->OnRender( &m_context );
 	}
 
-	// Update ALL objects within the scene (regardless of whether they're visible).
-	m_rootNode->OnUpdate( &m_context );
+	// Update ALL objects and controllers within the scene (regardless of whether they're visible).
+	// When pipelined, they're updated by updateScene() instead, while the previous frame
+	// is submitted, and the update gets its own copy of the context. The first pipelined frame
+	// still needs its update, and the first frame after the pipeline has already had it.
+	const bool update = m_pipelineChanged ? m_pipelined : !m_pipelined;
+	m_pipelineChanged = false;
 
-	// Iterate through all the controllers and update them
-	for( vector< shared_ptr<Controller> >::iterator	iter = m_controllers.begin(); iter != m_controllers.end(); iter++ )
-		(*iter)->OnUpdate( &m_context );
+	if ( update )
+		UpdateScene( &m_context );
+	if ( m_pipelined )
+		m_updateContext = m_context;
 
 	// Recursively iterate over the nodes in our scene graph, adding them to the
 	// render queue for rendering in endScene()
@@ -215,16 +316,60 @@ void SceneGraph::beginScene( Render * render, Camera * camera, float deltaTime )
 	m_renderQueue.clear();
 	m_shadowCasterQueue.clear();
 
-	// Clear the set of active lights
-	// TODO: Keep track of which lights effect specific nodes
+	// Clear the set of active lights. They're assigned to the objects they affect once the queue is built.
 	m_context.currentLights.clear();
+	m_lightPositions.clear();
+
+	// From now on until endScene(), the render queue references the nodes directly,
+	// so any removals must be deferred
+	m_inFrame = true;
+
+	// The root node must be tested against all the frustum planes
+	m_context.currentPlaneMask = FRUSTUM_PLANE_MASK_ALL;
 
 	// "Flatten" the scene graph by iterating throught all the nodes, call OnPreRender()
 	// to determine whether they want to be render (also updating their world matrices).
 	// If so, adding them to the render queue
-	RecursiveFillQueue( m_rootNode );
+	const kint64 cullTick = SystemTimer::GetTicks();
+
+	// Draw the occluders first, so the objects behind them can be rejected while they're culled
+	if ( m_occlusionCulling && camera )
+	{
+		KPROFILE( "SceneGraph::RenderOccluders" );
+		RenderOccluders();
+	}
+	else
+		m_occluders.clear();
+
+	if ( m_cullingMode == CULL_SPATIAL_INDEX )
+	{
+		KPROFILE( "SceneGraph::FillQueueFromIndex" );
+		FillQueueFromIndex();
+	}
+	else
+	{
+		KPROFILE( "SceneGraph::RecursiveFillQueue" );
+		RecursiveFillQueue( m_rootNode.get() );
+	}
+
+	// Sort the render queue to minimize the render states changes
+	const kint64 sortTick = SystemTimer::GetTicks();
+	{
+		KPROFILE( "SceneGraph::SortQueue" );
+		SortQueue();
+	}
 
-	// TODO: sort the render queue to minimize the render states changes
+	// Capture everything endScene() needs
+	BuildRenderPacket();
+
+	// Give every object its own lights
+	{
+		KPROFILE( "SceneGraph::AssignLights" );
+		AssignLights();
+	}
+
+	m_statistics.cullMilliseconds = GetMilliseconds( cullTick, sortTick );
+	m_statistics.sortMilliseconds = GetMilliseconds( sortTick, SystemTimer::GetTicks() );
 }
 
 //
@@ -232,99 +377,541 @@ void SceneGraph::beginScene( Render * render, Camera * camera, float deltaTime )
 //
 void SceneGraph::endScene()
 {
-	// Iterate over all the objects in the render queue and render them
-	for( vector< weak_ptr<Visible> >::iterator iter = m_renderQueue.begin();
-		 iter != m_renderQueue.end();
-		 iter++ )
+	KPROFILE( "SceneGraph::endScene" );
+
+	const kint64 renderTick = SystemTimer::GetTicks();
+
+	// The shader and material of the previous object. Since the render queue is sorted,
+	// the shader only needs to setup its shared states when it differs from the last object.
+	Shader * pActiveShader = NULL;
+	Material * pActiveMaterial = NULL;
+	bool bActiveShaderValid = false;
+
+	// The world matrix of the current object, copied out of the render packet
+	Matrix4 worldMatrix;
+	m_context.currentWorldMatrix = &worldMatrix;
+
+	// The lights of the previous object
+	const RenderPacket::Item * pLitItem = NULL;
+	m_context.currentLights.clear();
+
+	// Iterate over all the objects in the render packet and render them
+	for( unsigned int i = 0; i < m_packet.items.size(); i++ )
 	{
-		shared_ptr<Shader> spShader;
+		const RenderPacket::Item & item = m_packet.items[i];
+		Shader * pShader = item.shader;
 
-		// Obtain a shared point to the visible object
-		shared_ptr<Visible> spVisible = (*iter).lock();
-		if ( !spVisible ) continue;
+		// Setup the lights of this object, if they differ from the previous object's
+		m_context.currentLightsChanged = !pLitItem || item.lightCount != pLitItem->lightCount ||
+			( item.lightCount && memcmp( &m_packet.lightIndices[ item.lightBegin ], &m_packet.lightIndices[ pLitItem->lightBegin ], item.lightCount * sizeof(unsigned int) ) );
 
-		// Grab the material from the visible object
-		shared_ptr<Material> spMaterial = spVisible->getMaterial();
+		if ( m_context.currentLightsChanged )
+		{
+			m_context.currentLights.resize( item.lightCount );
+			for( unsigned int light = 0; light < item.lightCount; light++ )
+				m_context.currentLights[light] = m_packet.lights[ m_packet.lightIndices[ item.lightBegin + light ] ];
+		}
+		pLitItem = &item;
 
-		// Determine the shader to use for this visible object from its material.
-		// If the material does not have a shader, use the default shader
-		if ( spMaterial && spMaterial->shader )	spShader = spMaterial->shader;
-		else									spShader = m_defaultShader;
+		// When the shader changes, finish the previous batch and begin a new one
+		if ( pShader != pActiveShader )
+		{
+			// Allow the previous shader to do post-processing
+			if ( pActiveShader && bActiveShaderValid )
+				pActiveShader->OnPostRender( &m_context );
+
+			// Allow the shader to perform its pre-processing (which sets up the current lights)
+			pActiveShader = pShader;
+			pActiveMaterial = NULL;
+			m_context.currentMaterialChanged = true;
+			bActiveShaderValid = pActiveShader->OnPreRender( &m_context );
+			m_context.currentLightsChanged = false;
+		}
+
+		// Skip the objects of a shader which failed its pre-processing
+		if ( !bActiveShaderValid ) continue;
 
 		// Setup the current visible object. The shader will need this to determine
 		// the target of its operations
-		m_context.currentVisibleObject = spVisible.get();
-		
-		// Allow the shader to perform its pre-processing
-		if ( spShader->OnPreRender( &m_context ) )
+		m_context.currentVisibleObject = item.visible;
+		m_context.currentMaterial = item.material;
+		memcpy( worldMatrix.s, item.worldMatrix, sizeof(item.worldMatrix) );
+
+		// Let the shader know whether it needs to update the material states
+		if ( item.material.get() != pActiveMaterial )
+			m_context.currentMaterialChanged = true;
+		pActiveMaterial = item.material.get();
+
+		// Allow the shader to setup the per-object states
+		if ( pActiveShader->OnRenderObject( &m_context ) )
 		{
 			// Render the visible object
-			spVisible->OnRender( &m_context );
-
-			// Allow the shader to do post-processing
-			spShader->OnPostRender( &m_context );
+			item.visible->OnRender( &m_context );
 
 			// Post-Render the visible object
-			spVisible->OnPostRender( &m_context );
+			item.visible->OnPostRender( &m_context );
 		}
+
+		m_context.currentMaterialChanged = false;
 	}
 
+	// Allow the last shader to do post-processing
+	if ( pActiveShader && bActiveShaderValid )
+		pActiveShader->OnPostRender( &m_context );
+
+	// The shadows are cast from all the lights of the frame
+	m_context.currentLights = m_packet.lights;
+	m_context.currentLightsChanged = true;
+
 	// Renders the shadow casters
 	renderStencilShadowCasters();
 
+	// The matrix is about to go out of scope, and the material shouldn't be kept alive
+	m_context.currentWorldMatrix = NULL;
+	m_context.currentMaterial.reset();
+
 	// Stop the stats timer
 	m_statsTimer.Stop();
 
-	// Display debug output
-	m_context.debugOutput->OnDebugOutput( &m_context );
-
 	// The number of objects rendered this frame is the number of visible objects
 	// in the render queue
-	m_statistics.objectsRenderedLastFrame = (int)m_renderQueue.size();
+	m_statistics.objectsRenderedLastFrame = (int)m_packet.items.size();
 
 	// Increment the total objects rendered
 	m_statistics.totalObjectsRendered += m_statistics.objectsRenderedLastFrame;
 
+	// Gather the renderer's counters of the submission
+	if ( m_context.currentRenderer )
+	{
+		const RenderStatistics & renderStatistics = m_context.currentRenderer->getFrameStatistics();
+		m_statistics.drawCallsLastFrame = renderStatistics.drawCalls;
+		m_statistics.primitivesLastFrame = renderStatistics.primitives;
+		m_statistics.verticesLastFrame = renderStatistics.vertices;
+		m_statistics.bytesUploadedLastFrame = renderStatistics.bytesUploaded;
+		m_statistics.stateChangesLastFrame = renderStatistics.stateChanges;
+		m_statistics.textureBindsLastFrame = renderStatistics.textureBinds;
+	}
+
+	m_statistics.trianglesRenderedLastFrame = m_statistics.primitivesLastFrame;
+	m_statistics.totalTrianglesRendered += m_statistics.trianglesRenderedLastFrame;
+	m_statistics.renderMilliseconds = GetMilliseconds( renderTick, SystemTimer::GetTicks() );
+
 	// Increment the frame count
 	m_context.frameCount++;
+
+	// When pipelined, the frame is completed once the next frame's update is done
+	if ( !m_pipelined )
+		endFrame();
+}
+
+//
+// startRecording
+//
+bool SceneGraph::startRecording( const char * fileName )
+{
+	shared_ptr<StatisticsRecorder> recorder( new StatisticsRecorder );
+	if ( !recorder->open( fileName ) )
+		return false;
+
+	m_recorder = recorder;
+	return true;
+}
+
+//
+// stopRecording
+//
+void SceneGraph::stopRecording()
+{
+	// The recorder terminates the file when it's destroyed
+	m_recorder.reset();
+}
+
+//
+// isRecording
+//
+bool SceneGraph::isRecording() const
+{
+	return m_recorder && m_recorder->isRecording();
+}
+
+//
+// updateScene
+//
+void SceneGraph::updateScene( float deltaTime )
+{
+	m_updateContext.deltaTime = deltaTime;
+	UpdateScene( &m_updateContext );
+}
+
+//
+// setPipelined
+//
+void SceneGraph::setPipelined( bool pipelined )
+{
+	if ( pipelined != m_pipelined )
+	{
+		// Switching back and forth before the next frame cancels out
+		m_pipelineChanged = !m_pipelineChanged;
+		m_pipelined = pipelined;
+	}
+}
+
+//
+// endFrame
+//
+void SceneGraph::endFrame()
+{
+	// Record the completed frame
+	if ( m_recorder )
+		m_recorder->record( m_statistics );
+
+	// Display debug output
+	m_context.debugOutput->OnDebugOutput( &m_context );
+
+	// The frame is complete, so the nodes can now be safely added and removed
+	m_inFrame = false;
+	FlushPendingRemovals();
+}
+
+//
+// UpdateScene
+//
+void SceneGraph::UpdateScene( SceneContext * context )
+{
+	KPROFILE( "SceneGraph::UpdateScene" );
+
+	const kint64 updateTick = SystemTimer::GetTicks();
+	vector< shared_ptr<Controller> >::iterator iter;
+
+	JobSystem * pJobs = context->jobSystem;
+	if ( !m_parallelUpdate || !pJobs || pJobs->getThreadCount() < 2 )
+	{
+		m_rootNode->OnUpdate( context );
+
+		// Iterate through all the controllers and update them
+		for( iter = m_controllers.begin(); iter != m_controllers.end(); iter++ )
+			(*iter)->OnUpdate( context );
+
+		m_statistics.updateMilliseconds = GetMilliseconds( updateTick, SystemTimer::GetTicks() );
+		return;
+	}
+
+	// The jobs reach the context through the scene
+	m_updatingContext = context;
+
+	// Split the scene into independent subtrees, and update them on the worker threads
+	m_updateList.clear();
+	GatherUpdateList( m_rootNode.get() );
+
+	if ( !m_updateList.empty() )
+		pJobs->wait( pJobs->parallelFor( UpdateNodes, this, 0, (unsigned int)m_updateList.size() ) );
+
+	// The thread-safe controllers run next, since they may modify the nodes
+	m_parallelControllers.clear();
+	for( iter = m_controllers.begin(); iter != m_controllers.end(); iter++ )
+		if ( (*iter)->isThreadSafe() )
+			m_parallelControllers.push_back( iter->get() );
+
+	if ( !m_parallelControllers.empty() )
+		pJobs->wait( pJobs->parallelFor( UpdateControllers, this, 0, (unsigned int)m_parallelControllers.size() ) );
+
+	// And finally, the other controllers on this thread
+	for( iter = m_controllers.begin(); iter != m_controllers.end(); iter++ )
+		if ( !(*iter)->isThreadSafe() )
+			(*iter)->OnUpdate( context );
+
+	m_statistics.updateMilliseconds = GetMilliseconds( updateTick, SystemTimer::GetTicks() );
+}
+
+//
+// GatherUpdateList
+//
+void SceneGraph::GatherUpdateList( VisNode * pNode )
+{
+	vector< shared_ptr<Visible> > & children = pNode->getChildren();
+
+	for( unsigned int i = 0; i < children.size(); i++ )
+	{
+		Visible * pChild = children[i].get();
+
+		// A plain VisNode only forwards the update to its children, so they can be split further.
+		// Derived nodes may override OnUpdate(), so their subtree is kept together.
+		if ( KIsExactlyFromClass<VisNode>( pChild ) )
+			GatherUpdateList( static_cast<VisNode *>( pChild ) );
+		else
+			m_updateList.push_back( pChild );
+	}
+}
+
+//
+// UpdateNodes
+//
+void SceneGraph::UpdateNodes( void * data, unsigned int begin, unsigned int end )
+{
+	KPROFILE( "SceneGraph::UpdateNodes" );
+
+	SceneGraph * pScene = reinterpret_cast<SceneGraph *>( data );
+
+	for( unsigned int i = begin; i < end; i++ )
+		pScene->m_updateList[i]->OnUpdate( pScene->m_updatingContext );
+}
+
+//
+// UpdateControllers
+//
+void SceneGraph::UpdateControllers( void * data, unsigned int begin, unsigned int end )
+{
+	KPROFILE( "SceneGraph::UpdateControllers" );
+
+	SceneGraph * pScene = reinterpret_cast<SceneGraph *>( data );
+
+	for( unsigned int i = begin; i < end; i++ )
+		pScene->m_parallelControllers[i]->OnUpdate( pScene->m_updatingContext );
 }
 
 //
 // RecursiveFillQueue
 //
-void SceneGraph::RecursiveFillQueue( weak_ptr<VisNode> wpNode )
+void SceneGraph::RecursiveFillQueue( VisNode * pNode )
 {
-	if ( shared_ptr<VisNode> node = wpNode.lock() )
+	// Call OnPreRender() on this visible node
+	if ( pNode->OnPreRender( &m_context ) )
 	{
-		// Call OnPreRender() on this visible node
-		if ( node->OnPreRender( &m_context ) )
-		{
-			// Add this node to the render queue
-			AddNodeToQueue( node );
+		// Add this node to the render queue
+		AddNodeToQueue( pNode );
+
+		// The children only need to be tested against the planes which intersect our
+		// bounds. If we're fully inside the frustum, the children aren't tested at all.
+		const unsigned int parentPlaneMask = m_context.currentPlaneMask;
+
+		// Cull the leaf children together, the results are stacked above the masks of our ancestors
+		const unsigned int baseMask = (unsigned int)m_childPlaneMasks.size();
+		BatchCullChildren( pNode );
 
-			// Now, iterate through its children, add them to the render queue
-			// and add their iterate through its children's children (if they're
-			// visible nodes).
+		// Now, iterate through its children, add them to the render queue
+		// and add their iterate through its children's children (if they're
+		// visible nodes).
 
-			vector< shared_ptr<Visible> >::iterator iter;
-			vector< shared_ptr<Visible> > & children = node->getChildren();
+		vector< shared_ptr<Visible> > & children = pNode->getChildren();
 
-			for( iter = children.begin(); iter != children.end(); iter++ )
+		for( unsigned int i = 0; i < children.size(); i++ )
+		{
+			Visible * pChild = children[i].get();
+
+			// Can we even render the object?
+			m_context.currentPlaneMask = m_childPlaneMasks[ baseMask + i ];
+			if ( pChild->OnPreRender( &m_context ) && TestOcclusion( pChild ) )
 			{
-				// Can we even render the object?
-				if ( (*iter)->OnPreRender( &m_context ) )
-				{
-					shared_ptr<VisNode> visnode = boost::dynamic_pointer_cast<VisNode>( (*iter) );
-
-					if ( visnode )
-						// Next, if this is also a VisNode, recurse into its children
-						RecursiveFillQueue( visnode );
-					else
-						// Otherwise, just add it to the queue for rendering
-						AddNodeToQueue( (*iter) );
-				}
+				if ( pChild->isNode() )
+					// Next, if this is also a VisNode, recurse into its children
+					RecursiveFillQueue( static_cast<VisNode *>( pChild ) );
+				else
+					// Otherwise, just add it to the queue for rendering
+					AddNodeToQueue( pChild );
+			}
+			else
+			{
+				m_statistics.objectsCulledLastFrame++;
 			}
 		}
+
+		// Restore the plane mask for our siblings
+		m_context.currentPlaneMask = parentPlaneMask;
+		m_childPlaneMasks.resize( baseMask );
+	}
+}
+
+//
+// BatchCullChildren
+//
+void SceneGraph::BatchCullChildren( VisNode * pNode )
+{
+	vector< shared_ptr<Visible> > & children = pNode->getChildren();
+	const unsigned int nodePlaneMask = pNode->getCullPlaneMask();
+	const unsigned int baseMask = (unsigned int)m_childPlaneMasks.size();
+
+	// By default, the children are culled individually against the planes our bounds intersect
+	m_childPlaneMasks.resize( baseMask + children.size(), nodePlaneMask );
+
+	// Nothing to cull if we're fully inside the frustum
+	if ( !nodePlaneMask || !m_context.debugOutput->getEnableFrustumCulling() )
+		return;
+
+	m_cullCenterX.clear();
+	m_cullCenterY.clear();
+	m_cullCenterZ.clear();
+	m_cullRadius.clear();
+
+	// Gather the world bounds of the leaves. Child nodes are skipped, because their bounds
+	// are only rebuilt from their own children within OnPreRender().
+	unsigned int i;
+	for( i = 0; i < children.size(); i++ )
+	{
+		Visible * pChild = children[i].get();
+		if ( pChild->isNode() || !pChild->isVisible() )
+			continue;
+
+		pChild->updateWorldTransform();
+
+		const Bound & bound = pChild->getWorldBound();
+		m_cullCenterX.push_back( bound.getCenter().x );
+		m_cullCenterY.push_back( bound.getCenter().y );
+		m_cullCenterZ.push_back( bound.getCenter().z );
+
+		// If the object's radius is 0, assume it is always visible
+		m_cullRadius.push_back( bound.getRadius() ? bound.getRadius() : FLT_MAX );
+	}
+
+	const unsigned int count = (unsigned int)m_cullRadius.size();
+	if ( !count ) return;
+
+	m_cullVisible.resize( ( count + 31 ) / 32 );
+	m_cullIntersect.resize( count );
+
+	kmath::cullSpheres( &m_cullCenterX[0], &m_cullCenterY[0], &m_cullCenterZ[0], &m_cullRadius[0], count,
+						m_context.currentCamera->getWorldPlanes(), nodePlaneMask,
+						&m_cullVisible[0], &m_cullIntersect[0] );
+
+	// Scatter the results back to the leaves
+	unsigned int leaf = 0;
+	for( i = 0; i < children.size(); i++ )
+	{
+		Visible * pChild = children[i].get();
+		if ( pChild->isNode() || !pChild->isVisible() )
+			continue;
+
+		if ( m_cullVisible[ leaf >> 5 ] & ( 1u << ( leaf & 31 ) ) )
+			m_childPlaneMasks[ baseMask + i ] = m_cullIntersect[leaf] | FRUSTUM_PLANE_MASK_TESTED;
+		else
+			m_childPlaneMasks[ baseMask + i ] = FRUSTUM_PLANE_MASK_CULLED;
+
+		leaf++;
+	}
+}
+
+//
+// FillQueueFromIndex
+//
+void SceneGraph::FillQueueFromIndex()
+{
+	VisNode * pRoot = m_rootNode.get();
+
+	// The render states of the root apply to the whole scene, which must then be traversed
+	if ( !KIsExactlyFromClass<VisNode>( pRoot ) || pRoot->hasStates() )
+	{
+		RecursiveFillQueue( pRoot );
+		return;
+	}
+
+	// Bring the entries of the objects which moved up to date. The objects are registered
+	// when they're attached, and unregistered when they're detached.
+	m_spatialIndex->updateMoved();
+
+	// Find the objects within the frustum (all of them, if the culling is disabled)
+	const unsigned int planeMask = m_context.debugOutput->getEnableFrustumCulling() ? FRUSTUM_PLANE_MASK_ALL : 0;
+
+	m_indexResults.clear();
+	m_indexPlaneMasks.clear();
+	m_spatialIndex->queryFrustum( m_context.currentCamera->getWorldPlanes(), planeMask, m_indexResults, &m_indexPlaneMasks );
+
+	m_statistics.objectsCulledLastFrame += m_spatialIndex->getObjectCount() - (unsigned int)m_indexResults.size();
+
+	for( unsigned int i = 0; i < m_indexResults.size(); i++ )
+	{
+		Visible * pObject = m_indexResults[i];
+
+		if ( pObject->isNode() )
+		{
+			// The node culls its own bounds, then its children
+			m_context.currentPlaneMask = m_indexPlaneMasks[i];
+			RecursiveFillQueue( static_cast<VisNode *>( pObject ) );
+
+			// Its bounds are too coarse to be hidden, but it may still be an occluder
+			if ( m_occlusionCulling && pObject->getOccluder() )
+				GatherOccluder( pObject );
+		}
+		else
+		{
+			// The index has already culled the object's bounds against the planes
+			m_context.currentPlaneMask = m_indexPlaneMasks[i] | FRUSTUM_PLANE_MASK_TESTED;
+			if ( pObject->OnPreRender( &m_context ) && TestOcclusion( pObject ) )
+				AddNodeToQueue( pObject );
+			else
+				m_statistics.objectsCulledLastFrame++;
+		}
+	}
+
+	m_context.currentPlaneMask = FRUSTUM_PLANE_MASK_ALL;
+}
+
+//
+// RenderOccluders
+// Rasterizes the occluders gathered in the previous frame into the occlusion buffer
+//
+void SceneGraph::RenderOccluders()
+{
+	m_occlusionBuffer->begin( *m_context.currentCamera );
+
+	for( unsigned int i = 0; i < m_occluders.size(); i++ )
+	{
+		Visible * pOccluder = m_occluders[i].get();
+		shared_ptr<Geometry> spGeometry = pOccluder->getOccluderGeometry();
+		if ( !spGeometry || !pOccluder->isVisible() )
+			continue;
+
+		// The occluder may have moved since it was gathered
+		pOccluder->updateWorldTransform();
+		m_occlusionBuffer->addOccluder( *spGeometry, pOccluder->getWorldTransform() );
+	}
+
+	// This frame's visible occluders are gathered again during the culling
+	m_occluders.clear();
+
+	m_occlusionBuffer->render( m_context.jobSystem );
+}
+
+//
+// TestOcclusion
+// Returns false if the object is hidden by the occluders
+//
+bool SceneGraph::TestOcclusion( Visible * pVisible )
+{
+	if ( !m_occlusionCulling )
+		return true;
+
+	if ( pVisible->getOccluder() )
+	{
+		GatherOccluder( pVisible );
+		return true;
+	}
+
+	// A hidden shadow caster may still cast a visible shadow
+	if ( pVisible->getCastsShadows() || m_occlusionBuffer->isVisible( pVisible->getWorldBound() ) )
+		return true;
+
+	m_statistics.objectsOccludedLastFrame++;
+	return false;
+}
+
+//
+// GatherOccluder
+// Keeps a visible occluder for the next frame
+//
+void SceneGraph::GatherOccluder( Visible * pOccluder )
+{
+	// Find the reference the parent holds, which keeps the occluder alive until the next frame
+	shared_ptr<VisNode> spParent = pOccluder->getParent();
+	if ( !spParent )
+		return;
+
+	vector< shared_ptr<Visible> > & siblings = spParent->getChildren();
+	for( unsigned int i = 0; i < siblings.size(); i++ )
+	{
+		if ( siblings[i].get() == pOccluder )
+		{
+			m_occluders.push_back( siblings[i] );
+			return;
+		}
 	}
 }
 
@@ -332,20 +919,145 @@ void SceneGraph::RecursiveFillQueue( weak_ptr<VisNode> wpNode )
 // AddNodeToQueue
 // Adds a node to the render queue
 //
-void SceneGraph::AddNodeToQueue( weak_ptr<Visible> wpNode )
+void SceneGraph::AddNodeToQueue( Visible * pNode )
+{
+	// Push this node onto the queue
+	m_renderQueue.push_back( pNode );
+
+	// If this node is a shadow caster, then add it to the shadow caster queue
+	if ( pNode->getCastsShadows() )
+		m_shadowCasterQueue.push_back( pNode );
+
+	// If this node has a light, push it onto the list of lights to render
+	if ( pNode->getLight() ) 
+	{
+		const MatrixRow & position = pNode->getWorldTransform().pos;
+		m_context.currentLights.push_back( pNode->getLight() );
+		m_lightPositions.push_back( Point3( position.x, position.y, position.z ) );
+	}
+}
+
+//
+// FlushPendingRemovals
+// Performs the node removals which were requested during the frame
+//
+void SceneGraph::FlushPendingRemovals()
+{
+	if ( m_pendingRemoveAll )
+	{
+		m_pendingRemoveAll = false;
+		m_pendingRemovals.clear();
+		removeAllNodes();
+		return;
+	}
+
+	// Swap out the lists first, in case OnAttach() or OnDetach() change additional nodes
+	vector< shared_ptr<Visible> > pendingRemovals;
+	pendingRemovals.swap( m_pendingRemovals );
+
+	vector< shared_ptr<Visible> > pendingAdditions;
+	pendingAdditions.swap( m_pendingAdditions );
+
+	vector< shared_ptr<Visible> >::iterator iter;
+	for( iter = pendingRemovals.begin(); iter != pendingRemovals.end(); iter++ )
+		removeNode( *iter );
+
+	for( iter = pendingAdditions.begin(); iter != pendingAdditions.end(); iter++ )
+		addNode( *iter );
+}
+
+//
+// SortQueue
+// Generates the sort keys of the render queue and sorts them by render state
+//
+void SceneGraph::SortQueue()
+{
+	m_sortedQueue.clear();
+
+	// The depth is normalized to the far plane of the camera
+	const float fMaxDepth = m_context.currentCamera ? m_context.currentCamera->getFarPlane() : 0.f;
+
+	for( unsigned int i = 0; i < m_renderQueue.size(); i++ )
+	{
+		Visible * pVisible = m_renderQueue[i];
+
+		// Grab the render states of the object
+		shared_ptr<Material> spMaterial = pVisible->getMaterial();
+		Shader * pShader = ( spMaterial && spMaterial->shader ) ? spMaterial->shader.get() : m_defaultShader.get();
+		int iMaterialID = spMaterial ? spMaterial->matID : 0;
+		int iTextureID = ( spMaterial && spMaterial->diffuseMap0 ) ? spMaterial->diffuseMap0->getBindID() : Texture::INVALID_BIND_ID;
+		bool bTranslucent = spMaterial && spMaterial->fOpacity < 1.f;
+
+		// Transform the center of the world bound into view space to get its depth
+		Point3 viewCenter = pVisible->getWorldBound().getCenter();
+		if ( m_context.currentCamera ) viewCenter *= m_context.currentCamera->getWorldMatrix();
+		float fDepth = viewCenter.getLength();
+
+		m_sortedQueue.push( RenderQueue::makeKey( pShader->getSortID(), iMaterialID, iTextureID, fDepth, fMaxDepth, bTranslucent ), i );
+	}
+
+	m_sortedQueue.sort();
+}
+
+//
+// BuildRenderPacket
+// Copies the sorted render queue, the shadow casters and the lights into the render packet
+//
+void SceneGraph::BuildRenderPacket()
 {
-	if ( wpNode.lock() )
+	m_packet.clear();
+	m_packet.items.resize( m_sortedQueue.size() );
+	m_packet.shadowCasters.resize( m_shadowCasterQueue.size() );
+
+	unsigned int i;
+	for( i = 0; i < m_sortedQueue.size(); i++ )
 	{
-		// Push this node onto the queue
-		m_renderQueue.push_back( wpNode );
+		RenderPacket::Item & item = m_packet.items[i];
+		Visible * pVisible = m_renderQueue[ m_sortedQueue[i].index ];
 
-		// If this node is a shadow caster, then add it to the shadow caster queue
-		if ( wpNode.lock()->getCastsShadows() )
-			m_shadowCasterQueue.push_back( wpNode );
+		// Determine the shader to use for this visible object from its material.
+		// If the material does not have a shader, use the default shader
+		item.visible = pVisible;
+		item.material = pVisible->getMaterial();
+		item.shader = ( item.material && item.material->shader ) ? item.material->shader.get() : m_defaultShader.get();
+		memcpy( item.worldMatrix, pVisible->getWorldMatrix().s, sizeof(item.worldMatrix) );
+	}
+
+	for( i = 0; i < m_shadowCasterQueue.size(); i++ )
+	{
+		RenderPacket::Item & item = m_packet.shadowCasters[i];
+		Visible * pVisible = m_shadowCasterQueue[i];
 
-		// If this node has a light, push it onto the list of lights to render
-		if ( wpNode.lock()->getLight() ) 
-			m_context.currentLights.push_back( wpNode.lock()->getLight() );
+		item.visible = pVisible;
+		item.shader = NULL;
+		item.lightBegin = 0;
+		item.lightCount = 0;
+		memcpy( item.worldMatrix, pVisible->getWorldMatrix().s, sizeof(item.worldMatrix) );
+	}
+
+	m_packet.lights = m_context.currentLights;
+}
+
+//
+// AssignLights
+// Assigns the most significant lights to every object of the render packet
+//
+void SceneGraph::AssignLights()
+{
+	// Bin the lights of the frame by their range
+	m_lightGrid->clear();
+	for( unsigned int light = 0; light < m_packet.lights.size(); light++ )
+		m_lightGrid->addLight( light, m_packet.lights[light].get(), m_lightPositions[light] );
+	m_lightGrid->build();
+
+	// The lists are stored per object, endScene() only sets them up when they differ from the previous object's
+	for( unsigned int i = 0; i < m_packet.items.size(); i++ )
+	{
+		RenderPacket::Item & item = m_packet.items[i];
+
+		item.lightBegin = (unsigned int)m_packet.lightIndices.size();
+		m_lightGrid->assign( item.visible->getWorldBound(), m_packet.lightIndices );
+		item.lightCount = (unsigned int)m_packet.lightIndices.size() - item.lightBegin;
 	}
 }
 
@@ -359,7 +1071,9 @@ void SceneGraph::renderStencilShadowCasters()
 	if ( m_context.currentLights.size() == 0 ) return;
 
 	// Do we have any shadow casters, if not, exit
-	if ( m_shadowCasterQueue.size() == 0 ) return;
+	if ( m_packet.shadowCasters.size() == 0 ) return;
+
+	Matrix4 worldMatrix;
 
 	// Reset the render pass
 	m_context.renderPass = 0;
@@ -370,19 +1084,16 @@ void SceneGraph::renderStencilShadowCasters()
 	while ( !m_stencilShadowShader->OnPreRender( &m_context ) )
 	{
 		// Iterate over the shadow casters and tell them to render their shadow volumes
-		for( vector< weak_ptr<Visible> >::iterator iter = m_shadowCasterQueue.begin();
-			iter != m_shadowCasterQueue.end();
+		for( vector< RenderPacket::Item >::iterator iter = m_packet.shadowCasters.begin();
+			iter != m_packet.shadowCasters.end();
 			iter++ )
 		{
-			// Obtain a shared point to the visible object
-			shared_ptr<Visible> spVisible = (*iter).lock();
-			if ( !spVisible ) continue;
-
 			// Transform the shadow volume into world space
-			m_context.currentRenderer->SetMatrix( MODELVIEW, STORE, spVisible->getWorldMatrix() );
+			memcpy( worldMatrix.s, iter->worldMatrix, sizeof(iter->worldMatrix) );
+			m_context.currentRenderer->SetMatrix( MODELVIEW, STORE, worldMatrix );
 
 			// Render the shadow volume
-			spVisible->OnRenderShadow( &m_context );
+			iter->visible->OnRenderShadow( &m_context );
 		}
 	}
 
@@ -391,4 +1102,43 @@ void SceneGraph::renderStencilShadowCasters()
 
 	// Allow the stencil shadow shader to restore the render states
 	m_stencilShadowShader->OnPostRender( &m_context );
-}
\ No newline at end of file
+}
+
+// ----------------------------------------------------
+// Local Functions
+// ----------------------------------------------------
+
+//
+// ResetFrameStatistics
+// Clears the statistics which are only kept for the last frame
+//
+void ResetFrameStatistics( SceneStatistics & statistics )
+{
+	statistics.objectsRenderedLastFrame = 0;
+	statistics.trianglesRenderedLastFrame = 0;
+	statistics.objectsCulledLastFrame = 0;
+	statistics.objectsOccludedLastFrame = 0;
+	statistics.drawCallsLastFrame = 0;
+	statistics.primitivesLastFrame = 0;
+	statistics.verticesLastFrame = 0;
+	statistics.bytesUploadedLastFrame = 0;
+	statistics.stateChangesLastFrame = 0;
+	statistics.textureBindsLastFrame = 0;
+	statistics.terrainTrianglesLastFrame = 0;
+	statistics.terrainPatchesLastFrame = 0;
+	statistics.shadowVolumesRebuiltLastFrame = 0;
+	statistics.frameMilliseconds = 0.f;
+	statistics.updateMilliseconds = 0.f;
+	statistics.cullMilliseconds = 0.f;
+	statistics.sortMilliseconds = 0.f;
+	statistics.renderMilliseconds = 0.f;
+}
+
+//
+// GetMilliseconds
+// Converts the ticks elapsed between two SystemTimer::GetTicks() into milliseconds
+//
+float GetMilliseconds( kint64 beginTick, kint64 endTick )
+{
+	return (float)( endTick - beginTick ) * 1000.f / (float)SystemTimer::GetTicksPerSecond();
+}
@@ -28,6 +28,11 @@ class DebugOutput;
 class TextDisplay;
 class Visible;
 class Shader;
+class JobSystem;
+class StatisticsRecorder;
+class SpatialIndex;
+class LightGrid;
+class OcclusionBuffer;
 
 ///
 /// SceneGraph
@@ -39,6 +44,17 @@ class SceneGraph
 {
 	KDECLARE_SCRIPT;
 
+public:
+	///
+	/// CullingMode
+	/// How the visible objects are found every frame
+	///
+	enum CullingMode
+	{
+		CULL_HIERARCHY,			/// The scene graph is traversed, culling the bounds of the nodes (default)
+		CULL_SPATIAL_INDEX,		/// The spatial index is queried with the camera's frustum
+	};
+
 public:
 	/// Constructor
 	SceneGraph( shared_ptr<VisNode> root);
@@ -46,13 +62,16 @@ public:
 	/// Destructor
 	virtual ~SceneGraph();
 
-	/// Adds a node for rendering to the scene graph
+	/// Adds a node for rendering to the scene graph. In pipelined mode, if this is called
+	/// between beginScene() and endFrame(), the addition is deferred until the end of the frame.
 	void addNode( shared_ptr<Visible> node );
 
-	/// Removes a node from the scene graph
+	/// Removes a node from the scene graph. If this is called between beginScene()
+	/// and endFrame(), the removal is deferred until the end of the frame.
 	void removeNode( shared_ptr<Visible> node );
 
-	/// Clears all nodes from the scene graph
+	/// Clears all nodes from the scene graph. If this is called between beginScene()
+	/// and endFrame(), the removal is deferred until the end of the frame.
 	void removeAllNodes();
 
 	/// Adds a controller to the scene graph.
@@ -88,27 +107,138 @@ public:
 	/// Sets the context with its essential parameters
 	void setContext( Render * render, Camera * camera, DebugOutput * debug, TextDisplay * textDisplay );
 
+	/// Sets the job system used by the parallel update (and available to the nodes through the context)
+	void setJobSystem( JobSystem * jobSystem )					{ m_context.jobSystem = jobSystem; }
+
+	/// Enables updating the nodes and the thread-safe controllers on the job system's
+	/// worker threads. See Visible::OnUpdate() for what the nodes may touch.
+	void setParallelUpdate( bool parallel )						{ m_parallelUpdate = parallel; }
+
+	/// Returns whether the parallel update is enabled
+	bool getParallelUpdate() const								{ return m_parallelUpdate; }
+
+	/// Enables pipelined frames. beginScene() then doesn't update the scene, and endScene()
+	/// doesn't complete the frame. Instead, the game engine calls updateScene() for the next
+	/// frame on a worker thread while endScene() submits this one, then calls endFrame().
+	/// The frame after the pipeline is switched on still updates the scene in beginScene(), since
+	/// no previous frame updated it. After it's switched off, that frame's update is skipped instead.
+	void setPipelined( bool pipelined );
+
+	/// Returns whether the frames are pipelined
+	bool getPipelined() const									{ return m_pipelined; }
+
+	/// Sets how the visible objects are culled. With CULL_SPATIAL_INDEX, the objects are
+	/// registered in the spatial index with their world bounds, and the index is queried
+	/// instead of traversing the scene graph. Plain VisNodes without render states are only
+	/// containers then, any other node is rendered (and culled) with its whole subtree.
+	/// The objects keep their entries up to date as they move, are attached and detached.
+	void setCullingMode( CullingMode mode );
+
+	/// Returns how the visible objects are culled
+	CullingMode getCullingMode() const							{ return m_cullingMode; }
+
+	/// Retrieves the spatial index, which can be queried for the objects within a frustum,
+	/// a sphere or along a ray. It's only kept up to date with CULL_SPATIAL_INDEX; the objects
+	/// which moved since the last beginScene() may still have their previous bounds.
+	SpatialIndex * getSpatialIndex()							{ return m_spatialIndex.get(); }
+
+	/// Enables the occlusion culling. The occluders found visible in the previous frame (see
+	/// Visible::setOccluder()) are rasterized into the occlusion buffer before the scene is
+	/// culled, and the objects entirely hidden behind them aren't rendered. A hidden node is
+	/// skipped with its whole subtree. Shadow casters are never hidden, their shadows may not be.
+	void setOcclusionCulling( bool enable )						{ m_occlusionCulling = enable; }
+
+	/// Returns whether the occlusion culling is enabled
+	bool getOcclusionCulling() const							{ return m_occlusionCulling; }
+
+	/// Retrieves the occlusion buffer, whose resolution can be changed
+	OcclusionBuffer * getOcclusionBuffer()						{ return m_occlusionBuffer.get(); }
+
+	/// Retrieves the light grid, which assigns the lights of the frame to the objects they
+	/// affect. Its maximum lights per object and cell size can be changed.
+	LightGrid * getLightGrid()									{ return m_lightGrid.get(); }
+
 	/// Retrieves the context
 	SceneContext & getContext()									{ return m_context; }
 
-	/// Retrieve the statistics
+	/// Retrieve the statistics. The per-frame values are complete once endFrame() returns.
 	const SceneStatistics & getStatistics() const				{ return m_statistics; }
 
+	/// Starts recording the statistics of every frame to a CSV or JSON file (see StatisticsRecorder)
+	bool startRecording( const char * fileName );
+
+	/// Stops recording the statistics
+	void stopRecording();
+
+	/// Returns whether the statistics are being recorded
+	bool isRecording() const;
+
 	/// Preprocess the scene by iterating through the scene graph nodes, update them,
 	/// sorts them to minimize state changes, and pushes them in the render queue.
 	void beginScene( Render * render, Camera * camera, float deltaTime );
 
-	/// Flushes the render queue by calling render on all objects.
+	/// Flushes the render queue by calling render on all objects. Only the render packet
+	/// built by beginScene() is used, so the scene may be updated meanwhile (see setPipelined()).
 	void endScene();
 
+	/// Updates all the nodes and controllers. In pipelined mode, this is called for the next
+	/// frame while endScene() runs, and uses a copy of the context taken by beginScene().
+	void updateScene( float deltaTime );
+
+	/// Completes the frame by drawing the debug output and performing the deferred node
+	/// additions and removals. endScene() calls this itself, unless the frames are pipelined.
+	void endFrame();
+
 private:
 
+	/// Calls OnUpdate() on all the nodes and controllers, in parallel if it's enabled
+	void UpdateScene( SceneContext * context );
+
+	/// Collects the subtrees which can be updated independently. Plain VisNodes are
+	/// descended into, while any other object is updated as a whole.
+	void GatherUpdateList( VisNode * pNode );
+
+	/// Job function which updates a range of the update list
+	static void UpdateNodes( void * data, unsigned int begin, unsigned int end );
+
+	/// Job function which updates a range of the thread-safe controllers
+	static void UpdateControllers( void * data, unsigned int begin, unsigned int end );
+
 	/// Recursively adds the children of the root node into the render queue
 	/// if their OnPreRender() returns true.
-	void RecursiveFillQueue( weak_ptr<VisNode> wpNode );
+	void RecursiveFillQueue( VisNode * pNode );
+
+	/// Culls the bounds of all the leaf children of a node in one batch. One plane mask per
+	/// child is appended to m_childPlaneMasks, which the children receive through the context.
+	void BatchCullChildren( VisNode * pNode );
+
+	/// Queries the spatial index with the camera's frustum, and adds the visible objects to the render queue
+	void FillQueueFromIndex();
+
+	/// Rasterizes the occluders gathered in the previous frame into the occlusion buffer
+	void RenderOccluders();
+
+	/// Returns false if the object is hidden by the occluders. The occluders themselves are
+	/// never hidden, but gathered for the next frame.
+	bool TestOcclusion( Visible * pVisible );
+
+	/// Keeps a visible occluder, so it's rasterized in the next frame
+	void GatherOccluder( Visible * pOccluder );
 
 	/// Adds a node to the render queue
-	void AddNodeToQueue( weak_ptr<Visible> wpNode );
+	void AddNodeToQueue( Visible * pNode );
+
+	/// Performs the node additions and removals which were requested during the frame
+	void FlushPendingRemovals();
+
+	/// Generates the sort keys of the render queue and sorts them by render state
+	void SortQueue();
+
+	/// Copies the sorted render queue, the shadow casters and the lights into the render packet
+	void BuildRenderPacket();
+
+	/// Assigns the most significant lights to every object of the render packet
+	void AssignLights();
 
 	/// Renders the shadow casters using stencil shadow volumes
 	void renderStencilShadowCasters();
@@ -122,12 +252,99 @@ private:
 	/// This is the statistics object. It stores information like fps, tps, etc.
 	SceneStatistics						m_statistics;
 
+	/// Writes the statistics of every frame to a file, while recording
+	shared_ptr<StatisticsRecorder>		m_recorder;
+
+	/// Tick of the last beginScene(), which measures the frame time
+	kint64								m_frameTick;
+
 	/// The render queue, which is the flattened array of nodes to render.
-	/// This queue is filled during BeginScene()
-	vector< weak_ptr<Visible> >			m_renderQueue;
+	/// This queue is filled during BeginScene() and is only valid until EndScene().
+	/// The pointers are kept alive by the scene graph for the duration of the frame,
+	/// because node removals are deferred until the frame completes.
+	vector< Visible * >					m_renderQueue;
+
+	/// The sorted order of the render queue. Objects are grouped by shader, material
+	/// and texture, with translucent objects drawn last from back to front.
+	RenderQueue							m_sortedQueue;
+
+	/// Plane masks of the children being traversed, stacked for every level of RecursiveFillQueue()
+	vector< unsigned int >				m_childPlaneMasks;
+
+	/// The frame submitted by endScene(), built at the end of beginScene()
+	RenderPacket						m_packet;
+
+	/// Scratch memory for the batched culling, the world bounds of the leaf children
+	/// are gathered into separate arrays so they can be tested several at a time.
+	vector< float >						m_cullCenterX;
+	vector< float >						m_cullCenterY;
+	vector< float >						m_cullCenterZ;
+	vector< float >						m_cullRadius;
+	vector< unsigned int >				m_cullVisible;
+	vector< unsigned int >				m_cullIntersect;
+
+	/// How the visible objects are culled
+	CullingMode							m_cullingMode;
+
+	/// Loose octree of the objects' world bounds, maintained with CULL_SPATIAL_INDEX
+	shared_ptr<SpatialIndex>			m_spatialIndex;
+
+	/// Scratch memory for the spatial index query, the objects found and their plane masks
+	vector< Visible * >					m_indexResults;
+	vector< unsigned int >				m_indexPlaneMasks;
+
+	/// Is the occlusion culling enabled
+	bool								m_occlusionCulling;
+
+	/// Depth buffer of the occluders, rendered on the CPU
+	shared_ptr<OcclusionBuffer>			m_occlusionBuffer;
+
+	/// Occluders found visible during the frame, rasterized at the beginning of the next one.
+	/// They're held so they can't be destroyed meanwhile.
+	vector< shared_ptr<Visible> >		m_occluders;
 
 	// Collection of shadow casters accumated during the beginScene
-	vector< weak_ptr<Visible> >			m_shadowCasterQueue;
+	vector< Visible * >					m_shadowCasterQueue;
+
+	/// World positions of the lights gathered during beginScene(), in the order of the context's lights
+	vector< Point3 >					m_lightPositions;
+
+	/// Assigns the lights to the objects they affect
+	shared_ptr<LightGrid>				m_lightGrid;
+
+	/// Nodes which were removed between beginScene() and endFrame()
+	vector< shared_ptr<Visible> >		m_pendingRemovals;
+
+	/// Nodes which were added between beginScene() and endFrame() in pipelined mode
+	vector< shared_ptr<Visible> >		m_pendingAdditions;
+
+	/// Was removeAllNodes() called between beginScene() and endFrame()
+	bool								m_pendingRemoveAll;
+
+	/// Are we between beginScene() and endFrame()
+	bool								m_inFrame;
+
+	/// Are the frames pipelined
+	bool								m_pipelined;
+
+	/// Was the pipeline switched on or off since the last beginScene()
+	bool								m_pipelineChanged;
+
+	/// Copy of the context used by updateScene() in pipelined mode, because endScene()
+	/// modifies the scene context while the update runs
+	SceneContext						m_updateContext;
+
+	/// Context of the update in progress, used by the parallel update jobs
+	SceneContext *						m_updatingContext;
+
+	/// Are the nodes and thread-safe controllers updated on the worker threads
+	bool								m_parallelUpdate;
+
+	/// Independent subtrees updated by the parallel update, gathered every frame
+	vector< Visible * >					m_updateList;
+
+	/// Thread-safe controllers updated by the parallel update, gathered every frame
+	vector< Controller * >				m_parallelControllers;
 
 	/// This is the root node of the scene graph. Renders starts at
 	/// this node and works itself recursively down the scene graph.
@@ -13,6 +13,7 @@
 #include "visible.h"
 #include "controller.h"
 #include "scenecontext.h"
+#include "renderqueue.h"
 #include "scenegraph.h"
 #include "scriptcontroller.h"
 #include "base/kstring.h"
@@ -0,0 +1,716 @@
+/*
+	Katana Engine
+	Copyright  2001-2004 Eric Bryant, Inc.
+
+	File:		spatialindex.cpp
+	Author:		Eric Bryant
+
+	Loose octree of the visible objects' world bounds. Objects are stored
+	in the deepest cell whose loose bounds (twice the cell's size) contain
+	their bounding sphere, so an object only moves between cells when its
+	center leaves its cell. The index answers frustum, sphere and ray
+	queries without walking the scene hierarchy.
+*/
+
+#include <float.h>
+#include <math.h>
+#include <algorithm>
+#include "katana_core_includes.h"
+#include "katana_base_includes.h"
+#include "system/systemthread.h"
+#include "visible.h"
+#include "visnode.h"
+#include "spatialindex.h"
+
+//
+// Macros
+//
+#define LOOSENESS	2.0f
+
+//
+// Local Functions
+//
+static bool SortHits( const pair<float, Visible *> & a, const pair<float, Visible *> & b );
+static bool IntersectRayBox( const Point3 & origin, const Point3 & direction, float length, const Point3 & center, float halfSize );
+static float IntersectRaySphere( const Point3 & origin, const Point3 & direction, const Point3 & center, float radius );
+
+//
+// Constructor
+//
+SpatialIndex::SpatialIndex( const Point3 & center, float halfSize, unsigned int maximumDepth ) :
+	m_objectCount( 0 ),
+	m_movedLock( 0 )
+{
+	setBounds( center, halfSize, maximumDepth );
+}
+
+//
+// Destructor
+//
+SpatialIndex::~SpatialIndex()
+{
+	clear();
+}
+
+//
+// setBounds
+//
+void SpatialIndex::setBounds( const Point3 & center, float halfSize, unsigned int maximumDepth )
+{
+	m_center = center;
+	m_halfSize = halfSize;
+	m_maximumDepth = maximumDepth;
+
+	// Create the root cell
+	Cell root;
+	root.center = center;
+	root.halfSize = halfSize;
+	root.parent = -1;
+	root.depth = 0;
+	root.count = 0;
+	for( int child = 0; child < 8; child++ )
+		root.children[child] = -1;
+
+	m_cells.clear();
+	m_cells.push_back( root );
+	m_outside.clear();
+
+	// Link the registered objects to the new cells
+	for( unsigned int i = 0; i < m_entries.size(); i++ )
+		if ( m_entries[i].object && m_entries[i].cell != CONTAINER )
+			Link( i, FindCell( m_entries[i].center, m_entries[i].radius ) );
+}
+
+//
+// update
+//
+void SpatialIndex::update( Visible * object, const Bound & bound )
+{
+	const Point3 & center = bound.getCenter();
+	const float radius = bound.getRadius();
+
+	// Is the object already registered?
+	if ( object->m_spatialIndex == this && m_entries[object->m_spatialEntry].cell != CONTAINER )
+	{
+		const unsigned int index = object->m_spatialEntry;
+		Entry & entry = m_entries[index];
+
+		if ( entry.center.x == center.x && entry.center.y == center.y && entry.center.z == center.z && entry.radius == radius )
+			return;
+
+		entry.center = center;
+		entry.radius = radius;
+
+		// The entry stays in its cell as long as its center is within the cell, and it is
+		// neither too large for it nor small enough for a child cell
+		if ( entry.cell != OUTSIDE )
+		{
+			const Cell & cell = m_cells[entry.cell];
+			if ( fabsf( center.x - cell.center.x ) <= cell.halfSize &&
+				 fabsf( center.y - cell.center.y ) <= cell.halfSize &&
+				 fabsf( center.z - cell.center.z ) <= cell.halfSize &&
+				 radius <= cell.halfSize &&
+				 ( radius > cell.halfSize * 0.5f || cell.depth == m_maximumDepth ) )
+				return;
+		}
+
+		const int cell = FindCell( center, radius );
+		if ( cell != entry.cell )
+		{
+			Unlink( index );
+			Link( index, cell );
+		}
+		return;
+	}
+
+	// Otherwise, the object was registered in another index (or tracked as a node)
+	if ( object->m_spatialIndex )
+		object->m_spatialIndex->remove( object );
+
+	const unsigned int index = CreateEntry( object );
+	m_entries[index].center = center;
+	m_entries[index].radius = radius;
+	m_objectCount++;
+
+	Link( index, FindCell( center, radius ) );
+}
+
+//
+// update
+//
+void SpatialIndex::update( Visible * object )
+{
+	if ( object->m_spatialIndex != this || m_entries[object->m_spatialEntry].cell == CONTAINER )
+		return;
+
+	const Bound & bound = object->getWorldBound();
+	if ( object->isNode() || !bound.getRadius() )
+		update( object, Bound( bound.getCenter(), FLT_MAX ) );
+	else
+		update( object, bound );
+}
+
+//
+// insert
+//
+void SpatialIndex::insert( Visible * object )
+{
+	// The object may be moved from another place of the scene
+	removeTree( object );
+
+	// The parents are inserted first, so the world transforms are calculated from the top down
+	object->updateWorldTransform();
+
+	if ( !KIsExactlyFromClass<VisNode>( object ) || static_cast<VisNode *>( object )->hasStates() )
+	{
+		const Bound & bound = object->getWorldBound();
+		update( object, object->isNode() || !bound.getRadius() ? Bound( bound.getCenter(), FLT_MAX ) : bound );
+		return;
+	}
+
+	// A plain VisNode is tracked, so it reports its moves and its attached children
+	CreateEntry( object );
+	m_entries[object->m_spatialEntry].cell = CONTAINER;
+
+	// A hidden node hides its whole subtree, so its children aren't inserted
+	if ( !object->isVisible() )
+		return;
+
+	vector< shared_ptr<Visible> > & children = static_cast<VisNode *>( object )->getChildren();
+	for( unsigned int i = 0; i < children.size(); i++ )
+		insert( children[i].get() );
+}
+
+//
+// insertChild
+//
+void SpatialIndex::insertChild( VisNode * parent, Visible * child )
+{
+	// Only the children of the visible tracked nodes are inserted
+	if ( parent->m_spatialIndex == this && m_entries[parent->m_spatialEntry].cell == CONTAINER && parent->isVisible() )
+		insert( child );
+}
+
+//
+// remove
+//
+void SpatialIndex::remove( Visible * object )
+{
+	if ( !object || object->m_spatialIndex != this )
+		return;
+
+	const unsigned int index = object->m_spatialEntry;
+	if ( m_entries[index].cell != CONTAINER )
+	{
+		Unlink( index );
+		m_objectCount--;
+	}
+
+	m_entries[index].object = 0;
+	m_freeEntries.push_back( index );
+
+	object->m_spatialIndex = 0;
+	object->m_spatialEntry = NO_ENTRY;
+
+	// The object may not be updated anymore
+	if ( object->m_spatialMoved )
+	{
+		while( SystemThread::atomicExchange( &m_movedLock, 1 ) != 0 )
+			SystemThread::yield();
+
+		m_moved.erase( std::remove( m_moved.begin(), m_moved.end(), object ), m_moved.end() );
+		object->m_spatialMoved = 0;
+
+		SystemThread::atomicExchange( &m_movedLock, 0 );
+	}
+}
+
+//
+// removeTree
+//
+void SpatialIndex::removeTree( Visible * object )
+{
+	remove( object );
+
+	// The descendants of a node registered as a whole aren't in the index, so removing them is harmless
+	if ( object->isNode() )
+	{
+		vector< shared_ptr<Visible> > & children = static_cast<VisNode *>( object )->getChildren();
+		for( unsigned int i = 0; i < children.size(); i++ )
+			removeTree( children[i].get() );
+	}
+}
+
+//
+// markMoved
+//
+void SpatialIndex::markMoved( Visible * object )
+{
+	// Only the first move of the frame queues the object
+	if ( SystemThread::atomicExchange( &object->m_spatialMoved, 1 ) != 0 )
+		return;
+
+	while( SystemThread::atomicExchange( &m_movedLock, 1 ) != 0 )
+		SystemThread::yield();
+
+	m_moved.push_back( object );
+
+	SystemThread::atomicExchange( &m_movedLock, 0 );
+}
+
+//
+// updateMoved
+//
+void SpatialIndex::updateMoved()
+{
+	// Take the queue, the objects may be queued again while they're updated
+	vector<Visible *> moved;
+
+	while( SystemThread::atomicExchange( &m_movedLock, 1 ) != 0 )
+		SystemThread::yield();
+
+	moved.swap( m_moved );
+
+	SystemThread::atomicExchange( &m_movedLock, 0 );
+
+	for( unsigned int i = 0; i < moved.size(); i++ )
+	{
+		SystemThread::atomicExchange( &moved[i]->m_spatialMoved, 0 );
+		UpdateTree( moved[i] );
+	}
+}
+
+//
+// clear
+//
+void SpatialIndex::clear()
+{
+	for( unsigned int i = 0; i < m_entries.size(); i++ )
+	{
+		if ( m_entries[i].object )
+		{
+			m_entries[i].object->m_spatialIndex = 0;
+			m_entries[i].object->m_spatialEntry = NO_ENTRY;
+			m_entries[i].object->m_spatialMoved = 0;
+		}
+	}
+
+	m_entries.clear();
+	m_freeEntries.clear();
+	m_outside.clear();
+	m_moved.clear();
+	m_objectCount = 0;
+
+	// Only keep an empty root cell
+	if ( m_cells.size() )
+	{
+		m_cells.resize( 1 );
+		m_cells[0].entries.clear();
+		m_cells[0].count = 0;
+		for( int child = 0; child < 8; child++ )
+			m_cells[0].children[child] = -1;
+	}
+}
+
+//
+// queryFrustum
+//
+void SpatialIndex::queryFrustum( const Plane * planes, unsigned int planeMask, vector<Visible *> & results, vector<unsigned int> * planeMasks ) const
+{
+	planeMask &= FRUSTUM_PLANE_MASK_ALL;
+
+	QueryFrustumEntries( m_outside, planes, planeMask, results, planeMasks );
+	QueryFrustum( 0, planes, planeMask, results, planeMasks );
+}
+
+//
+// querySphere
+//
+void SpatialIndex::querySphere( const Bound & sphere, vector<Visible *> & results ) const
+{
+	QuerySphereEntries( m_outside, sphere, results );
+	QuerySphere( 0, sphere, results );
+}
+
+//
+// queryRay
+//
+void SpatialIndex::queryRay( const Point3 & origin, const Point3 & direction, float length, vector<Visible *> & results ) const
+{
+	vector< pair<float, Visible *> > hits;
+
+	QueryRayEntries( m_outside, origin, direction, length, hits );
+	QueryRay( 0, origin, direction, length, hits );
+
+	std::sort( hits.begin(), hits.end(), SortHits );
+
+	for( unsigned int i = 0; i < hits.size(); i++ )
+		results.push_back( hits[i].second );
+}
+
+//
+// FindCell
+//
+int SpatialIndex::FindCell( const Point3 & center, float radius )
+{
+	// The object must be centered within the root cell, and fit its loose bounds
+	if ( fabsf( center.x - m_center.x ) > m_halfSize ||
+		 fabsf( center.y - m_center.y ) > m_halfSize ||
+		 fabsf( center.z - m_center.z ) > m_halfSize ||
+		 radius > m_halfSize )
+		return OUTSIDE;
+
+	// Descend towards the child containing the center, while the object fits the child's loose bounds
+	int current = 0;
+	while( m_cells[current].depth < m_maximumDepth && radius <= m_cells[current].halfSize * 0.5f )
+	{
+		const Point3 cellCenter = m_cells[current].center;
+		const int child = ( center.x >= cellCenter.x ? 1 : 0 ) |
+						  ( center.y >= cellCenter.y ? 2 : 0 ) |
+						  ( center.z >= cellCenter.z ? 4 : 0 );
+
+		if ( m_cells[current].children[child] == -1 )
+		{
+			const float halfSize = m_cells[current].halfSize * 0.5f;
+
+			Cell cell;
+			cell.center = Point3( cellCenter.x + ( child & 1 ? halfSize : -halfSize ),
+								  cellCenter.y + ( child & 2 ? halfSize : -halfSize ),
+								  cellCenter.z + ( child & 4 ? halfSize : -halfSize ) );
+			cell.halfSize = halfSize;
+			cell.parent = current;
+			cell.depth = m_cells[current].depth + 1;
+			cell.count = 0;
+			for( int grandChild = 0; grandChild < 8; grandChild++ )
+				cell.children[grandChild] = -1;
+
+			// Push the new cell before linking it, since the push may move the cells
+			m_cells.push_back( cell );
+			m_cells[current].children[child] = (int)m_cells.size() - 1;
+		}
+
+		current = m_cells[current].children[child];
+	}
+
+	return current;
+}
+
+//
+// CreateEntry
+//
+unsigned int SpatialIndex::CreateEntry( Visible * object )
+{
+	unsigned int index;
+	if ( m_freeEntries.size() )
+	{
+		index = m_freeEntries.back();
+		m_freeEntries.pop_back();
+	}
+	else
+	{
+		index = (unsigned int)m_entries.size();
+		m_entries.push_back( Entry() );
+	}
+
+	Entry & entry = m_entries[index];
+	entry.object = object;
+	entry.center = Point3( 0, 0, 0 );
+	entry.radius = 0.f;
+	entry.cell = OUTSIDE;
+	entry.slot = 0;
+
+	object->m_spatialIndex = this;
+	object->m_spatialEntry = index;
+	return index;
+}
+
+//
+// UpdateTree
+//
+void SpatialIndex::UpdateTree( Visible * object )
+{
+	// The entry of a registered object follows its world bounds (see Visible::updateWorldBound())
+	object->updateWorldTransform();
+
+	// The children of a tracked node move along with it
+	if ( m_entries[object->m_spatialEntry].cell == CONTAINER && object->isVisible() )
+	{
+		vector< shared_ptr<Visible> > & children = static_cast<VisNode *>( object )->getChildren();
+		for( unsigned int i = 0; i < children.size(); i++ )
+			if ( children[i]->m_spatialIndex == this )
+				UpdateTree( children[i].get() );
+	}
+}
+
+//
+// Link
+//
+void SpatialIndex::Link( unsigned int index, int cell )
+{
+	Entry & entry = m_entries[index];
+	entry.cell = cell;
+
+	vector<unsigned int> & entries = cell == OUTSIDE ? m_outside : m_cells[cell].entries;
+	entry.slot = (unsigned int)entries.size();
+	entries.push_back( index );
+
+	// Count the object in the cell and its ancestors, so empty branches are skipped
+	for( int current = cell; current != -1; current = m_cells[current].parent )
+		m_cells[current].count++;
+}
+
+//
+// Unlink
+//
+void SpatialIndex::Unlink( unsigned int index )
+{
+	Entry & entry = m_entries[index];
+
+	vector<unsigned int> & entries = entry.cell == OUTSIDE ? m_outside : m_cells[entry.cell].entries;
+
+	// Move the last entry of the cell into the free slot
+	const unsigned int last = entries.back();
+	entries[entry.slot] = last;
+	m_entries[last].slot = entry.slot;
+	entries.pop_back();
+
+	for( int current = entry.cell; current != -1; current = m_cells[current].parent )
+		m_cells[current].count--;
+
+	entry.cell = OUTSIDE;
+}
+
+//
+// QueryFrustum
+//
+void SpatialIndex::QueryFrustum( int index, const Plane * planes, unsigned int planeMask, vector<Visible *> & results, vector<unsigned int> * planeMasks ) const
+{
+	const Cell & cell = m_cells[index];
+	if ( !cell.count )
+		return;
+
+	// Test the loose box against the planes which intersect the parent. The planes the box
+	// is fully inside are not tested again for the children.
+	if ( planeMask )
+	{
+		const float extent = cell.halfSize * LOOSENESS;
+
+		for( unsigned int plane = 0; plane < MAX_FRUSTUM_PLANES; plane++ )
+		{
+			if ( !( planeMask & ( 1u << plane ) ) )
+				continue;
+
+			const Point3 & normal = planes[plane].getNormal();
+			const float radius = extent * ( fabsf( normal.x ) + fabsf( normal.y ) + fabsf( normal.z ) );
+			const float distance = planes[plane].distance( cell.center );
+
+			if ( distance < -radius )
+				return;
+			if ( distance >= radius )
+				planeMask &= ~( 1u << plane );
+		}
+	}
+
+	QueryFrustumEntries( cell.entries, planes, planeMask, results, planeMasks );
+
+	for( int child = 0; child < 8; child++ )
+		if ( cell.children[child] != -1 )
+			QueryFrustum( cell.children[child], planes, planeMask, results, planeMasks );
+}
+
+//
+// QueryFrustumEntries
+//
+void SpatialIndex::QueryFrustumEntries( const vector<unsigned int> & entries, const Plane * planes, unsigned int planeMask, vector<Visible *> & results, vector<unsigned int> * planeMasks ) const
+{
+	for( unsigned int i = 0; i < entries.size(); i++ )
+	{
+		const Entry & entry = m_entries[ entries[i] ];
+		unsigned int entryMask = planeMask;
+		bool culled = false;
+
+		for( unsigned int plane = 0; plane < MAX_FRUSTUM_PLANES && entryMask; plane++ )
+		{
+			if ( !( entryMask & ( 1u << plane ) ) )
+				continue;
+
+			const float distance = planes[plane].distance( entry.center );
+
+			if ( distance < -entry.radius )
+			{
+				culled = true;
+				break;
+			}
+			if ( distance >= entry.radius )
+				entryMask &= ~( 1u << plane );
+		}
+
+		if ( culled )
+			continue;
+
+		results.push_back( entry.object );
+		if ( planeMasks )
+			planeMasks->push_back( entryMask );
+	}
+}
+
+//
+// QuerySphere
+//
+void SpatialIndex::QuerySphere( int index, const Bound & sphere, vector<Visible *> & results ) const
+{
+	const Cell & cell = m_cells[index];
+	if ( !cell.count )
+		return;
+
+	// Distance from the sphere's center to the loose box
+	const float extent = cell.halfSize * LOOSENESS;
+	const Point3 & center = sphere.getCenter();
+	float distance = 0;
+
+	for( int axis = 0; axis < 3; axis++ )
+	{
+		const float offset = fabsf( center[axis] - cell.center[axis] ) - extent;
+		if ( offset > 0 )
+			distance += offset * offset;
+	}
+
+	if ( distance > sphere.getRadius() * sphere.getRadius() )
+		return;
+
+	QuerySphereEntries( cell.entries, sphere, results );
+
+	for( int child = 0; child < 8; child++ )
+		if ( cell.children[child] != -1 )
+			QuerySphere( cell.children[child], sphere, results );
+}
+
+//
+// QuerySphereEntries
+//
+void SpatialIndex::QuerySphereEntries( const vector<unsigned int> & entries, const Bound & sphere, vector<Visible *> & results ) const
+{
+	for( unsigned int i = 0; i < entries.size(); i++ )
+	{
+		const Entry & entry = m_entries[ entries[i] ];
+
+		// Objects with infinite bounds always intersect
+		const float radius = entry.radius + sphere.getRadius();
+		if ( entry.radius >= FLT_MAX || ( entry.center - sphere.getCenter() ).getSqrLength() <= radius * radius )
+			results.push_back( entry.object );
+	}
+}
+
+//
+// QueryRay
+//
+void SpatialIndex::QueryRay( int index, const Point3 & origin, const Point3 & direction, float length, vector< pair<float, Visible *> > & hits ) const
+{
+	const Cell & cell = m_cells[index];
+	if ( !cell.count )
+		return;
+
+	if ( !IntersectRayBox( origin, direction, length, cell.center, cell.halfSize * LOOSENESS ) )
+		return;
+
+	QueryRayEntries( cell.entries, origin, direction, length, hits );
+
+	for( int child = 0; child < 8; child++ )
+		if ( cell.children[child] != -1 )
+			QueryRay( cell.children[child], origin, direction, length, hits );
+}
+
+//
+// QueryRayEntries
+//
+void SpatialIndex::QueryRayEntries( const vector<unsigned int> & entries, const Point3 & origin, const Point3 & direction, float length, vector< pair<float, Visible *> > & hits ) const
+{
+	for( unsigned int i = 0; i < entries.size(); i++ )
+	{
+		const Entry & entry = m_entries[ entries[i] ];
+
+		const float distance = entry.radius >= FLT_MAX ? 0 : IntersectRaySphere( origin, direction, entry.center, entry.radius );
+		if ( distance >= 0 && distance <= length )
+			hits.push_back( pair<float, Visible *>( distance, entry.object ) );
+	}
+}
+
+// ----------------------------------------------------
+// Local Functions
+// ----------------------------------------------------
+
+//
+// SortHits
+// Orders the ray hits by distance
+//
+bool SortHits( const pair<float, Visible *> & a, const pair<float, Visible *> & b )
+{
+	return a.first < b.first;
+}
+
+//
+// IntersectRayBox
+// Returns whether the ray segment intersects the cube (slab test)
+//
+bool IntersectRayBox( const Point3 & origin, const Point3 & direction, float length, const Point3 & center, float halfSize )
+{
+	float enter = 0;
+	float leave = length;
+
+	for( int axis = 0; axis < 3; axis++ )
+	{
+		const float minimum = center[axis] - halfSize;
+		const float maximum = center[axis] + halfSize;
+
+		// Parallel to the slab, the origin must be within it
+		if ( fabsf( direction[axis] ) < 1e-6f )
+		{
+			if ( origin[axis] < minimum || origin[axis] > maximum )
+				return false;
+			continue;
+		}
+
+		const float inverse = 1.0f / direction[axis];
+		float nearest = ( minimum - origin[axis] ) * inverse;
+		float farthest = ( maximum - origin[axis] ) * inverse;
+		if ( nearest > farthest )
+		{
+			const float swap = nearest;
+			nearest = farthest;
+			farthest = swap;
+		}
+
+		if ( nearest > enter ) enter = nearest;
+		if ( farthest < leave ) leave = farthest;
+		if ( enter > leave )
+			return false;
+	}
+
+	return true;
+}
+
+//
+// IntersectRaySphere
+// Returns the distance at which the ray enters the sphere (zero if the origin is inside),
+// or a negative number if the ray misses it
+//
+float IntersectRaySphere( const Point3 & origin, const Point3 & direction, const Point3 & center, float radius )
+{
+	const Point3 offset = origin - center;
+	const float b = offset.getDot( direction );
+	const float c = offset.getSqrLength() - radius * radius;
+
+	// The origin is inside the sphere
+	if ( c <= 0 )
+		return 0;
+
+	// The origin is outside, and the ray points away from the sphere
+	if ( b > 0 )
+		return -1;
+
+	const float discriminant = b * b - c;
+	if ( discriminant < 0 )
+		return -1;
+
+	return -b - sqrtf( discriminant );
+}
@@ -0,0 +1,204 @@
+/*
+	Katana Engine
+	Copyright  2001-2004 Eric Bryant, Inc.
+
+	File:		spatialindex.h
+	Author:		Eric Bryant
+
+	Loose octree of the visible objects' world bounds. Objects are stored
+	in the deepest cell whose loose bounds (twice the cell's size) contain
+	their bounding sphere, so an object only moves between cells when its
+	center leaves its cell. The index answers frustum, sphere and ray
+	queries without walking the scene hierarchy.
+*/
+
+#ifndef _SPATIALINDEX_H
+#define _SPATIALINDEX_H
+
+namespace Katana
+{
+
+//
+// Forward Declarations
+//
+class Visible;
+class VisNode;
+class Plane;
+
+///
+/// SpatialIndex
+/// The objects are registered with their world bounds, and updated whenever their bounds change.
+/// Objects whose center lies outside the root cell, or which are larger than it, are kept
+/// in a separate list and tested individually by every query.
+///
+/// Trees of objects are inserted with insert(). The objects keep the index up to date: they
+/// report their moves (see markMoved()), update their entry when their world bounds change,
+/// register the children attached to them, and unregister the children detached from them.
+///
+class SpatialIndex
+{
+public:
+	enum
+	{
+		DEFAULT_MAXIMUM_DEPTH = 10,		/// Default number of subdivisions of the root cell
+		NO_ENTRY = 0xFFFFFFFF,			/// Entry of the objects which aren't registered
+	};
+
+public:
+	/// Constructor takes the center and half size of the root cell
+	SpatialIndex( const Point3 & center = Point3( 0, 0, 0 ), float halfSize = 16384.f, unsigned int maximumDepth = DEFAULT_MAXIMUM_DEPTH );
+
+	/// Destructor (unregisters the objects)
+	~SpatialIndex();
+
+	/// Changes the root cell. The registered objects are inserted again.
+	void setBounds( const Point3 & center, float halfSize, unsigned int maximumDepth = DEFAULT_MAXIMUM_DEPTH );
+
+	/// Registers an object, or updates its bounds if it's already registered. The object
+	/// only moves to another cell if its bounds no longer fit its cell.
+	void update( Visible * object, const Bound & bound );
+
+	/// Updates the entry of an object from its world bounds. Nodes, and objects without a radius,
+	/// are registered with infinite bounds, so every query returns them.
+	void update( Visible * object );
+
+	/// Inserts an object and its descendants. Plain VisNodes without render states only group
+	/// their children, they're tracked without being registered and their children are inserted
+	/// instead (unless the node is hidden). Any other node is registered as a whole.
+	void insert( Visible * object );
+
+	/// Inserts a child attached to a node of the index, if the node's children are inserted
+	void insertChild( VisNode * parent, Visible * child );
+
+	/// Unregisters an object
+	void remove( Visible * object );
+
+	/// Unregisters an object and its descendants
+	void removeTree( Visible * object );
+
+	/// Called by the objects of the index when they (or their local bounds) have moved. The
+	/// object's world bounds are updated by the next call to updateMoved(). This may be called
+	/// from the worker threads during the parallel update.
+	void markMoved( Visible * object );
+
+	/// Updates the world transforms of the objects which have moved (and of their descendants),
+	/// along with their entries
+	void updateMoved();
+
+	/// Unregisters every object
+	void clear();
+
+	/// Returns the number of registered objects
+	unsigned int getObjectCount() const								{ return m_objectCount; }
+
+	/// Returns the number of cells allocated
+	unsigned int getCellCount() const								{ return (unsigned int)m_cells.size(); }
+
+public:
+	/// Finds the objects whose bounds intersect the frustum, given its planes (indexed by
+	/// FrustumPlanes, with the normals pointing inside). Only the planes of the mask are tested.
+	/// If planeMasks is given, it receives for every object the planes its bounds intersect
+	/// (zero if the object is fully inside the frustum).
+	void queryFrustum( const Plane * planes, unsigned int planeMask, vector<Visible *> & results, vector<unsigned int> * planeMasks = 0 ) const;
+
+	/// Finds the objects whose bounds intersect the sphere
+	void querySphere( const Bound & sphere, vector<Visible *> & results ) const;
+
+	/// Finds the objects whose bounds are hit by the ray, within the given length. The direction
+	/// must be normalized. The objects are sorted by the distance at which the ray enters their bounds.
+	void queryRay( const Point3 & origin, const Point3 & direction, float length, vector<Visible *> & results ) const;
+
+private:
+	///
+	/// Cell
+	/// A cell of the octree. Its loose bounds extend twice its half size from its center.
+	///
+	struct Cell
+	{
+		Point3			center;
+		float			halfSize;
+		int				parent;
+		unsigned int	depth;
+		int				children[8];	/// Index of the child cells (-1 if not allocated)
+		unsigned int	count;			/// Number of objects in this cell and its descendants
+		vector<unsigned int>	entries;
+	};
+
+	///
+	/// Entry
+	/// A registered object. The object keeps the index of its entry.
+	///
+	struct Entry
+	{
+		Visible *		object;
+		Point3			center;
+		float			radius;
+		int				cell;			/// Cell holding the entry (OUTSIDE if it doesn't fit the root cell, CONTAINER for a tracked node)
+		unsigned int	slot;			/// Position of the entry in its cell's list
+	};
+
+	enum { OUTSIDE = -1, CONTAINER = -2 };
+
+private:
+	/// Returns the deepest cell whose loose bounds contain the sphere, allocating the cells on the way
+	int FindCell( const Point3 & center, float radius );
+
+	/// Creates an entry for the object, which isn't linked to any cell
+	unsigned int CreateEntry( Visible * object );
+
+	/// Updates the world transform of an object which has moved, and those of the descendants of a container
+	void UpdateTree( Visible * object );
+
+	/// Adds the entry to the cell's list
+	void Link( unsigned int entry, int cell );
+
+	/// Removes the entry from its cell's list
+	void Unlink( unsigned int entry );
+
+	/// Frustum query of a cell and its descendants
+	void QueryFrustum( int cell, const Plane * planes, unsigned int planeMask, vector<Visible *> & results, vector<unsigned int> * planeMasks ) const;
+
+	/// Frustum query of a list of entries
+	void QueryFrustumEntries( const vector<unsigned int> & entries, const Plane * planes, unsigned int planeMask, vector<Visible *> & results, vector<unsigned int> * planeMasks ) const;
+
+	/// Sphere query of a cell and its descendants
+	void QuerySphere( int cell, const Bound & sphere, vector<Visible *> & results ) const;
+
+	/// Sphere query of a list of entries
+	void QuerySphereEntries( const vector<unsigned int> & entries, const Bound & sphere, vector<Visible *> & results ) const;
+
+	/// Ray query of a cell and its descendants. The hits are collected with their distance.
+	void QueryRay( int cell, const Point3 & origin, const Point3 & direction, float length, vector< pair<float, Visible *> > & hits ) const;
+
+	/// Ray query of a list of entries
+	void QueryRayEntries( const vector<unsigned int> & entries, const Point3 & origin, const Point3 & direction, float length, vector< pair<float, Visible *> > & hits ) const;
+
+private:
+	/// Center and half size of the root cell
+	Point3					m_center;
+	float					m_halfSize;
+
+	/// Maximum depth of the cells below the root cell
+	unsigned int			m_maximumDepth;
+
+	/// The cells, the root cell is the first one
+	vector<Cell>			m_cells;
+
+	/// The entries, and the unused entries
+	vector<Entry>			m_entries;
+	vector<unsigned int>	m_freeEntries;
+
+	/// Entries which don't fit in the root cell
+	vector<unsigned int>	m_outside;
+
+	/// Objects which have moved since the last updateMoved(), and the spin lock guarding them
+	vector<Visible *>		m_moved;
+	volatile long			m_movedLock;
+
+	/// Number of registered objects
+	unsigned int			m_objectCount;
+};
+
+}; // Katana
+
+#endif // _SPATIALINDEX_H
@@ -0,0 +1,193 @@
+/*
+	Katana Engine
+	Copyright  2001-2004 Eric Bryant, Inc.
+
+	File:		statisticsrecorder.cpp
+	Author:		Eric Bryant
+
+	Records the scene statistics of every frame to a CSV or JSON file,
+	so runs of the same flythrough can be compared across builds.
+*/
+
+#include <string.h>
+#include "katana_core_includes.h"
+#include "katana_base_includes.h"
+#include "system/systemfile.h"
+#include "scenecontext.h"
+#include "statisticsrecorder.h"
+
+//
+// Macros
+//
+#define COLUMN_COUNT	( sizeof( g_columns ) / sizeof( g_columns[0] ) )
+
+//
+// Local Types
+//
+struct StatisticsColumn
+{
+	const char *	name;
+	bool			milliseconds;		/// Whether the column holds a time (otherwise, a count)
+};
+
+//
+// Local Variables
+//
+static const StatisticsColumn g_columns[] =
+{
+	{ "frame",					false },
+	{ "frameMilliseconds",		true },
+	{ "updateMilliseconds",		true },
+	{ "cullMilliseconds",		true },
+	{ "sortMilliseconds",		true },
+	{ "renderMilliseconds",		true },
+	{ "objectsRendered",		false },
+	{ "objectsCulled",			false },
+	{ "objectsOccluded",		false },
+	{ "drawCalls",				false },
+	{ "primitives",				false },
+	{ "vertices",				false },
+	{ "bytesUploaded",			false },
+	{ "stateChanges",			false },
+	{ "textureBinds",			false },
+	{ "terrainTriangles",		false },
+	{ "terrainPatches",			false },
+	{ "shadowVolumesRebuilt",	false },
+};
+
+//
+// Constructor
+//
+StatisticsRecorder::StatisticsRecorder() :
+	m_format( CSV_FORMAT ),
+	m_frames( 0 )
+{
+}
+
+//
+// Destructor
+//
+StatisticsRecorder::~StatisticsRecorder()
+{
+	close();
+}
+
+//
+// open
+//
+bool StatisticsRecorder::open( const char * fileName )
+{
+	close();
+
+	shared_ptr<SystemFile> file( new SystemFile( fileName, READ_WRITE, BINARY_FILE ) );
+	if ( !file->isValid() )
+	{
+		KLOG( "StatisticsRecorder failed to create %s", fileName );
+		return false;
+	}
+
+	m_file = file;
+	m_frames = 0;
+
+	const unsigned int length = (unsigned int)strlen( fileName );
+	m_format = ( length >= 5 && !strcmp( fileName + length - 5, ".json" ) ) ? JSON_FORMAT : CSV_FORMAT;
+
+	// Start the array of frames, or write the header row
+	if ( m_format == JSON_FORMAT )
+		return Write( "[\n" );
+
+	string header;
+	for( unsigned int i = 0; i < COLUMN_COUNT; i++ )
+	{
+		if ( i ) header += ",";
+		header += g_columns[i].name;
+	}
+	header += "\n";
+
+	return Write( header );
+}
+
+//
+// close
+//
+void StatisticsRecorder::close()
+{
+	if ( !m_file )
+		return;
+
+	// Terminate the array of frames
+	if ( m_format == JSON_FORMAT )
+		Write( m_frames ? "\n]\n" : "]\n" );
+
+	// The file is closed when it's destroyed
+	m_file.reset();
+}
+
+//
+// record
+//
+bool StatisticsRecorder::record( const SceneStatistics & statistics )
+{
+	if ( !m_file )
+		return false;
+
+	// Same order as the columns
+	const double values[] =
+	{
+		m_frames,
+		statistics.frameMilliseconds,
+		statistics.updateMilliseconds,
+		statistics.cullMilliseconds,
+		statistics.sortMilliseconds,
+		statistics.renderMilliseconds,
+		statistics.objectsRenderedLastFrame,
+		statistics.objectsCulledLastFrame,
+		statistics.objectsOccludedLastFrame,
+		statistics.drawCallsLastFrame,
+		statistics.primitivesLastFrame,
+		statistics.verticesLastFrame,
+		statistics.bytesUploadedLastFrame,
+		statistics.stateChangesLastFrame,
+		statistics.textureBindsLastFrame,
+		statistics.terrainTrianglesLastFrame,
+		statistics.terrainPatchesLastFrame,
+		statistics.shadowVolumesRebuiltLastFrame,
+	};
+
+	string row;
+	if ( m_format == JSON_FORMAT )
+		row = m_frames ? ",\n{" : "{";
+
+	for( unsigned int i = 0; i < COLUMN_COUNT; i++ )
+	{
+		kstring value;
+		value.format( g_columns[i].milliseconds ? "%.3f" : "%.0f", values[i] );
+
+		if ( m_format == JSON_FORMAT )
+		{
+			if ( i ) row += ",";
+			row += "\"";
+			row += g_columns[i].name;
+			row += "\":";
+		}
+		else if ( i )
+		{
+			row += ",";
+		}
+
+		row += value;
+	}
+
+	row += m_format == JSON_FORMAT ? "}" : "\n";
+
+	m_frames++;
+	return Write( row );
+}
+
+//
+// Write
+//
+bool StatisticsRecorder::Write( const string & text )
+{
+	return m_file->writeBytes( (void *)text.c_str(), (int)text.size() );
+}
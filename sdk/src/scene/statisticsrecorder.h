@@ -0,0 +1,78 @@
+/*
+	Katana Engine
+	Copyright  2001-2004 Eric Bryant, Inc.
+
+	File:		statisticsrecorder.h
+	Author:		Eric Bryant
+
+	Records the scene statistics of every frame to a CSV or JSON file,
+	so runs of the same flythrough can be compared across builds.
+*/
+
+#ifndef _STATISTICSRECORDER_H
+#define _STATISTICSRECORDER_H
+
+namespace Katana
+{
+
+//
+// Forward Declarations
+//
+class SystemFile;
+struct SceneStatistics;
+
+///
+/// StatisticsRecorder
+/// Writes one row per frame. CSV files start with a header row, while JSON files
+/// hold an array with one object per frame.
+///
+class StatisticsRecorder
+{
+public:
+	/// Format of the recorded file
+	enum Format
+	{
+		CSV_FORMAT,
+		JSON_FORMAT,
+	};
+
+public:
+	/// Constructor
+	StatisticsRecorder();
+
+	/// Destructor (closes the file)
+	~StatisticsRecorder();
+
+	/// Creates the file. The format is JSON if the file name ends with ".json", and CSV otherwise.
+	bool open( const char * fileName );
+
+	/// Terminates and closes the file
+	void close();
+
+	/// Returns whether a file is opened
+	bool isRecording() const									{ return m_file.get() != 0; }
+
+	/// Returns the number of frames recorded in the file
+	unsigned int getFrameCount() const							{ return m_frames; }
+
+	/// Writes the statistics of a frame
+	bool record( const SceneStatistics & statistics );
+
+private:
+	/// Writes a string to the file
+	bool Write( const string & text );
+
+private:
+	/// The recorded file
+	shared_ptr<SystemFile>	m_file;
+
+	/// Format of the file
+	Format					m_format;
+
+	/// Number of frames recorded
+	unsigned int			m_frames;
+};
+
+}; // Katana
+
+#endif // _STATISTICSRECORDER_H
@@ -8,50 +8,43 @@
 	Terrain Node.
 */
 
+#include "katana_config.h"
 #include <list>
-#include <map>
 #include <algorithm>
-#include "../base/kbase.h"
-#include "../base/rtti.h"
-#include "../base/refcount.h"
-#include "../base/streamable.h"
-#include "../base/color.h"
-#include "../base/kstring.h"
-#include "../base/karray.h"
-#include "../base/log.h"
-#include "../math/kmath.h"
-#include "../math/point.h"
-#include "../math/plane.h"
-#include "../math/matrix.h"
-#include "../math/quaternion.h"
-#include "../math/bound.h"
-#include "../base/karray.h"
-#include "../base/kstream.h"
-#include "../base/kistream.h"
-#include "../base/kostream.h"
-#include "../script/scriptengine.h"
-#include "../system/systemfile.h"
-#include "../render/geometry.h"
-#include "../render/vertexbuffer.h"
-#include "../render/indexbuffer.h"
-#include "../render/heightfield.h"
-#include "../render/render.h"
-#include "../render/renderstate.h"
-#include "../render/cullstate.h"
-#include "../scene/scenecontext.h"
-#include "../scene/visible.h"
-#include "../scene/camera.h"
+#include <math.h>
+#include "katana_core_includes.h"
+#include "katana_base_includes.h"
+#include "base/profiler.h"
+#include "base/jobsystem.h"
+#include "system/systemfile.h"
+#include "system/systemthread.h"
+#include "system/systemmappedfile.h"
+#include "render/rendertypes.h"
+#include "render/geometry.h"
+#include "render/vertexbuffer.h"
+#include "render/indexbuffer.h"
+#include "render/heightfield.h"
+#include "render/render.h"
+#include "render/renderstate.h"
+#include "render/cullstate.h"
+#include "engine/debugoutput.h"
+#include "scenecontext.h"
 #include "visible.h"
 #include "visnode.h"
+#include "camera.h"
 #include "terrain.h"
 #include "terrainpatch.h"
 #include "terrainsettings.h"
+#include "terrainpager.h"
 using namespace Katana;
 
 //
 // Macros
 //
-#define INDEX(x,z) x+z*m_patchesZ
+#define INDEX(x,z) ( (x) + (z) * m_patchesX )
+
+// Fraction of a chunk's distance range after which its grid starts morphing to the next coarser level
+#define CHUNK_MORPH_START	0.7f
 
 //
 // RTTI declaration
@@ -62,11 +55,29 @@ KIMPLEMENT_RTTI( Terrain, VisNode );
 // Constructor
 //
 Terrain::Terrain() :
-	m_isInitialized( false )
+	m_isInitialized( false ),
+	m_patchBoundsRevision( 0 ),
+	m_requiredPatchVertices( 0 ),
+	m_requiredPatchIndices( 0 ),
+	m_triangleCount( 0 ),
+	m_pageDistance( 0 ),
+	m_maxResidentPatches( 0 ),
+	m_pageFrame( 0 ),
+	m_chunkLevels( 0 ),
+	m_chunkVertices( 0 )
 {
 }
 
-Terrain::Terrain( TerrainSettings & settings )
+Terrain::Terrain( TerrainSettings & settings ) :
+	m_patchBoundsRevision( 0 ),
+	m_requiredPatchVertices( 0 ),
+	m_requiredPatchIndices( 0 ),
+	m_triangleCount( 0 ),
+	m_pageDistance( 0 ),
+	m_maxResidentPatches( 0 ),
+	m_pageFrame( 0 ),
+	m_chunkLevels( 0 ),
+	m_chunkVertices( 0 )
 {
 	m_isInitialized = construct( settings );
 }
@@ -82,6 +93,9 @@ Terrain::~Terrain()
 		static void deletePatch( TerrainPatch * pPatch ) { delete pPatch; }
 	};
 
+	// Stop the pager first, since its thread creates patches
+	if ( m_pager ) m_pager->close();
+
 	// Iterate through the patches and destroy them
 	std::for_each( m_patches.begin(), m_patches.end(), &Local::deletePatch );
 }
@@ -90,16 +104,24 @@ Terrain::~Terrain()
 // construct
 //
 bool Terrain::construct(TerrainSettings & settings )
+{
+	// A paged terrain reads its heights from the tile file, as they're needed
+	if ( !settings.tileFileName.empty() ) return constructPaged( settings );
+
+	// Load the heightmap via the greyscale texture
+	shared_ptr<Heightfield> heightmap( new Heightfield( settings.heightMapFileName.c_str(), settings.worldWidth, settings.worldHeight ) );
+	if ( !heightmap->isValid() ) return false;
+
+	return construct( settings, heightmap );
+}
+
+bool Terrain::construct( TerrainSettings & settings, shared_ptr<Heightfield> heightmap )
 {
 	unsigned int px, pz;
 
 	// Start logging the terrain construction process
 	KLOG( "Constructing terrain: '%s'", settings.settingsFile.c_str() );
 
-	// Load the heightmap via the greyscale texture
-	AutoPtr<Heightfield> heightmap = new Heightfield( settings.heightMapFileName.c_str(), settings.worldWidth, settings.worldHeight );
-	if ( !heightmap->isValid() ) return false;
-
 	// Determine the patch units in (X,Y)
 	m_patchesX = ( heightmap->getWidth() - 1 ) / ( TerrainPatch::PATCH_VERTEX_WIDTH - 1);
 	m_patchesZ = ( heightmap->getHeight() - 1 ) / ( TerrainPatch::PATCH_VERTEX_HEIGHT - 1);
@@ -118,37 +140,23 @@ bool Terrain::construct(TerrainSettings & settings )
 		for( px = 0; px < m_patchesX; px++ )
 		{
 			// Create the appropate patch and stuff it in the collection
-			TerrainPatch * patch = createPatch( x, z );
+			TerrainPatch * patch = createPatch( px, pz );
 			m_patches.push_back( patch );
 			
 			// Setup the patch parameters
-			patch->setScale( Point3( (float)m_patchSizeX, (float)m_worldHeight, (float)m_patchSizeZ ) );
-			patch->setWorldTranslation( Point3( float( px * m_patchSizeX ), 0.f, float( pz * m_patchSizeZ ) ) );
-			patch->setHeightMap( heightmap, px * ( TerrainPatch::PATCH_VERTEX_WIDTH - 1 ), pz * ( TerrainPatch::PATCH_VERTEX_HEIGHT - 1 ) );
-
-			// Allow the patch to precalculate the error values
-			patch->calculateErrors();
-			patch->calculateMinMaxY();
+			setupPatch( patch, px, pz, heightmap, px * ( TerrainPatch::PATCH_VERTEX_WIDTH - 1 ), pz * ( TerrainPatch::PATCH_VERTEX_HEIGHT - 1 ) );
 		}
 	}
 
 	// Setup the relationship between patches and their neighbors
 	for( pz = 0; pz < m_patchesZ; pz++ )
-	{
 		for( px = 0; px < m_patchesX; px++ )
-		{
-			m_patches[ INDEX(x,z) ]->setNeighbors(	px > 0 ? m_patches[ INDEX(pz,px-1) ]			: NULL,
-													px < m_patchesX-1 ? m_patches[ INDEX(pz,px+1) ]	: NULL,
-													pz > 0 ? m_patches[ INDEX(pz-1,px) ]			: NULL,
-													pz < m_patchesX-1 ? m_patches[ INDEX(pz+1,pz) ]	: NULL);
-		}
-	}
+			linkPatch( px, pz );
 
-	// Store the render method to use for the terrain patches
-	m_renderMethod = ( settings.blendType == TerrainSettings::BLEND_UNIFIED ? RENDER_UNIFIED : RENDER_SPLIT );
+	// The chunked LOD samples the whole height map
+	m_heightmap = heightmap;
 
-	// Store the maximum screen error for rendering terrain patches
-	m_maximumScreenError = settings.maxScreenError;
+	setupRenderMethod( settings );
 
 	// Log the resultant terrain
 	KLOG("Terrain Statistics:\r\n"
@@ -163,6 +171,332 @@ bool Terrain::construct(TerrainSettings & settings )
 	return true;
 }
 
+//
+// constructPaged
+//
+bool Terrain::constructPaged( TerrainSettings & settings )
+{
+	KLOG( "Constructing paged terrain: '%s'", settings.tileFileName.c_str() );
+
+	// Map the tile file. Every tile holds the heights of one patch.
+	shared_ptr<TerrainPager> pager( new TerrainPager() );
+	if ( !pager->open( settings.tileFileName.c_str() ) ) return false;
+
+	if ( pager->getTileSize() != TerrainPatch::PATCH_VERTEX_WIDTH )
+	{
+		KLOG( "The tiles of '%s' must be %d heights wide", settings.tileFileName.c_str(), TerrainPatch::PATCH_VERTEX_WIDTH );
+		return false;
+	}
+
+	// The patches are created as the camera comes near them
+	m_patchesX = pager->getTilesX();
+	m_patchesZ = pager->getTilesZ();
+	m_patchSizeX = settings.worldWidth / m_patchesX;
+	m_patchSizeZ = settings.worldDepth / m_patchesZ;
+	m_worldHeight = settings.worldHeight;
+
+	m_patches.assign( m_patchesX * m_patchesZ, (TerrainPatch *)NULL );
+	m_tileStamps.assign( m_patches.size(), 0 );
+	m_pageDistance = settings.pageDistance;
+	m_maxResidentPatches = settings.maxResidentPatches;
+
+	setupRenderMethod( settings );
+
+	// The pager's thread calls loadPatch(), which uses the members above
+	m_pager = pager;
+	if ( !m_pager->start( this ) )
+	{
+		KLOG( "Unable to start the terrain pager" );
+		m_pager.reset();
+		return false;
+	}
+
+	KLOG("Terrain Statistics:\r\n"
+		 "\tPatches (paged): %d x %d = %d, %d resident\r\n"
+		 "\tTerrain Size (world units): %d x %d x %d\r\n",
+		m_patchesX, m_patchesZ, m_patchesX * m_patchesZ, m_maxResidentPatches,
+		settings.worldWidth, settings.worldHeight, settings.worldDepth
+	);
+
+	return true;
+}
+
+//
+// setupPatch
+//
+void Terrain::setupPatch( TerrainPatch * patch, unsigned int px, unsigned int pz, shared_ptr<Heightfield> heightmap, unsigned int heightMapX, unsigned int heightMapZ )
+{
+	patch->setScale( Point3( (float)m_patchSizeX, (float)m_worldHeight, (float)m_patchSizeZ ) );
+	patch->setWorldTranslation( Point3( float( px * m_patchSizeX ), 0.f, float( pz * m_patchSizeZ ) ) );
+	patch->setHeightMap( heightmap, heightMapX, heightMapZ );
+
+	// Allow the patch to precalculate the error values
+	patch->calculateErrors();
+	patch->calculateMinMaxY();
+	patch->calculateBound();
+}
+
+//
+// setupRenderMethod
+//
+void Terrain::setupRenderMethod( TerrainSettings & settings )
+{
+	// Store the maximum screen error for rendering terrain patches
+	m_maximumScreenError = settings.maxScreenError;
+
+	// The chunks are drawn with the full resolution grid of a patch, morphed on the CPU
+	if ( settings.lodType == TerrainSettings::CDLOD )
+	{
+		if ( m_heightmap )
+		{
+			m_renderMethod = RENDER_CHUNKED;
+
+			m_stitchIndices.resize( 1 );
+			m_stitchIBs.resize( 1 );
+			TerrainPatch::createStitchIndices( 0, 0, m_stitchIndices[0] );
+
+			setupChunks( settings );
+			return;
+		}
+
+		KLOG( "The chunked LOD needs the whole height map, the paged terrain uses geomipmapping" );
+	}
+
+	// Store the render method to use for the terrain patches
+	m_renderMethod = ( settings.blendType == TerrainSettings::BLEND_UNIFIED ? RENDER_UNIFIED : RENDER_SPLIT );
+
+	// The split rendering shares the index lists of every level and stitch combination between the patches
+	if ( m_renderMethod == RENDER_SPLIT )
+	{
+		m_stitchIndices.resize( ( TerrainPatch::MAXIMUM_SUBDIVISION + 1 ) * TerrainPatch::STITCH_COMBINATIONS );
+		m_stitchIBs.resize( m_stitchIndices.size() );
+
+		for( unsigned int stitch = 0; stitch < m_stitchIndices.size(); stitch++ )
+			TerrainPatch::createStitchIndices(	stitch / TerrainPatch::STITCH_COMBINATIONS,
+												stitch % TerrainPatch::STITCH_COMBINATIONS,
+												m_stitchIndices[stitch] );
+	}
+}
+
+//
+// setupChunks
+//
+void Terrain::setupChunks( TerrainSettings & settings )
+{
+	// The chunk of the last level is the smallest power of two of patches covering the terrain
+	m_chunkLevels = 1;
+	while( ( 1u << ( m_chunkLevels - 1 ) ) < std::max( m_patchesX, m_patchesZ ) )
+		m_chunkLevels++;
+
+	// The height ranges of the patches, then of the chunks of each coarser level
+	m_chunkHeights.resize( m_chunkLevels );
+
+	unsigned int level, x, z;
+	for( level = 0; level < m_chunkLevels; level++ )
+	{
+		const unsigned int chunks = 1u << ( m_chunkLevels - 1 - level );
+		m_chunkHeights[level].assign( chunks * chunks, std::pair<float, float>( 1.f, 0.f ) );
+
+		for( z = 0; z < chunks; z++ )
+		{
+			for( x = 0; x < chunks; x++ )
+			{
+				std::pair<float, float> & heights = m_chunkHeights[level][ x + z * chunks ];
+
+				if ( level == 0 )
+				{
+					if ( x < m_patchesX && z < m_patchesZ )
+						heights = std::pair<float, float>( m_patches[ INDEX(x,z) ]->getMinimumHeight(), m_patches[ INDEX(x,z) ]->getMaximumHeight() );
+					continue;
+				}
+
+				for( int child = 0; child < 4; child++ )
+				{
+					const std::pair<float, float> & childHeights = m_chunkHeights[level - 1][ x * 2 + ( child & 1 ) + ( z * 2 + ( child >> 1 ) ) * chunks * 2 ];
+					if ( childHeights.first > childHeights.second )
+						continue;
+
+					if ( heights.first > heights.second )
+						heights = childHeights;
+					else
+						heights = std::pair<float, float>( std::min( heights.first, childHeights.first ), std::max( heights.second, childHeights.second ) );
+				}
+			}
+		}
+	}
+
+	// The distance ranges double with each level. Neighboring chunks only differ by one level, and the borders
+	// of the finer one are fully morphed, if the first range is larger than twice a patch plus the terrain's height.
+	const float minimumDistance = 2.f * sqrtf( float( m_patchSizeX * m_patchSizeX + m_patchSizeZ * m_patchSizeZ ) ) + m_worldHeight;
+
+	m_chunkRanges.resize( m_chunkLevels );
+	m_chunkRanges[0] = std::max( settings.lodDistance, minimumDistance );
+
+	for( level = 1; level < m_chunkLevels; level++ )
+		m_chunkRanges[level] = m_chunkRanges[level - 1] * 2.f;
+
+	KLOG( "Chunked LOD: %d levels, chunks of one patch within %.0f units", m_chunkLevels, m_chunkRanges[0] );
+}
+
+//
+// loadPatch
+//
+TerrainPatch * Terrain::loadPatch( unsigned int px, unsigned int pz )
+{
+	if ( !m_pager ) return NULL;
+
+	// Every patch has its own height map, with the heights of its tile
+	const unsigned int tileSize = m_pager->getTileSize();
+
+	shared_ptr<Heightfield> heightmap( new Heightfield() );
+	if ( !heightmap->create( m_pager->getTileHeights( INDEX(px,pz) ), tileSize, tileSize, m_patchSizeX, m_patchSizeZ ) )
+		return NULL;
+
+	TerrainPatch * patch = createPatch( px, pz );
+	setupPatch( patch, px, pz, heightmap, 0, 0 );
+
+	return patch;
+}
+
+//
+// linkPatch
+//
+void Terrain::linkPatch( unsigned int px, unsigned int pz )
+{
+	TerrainPatch * patch = m_patches[ INDEX(px,pz) ];
+	if ( !patch ) return;
+
+	patch->setNeighbors(	px > 0 ? m_patches[ INDEX(px-1,pz) ]			: NULL,
+							px < m_patchesX-1 ? m_patches[ INDEX(px+1,pz) ]	: NULL,
+							pz > 0 ? m_patches[ INDEX(px,pz-1) ]			: NULL,
+							pz < m_patchesZ-1 ? m_patches[ INDEX(px,pz+1) ]	: NULL);
+}
+
+//
+// linkNeighbors
+//
+void Terrain::linkNeighbors( unsigned int px, unsigned int pz )
+{
+	linkPatch( px, pz );
+
+	if ( px > 0 )				linkPatch( px - 1, pz );
+	if ( px < m_patchesX - 1 )	linkPatch( px + 1, pz );
+	if ( pz > 0 )				linkPatch( px, pz - 1 );
+	if ( pz < m_patchesZ - 1 )	linkPatch( px, pz + 1 );
+}
+
+//
+// updatePages
+//
+void Terrain::updatePages( SceneContext * context )
+{
+	KPROFILE( "Terrain::updatePages" );
+
+	m_pageFrame++;
+
+	// Install the patches which were loaded since the last frame
+	std::vector< std::pair<unsigned int, TerrainPatch *> > loaded;
+	m_pager->collect( loaded );
+
+	unsigned int i;
+	for( i = 0; i < loaded.size(); i++ )
+	{
+		const unsigned int tile = loaded[i].first;
+
+		m_patches[tile] = loaded[i].second;
+		m_tileStamps[tile] = m_pageFrame;
+		m_residentTiles.push_back( tile );
+
+		linkNeighbors( tile % m_patchesX, tile / m_patchesX );
+	}
+
+	const Point3 camera = getCameraPosition();
+	const float cameraX = camera.x;
+	const float cameraZ = camera.z;
+
+	// Mark the loaded tiles within the paging distance as used, and find the missing ones
+	const int x0 = std::max( (int)floorf( ( cameraX - m_pageDistance ) / m_patchSizeX ), 0 );
+	const int x1 = std::min( (int)floorf( ( cameraX + m_pageDistance ) / m_patchSizeX ), (int)m_patchesX - 1 );
+	const int z0 = std::max( (int)floorf( ( cameraZ - m_pageDistance ) / m_patchSizeZ ), 0 );
+	const int z1 = std::min( (int)floorf( ( cameraZ + m_pageDistance ) / m_patchSizeZ ), (int)m_patchesZ - 1 );
+
+	std::vector< std::pair<float, unsigned int> > missing;
+
+	for( int pz = z0; pz <= z1; pz++ )
+	{
+		for( int px = x0; px <= x1; px++ )
+		{
+			// Distance from the camera to the tile's rectangle
+			const float dx = std::max( 0.f, std::max( px * (float)m_patchSizeX - cameraX, cameraX - ( px + 1 ) * (float)m_patchSizeX ) );
+			const float dz = std::max( 0.f, std::max( pz * (float)m_patchSizeZ - cameraZ, cameraZ - ( pz + 1 ) * (float)m_patchSizeZ ) );
+			const float distanceSquared = dx * dx + dz * dz;
+
+			if ( distanceSquared > m_pageDistance * m_pageDistance )
+				continue;
+
+			const unsigned int tile = INDEX(px,pz);
+			if ( m_patches[tile] )
+				m_tileStamps[tile] = m_pageFrame;
+			else
+				missing.push_back( std::pair<float, unsigned int>( distanceSquared, tile ) );
+		}
+	}
+
+	// Request the missing tiles, the nearest first. There's no point loading more than the budget.
+	std::sort( missing.begin(), missing.end() );
+	if ( missing.size() > m_maxResidentPatches )
+		missing.resize( m_maxResidentPatches );
+
+	std::vector<unsigned int> requests( missing.size() );
+	for( i = 0; i < missing.size(); i++ )
+		requests[i] = missing[i].second;
+
+	m_pager->request( requests );
+
+	// Unload the least recently used patches beyond the budget. The tiles used this frame are kept.
+	if ( m_residentTiles.size() > m_maxResidentPatches )
+	{
+		std::vector< std::pair<unsigned int, unsigned int> > used( m_residentTiles.size() );
+		for( i = 0; i < m_residentTiles.size(); i++ )
+			used[i] = std::pair<unsigned int, unsigned int>( m_tileStamps[ m_residentTiles[i] ], m_residentTiles[i] );
+
+		std::sort( used.begin(), used.end() );
+
+		unsigned int unload = (unsigned int)m_residentTiles.size() - m_maxResidentPatches;
+		m_residentTiles.clear();
+
+		for( i = 0; i < used.size(); i++ )
+		{
+			const unsigned int tile = used[i].second;
+
+			if ( !unload || used[i].first == m_pageFrame )
+			{
+				m_residentTiles.push_back( tile );
+				continue;
+			}
+
+			delete m_patches[tile];
+			m_patches[tile] = NULL;
+			linkNeighbors( tile % m_patchesX, tile / m_patchesX );
+
+			m_pager->release( tile );
+			unload--;
+		}
+	}
+}
+
+//
+// getCameraPosition
+//
+Point3 Terrain::getCameraPosition() const
+{
+	// The camera is the origin of the view space, so find it in the terrain's space
+	Matrix4 viewToTerrain = m_worldViewMatrix;
+	viewToTerrain.inverse();
+
+	return Point3( viewToTerrain.pos[0], viewToTerrain.pos[1], viewToTerrain.pos[2] );
+}
+
 //
 // OnAttach
 //
@@ -170,7 +504,7 @@ bool Terrain::OnAttach( SceneContext * context )
 {
 	// The triangles in the terrain are triangle strips and orders in the
 	// opposite direction DirectX likes (CLOCKWISE), so we'll compensate
-	addState( new CullState( COUNTERCLOCKWISE, BACK ) );
+	addState( shared_ptr<RenderState>( new CullState( COUNTERCLOCKWISE, BACK ) ) );
 
 	return true;
 }
@@ -181,8 +515,15 @@ bool Terrain::OnAttach( SceneContext * context )
 bool Terrain::OnDetach( SceneContext * context )
 {
 	// Invalidate the vertex buffer
-	m_vb = 0;
-	m_ib = 0;
+	m_vb.reset();
+	m_ib.reset();
+
+	// And the buffers of the split rendering, which are recreated when they're drawn
+	for( unsigned int stitch = 0; stitch < m_stitchIBs.size(); stitch++ )
+		m_stitchIBs[stitch].reset();
+
+	for( unsigned int patch = 0; patch < m_patches.size(); patch++ )
+		if ( m_patches[patch] ) m_patches[patch]->setStaticVB( shared_ptr<VertexBuffer>() );
 
 	return true;
 }
@@ -192,74 +533,100 @@ bool Terrain::OnDetach( SceneContext * context )
 //
 bool Terrain::OnPreRender( SceneContext * context )
 {
+	KPROFILE( "Terrain::OnPreRender" );
+
 	// Call base class to determine whether we've visible and update our world matrices
 	if ( !Visible::OnPreRender( context ) ) return false;
 
-	// Clear all the active patches
+	// Clear all the active patches. Their neighbors stitch to the current tesselation of the hidden patches.
+	for( std::vector<TerrainPatch *>::iterator iter = m_activePatches.begin(); 
+		iter != m_activePatches.end(); 
+		iter++ )
+		(*iter)->setVisible( false );
+
 	m_activePatches.clear();
 
-	// Cull the terrain patches
-	for( unsigned int pz = 0; pz < m_patchesZ; pz++ )
-		for( unsigned int px = 0; px < m_patchesX; px++ )
-			if ( !context->currentCamera->Cull( Bound( m_patches[ INDEX(px, pz) ]->getWorldTranslation(), (float)m_patchSizeX ) ) )
-				m_activePatches.push_back( m_patches[ INDEX(px, pz) ] );
+	// The chunked LOD selects its chunks from the camera's distance, and doesn't use the patches
+	if ( m_renderMethod == RENDER_CHUNKED )
+	{
+		KPROFILE( "Terrain::selectChunks" );
+
+		m_selectedChunks.clear();
+		m_chunkCamera = getCameraPosition();
+
+		const unsigned int planeMask = context->debugOutput->getEnableFrustumCulling() ? m_cullPlaneMask : 0;
+		selectChunk( m_chunkLevels - 1, 0, 0, context->currentCamera->getWorldPlanes(), planeMask );
+
+		m_requiredPatchVertices = (unsigned int)m_selectedChunks.size() * TerrainPatch::MAXIMUM_VERTICES;
+		m_requiredPatchIndices = (unsigned int)( m_selectedChunks.size() * m_stitchIndices[0].size() );
+		m_triangleCount = m_requiredPatchIndices / 3;
+		return true;
+	}
+
+	// Load the patches around the camera, and unload the ones which weren't used for the longest time
+	if ( m_pager ) updatePages( context );
+
+	// Cull the terrain patches through the quadtree. Only the frustum planes which intersect the terrain's bounds
+	// are tested, if there are none left (or culling is disabled) every patch is visible.
+	updatePatchBounds();
+
+	if ( !m_quadtree.empty() )
+	{
+		const unsigned int planeMask = context->debugOutput->getEnableFrustumCulling() ? m_cullPlaneMask : 0;
+		cullQuadtree( 0, context->currentCamera->getWorldPlanes(), planeMask );
+	}
 
 	// Compute the projected error matrix
-	Matrix4 projectedErrorMatrix; projectedErrorMatrix.setIdentity();
-	projectedErrorMatrix.pos = Point3( 0.f, 0.f, 1.2f * std::max( m_worldHeight, std::max( m_patchSizeX, m_patchSizeZ ) ) );
-	projectedErrorMatrix *= context->currentCamera->getProjection();
-	projectedErrorMatrix *= m_worldViewMatrix;
-
-	// Iterate through all the active (visible) patches and update their
-	// tesselation level based on the projected error
-	for( std::list<TerrainPatch *>::iterator iter = m_activePatches.begin(); 
-		iter != m_activePatches.end(); 
-		iter++ )
+	m_projectedErrorMatrix.setIdentity();
+	m_projectedErrorMatrix.pos = Point3( 0.f, 0.f, 1.2f * std::max( m_worldHeight, std::max( m_patchSizeX, m_patchSizeZ ) ) );
+	m_projectedErrorMatrix *= context->currentCamera->getProjection();
+	m_projectedErrorMatrix *= m_worldViewMatrix;
+
+	// Select the tesselation level of every active patch from its projected error. This must be
+	// finished before any patch is tesselated, since the tesselation stitches to the neighbor's new level.
+	updateActivePatches( context->jobSystem, SelectPatchLevels );
+
+	// Reset the total number of patch vertices and indices
+	m_requiredPatchVertices = m_requiredPatchIndices = 0;
+
+	if ( m_renderMethod == RENDER_SPLIT )
 	{
-		// Update the projected error for this patch
-		(*iter)->updateProjectedErrors( projectedErrorMatrix );
+		// The patches are drawn from their full resolution vertices with the shared index lists,
+		// so there's nothing to tesselate
+		limitPatchTesselation();
 
-		// For each tesselation level, check if the projected error
-		// difference is less than our threshold.
-		for ( int tessLevel = TerrainPatch::MAXIMUM_SUBDIVISION; tessLevel >= 0; tessLevel-- )
+		m_activeStitches.resize( m_activePatches.size() );
+
+		for( unsigned int active = 0; active < m_activePatches.size(); active++ )
 		{
-			if ( (*iter)->getProjectedError( tessLevel ) < m_maximumScreenError )
-			{
-				(*iter)->setRealTesselation( tessLevel );
-				(*iter)->setTesselation( tessLevel );
-				break;
-			}
+			const int level = std::min( m_activePatches[active]->getNewTesselation(), (int)TerrainPatch::MAXIMUM_SUBDIVISION );
+			const unsigned int stitch = level * TerrainPatch::STITCH_COMBINATIONS + m_activePatches[active]->getStitchMask();
+
+			m_activeStitches[active] = stitch;
+			m_requiredPatchVertices += TerrainPatch::MAXIMUM_VERTICES;
+			m_requiredPatchIndices += (unsigned int)m_stitchIndices[stitch].size();
 		}
+
+		m_triangleCount = m_requiredPatchIndices / 3;
+		return true;
 	}
 
-	// Reset the total number of patch vertices and indices
-	m_requiredPatchVertices = m_requiredPatchIndices = 0;
+	// Have the active patches update their tesselation by generating vertex/index data
+	updateActivePatches( context->jobSystem, TesselatePatches );
 
-	// Iterate through all the active (visible) patches and have them
-	// update their tesselation level by generating vertex/index data
-	for( std::list<TerrainPatch *>::iterator iter = m_activePatches.begin(); 
+	// Total the number of patch vertices and indices
+	for( std::vector<TerrainPatch *>::iterator iter = m_activePatches.begin(); 
 		iter != m_activePatches.end(); 
 		iter++ )
 	{
-		(*iter)->updateTesselation();
 		m_requiredPatchVertices += (*iter)->getNewVertexCount();
 		m_requiredPatchIndices += (*iter)->getNewIndexCount() + 2;	// Two more for degen-tris
 	}
 
-	// Iterate through all the active patches and call the additional tesselation
-	// methods. Patches may need additional update passes to adapt to neighbors. 
-	// This is because our tesselation may depend on the tesselation of our neighboring patches.
-	std::for_each( m_activePatches.begin(), 
-		m_activePatches.end(), 
-		std::mem_fun( &TerrainPatch::updateTesselation2 ) );
-
-	std::for_each( m_activePatches.begin(), 
-		m_activePatches.end(), 
-		std::mem_fun( &TerrainPatch::updateTesselation3 ) );
-
 	// The last patch doesn't need degenerate triangles, so decremenent
 	if ( m_requiredPatchIndices > 0 ) m_requiredPatchIndices -= 2;
 
+	m_triangleCount = m_requiredPatchIndices > 2 ? m_requiredPatchIndices - 2 : 0;
 	return true;
 }
 
@@ -269,8 +636,9 @@ bool Terrain::OnPreRender( SceneContext * context )
 bool Terrain::OnRender( SceneContext * context )
 {
 	// Render the terrain using the appropiate method
-	if	( m_renderMethod == RENDER_UNIFIED ) renderUnified( context );
-	else									 renderSplit( context );
+	if		( m_renderMethod == RENDER_UNIFIED ) renderUnified( context );
+	else if ( m_renderMethod == RENDER_SPLIT )	 renderSplit( context );
+	else										 renderChunked( context );
 
 	// Call the base class to render the child nodes
 	return VisNode::OnRender( context );
@@ -285,6 +653,381 @@ TerrainPatch * Terrain::createPatch( unsigned int px, unsigned int pz )
 	return new TerrainPatch( this, px, pz );
 }
 
+//
+// updatePatchBounds
+//
+void Terrain::updatePatchBounds()
+{
+	// The boxes only change when the terrain moves
+	if ( !m_quadtree.empty() && m_patchBoundsRevision == m_worldRevision )
+		return;
+
+	m_quadtree.clear();
+
+	if ( !m_patches.empty() )
+	{
+		Point3 minimum, maximum;
+		buildQuadtree( 0, 0, m_patchesX, m_patchesZ, minimum, maximum );
+	}
+
+	m_patchBoundsRevision = m_worldRevision;
+}
+
+//
+// buildQuadtree
+//
+int Terrain::buildQuadtree( unsigned int x0, unsigned int z0, unsigned int x1, unsigned int z1, Point3 & minimum, Point3 & maximum )
+{
+	const int index = (int)m_quadtree.size();
+	m_quadtree.push_back( QuadtreeNode() );
+
+	m_quadtree[index].x0 = x0;
+	m_quadtree[index].z0 = z0;
+	m_quadtree[index].x1 = x1;
+	m_quadtree[index].z1 = z1;
+
+	int child;
+	for( child = 0; child < 4; child++ )
+		m_quadtree[index].children[child] = -1;
+
+	if ( x1 - x0 == 1 && z1 - z0 == 1 )
+	{
+		// A leaf spans its patch, with the height range of the patch's vertices. The patches of a paged
+		// terrain may not be loaded, so the height range stored in the tile file is used.
+		if ( m_pager )
+		{
+			unsigned short low, high;
+			m_pager->getHeightRange( INDEX(x0,z0), low, high );
+
+			minimum = Point3( float( x0 * m_patchSizeX ), m_worldHeight * low / 255.f, float( z0 * m_patchSizeZ ) );
+			maximum = Point3( minimum.x + m_patchSizeX, m_worldHeight * high / 255.f, minimum.z + m_patchSizeZ );
+		}
+		else
+		{
+			const TerrainPatch * patch = m_patches[ INDEX(x0,z0) ];
+			const Point3 translation = patch->getWorldTranslation();
+
+			minimum = Point3( translation.x, patch->getMinimumHeight(), translation.z );
+			maximum = Point3( translation.x + m_patchSizeX, patch->getMaximumHeight(), translation.z + m_patchSizeZ );
+		}
+	}
+	else
+	{
+		// Split the rectangle in halves along each axis. A rectangle one patch wide only splits along the other.
+		const unsigned int splitX = x1 - x0 > 1 ? ( x0 + x1 ) / 2 : x1;
+		const unsigned int splitZ = z1 - z0 > 1 ? ( z0 + z1 ) / 2 : z1;
+		const unsigned int childX0[4] = { x0, splitX, x0, splitX };
+		const unsigned int childX1[4] = { splitX, x1, splitX, x1 };
+		const unsigned int childZ0[4] = { z0, z0, splitZ, splitZ };
+		const unsigned int childZ1[4] = { splitZ, splitZ, z1, z1 };
+
+		bool first = true;
+		for( child = 0; child < 4; child++ )
+		{
+			if ( childX0[child] == childX1[child] || childZ0[child] == childZ1[child] )
+				continue;
+
+			Point3 childMinimum, childMaximum;
+			const int childIndex = buildQuadtree( childX0[child], childZ0[child], childX1[child], childZ1[child], childMinimum, childMaximum );
+			m_quadtree[index].children[child] = childIndex;
+
+			for( int axis = 0; axis < 3; axis++ )
+			{
+				if ( first || childMinimum[axis] < minimum[axis] ) minimum[axis] = childMinimum[axis];
+				if ( first || childMaximum[axis] > maximum[axis] ) maximum[axis] = childMaximum[axis];
+			}
+			first = false;
+		}
+	}
+
+	transformBox( minimum, maximum, m_quadtree[index].center, m_quadtree[index].extents );
+
+	return index;
+}
+
+//
+// transformBox
+//
+void Terrain::transformBox( const Point3 & minimum, const Point3 & maximum, Point3 & center, Point3 & extents ) const
+{
+	// The extents along each world axis are the sum of the extents along the terrain's axes, projected on it
+	const Point3 localExtents = ( maximum - minimum ) * 0.5f;
+
+	// The world matrix doesn't hold the scale (see Visible::updateWorldTransform), so scale the center first
+	center = ( minimum + maximum ) * ( 0.5f * m_scale );
+	center *= m_worldMatrix;
+
+	for( int axis = 0; axis < 3; axis++ )
+		extents[axis] = ( fabsf( m_worldMatrix.m[axis][0] ) * localExtents.x +
+						  fabsf( m_worldMatrix.m[axis][1] ) * localExtents.y +
+						  fabsf( m_worldMatrix.m[axis][2] ) * localExtents.z ) * m_scale;
+}
+
+//
+// cullBox
+//
+bool Terrain::cullBox( const Point3 & center, const Point3 & extents, const Plane * planes, unsigned int & planeMask )
+{
+	for( unsigned int plane = 0; plane < MAX_FRUSTUM_PLANES && planeMask; plane++ )
+	{
+		if ( !( planeMask & ( 1u << plane ) ) )
+			continue;
+
+		const Point3 & normal = planes[plane].getNormal();
+		const float radius = fabsf( normal.x ) * extents.x + fabsf( normal.y ) * extents.y + fabsf( normal.z ) * extents.z;
+		const float distance = planes[plane].distance( center );
+
+		if ( distance < -radius )
+			return false;
+		if ( distance >= radius )
+			planeMask &= ~( 1u << plane );
+	}
+
+	return true;
+}
+
+//
+// cullQuadtree
+//
+void Terrain::cullQuadtree( int index, const Plane * planes, unsigned int planeMask )
+{
+	const QuadtreeNode & node = m_quadtree[index];
+
+	// Test the box against the planes which intersect the parent
+	if ( !cullBox( node.center, node.extents, planes, planeMask ) )
+		return;
+
+	// If the node is inside the frustum, so are all its patches
+	if ( !planeMask )
+	{
+		activatePatches( index );
+		return;
+	}
+
+	bool leaf = true;
+	for( int child = 0; child < 4; child++ )
+	{
+		if ( node.children[child] != -1 )
+		{
+			cullQuadtree( node.children[child], planes, planeMask );
+			leaf = false;
+		}
+	}
+
+	// The leaves intersect the frustum
+	if ( leaf )
+		activatePatches( index );
+}
+
+//
+// activatePatches
+//
+void Terrain::activatePatches( int index )
+{
+	const QuadtreeNode & node = m_quadtree[index];
+
+	for( unsigned int pz = node.z0; pz < node.z1; pz++ )
+	{
+		for( unsigned int px = node.x0; px < node.x1; px++ )
+		{
+			// The patches of a paged terrain which aren't loaded yet are skipped
+			TerrainPatch * patch = m_patches[ INDEX(px,pz) ];
+			if ( !patch ) continue;
+
+			patch->setVisible( true );
+			m_activePatches.push_back( patch );
+		}
+	}
+}
+
+//
+// selectChunk
+//
+void Terrain::selectChunk( unsigned int level, unsigned int chunkX, unsigned int chunkZ, const Plane * planes, unsigned int planeMask )
+{
+	// Skip the chunks past the terrain's edge
+	const std::pair<float, float> & heights = m_chunkHeights[level][ chunkX + ( chunkZ << ( m_chunkLevels - 1 - level ) ) ];
+	if ( heights.first > heights.second )
+		return;
+
+	// Box of the chunk, clipped to the terrain
+	const unsigned int x0 = chunkX << level, x1 = std::min( ( chunkX + 1 ) << level, m_patchesX );
+	const unsigned int z0 = chunkZ << level, z1 = std::min( ( chunkZ + 1 ) << level, m_patchesZ );
+	const Point3 minimum( float( x0 * m_patchSizeX ), heights.first, float( z0 * m_patchSizeZ ) );
+	const Point3 maximum( float( x1 * m_patchSizeX ), heights.second, float( z1 * m_patchSizeZ ) );
+
+	Point3 center, extents;
+	transformBox( minimum, maximum, center, extents );
+	if ( !cullBox( center, extents, planes, planeMask ) )
+		return;
+
+	// Draw the chunk if it doesn't reach within the distance range of its children
+	bool draw = ( level == 0 );
+
+	if ( !draw )
+	{
+		const float dx = std::max( 0.f, std::max( minimum.x - m_chunkCamera.x, m_chunkCamera.x - maximum.x ) );
+		const float dy = std::max( 0.f, std::max( minimum.y - m_chunkCamera.y, m_chunkCamera.y - maximum.y ) );
+		const float dz = std::max( 0.f, std::max( minimum.z - m_chunkCamera.z, m_chunkCamera.z - maximum.z ) );
+
+		draw = ( dx * dx + dy * dy + dz * dz > m_chunkRanges[level - 1] * m_chunkRanges[level - 1] );
+	}
+
+	if ( draw )
+	{
+		Chunk chunk;
+		chunk.level = level;
+		chunk.x = chunkX;
+		chunk.z = chunkZ;
+		m_selectedChunks.push_back( chunk );
+		return;
+	}
+
+	// The children beyond their own range are drawn at this chunk's resolution, since they're fully morphed
+	for( int child = 0; child < 4; child++ )
+		selectChunk( level - 1, chunkX * 2 + ( child & 1 ), chunkZ * 2 + ( child >> 1 ), planes, planeMask );
+}
+
+//
+// updateActivePatches
+//
+void Terrain::updateActivePatches( JobSystem * jobSystem, void (*function)( void * data, unsigned int begin, unsigned int end ) )
+{
+	runJobs( jobSystem, function, (unsigned int)m_activePatches.size() );
+}
+
+//
+// runJobs
+//
+void Terrain::runJobs( JobSystem * jobSystem, void (*function)( void * data, unsigned int begin, unsigned int end ), unsigned int count )
+{
+	if ( !jobSystem || jobSystem->getThreadCount() < 2 || count < 2 )
+		function( this, 0, count );
+	else
+		jobSystem->wait( jobSystem->parallelFor( function, this, 0, count ) );
+}
+
+//
+// SelectPatchLevels
+//
+void Terrain::SelectPatchLevels( void * data, unsigned int begin, unsigned int end )
+{
+	KPROFILE( "Terrain::SelectPatchLevels" );
+
+	Terrain * pTerrain = reinterpret_cast<Terrain *>( data );
+
+	for( unsigned int i = begin; i < end; i++ )
+	{
+		TerrainPatch * pPatch = pTerrain->m_activePatches[i];
+
+		// Update the projected error for this patch
+		pPatch->updateProjectedErrors( pTerrain->m_projectedErrorMatrix );
+
+		// For each tesselation level, check if the projected error
+		// difference is less than our threshold.
+		for ( int tessLevel = TerrainPatch::MAXIMUM_SUBDIVISION; tessLevel >= 0; tessLevel-- )
+		{
+			if ( pPatch->getProjectedError( tessLevel ) < pTerrain->m_maximumScreenError )
+			{
+				pPatch->setRealTesselation( tessLevel );
+				pPatch->setTesselation( tessLevel );
+				break;
+			}
+		}
+	}
+}
+
+//
+// TesselatePatches
+//
+void Terrain::TesselatePatches( void * data, unsigned int begin, unsigned int end )
+{
+	KPROFILE( "Terrain::TesselatePatches" );
+
+	Terrain * pTerrain = reinterpret_cast<Terrain *>( data );
+
+	for( unsigned int i = begin; i < end; i++ )
+		pTerrain->m_activePatches[i]->updateTesselation();
+}
+
+//
+// MorphChunks
+//
+void Terrain::MorphChunks( void * data, unsigned int begin, unsigned int end )
+{
+	KPROFILE( "Terrain::MorphChunks" );
+
+	Terrain * pTerrain = reinterpret_cast<Terrain *>( data );
+	const Heightfield * heightmap = pTerrain->m_heightmap.get();
+
+	const float scaleX = pTerrain->m_patchSizeX / float( TerrainPatch::PATCH_VERTEX_WIDTH - 1 );
+	const float scaleY = pTerrain->m_worldHeight / 255.f;
+	const float scaleZ = pTerrain->m_patchSizeZ / float( TerrainPatch::PATCH_VERTEX_HEIGHT - 1 );
+	const float textureX = 1.f / ( heightmap->getWidth() - 1 );
+	const float textureZ = 1.f / ( heightmap->getHeight() - 1 );
+
+	for( unsigned int i = begin; i < end; i++ )
+	{
+		const Chunk & chunk = pTerrain->m_selectedChunks[i];
+		TerrainVertex * pVertex = pTerrain->m_chunkVertices + i * TerrainPatch::MAXIMUM_VERTICES;
+
+		// The grid of a chunk spans 2^level heights per quad. The vertices past the terrain's edge are
+		// clamped to it, so the triangles past the edge are degenerate.
+		const int step = 1 << chunk.level;
+		const int startX = ( chunk.x << chunk.level ) * ( TerrainPatch::PATCH_VERTEX_WIDTH - 1 );
+		const int startZ = ( chunk.z << chunk.level ) * ( TerrainPatch::PATCH_VERTEX_HEIGHT - 1 );
+		const int lastX = (int)heightmap->getWidth() - 1;
+		const int lastZ = (int)heightmap->getHeight() - 1;
+
+		// The grid morphs over the end of the chunk's distance range. The last level has nothing to morph to.
+		const bool morph = ( chunk.level < pTerrain->m_chunkLevels - 1 );
+		const float rangeStart = chunk.level > 0 ? pTerrain->m_chunkRanges[ chunk.level - 1 ] : 0.f;
+		const float morphEnd = pTerrain->m_chunkRanges[ chunk.level ];
+		const float morphStart = rangeStart + ( morphEnd - rangeStart ) * CHUNK_MORPH_START;
+
+		for( int gz = 0; gz < TerrainPatch::PATCH_VERTEX_HEIGHT; gz++ )
+		{
+			for( int gx = 0; gx < TerrainPatch::PATCH_VERTEX_WIDTH; gx++, pVertex++ )
+			{
+				const int hx = std::min( startX + gx * step, lastX );
+				const int hz = std::min( startZ + gz * step, lastZ );
+
+				Point3 position( hx * scaleX, heightmap->getHeightAt( hx, hz ) * scaleY, hz * scaleZ );
+				float morphX = 0.f, morphZ = 0.f;
+
+				// The odd columns collapse onto the previous even column, and the odd rows onto the next
+				// even row, so the quads' diagonals match the coarser grid's. The columns clamped to the
+				// edge stay on it, like the coarser grid's.
+				const bool oddX = ( gx & 1 ) && startX + gx * step <= lastX;
+				const bool oddZ = ( gz & 1 ) != 0;
+
+				if ( morph && ( oddX || oddZ ) )
+				{
+					const Point3 offset( position.x - pTerrain->m_chunkCamera.x, position.y - pTerrain->m_chunkCamera.y, position.z - pTerrain->m_chunkCamera.z );
+					const float factor = std::min( std::max( ( offset.getLength() - morphStart ) / ( morphEnd - morphStart ), 0.f ), 1.f );
+
+					if ( factor > 0.f )
+					{
+						const int targetX = oddX ? hx - step : hx;
+						const int targetZ = oddZ ? std::min( hz + step, lastZ ) : hz;
+						const float targetY = heightmap->getHeightAt( targetX, targetZ ) * scaleY;
+
+						morphX = ( targetX - hx ) * factor;
+						morphZ = ( targetZ - hz ) * factor;
+						position.x += morphX * scaleX;
+						position.y += ( targetY - position.y ) * factor;
+						position.z += morphZ * scaleZ;
+					}
+				}
+
+				pVertex->position = position;
+				pVertex->texture.x = ( hx + morphX ) * textureX;
+				pVertex->texture.y = (float) heightmap->getHeight() - 1 - ( hz + morphZ ) * textureZ;
+			}
+		}
+	}
+}
+
 //
 // createBuffers
 //
@@ -295,15 +1038,24 @@ bool Terrain::createBuffers( SceneContext * context )
 
 	if ( m_renderMethod == RENDER_UNIFIED )
 	{
-		if ( !m_ib.isValid() || ( m_requiredPatchIndices > m_ib->getIndexCount() ) )
+		if ( !m_ib || ( m_requiredPatchIndices > m_ib->getIndexCount() ) )
+		{
+			m_ib.reset( context->currentRenderer->CreateIB( DYNAMIC | WRITE_ONLY, m_requiredPatchIndices ) );
+			if ( !m_ib ) return false;
+		}
+		if ( !m_vb || ( m_requiredPatchVertices > m_vb->getVertexCount() ) )
 		{
-			m_ib = context->currentRenderer->CreateIB( DYNAMIC | WRITE_ONLY, m_requiredPatchIndices );
-			if ( !m_ib.isValid() ) return false;
+			m_vb.reset( context->currentRenderer->CreateVB( VERTEX | TEXTURE_0, DYNAMIC | WRITE_ONLY, m_requiredPatchVertices, 0 ) );
+			if ( !m_vb ) return false;
 		}
-		if ( !m_vb.isValid() || ( m_requiredPatchVertices > m_vb->getVertexCount() ) )
+	}
+	else if ( m_renderMethod == RENDER_CHUNKED )
+	{
+		// The chunks share the index buffer of the grid
+		if ( !m_vb || ( m_requiredPatchVertices > m_vb->getVertexCount() ) )
 		{
-			m_vb = context->currentRenderer->CreateVB( VERTEX | TEXTURE_0, DYNAMIC | WRITE_ONLY, m_requiredPatchVertices, 0 );
-			if ( !m_vb.isValid() ) return false;
+			m_vb.reset( context->currentRenderer->CreateVB( VERTEX | TEXTURE_0, DYNAMIC | WRITE_ONLY, m_requiredPatchVertices, 0 ) );
+			if ( !m_vb ) return false;
 		}
 	}
 
@@ -322,8 +1074,8 @@ void Terrain::renderUnified( SceneContext * context )
 	if ( !createBuffers( context ) ) return;
 
 	// Lock the vertex buffer. This will get the raw hardware vertex and index buffer
-	if ( !m_vb.isValid() || !m_vb->LockRange( 0, m_requiredPatchVertices ) ) return;
-	if ( !m_ib.isValid() || !m_ib->LockRange( 0, m_requiredPatchIndices ) ) return;
+	if ( !m_vb || !m_vb->LockRange( 0, m_requiredPatchVertices ) ) return;
+	if ( !m_ib || !m_ib->LockRange( 0, m_requiredPatchIndices ) ) return;
 
 	// Get safe arrays to the hardware vertex buffers
 	ksafearray<TerrainVertex> vertexData = m_vb->getVertexBufferData<TerrainVertex>();
@@ -336,7 +1088,7 @@ void Terrain::renderUnified( SceneContext * context )
 	unsigned short lastIndex = 0xFFFF;
 
 	// Iterate through the patches, filling in the vertex buffers
-	for( std::list<TerrainPatch *>::iterator iter = m_activePatches.begin();
+	for( std::vector<TerrainPatch *>::iterator iter = m_activePatches.begin();
 		 iter != m_activePatches.end();
 		 iter++ )
 	{
@@ -374,7 +1126,14 @@ void Terrain::renderUnified( SceneContext * context )
 
 	// Render the terrain geometry
 	Render * render = context->currentRenderer;
-	if ( render ) render->RenderVB( m_vb, m_ib );
+	if ( render ) render->RenderVB( m_vb.get(), m_ib.get() );
+
+	// The patches are concatenated in a single strip
+	if ( context->statistics )
+	{
+		context->statistics->terrainTrianglesLastFrame += numIndices - 4;
+		context->statistics->terrainPatchesLastFrame += numPatches;
+	}
 }
 
 //
@@ -382,6 +1141,153 @@ void Terrain::renderUnified( SceneContext * context )
 //
 void Terrain::renderSplit( SceneContext * context )
 {
+	Render * render = context->currentRenderer;
+	if ( !render || m_activePatches.empty() || m_activeStitches.size() != m_activePatches.size() ) return;
+
+	unsigned int numTriangles = 0, numPatches = 0;
+
+	for( unsigned int active = 0; active < m_activePatches.size(); active++ )
+	{
+		TerrainPatch * patch = m_activePatches[active];
+		const unsigned int stitch = m_activeStitches[active];
+
+		// The buffers are only filled when they're created
+		if ( m_stitchIndices[stitch].empty() || !createSplitBuffers( context, patch, stitch ) ) continue;
+
+		// The index count of the combination decides the number of triangles
+		shared_ptr<VertexBuffer> vb = patch->getStaticVB();
+		vb->setPrimitveType( TRIANGLE_LIST );
+		vb->setPrimitveCount( (unsigned int)m_stitchIndices[stitch].size() / 3 );
+
+		render->RenderVB( vb.get(), m_stitchIBs[stitch].get() );
+
+		numTriangles += (unsigned int)m_stitchIndices[stitch].size() / 3;
+		numPatches++;
+	}
+
+	if ( context->statistics )
+	{
+		context->statistics->terrainTrianglesLastFrame += numTriangles;
+		context->statistics->terrainPatchesLastFrame += numPatches;
+	}
+}
+
+//
+// createSplitBuffers
+//
+bool Terrain::createSplitBuffers( SceneContext * context, TerrainPatch * patch, unsigned int stitch )
+{
+	Render * render = context->currentRenderer;
+
+	// Create the static vertex buffer of the patch, with its full resolution vertices
+	if ( !patch->getStaticVB() )
+	{
+		shared_ptr<VertexBuffer> vb( render->CreateVB( VERTEX | TEXTURE_0, STATIC | WRITE_ONLY, TerrainPatch::MAXIMUM_VERTICES, 0 ) );
+		if ( !vb || !vb->LockRange( 0, TerrainPatch::MAXIMUM_VERTICES ) ) return false;
+
+		ksafearray<TerrainVertex> vertexData = vb->getVertexBufferData<TerrainVertex>();
+		if ( !vertexData.empty() ) patch->createStaticVertices( &vertexData[0] );
+
+		vb->Unlock();
+		if ( vertexData.empty() ) return false;
+
+		patch->setStaticVB( vb );
+	}
+
+	return createStitchBuffer( context, stitch );
+}
+
+//
+// createStitchBuffer
+//
+bool Terrain::createStitchBuffer( SceneContext * context, unsigned int stitch )
+{
+	Render * render = context->currentRenderer;
+
+	// Create the index buffer of the level and stitch combination, shared by all the patches
+	if ( !m_stitchIBs[stitch] )
+	{
+		const std::vector<unsigned short> & indices = m_stitchIndices[stitch];
+
+		shared_ptr<IndexBuffer> ib( render->CreateIB( STATIC | WRITE_ONLY, (unsigned int)indices.size() ) );
+		if ( !ib || !ib->LockRange( 0, (unsigned int)indices.size() ) ) return false;
+
+		ksafearray<unsigned short> indexData = ib->getIndexBufferData();
+		if ( !indexData.empty() ) memcpy( &indexData[0], &indices[0], indices.size() * sizeof(unsigned short) );
+
+		ib->Unlock();
+		if ( indexData.empty() ) return false;
+
+		ib->setActiveIndexCount( (unsigned int)indices.size() );
+		m_stitchIBs[stitch] = ib;
+	}
+
+	return true;
+}
+
+//
+// renderChunked
+//
+void Terrain::renderChunked( SceneContext * context )
+{
+	Render * render = context->currentRenderer;
+	if ( !render || m_selectedChunks.empty() ) return;
+
+	// The grid's indices are shared by all the chunks, and the vertices are rewritten every pass
+	if ( !createBuffers( context ) || !createStitchBuffer( context, 0 ) ) return;
+	if ( !m_vb->LockRange( 0, m_requiredPatchVertices ) ) return;
+
+	ksafearray<TerrainVertex> vertexData = m_vb->getVertexBufferData<TerrainVertex>();
+	if ( !vertexData.empty() )
+	{
+		m_chunkVertices = &vertexData[0];
+		runJobs( context->jobSystem, MorphChunks, (unsigned int)m_selectedChunks.size() );
+		m_chunkVertices = 0;
+	}
+
+	m_vb->Unlock();
+	if ( vertexData.empty() ) return;
+
+	// Draw every chunk from its own vertices
+	const unsigned int triangles = (unsigned int)m_stitchIndices[0].size() / 3;
+
+	m_vb->setPrimitveType( TRIANGLE_LIST );
+	m_vb->setPrimitveCount( triangles );
+	m_vb->setActiveVertexCount( TerrainPatch::MAXIMUM_VERTICES );
+
+	for( unsigned int chunk = 0; chunk < m_selectedChunks.size(); chunk++ )
+	{
+		m_vb->setVertexOffset( chunk * TerrainPatch::MAXIMUM_VERTICES );
+		render->RenderVB( m_vb.get(), m_stitchIBs[0].get() );
+	}
+
+	m_vb->setVertexOffset( 0 );
+
+	if ( context->statistics )
+	{
+		context->statistics->terrainTrianglesLastFrame += triangles * (unsigned int)m_selectedChunks.size();
+		context->statistics->terrainPatchesLastFrame += (unsigned int)m_selectedChunks.size();
+	}
+}
+
+//
+// limitPatchTesselation
+//
+void Terrain::limitPatchTesselation()
+{
+	// Refining a patch may require its other neighbors to be refined, so repeat until nothing changes.
+	// The levels only decrease, so this terminates.
+	bool changed = true;
+
+	while( changed )
+	{
+		changed = false;
+
+		for( std::vector<TerrainPatch *>::iterator iter = m_activePatches.begin(); 
+			iter != m_activePatches.end(); 
+			iter++ )
+			changed |= (*iter)->limitTesselation();
+	}
 }
 
 // -------------------------------------------------------
@@ -19,9 +19,14 @@ namespace Katana
 //
 class TerrainSettings;
 class TerrainPatch;
+class TerrainPager;
+class Heightfield;
 class VertexBuffer;
 class IndexBuffer;
+class JobSystem;
+class Plane;
 struct SceneContext;
+struct TerrainVertex;
 
 ///
 /// Terrain
@@ -42,9 +47,14 @@ public:
 	/// Destructor
 	virtual ~Terrain();
 
-	/// Constructs the terrain from a height map and world dimensions
+	/// Constructs the terrain from a height map and world dimensions. If the settings name a tile
+	/// file, the terrain is paged: its patches are loaded around the camera as it moves.
 	bool construct( TerrainSettings & settings );
 
+	/// Constructs the terrain from a height map which is already loaded (or generated).
+	/// The height map file name of the settings is ignored.
+	bool construct( TerrainSettings & settings, shared_ptr<Heightfield> heightmap );
+
 	/// Returns whether the terrain was constructed properly
 	bool isInitialized() const								{ return m_isInitialized; }
 
@@ -55,11 +65,19 @@ public:
 	unsigned int getActivePatchCount() const				{ return (unsigned int)m_activePatches.size(); }
 
 	/// Returns the number of triangles rendered in the last pass
-	unsigned int getTriangleCount() const					{ return m_requiredPatchIndices - 2; }
+	unsigned int getTriangleCount() const					{ return m_triangleCount; }
 
-	/// Returns the patches
+	/// Returns the patches. The patches of a paged terrain which aren't loaded are NULL.
 	std::vector<TerrainPatch*> getTerrainPatches()			{ return m_patches; }
 
+	/// Returns whether the patches are paged from a tile file
+	bool isPaged() const									{ return m_pager.get() != 0; }
+
+	/// Creates the patch of a tile of a paged terrain from its heights in the tile file. This is called
+	/// by the pager's thread, so it only reads what doesn't change once the terrain is constructed.
+	/// The texture coordinates of the patch span its own tile.
+	TerrainPatch * loadPatch( unsigned int px, unsigned int pz );
+
 	/// Called before the terrain is attached to the scene, it will create the vertex
 	/// and index buffers and load the shaders.
 	virtual bool OnAttach( SceneContext * context );
@@ -67,11 +85,13 @@ public:
 	/// Called when the terrain is detached from the scene, it will release resources from memory.
 	virtual bool OnDetach( SceneContext * context );
 
-	/// Called before actual rendering. Patches are culling and renderable patches are added to the active list of patches.
-	/// Also the vertex and pixel shaders are enabled during this call.
+	/// Called before actual rendering. The patches of a paged terrain are loaded and unloaded around the camera.
+	/// Patches are culled through the quadtree and renderable patches are added to the active list of patches.
+	/// The level of every active patch is selected, then the patches are tesselated. Both run on the worker threads
+	/// of the job system, if the context has one. With the chunked LOD, the chunks are selected instead.
 	virtual bool OnPreRender( SceneContext * context );
 
-	/// Renders the terrain. It routes the call to either renderUnififed() or renderSplit().
+	/// Renders the terrain. It routes the call to either renderUnififed(), renderSplit() or renderChunked().
 	virtual bool OnRender( SceneContext * context );
 
 protected:
@@ -79,19 +99,104 @@ protected:
 	/// Creates a terrain patch during construct(). Override this method to create your own terrain behavior
 	virtual TerrainPatch * createPatch( unsigned int px, unsigned int pz );
 
+	/// Constructs a paged terrain from the tile file of the settings, and starts loading its patches
+	bool constructPaged( TerrainSettings & settings );
+
+	/// Positions a patch, gives it its height map and precalculates its errors and bounds
+	void setupPatch( TerrainPatch * patch, unsigned int px, unsigned int pz, shared_ptr<Heightfield> heightmap, unsigned int heightMapX, unsigned int heightMapZ );
+
+	/// Stores the render method and the screen error of the settings
+	void setupRenderMethod( TerrainSettings & settings );
+
+	/// Links a patch to its neighbors, if it's present
+	void linkPatch( unsigned int px, unsigned int pz );
+
+	/// Links a patch and the patches around it, after it was loaded or unloaded
+	void linkNeighbors( unsigned int px, unsigned int pz );
+
+	/// Installs the patches which the pager loaded, requests the missing patches within the paging distance
+	/// (the nearest first), and unloads the least recently used patches beyond the resident budget
+	void updatePages( SceneContext * context );
+
+	/// Returns the position of the current camera in the terrain's space
+	Point3 getCameraPosition() const;
+
+	/// Transforms a box in the terrain's space to a world space box, given by its center and extents
+	void transformBox( const Point3 & minimum, const Point3 & maximum, Point3 & center, Point3 & extents ) const;
+
+	/// Tests a world space box against the frustum planes of the mask. Returns false if the box is outside
+	/// a plane, and removes the planes the box is fully inside from the mask.
+	static bool cullBox( const Point3 & center, const Point3 & extents, const Plane * planes, unsigned int & planeMask );
+
+	/// Builds the height ranges of the chunks of every level, and their distance ranges (chunked LOD)
+	void setupChunks( TerrainSettings & settings );
+
+	/// Selects the chunks to draw within a chunk, from the distance of the camera. A chunk is drawn if its children
+	/// would all be drawn beyond their distance range, otherwise its children are selected. The chunks past the
+	/// terrain's edge are skipped.
+	void selectChunk( unsigned int level, unsigned int chunkX, unsigned int chunkZ, const Plane * planes, unsigned int planeMask );
+
 	/// Generates the vertex and index buffers
 	virtual bool createBuffers( SceneContext * context );
 
+	/// Rebuilds the quadtree of the patches with their world space boxes, if the terrain has moved
+	void updatePatchBounds();
+
+	/// Builds the quadtree node of a rectangle of patches [x0, x1) x [z0, z1) and its children. The box of
+	/// the patches, in the terrain's space, is returned. Returns the index of the node.
+	int buildQuadtree( unsigned int x0, unsigned int z0, unsigned int x1, unsigned int z1, Point3 & minimum, Point3 & maximum );
+
+	/// Culls a quadtree node against the frustum planes of the mask, and activates its visible patches. The planes
+	/// a node is fully inside aren't tested for its children, and nodes fully inside the frustum aren't descended.
+	void cullQuadtree( int node, const Plane * planes, unsigned int planeMask );
+
+	/// Activates every patch of a quadtree node
+	void activatePatches( int node );
+
+	/// Runs a job function over the active patches, split across the worker threads if a job system
+	/// is given. Returns once every patch has been processed.
+	void updateActivePatches( JobSystem * jobSystem, void (*function)( void * data, unsigned int begin, unsigned int end ) );
+
+	/// Runs a job function over the range [0, count), split across the worker threads if a job system is given
+	void runJobs( JobSystem * jobSystem, void (*function)( void * data, unsigned int begin, unsigned int end ), unsigned int count );
+
+	/// Job function which selects the tesselation level of a range of the active patches from their projected errors
+	static void SelectPatchLevels( void * data, unsigned int begin, unsigned int end );
+
+	/// Job function which tesselates a range of the active patches. A patch only writes to itself,
+	/// and only reads the tesselation levels its neighbors selected in SelectPatchLevels.
+	static void TesselatePatches( void * data, unsigned int begin, unsigned int end );
+
+	/// Job function which writes the grid vertices of a range of the selected chunks. The odd rows and columns
+	/// of a chunk's grid are morphed onto the grid of the next coarser level as the camera moves away.
+	static void MorphChunks( void * data, unsigned int begin, unsigned int end );
+
 	/// Renders all the terrain patches in a unified vertex buffer. This method assumed each patch as the same lod level.
 	virtual void renderUnified( SceneContext * context );
 
 	/// Renders the terrain in separater buffers. This method assuming each patch may have different lod's levels are require stitching.
+	/// Every patch keeps its full resolution vertices in a static vertex buffer, and is drawn with the index buffer of its
+	/// level and stitched borders, which are shared by all the patches. Nothing is written to the buffers once they're created.
 	virtual void renderSplit( SceneContext * context );
 
+	/// Renders the selected chunks of the chunked LOD. The chunks are morphed into a dynamic vertex buffer, and each
+	/// one is drawn with the full resolution grid of a patch, shared by all the chunks.
+	virtual void renderChunked( SceneContext * context );
+
+	/// Creates the static vertex buffer of a patch and the index buffer of a level and stitch combination, if they don't exist yet
+	bool createSplitBuffers( SceneContext * context, TerrainPatch * patch, unsigned int stitchIndex );
+
+	/// Creates the index buffer of a level and stitch combination, if it doesn't exist yet
+	bool createStitchBuffer( SceneContext * context, unsigned int stitchIndex );
+
+	/// Refines the levels of the active patches until the visible neighbors differ by one level at most,
+	/// since the stitched index lists only match a border to the next coarser level
+	void limitPatchTesselation();
+
 protected:
 
-	enum RenderMethod { RENDER_UNIFIED, RENDER_SPLIT };				/// Enumeration to determine whether the terrain is rendered in one vertex buffer,
-																	/// on in seperate buffers with separate lods.
+	enum RenderMethod { RENDER_UNIFIED, RENDER_SPLIT, RENDER_CHUNKED };	/// Enumeration to determine whether the terrain is rendered in one vertex buffer,
+																	/// on in seperate buffers with separate lods, or in chunks selected by distance.
 
 	bool						m_isInitialized;					/// Flags whether the terrain has been constructed/loaded successfully
 	std::vector<TerrainPatch*>	m_patches;							/// The collection of patches
@@ -99,13 +204,61 @@ protected:
 	unsigned int				m_patchSizeX, m_patchSizeZ;			/// Size of each individual patch in (X,Z) directions
 	unsigned int				m_worldHeight;						/// The height of the world
 	RenderMethod				m_renderMethod;						/// Method to render the terrain
-	std::list<TerrainPatch *>	m_activePatches;					/// List of active patches for rendering
+	std::vector<TerrainPatch *>	m_activePatches;					/// Active (visible) patches for rendering, kept contiguous so they can be split into ranges
+	unsigned int				m_patchBoundsRevision;				/// World revision of the terrain when the patch bounds were calculated
 	shared_ptr<VertexBuffer>	m_vb;								/// Vertex buffer used for rendering the terrain
 	shared_ptr<IndexBuffer>		m_ib;								/// Index buffer used for rendering the terrain
+	std::vector< std::vector<unsigned short> >	m_stitchIndices;	/// Triangle list indices of every level and stitch combination (split rendering)
+	std::vector< shared_ptr<IndexBuffer> >		m_stitchIBs;		/// Index buffers of the combinations, created when they're first drawn
+	std::vector<unsigned int>	m_activeStitches;					/// Level and stitch combination of every active patch
 	float						m_maximumScreenError;				/// This is the maximum allowable projected screen error for patch rendering
+	Matrix4						m_projectedErrorMatrix;				/// Projects the patch errors to the screen, computed during OnPreRender()
 
 	unsigned int				m_requiredPatchVertices, m_requiredPatchIndices;	/// Calculated during OnPreRender(), this is the number of 
 																					/// vertices and indices needed to render the terrain for this pass
+	unsigned int				m_triangleCount;					/// Number of triangles rendered in this pass
+
+	///
+	/// QuadtreeNode
+	/// A node of the quadtree over the patch grid. The children split the node's rectangle of patches
+	/// in halves along each axis (a child is missing if its half is empty), and the leaves hold one patch.
+	///
+	struct QuadtreeNode
+	{
+		Point3					center;								/// World space box of the node's patches
+		Point3					extents;
+		unsigned int			x0, z0, x1, z1;						/// Rectangle of patches [x0, x1) x [z0, z1)
+		int						children[4];						/// Index of the child nodes (-1 if not present)
+	};
+
+	std::vector<QuadtreeNode>	m_quadtree;							/// Nodes of the quadtree, the root is the first
+
+	shared_ptr<TerrainPager>	m_pager;							/// Loads the patches of a paged terrain (NULL if the terrain isn't paged)
+	float						m_pageDistance;						/// Patches within this distance of the camera are loaded
+	unsigned int				m_maxResidentPatches;				/// Number of loaded patches above which the least recently used are unloaded
+	unsigned int				m_pageFrame;						/// Incremented every time the pages are updated
+	std::vector<unsigned int>	m_tileStamps;						/// Page frame when every tile was last within the paging distance
+	std::vector<unsigned int>	m_residentTiles;					/// Tiles whose patches are loaded
+
+	///
+	/// Chunk
+	/// A square of patches drawn with a single grid (chunked LOD). The chunks of level n are 2^n patches wide,
+	/// so the grid's spacing is 2^n heights, and the chunk at (x, z) starts at the patch (x * 2^n, z * 2^n).
+	///
+	struct Chunk
+	{
+		unsigned int			level;
+		unsigned int			x, z;
+	};
+
+	shared_ptr<Heightfield>		m_heightmap;						/// The height map of the whole terrain (NULL if the terrain is paged)
+	unsigned int				m_chunkLevels;						/// Number of chunk levels. The chunk of the last level covers the terrain.
+	std::vector<float>			m_chunkRanges;						/// Distance from the camera within which the chunks of every level are split
+	std::vector< std::vector< std::pair<float, float> > >	m_chunkHeights;	/// Height range of the chunks of every level (the minimum
+																			/// is greater than the maximum if a chunk is past the terrain)
+	std::vector<Chunk>			m_selectedChunks;					/// Chunks to draw in this pass
+	Point3						m_chunkCamera;						/// Position of the camera in the terrain's space, for the morphing
+	TerrainVertex *				m_chunkVertices;					/// Vertex buffer data written by MorphChunks()
 };
 
 KIMPLEMENT_STREAM( Terrain );
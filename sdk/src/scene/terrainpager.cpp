@@ -0,0 +1,291 @@
+/*
+	Katana Engine
+	Copyright  2001-2004 Eric Bryant, Inc.
+
+	File:		terrainpager.cpp
+	Author:		Eric Bryant
+
+	Loads the patches of a paged terrain on a background thread. The height
+	map is split in tiles, one per patch, stored in a binary file which is
+	mapped into memory, so only the tiles around the camera are read.
+*/
+
+#include "katana_config.h"
+#include <algorithm>
+#include <string.h>
+#include "katana_core_includes.h"
+#include "katana_base_includes.h"
+#include "system/systemfile.h"
+#include "system/systemthread.h"
+#include "system/systemmappedfile.h"
+#include "render/rendertypes.h"
+#include "render/geometry.h"
+#include "render/heightfield.h"
+#include "visible.h"
+#include "visnode.h"
+#include "terrain.h"
+#include "terrainpatch.h"
+#include "terrainpager.h"
+using namespace Katana;
+
+//
+// Constructor
+//
+TerrainPager::TerrainPager() :
+	m_header( 0 ),
+	m_heightRanges( 0 ),
+	m_heights( 0 ),
+	m_terrain( 0 ),
+	m_stopping( false )
+{
+}
+
+//
+// Destructor
+//
+TerrainPager::~TerrainPager()
+{
+	close();
+}
+
+//
+// open
+//
+bool TerrainPager::open( const char * szFileName )
+{
+	close();
+
+	if ( !m_file.openFile( szFileName ) )
+	{
+		KLOG( "Unable to map the terrain tile file '%s'", szFileName );
+		return false;
+	}
+
+	// Validate the header, and that the file holds every tile
+	const TileFileHeader * header = reinterpret_cast<const TileFileHeader *>( m_file.getData() );
+	const unsigned int tileCount = m_file.getSize() >= sizeof(TileFileHeader) ? header->tilesX * header->tilesZ : 0;
+
+	if ( !tileCount || strncmp( header->magic, "KTTF", 4 ) != 0 || header->version != TILE_FILE_VERSION || header->tileSize < 2 ||
+		 m_file.getSize() < sizeof(TileFileHeader) + tileCount * ( 2 + header->tileSize * header->tileSize ) * sizeof(unsigned short) )
+	{
+		KLOG( "Invalid terrain tile file '%s'", szFileName );
+		m_file.closeFile();
+		return false;
+	}
+
+	m_header = header;
+	m_heightRanges = reinterpret_cast<const unsigned short *>( header + 1 );
+	m_heights = m_heightRanges + 2 * tileCount;
+
+	m_tileStates.assign( tileCount, TILE_IDLE );
+
+	return true;
+}
+
+//
+// start
+//
+bool TerrainPager::start( Terrain * terrain )
+{
+	if ( !isOpen() || m_thread.isRunning() )
+		return false;
+
+	m_terrain = terrain;
+	m_stopping = false;
+
+	return m_thread.start( LoadTiles, this );
+}
+
+//
+// close
+//
+void TerrainPager::close()
+{
+	// Stop the thread. It returns once it has finished the tile it's loading.
+	if ( m_thread.isRunning() )
+	{
+		m_mutex.lock();
+		m_stopping = true;
+		m_mutex.unlock();
+
+		m_semaphore.signal();
+		m_thread.join();
+	}
+
+	// The patches which weren't collected still belong to the pager
+	for( unsigned int i = 0; i < m_loaded.size(); i++ )
+		delete m_loaded[i].second;
+
+	m_loaded.clear();
+	m_requests.clear();
+	m_tileStates.clear();
+
+	m_file.closeFile();
+	m_header = 0;
+	m_heightRanges = 0;
+	m_heights = 0;
+	m_terrain = 0;
+}
+
+//
+// getHeightRange
+//
+void TerrainPager::getHeightRange( unsigned int tile, unsigned short & minimum, unsigned short & maximum ) const
+{
+	minimum = m_heightRanges[ tile * 2 ];
+	maximum = m_heightRanges[ tile * 2 + 1 ];
+}
+
+//
+// getTileHeights
+//
+const unsigned short * TerrainPager::getTileHeights( unsigned int tile ) const
+{
+	return m_heights + tile * m_header->tileSize * m_header->tileSize;
+}
+
+//
+// request
+//
+void TerrainPager::request( const vector<unsigned int> & tiles )
+{
+	SystemScopedLock lock( m_mutex );
+
+	// The requests are stored in reverse, so the most important tile is taken from the back
+	m_requests.clear();
+	for( unsigned int i = (unsigned int)tiles.size(); i > 0; i-- )
+		if ( m_tileStates[ tiles[i - 1] ] == TILE_IDLE )
+			m_requests.push_back( tiles[i - 1] );
+
+	if ( !m_requests.empty() )
+		m_semaphore.signal();
+}
+
+//
+// collect
+//
+void TerrainPager::collect( vector< pair<unsigned int, TerrainPatch *> > & patches )
+{
+	SystemScopedLock lock( m_mutex );
+
+	for( unsigned int i = 0; i < m_loaded.size(); i++ )
+	{
+		m_tileStates[ m_loaded[i].first ] = TILE_RESIDENT;
+		patches.push_back( m_loaded[i] );
+	}
+
+	m_loaded.clear();
+}
+
+//
+// release
+//
+void TerrainPager::release( unsigned int tile )
+{
+	SystemScopedLock lock( m_mutex );
+	m_tileStates[tile] = TILE_IDLE;
+}
+
+//
+// LoadTiles
+//
+void TerrainPager::LoadTiles( void * data )
+{
+	TerrainPager * pPager = reinterpret_cast<TerrainPager *>( data );
+
+	for( ;; )
+	{
+		pPager->m_semaphore.wait();
+
+		// Load the requests until there are none left. The terrain may replace them meanwhile.
+		for( ;; )
+		{
+			unsigned int tile;
+			{
+				SystemScopedLock lock( pPager->m_mutex );
+
+				if ( pPager->m_stopping )
+					return;
+				if ( pPager->m_requests.empty() )
+					break;
+
+				tile = pPager->m_requests.back();
+				pPager->m_requests.pop_back();
+				pPager->m_tileStates[tile] = TILE_LOADING;
+			}
+
+			// The tile file is only read, and the patch is only seen by this thread until it's collected
+			const unsigned int tilesX = pPager->m_header->tilesX;
+			TerrainPatch * patch = pPager->m_terrain->loadPatch( tile % tilesX, tile / tilesX );
+
+			SystemScopedLock lock( pPager->m_mutex );
+
+			if ( patch )
+			{
+				pPager->m_loaded.push_back( pair<unsigned int, TerrainPatch *>( tile, patch ) );
+				pPager->m_tileStates[tile] = TILE_LOADED;
+			}
+			else
+				pPager->m_tileStates[tile] = TILE_FAILED;
+		}
+	}
+}
+
+//
+// createTileFile
+//
+bool TerrainPager::createTileFile( const char * szFileName, const Heightfield & heightmap, unsigned int tileSize )
+{
+	if ( !heightmap.isValid() || tileSize < 2 ||
+		 ( heightmap.getWidth() - 1 ) % ( tileSize - 1 ) != 0 || ( heightmap.getHeight() - 1 ) % ( tileSize - 1 ) != 0 )
+	{
+		KLOG( "The height map can't be split into tiles of %d heights", tileSize );
+		return false;
+	}
+
+	TileFileHeader header;
+	memcpy( header.magic, "KTTF", 4 );
+	header.version = TILE_FILE_VERSION;
+	header.tilesX = ( heightmap.getWidth() - 1 ) / ( tileSize - 1 );
+	header.tilesZ = ( heightmap.getHeight() - 1 ) / ( tileSize - 1 );
+	header.tileSize = tileSize;
+
+	const unsigned int tileCount = header.tilesX * header.tilesZ;
+	vector<unsigned short> heightRanges( tileCount * 2 );
+	vector<unsigned short> heights( tileCount * tileSize * tileSize );
+
+	// Copy the heights of every tile, the rows of the largest Z first
+	unsigned short * pHeights = &heights[0];
+
+	for( unsigned int tile = 0; tile < tileCount; tile++ )
+	{
+		const unsigned int x0 = ( tile % header.tilesX ) * ( tileSize - 1 );
+		const unsigned int z0 = ( tile / header.tilesX ) * ( tileSize - 1 );
+		unsigned short minimum = 0xFFFF, maximum = 0;
+
+		for( unsigned int row = 0; row < tileSize; row++ )
+		{
+			for( unsigned int x = 0; x < tileSize; x++, pHeights++ )
+			{
+				*pHeights = heightmap.getHeightAt( x0 + x, z0 + tileSize - 1 - row );
+				if ( *pHeights < minimum ) minimum = *pHeights;
+				if ( *pHeights > maximum ) maximum = *pHeights;
+			}
+		}
+
+		heightRanges[ tile * 2 ] = minimum;
+		heightRanges[ tile * 2 + 1 ] = maximum;
+	}
+
+	SystemFile file( szFileName, READ_WRITE, BINARY_FILE );
+	if ( !file.isValid() ||
+		 !file.writeBytes( &header, sizeof(header) ) ||
+		 !file.writeBytes( &heightRanges[0], (int)( heightRanges.size() * sizeof(unsigned short) ) ) ||
+		 !file.writeBytes( &heights[0], (int)( heights.size() * sizeof(unsigned short) ) ) )
+	{
+		KLOG( "Unable to write the terrain tile file '%s'", szFileName );
+		return false;
+	}
+
+	return true;
+}
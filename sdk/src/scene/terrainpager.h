@@ -0,0 +1,149 @@
+/*
+	Katana Engine
+	Copyright  2001-2004 Eric Bryant, Inc.
+
+	File:		terrainpager.h
+	Author:		Eric Bryant
+
+	Loads the patches of a paged terrain on a background thread. The height
+	map is split in tiles, one per patch, stored in a binary file which is
+	mapped into memory, so only the tiles around the camera are read.
+*/
+
+#ifndef _TERRAINPAGER_H
+#define _TERRAINPAGER_H
+
+namespace Katana
+{
+
+//
+// Forward Declarations
+//
+class Terrain;
+class TerrainPatch;
+class Heightfield;
+
+///
+/// TerrainPager
+/// The terrain requests the tiles it needs every frame, nearest first. The pager's thread creates
+/// their patches through Terrain::loadPatch(), and the terrain collects them on its own thread.
+/// The terrain releases the tiles of the patches it unloads, so they may be requested again.
+///
+/// The tile file starts with a TileFileHeader, followed by the minimum and maximum height of every
+/// tile (two unsigned shorts), then by the heights of every tile. Tiles are stored row by row, and
+/// their heights are stored like the rows of a height map image (the largest Z first). Neighboring
+/// tiles share their border heights.
+///
+class TerrainPager
+{
+public:
+	enum
+	{
+		TILE_FILE_VERSION = 1,
+	};
+
+	///
+	/// TileFileHeader
+	///
+	struct TileFileHeader
+	{
+		char			magic[4];			/// "KTTF"
+		unsigned int	version;			/// TILE_FILE_VERSION
+		unsigned int	tilesX, tilesZ;		/// Number of tiles in the (X,Z) directions
+		unsigned int	tileSize;			/// Heights along each side of a tile
+	};
+
+public:
+	/// Constructor
+	TerrainPager();
+
+	/// Destructor (stops the thread)
+	~TerrainPager();
+
+	/// Maps the tile file. Returns false if it's missing or invalid.
+	bool open( const char * szFileName );
+
+	/// Starts the thread, which loads the requested tiles through the terrain
+	bool start( Terrain * terrain );
+
+	/// Stops the thread and unmaps the file. The patches which weren't collected are deleted.
+	void close();
+
+	/// Returns whether the tile file is mapped
+	bool isOpen() const													{ return m_header != 0; }
+
+	/// Returns the number of tiles in the X direction
+	unsigned int getTilesX() const										{ return m_header ? m_header->tilesX : 0; }
+
+	/// Returns the number of tiles in the Z direction
+	unsigned int getTilesZ() const										{ return m_header ? m_header->tilesZ : 0; }
+
+	/// Returns the number of heights along each side of a tile
+	unsigned int getTileSize() const									{ return m_header ? m_header->tileSize : 0; }
+
+	/// Returns the minimum and maximum height of a tile, without reading its heights
+	void getHeightRange( unsigned int tile, unsigned short & minimum, unsigned short & maximum ) const;
+
+	/// Returns the heights of a tile (tileSize x tileSize of them)
+	const unsigned short * getTileHeights( unsigned int tile ) const;
+
+	/// Replaces the tiles waiting to be loaded. The tiles are ordered by priority, the most important first.
+	/// Tiles which are loading, loaded or failed to load are ignored.
+	void request( const vector<unsigned int> & tiles );
+
+	/// Appends the tiles loaded since the last call, with their patches, to the list. The terrain
+	/// owns the patches from then on.
+	void collect( vector< pair<unsigned int, TerrainPatch *> > & patches );
+
+	/// Called when the terrain deletes the patch of a tile, so it may be requested again
+	void release( unsigned int tile );
+
+public:
+	/// Splits a height map into tiles of the given size and writes them into a tile file. The height map's
+	/// dimensions must be a multiple of the tile size minus one, plus one (e.g. 16 * n + 1 for tiles of 17).
+	static bool createTileFile( const char * szFileName, const Heightfield & heightmap, unsigned int tileSize );
+
+private:
+	/// Loading state of a tile
+	enum TileState { TILE_IDLE, TILE_LOADING, TILE_LOADED, TILE_RESIDENT, TILE_FAILED };
+
+	/// Non-copyable
+	TerrainPager( const TerrainPager & );
+	TerrainPager & operator=( const TerrainPager & );
+
+	/// Thread function which loads the requested tiles until the pager is closed
+	static void LoadTiles( void * data );
+
+private:
+	/// The mapped tile file, and the location of its parts
+	SystemMappedFile			m_file;
+	const TileFileHeader *		m_header;
+	const unsigned short *		m_heightRanges;
+	const unsigned short *		m_heights;
+
+	/// Terrain which creates the patches
+	Terrain *					m_terrain;
+
+	/// The thread, and the semaphore it waits on for requests
+	SystemThread				m_thread;
+	SystemSemaphore				m_semaphore;
+
+	/// Guards the members below, which are shared with the thread
+	SystemMutex					m_mutex;
+
+	/// Tiles waiting to be loaded, the next one is at the back
+	vector<unsigned int>		m_requests;
+
+	/// Loaded patches which weren't collected yet
+	vector< pair<unsigned int, TerrainPatch *> >	m_loaded;
+
+	/// State of every tile
+	vector<unsigned char>		m_tileStates;
+
+	/// Set when the thread must return
+	bool						m_stopping;
+};
+
+}; // Katana
+
+#endif // _TERRAINPAGER_H
@@ -8,26 +8,16 @@
 	Terrain Patch.
 */
 
-#include <vector>
-#include <map>
 #include <list>
 #include <algorithm>
 #include <math.h>
 #include <assert.h>
-#include "../base/kbase.h"
-#include "../base/rtti.h"
-#include "../base/refcount.h"
-#include "../base/streamable.h"
-#include "../base/karray.h"
-#include "../math/kmath.h"
-#include "../math/point.h"
-#include "../math/matrix.h"
-#include "../math/bound.h"
-#include "../math/quaternion.h"
-#include "../script/scriptengine.h"
-#include "../render/geometry.h"
-#include "../render/vertexbuffer.h"
-#include "../render/heightfield.h"
+#include "katana_core_includes.h"
+#include "katana_base_includes.h"
+#include "render/rendertypes.h"
+#include "render/geometry.h"
+#include "render/vertexbuffer.h"
+#include "render/heightfield.h"
 #include "visible.h"
 #include "visnode.h"
 #include "terrain.h"
@@ -52,11 +42,13 @@ TerrainPatch::TerrainPatch() :
 	m_topPatch( NULL ),
 	m_worldScale( Point3( 1, 1, 1 ) ),
 	m_active( true ),
+	m_visible( false ),
 	m_heightMapX( 0 ),
 	m_heightMapZ( 0 ),
 	m_initBuffers( false ),
 	m_currentError( -1 ),
 	m_minHeightY( 0 ),
+	m_maxHeightY( 0 ),
 	m_newVertexCount( 0 ),
 	m_newIndexCount( 0 )
 {
@@ -79,11 +71,13 @@ TerrainPatch::TerrainPatch( Terrain * parentTerrain, unsigned int indexX, unsign
 	m_topPatch( NULL ),
 	m_worldScale( Point3( 1, 1, 1 ) ),
 	m_active( true ),
+	m_visible( false ),
 	m_heightMapX( 0 ),
 	m_heightMapZ( 0 ),
 	m_initBuffers( false ),
 	m_currentError( -1 ),
 	m_minHeightY( 0 ),
+	m_maxHeightY( 0 ),
 	m_newVertexCount( 0 ),
 	m_newIndexCount( 0 )
 {
@@ -99,9 +93,9 @@ TerrainPatch::TerrainPatch( Terrain * parentTerrain, unsigned int indexX, unsign
 //
 // setHeightMap
 //
-void TerrainPatch::setHeightMap( Heightfield & heightmap, unsigned int posX, unsigned posZ )
+void TerrainPatch::setHeightMap( shared_ptr<Heightfield> heightmap, unsigned int posX, unsigned posZ )
 {
-	m_heightmap = &heightmap;
+	m_heightmap = heightmap;
 	m_heightMapX = posX;
 	m_heightMapZ = posZ;
 }
@@ -120,17 +114,37 @@ void TerrainPatch::calculateErrors()
 //
 void TerrainPatch::calculateMinMaxY()
 {
+	if ( !m_heightmap ) return;
+
+	// Use the scaled heights of the rendered vertices, so the range bounds the patch
+	m_minHeightY = m_maxHeightY = getHeight( 0, 0 );
+
 	for( int px = 0; px < PATCH_VERTEX_WIDTH; px++ )
 	{
 		for( int pz = 0; pz < PATCH_VERTEX_HEIGHT; pz++ )
 		{
-			Point3 vertex = getVertex( px, pz );
-			if ( vertex.y < m_minHeightY ) m_minHeightY = vertex.y;
-			if ( vertex.y > m_maxHeightY ) m_maxHeightY = vertex.y;
+			const float height = getHeight( px, pz );
+			if ( height < m_minHeightY ) m_minHeightY = height;
+			if ( height > m_maxHeightY ) m_maxHeightY = height;
 		}
 	}
 }
 
+//
+// calculateBound
+//
+void TerrainPatch::calculateBound()
+{
+	if ( !m_heightmap ) return;
+
+	Point3 vertices[MAXIMUM_VERTICES];
+	for( int pz = 0; pz < PATCH_VERTEX_HEIGHT; pz++ )
+		for( int px = 0; px < PATCH_VERTEX_WIDTH; px++ )
+			getVertex( px, pz, vertices[ pz * PATCH_VERTEX_WIDTH + px ] );
+
+	m_bound.fit( vertices, MAXIMUM_VERTICES );
+}
+
 //
 // setNeighbors
 //
@@ -148,7 +162,7 @@ void TerrainPatch::setNeighbors( TerrainPatch * left, TerrainPatch * right, Terr
 Point3 TerrainPatch::getVertex( int positionX, int positionZ )
 {
 	// Check whether we have a valid heightmap for the operation
-	if ( !m_heightmap.isValid() ) return Point3();
+	if ( !m_heightmap ) return Point3();
 
 	return Point3(	(float)positionX,
 					(float)m_heightmap->getHeightAt( m_heightMapX + positionX, m_heightMapZ + positionZ ),
@@ -312,6 +326,112 @@ bool TerrainPatch::updateTesselation()
 	return tesselation;
 }
 
+//
+// createStaticVertices
+//
+void TerrainPatch::createStaticVertices( TerrainVertex * pData ) const
+{
+	for( int pz = 0; pz < PATCH_VERTEX_HEIGHT; pz++ )
+	{
+		for( int px = 0; px < PATCH_VERTEX_WIDTH; px++, pData++ )
+		{
+			getVertex( px, pz, pData->position );
+			getTexCoord( px, pz, pData->texture );
+		}
+	}
+}
+
+//
+// limitTesselation
+//
+bool TerrainPatch::limitTesselation()
+{
+	TerrainPatch * neighbors[4] = { m_leftPatch, m_rightPatch, m_bottomPatch, m_topPatch };
+	bool changed = false;
+
+	for( int i = 0; i < 4; i++ )
+	{
+		if ( neighbors[i] && neighbors[i]->isVisible() && m_newTesselation > neighbors[i]->getNewTesselation() + 1 )
+		{
+			m_newTesselation = neighbors[i]->getNewTesselation() + 1;
+			changed = true;
+		}
+	}
+
+	return changed;
+}
+
+//
+// getStitchMask
+//
+unsigned int TerrainPatch::getStitchMask() const
+{
+	TerrainPatch * neighbors[4] = { m_leftPatch, m_rightPatch, m_bottomPatch, m_topPatch };
+	unsigned int stitchMask = 0;
+
+	for( int i = 0; i < 4; i++ )
+		if ( neighbors[i] && neighbors[i]->isVisible() && neighbors[i]->getNewTesselation() > m_newTesselation )
+			stitchMask |= ( STITCH_LEFT << i );
+
+	return stitchMask;
+}
+
+//
+// createStitchIndices
+// The patch is split into quads of the tesselation's size. The odd vertices of a stitched border
+// are collapsed onto the next vertex along the border (towards the bottom left corner on the
+// left and bottom borders, towards the top right on the others), and the triangles which become
+// degenerate are dropped. The border then only has the vertices of the coarser neighbor.
+//
+void TerrainPatch::createStitchIndices( int tesselation, unsigned int stitchMask, vector<unsigned short> & indices )
+{
+	const int power = kmath::powerOf2( tesselation );
+
+	// The coarsest tesselation has no odd border vertices
+	if ( power >= PATCH_VERTEX_WIDTH - 1 )
+		stitchMask = 0;
+
+	indices.clear();
+	indices.reserve( ( PATCH_VERTEX_WIDTH - 1 ) / power * ( PATCH_VERTEX_HEIGHT - 1 ) / power * 6 );
+
+	for( int z = 0; z < PATCH_VERTEX_HEIGHT - 1; z += power )
+	{
+		for( int x = 0; x < PATCH_VERTEX_WIDTH - 1; x += power )
+		{
+			// Corners of the quad, with the stitched vertices collapsed
+			unsigned short corners[4];
+			const int cornerX[4] = { x, x, x + power, x + power };
+			const int cornerZ[4] = { z, z + power, z, z + power };
+
+			for( int i = 0; i < 4; i++ )
+			{
+				int cx = cornerX[i], cz = cornerZ[i];
+
+				if		( ( stitchMask & STITCH_BOTTOM ) && cz == 0 && ( cx / power ) & 1 )							cx -= power;
+				else if ( ( stitchMask & STITCH_TOP ) && cz == PATCH_VERTEX_HEIGHT - 1 && ( cx / power ) & 1 )		cx += power;
+				else if ( ( stitchMask & STITCH_LEFT ) && cx == 0 && ( cz / power ) & 1 )							cz -= power;
+				else if ( ( stitchMask & STITCH_RIGHT ) && cx == PATCH_VERTEX_WIDTH - 1 && ( cz / power ) & 1 )	cz += power;
+
+				corners[i] = (unsigned short)( cx + cz * PATCH_VERTEX_WIDTH );
+			}
+
+			// Two triangles, wound the same way as the tesselated strips
+			const int triangles[2][3] = { { 0, 1, 2 }, { 2, 1, 3 } };
+
+			for( int t = 0; t < 2; t++ )
+			{
+				const unsigned short a = corners[ triangles[t][0] ], b = corners[ triangles[t][1] ], c = corners[ triangles[t][2] ];
+				if ( a == b || b == c || a == c )
+					continue;
+
+				indices.push_back( a );
+				indices.push_back( b );
+				indices.push_back( c );
+			}
+		}
+	}
+}
+
 // -------------------------------------------------------
 // TESSELATION METHODS
 // -------------------------------------------------------
@@ -902,7 +1022,7 @@ float TerrainPatch::getHeight( int nX, int nZ ) const
 {
 	assert( nX >= 0 && nX < PATCH_VERTEX_WIDTH );
 	assert( nZ >= 0 && nZ < PATCH_VERTEX_HEIGHT );
-	assert( m_heightmap.isValid() );
+	assert( m_heightmap );
 
 	return m_worldTranslation.y + m_worldScale.y * 
 			m_heightmap->getHeightAt( 
@@ -929,7 +1049,7 @@ void TerrainPatch::getTexCoord( int nX, int nZ, Point2 & tcoord ) const
 {
 	assert( nX >= 0 && nX < PATCH_VERTEX_WIDTH );
 	assert( nZ >= 0 && nZ < PATCH_VERTEX_HEIGHT );
-	assert( m_heightmap.isValid() );
+	assert( m_heightmap );
 
 	tcoord.x = (float) ( m_heightMapX + nX ) / (float)( m_heightmap->getWidth()- 1 );	
 	tcoord.y = (float) m_heightmap->getHeight() - 1 - ( m_heightMapZ + nZ ) / (float)( m_heightmap->getHeight() - 1 );
@@ -942,7 +1062,7 @@ void TerrainPatch::getNormal(int nX, int nZ, Point3 & normal) const
 {
 	assert( nX >= 0 && nX < PATCH_VERTEX_WIDTH );
 	assert( nZ >= 0 && nZ < PATCH_VERTEX_HEIGHT );
-	assert( m_heightmap.isValid() );
+	assert( m_heightmap );
 
 	normal = m_heightmap->getNormalAt( m_heightMapX + nX, m_heightMapZ + nZ );
 }
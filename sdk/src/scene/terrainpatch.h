@@ -18,6 +18,7 @@ namespace Katana
 //
 class Heightfield;
 class Terrain;
+class VertexBuffer;
 
 ///
 /// TerrainVertex
@@ -54,6 +55,14 @@ public:
 		MAXIMUM_VERTICES = PATCH_VERTEX_WIDTH * PATCH_VERTEX_HEIGHT,
 		MAXIMUM_INDICES = MAXIMUM_VERTICES * 3,
 	};
+	enum
+	{
+		STITCH_LEFT = 1,				/// Borders which are matched to a coarser neighbor by the stitched index lists
+		STITCH_RIGHT = 2,
+		STITCH_BOTTOM = 4,
+		STITCH_TOP = 8,
+		STITCH_COMBINATIONS = 16,
+	};
 public: 
 	/// Constructor
 	TerrainPatch();
@@ -62,7 +71,7 @@ public:
 	TerrainPatch( Terrain * parentTerrain, unsigned int indexX, unsigned int indexZ );
 
 	/// Store the source heightmap with an offset
-	void setHeightMap( Heightfield & heightmap, unsigned int posX, unsigned posZ );
+	void setHeightMap( shared_ptr<Heightfield> heightmap, unsigned int posX, unsigned posZ );
 
 	/// Store the scale of the patch in world coordinates
 	void setScale( const Point3 & scale )												{ m_worldScale = scale; }
@@ -79,6 +88,18 @@ public:
 	/// Calculate the minimum and maximum Y coordinates
 	void calculateMinMaxY();
 
+	/// Returns the minimum Y coordinate of the patch's vertices (in the terrain's space)
+	float getMinimumHeight() const														{ return m_minHeightY; }
+
+	/// Returns the maximum Y coordinate of the patch's vertices (in the terrain's space)
+	float getMaximumHeight() const														{ return m_maxHeightY; }
+
+	/// Fits the bounding sphere to the full resolution vertices of the patch
+	void calculateBound();
+
+	/// Returns the bounding sphere of the patch (in the terrain's space)
+	const Bound & getBound() const														{ return m_bound; }
+
 	/// Setup the neighboring relation between this patch
 	void setNeighbors( TerrainPatch * left, TerrainPatch * right, TerrainPatch * bottom, TerrainPatch * top );
 
@@ -88,6 +109,10 @@ public:
 	/// Retrieve the indices for this patch
 	vector<unsigned short>& getPatchIndices()											{ return m_patchIndices; }
 
+	/// Sets whether the patch is visible. Only visible patches are tesselated, so the neighbors of
+	/// a patch use its current tesselation instead of the new one if it isn't.
+	void setVisible( bool visible )														{ m_visible = visible; }
+
 	/// Returns whether the patch is visible
 	bool isVisible() const																{ return m_visible; }
 
@@ -120,17 +145,32 @@ public:
 	/// Updates the tesselation by filling in the vertex and index buffers
 	virtual bool updateTesselation();
 
-	/// Patches may need additional update passes to adapt to neighbors. This is because our
-	/// tesselation may depend on the tesselation of our neighboring patches.
-	virtual bool updateTesselation2()													{ return false; }
-	virtual bool updateTesselation3()													{ return false; }
-
 	// Update the projected screen errors
 	void updateProjectedErrors( const Matrix4 & screenProjection );
 	
 	// Retrieve the projected error for a given subdivision level
 	float getProjectedError( int tess )													{ return m_errors[tess].difference; }
 
+	/// Fills in the full resolution vertices of the patch, row by row (MAXIMUM_VERTICES of them)
+	void createStaticVertices( TerrainVertex * pData ) const;
+
+	/// Sets the static vertex buffer which holds the full resolution vertices of the patch
+	void setStaticVB( shared_ptr<VertexBuffer> vb )										{ m_staticVB = vb; }
+
+	/// Returns the static vertex buffer of the patch (null until it's created by the terrain)
+	shared_ptr<VertexBuffer> getStaticVB() const										{ return m_staticVB; }
+
+	/// Refines the new tesselation so it's at most one level coarser than the visible neighbors.
+	/// Returns true if the tesselation was changed.
+	bool limitTesselation();
+
+	/// Returns the borders which must be stitched to a visible neighbor with a coarser new tesselation
+	unsigned int getStitchMask() const;
+
+	/// Creates the triangle list indices of a tesselation, into the full resolution vertices of a patch. The
+	/// borders in the stitch mask are matched to the next coarser tesselation.
+	static void createStitchIndices( int tesselation, unsigned int stitchMask, vector<unsigned short> & indices );
+
 protected:
 
 	/// Retrieves the vertex at the given position within the height map
@@ -186,6 +226,9 @@ protected:
 	/// The minimum and maximum Y values in the heightmap
 	float					m_minHeightY, m_maxHeightY;
 
+	/// Bounding sphere of the full resolution vertices (in the terrain's space)
+	Bound					m_bound;
+
 	/// Neighboring patch information
 	TerrainPatch *			m_leftPatch, * m_rightPatch, * m_bottomPatch, * m_topPatch;
 
@@ -228,6 +271,9 @@ protected:
 	/// Array of terrain patch indices and index mapping
 	vector<unsigned short>	m_patchIndices;
 	vector<unsigned short>	m_patchIndexMap;
+
+	/// Full resolution vertices of the patch, for split rendering
+	shared_ptr<VertexBuffer> m_staticVB;
 };
 
 KIMPLEMENT_STREAM( TerrainPatch );
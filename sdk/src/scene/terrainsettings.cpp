@@ -8,33 +8,45 @@
 	Structure which holds the initalization settings of the terrain engine construction
 */
 
-#include <vector>
-#include "../base/refcount.h"
-#include "../base/kstring.h"
-#include "../system/systemxml.h"
+#include "katana_core_includes.h"
+#include "katana_base_includes.h"
+#include "system/systemxml.h"
 #include "terrainsettings.h"
 using namespace Katana;
 
 //
 // Local Functions
 //
-TerrainSettings::BlendType convertStringToBlendType( const kstring & str );
+TerrainSettings::BlendType convertStringToBlendType( const string & str );
+TerrainSettings::LODType convertStringToLODType( const string & str );
 
 //
 // Constructor
 //
-TerrainSettings::TerrainSettings()
+TerrainSettings::TerrainSettings() :
+	lodType( GEOMIPMAP ),
+	lodDistance( DEFAULT_LOD_DISTANCE ),
+	pageDistance( DEFAULT_PAGE_DISTANCE ),
+	maxResidentPatches( DEFAULT_RESIDENT_PATCHES )
 {
 }
 
 TerrainSettings::TerrainSettings( const char * szSettingsFile ) :
-	settingsFile( szSettingsFile )
+	settingsFile( szSettingsFile ),
+	lodType( GEOMIPMAP ),
+	lodDistance( DEFAULT_LOD_DISTANCE ),
+	pageDistance( DEFAULT_PAGE_DISTANCE ),
+	maxResidentPatches( DEFAULT_RESIDENT_PATCHES )
 {
 	loadSettings( szSettingsFile );
 }
 
 TerrainSettings::TerrainSettings( const char * szHeightMapFile, unsigned int wWidth, unsigned int wHeight  ) :
-	worldWidth( wWidth ), worldHeight( wHeight )
+	worldWidth( wWidth ), worldHeight( wHeight ),
+	lodType( GEOMIPMAP ),
+	lodDistance( DEFAULT_LOD_DISTANCE ),
+	pageDistance( DEFAULT_PAGE_DISTANCE ),
+	maxResidentPatches( DEFAULT_RESIDENT_PATCHES )
 {
 	heightMapFileName = szHeightMapFile;
 }
@@ -45,9 +57,9 @@ TerrainSettings::TerrainSettings( const char * szHeightMapFile, unsigned int wWi
 bool TerrainSettings::loadSettings( const char * szSettingsFile )
 {
 	// Load the settings from the XML File
-	m_settingsFile = new SystemXML( szSettingsFile );
+	m_settingsFile.reset( new SystemXML( szSettingsFile ) );
 
-	if ( !m_settingsFile.isValid() )
+	if ( !m_settingsFile )
 		return false;
 
 	// Initialize the terrain settings
@@ -60,11 +72,20 @@ bool TerrainSettings::loadSettings( const char * szSettingsFile )
 				worldHeight = size.getAttributeInteger( "height" );
 				worldDepth = size.getAttributeInteger( "depth" );
 			XML_Node lod = map.getNode( "lod" );
-				lodType = GEOMIPMAP; // TODO: This is the only lod type supported
+				lodType = convertStringToLODType( lod.getAttributeString( "type" ) );
 				blendType = convertStringToBlendType( lod.getAttributeString( "blend" ) );
 				maxScreenError  = lod.getAttributeFloat( "error" );
+				if ( lodType == CDLOD )
+					lodDistance = lod.getAttributeFloat( "distance" );
 			XML_Node pvs = map.getNode( "pvs" );
-				pvsFileName = pvs.getAttributeString( "file" );
+				pvsFileName = pvs.getAttributeString( "file" ).c_str();
+			XML_Node paging = map.getNode( "paging" );
+				tileFileName = paging.getAttributeString( "file" );
+				if ( !tileFileName.empty() )
+				{
+					pageDistance = paging.getAttributeFloat( "distance" );
+					maxResidentPatches = paging.getAttributeInteger( "patches" );
+				}
 		XML_Node textures = terrain.getNode( "textures" );
 			maxTextureLayers = textures.getAttributeInteger( "layers" );
 
@@ -74,8 +95,8 @@ bool TerrainSettings::loadSettings( const char * szSettingsFile )
 				 index++, nodeid.format( "layer-%d", index ) )
 			{
 				XML_Node layer = textures.getNode( nodeid );
-				textureLayers.push_back( TerrainSettings::TextureLayer( layer.getAttributeString( "file" ),
-																		layer.getAttributeString( "bump" ),
+				textureLayers.push_back( TerrainSettings::TextureLayer( layer.getAttributeString( "file" ).c_str(),
+																		layer.getAttributeString( "bump" ).c_str(),
 																		layer.getAttributeInteger( "repeat" ) ) );
 			}
 
@@ -85,7 +106,7 @@ bool TerrainSettings::loadSettings( const char * szSettingsFile )
 //
 //
 //
-TerrainSettings::BlendType convertStringToBlendType( const kstring & str )
+TerrainSettings::BlendType convertStringToBlendType( const string & str )
 {
 	if ( str == "UNIFIED" )
 		return TerrainSettings::BLEND_UNIFIED;
@@ -97,4 +118,15 @@ TerrainSettings::BlendType convertStringToBlendType( const kstring & str )
 		return TerrainSettings::BLEND_HW;
 
 	return TerrainSettings::BLEND_UNIFIED;
-}
\ No newline at end of file
+}
+
+//
+//
+//
+TerrainSettings::LODType convertStringToLODType( const string & str )
+{
+	if ( str == "CDLOD" )
+		return TerrainSettings::CDLOD;
+
+	return TerrainSettings::GEOMIPMAP;
+}
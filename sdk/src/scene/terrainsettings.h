@@ -28,6 +28,7 @@ public:
 	enum LODType
 	{
 		GEOMIPMAP,
+		CDLOD,
 	};
 	enum BlendType
 	{
@@ -45,6 +46,12 @@ public:
 		std::string	bumpTexture;
 		int			nRepeat;
 	};
+	enum
+	{
+		DEFAULT_PAGE_DISTANCE = 4096,		/// Default paging parameters
+		DEFAULT_RESIDENT_PATCHES = 1024,
+		DEFAULT_LOD_DISTANCE = 512,			/// Default distance of the finest chunks (CDLOD)
+	};
 public:
 	/// Constructor
 	TerrainSettings();
@@ -66,11 +73,18 @@ public:
 	unsigned int				worldWidth;			/// The absolute width (X) of the world in world units
 	unsigned int				worldHeight;		/// The absolute height (Y) of the world in world units
 	unsigned int				worldDepth;			/// The absolute depth (Z) of the world in world units
-	LODType						lodType;			/// Lod algorithm to use for the terrain (currently only geomipmapping is supported)
-	BlendType					blendType;			/// Determines how to blend between different LOD versions of the terrain
-	float						maxScreenError;		/// The tolerance for the screen error when determining terrain lod
+	LODType						lodType;			/// Lod algorithm to use for the terrain (geomipmapping, or chunks selected by distance)
+	BlendType					blendType;			/// Determines how to blend between different LOD versions of the terrain (geomipmapping)
+	float						maxScreenError;		/// The tolerance for the screen error when determining terrain lod (geomipmapping)
+	float						lodDistance;		/// Chunks of a single patch are drawn within this distance of the camera. Each coarser
+													/// level of chunks is drawn within twice the distance of the previous one (CDLOD)
 	unsigned int				maxTextureLayers;	/// Maximum number of texture passes
 	std::vector<TextureLayer>	textureLayers;		/// Texture pass layers
+	std::string					tileFileName;		/// Tiled height map file (see TerrainPager) of a paged terrain. If it's set, the
+													/// patches are loaded around the camera instead of from the height map file.
+	float						pageDistance;		/// Patches within this distance of the camera are kept loaded (paged terrain)
+	unsigned int				maxResidentPatches;	/// Patches beyond the distance are unloaded, least recently used first, when more
+													/// than this number are loaded (paged terrain)
 
 protected:
 	shared_ptr<SystemXML> m_settingsFile;	/// Internal settings file used to load and save the terrain configuration
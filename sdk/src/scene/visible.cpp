@@ -26,6 +26,7 @@
 #include "visible.h"
 #include "visnode.h"
 #include "camera.h"
+#include "spatialindex.h"
 
 //
 // RTTI declaration
@@ -38,12 +39,26 @@ KIMPLEMENT_RTTI( Visible, Streamable );
 Visible::Visible() 
 	: m_isVisible( true )
 	, m_isDirty( true )
+	, m_isNode( false )
 	, m_frameCount( 0 )
 	, m_renderPass( 0 )
 	, m_scale( 1 )
+	, m_worldRevision( 0 )
+	, m_parentRevision( 0 )
+	, m_worldViewRevision( 0 )
+	, m_viewRevision( 0 )
+	, m_isBoundDirty( true )
+	, m_cullPlaneMask( FRUSTUM_PLANE_MASK_ALL )
+	, m_lastCullPlane( 0 )
+	, m_cullVolume( CULL_SPHERE )
 	, m_isShadowCaster( false )
 	, m_isBillboard( false )
+	, m_isOccluder( false )
+	, m_spatialIndex( 0 )
+	, m_spatialEntry( SpatialIndex::NO_ENTRY )
+	, m_spatialMoved( 0 )
 {
+	m_worldMatrix.setIdentity();
 	m_worldViewMatrix.setIdentity();
 }
 
@@ -51,15 +66,38 @@ Visible::Visible( shared_ptr<VisNode> parent)
 	: m_parent( parent )
 	, m_isVisible( true )
 	, m_isDirty( true )
+	, m_isNode( false )
 	, m_frameCount( 0 )
 	, m_renderPass( 0 )
 	, m_scale( 1 )
+	, m_worldRevision( 0 )
+	, m_parentRevision( 0 )
+	, m_worldViewRevision( 0 )
+	, m_viewRevision( 0 )
+	, m_isBoundDirty( true )
+	, m_cullPlaneMask( FRUSTUM_PLANE_MASK_ALL )
+	, m_lastCullPlane( 0 )
+	, m_cullVolume( CULL_SPHERE )
 	, m_isShadowCaster( false )
 	, m_isBillboard( false )
+	, m_isOccluder( false )
+	, m_spatialIndex( 0 )
+	, m_spatialEntry( SpatialIndex::NO_ENTRY )
+	, m_spatialMoved( 0 )
 {
+	m_worldMatrix.setIdentity();
 	m_worldViewMatrix.setIdentity();
 }
 
+//
+// Destructor
+//
+Visible::~Visible()
+{
+	if ( m_spatialIndex )
+		m_spatialIndex->remove( this );
+}
+
 //
 // setTransform
 //
@@ -68,7 +106,46 @@ void Visible::setTransform(const Point3 & trans, const Quaternion & rot)
 	// Store the new translation, rotation
 	m_translation = trans;
 	m_rotation = rot;
+	setDirty();
+}
+
+//
+// setVisible
+//
+void Visible::setVisible(bool bOn)
+{
+	if ( m_isVisible == bOn )
+		return;
+
+	m_isVisible = bOn;
+
+	// The spatial index doesn't hold the subtrees of the hidden nodes, so the node is inserted again
+	if ( m_spatialIndex && m_isNode )
+		m_spatialIndex->insert( this );
+}
+
+//
+// setDirty
+//
+void Visible::setDirty()
+{
 	m_isDirty = true;
+
+	// The world bounds are only updated when the object is rendered, so the index must
+	// update them itself in case the object moves into the frustum
+	if ( m_spatialIndex )
+		m_spatialIndex->markMoved( this );
+}
+
+//
+// setBoundDirty
+//
+void Visible::setBoundDirty()
+{
+	m_isBoundDirty = true;
+
+	if ( m_spatialIndex )
+		m_spatialIndex->markMoved( this );
 }
 
 //
@@ -97,7 +174,7 @@ bool Visible::OnUpdate( SceneContext * context )
 	{
 		m_translation	= m_spRigidBody->getPosition();
 		m_rotation		= m_spRigidBody->getRotation();
-		m_isDirty		= true;
+		setDirty();
 	}
 	// Otherwise, if we have an animation tell it to advance the animation
 	// forward and apply the resultant keyframe to our position, orientation
@@ -105,7 +182,8 @@ bool Visible::OnUpdate( SceneContext * context )
 	{
 		// The advance function will return TRUE if there was a 
 		// positional/rotational change, or false otherwise
-		m_isDirty = m_animation->advance( context->deltaTime, m_translation, m_rotation );
+		if ( m_animation->advance( context->deltaTime, m_translation, m_rotation ) )
+			setDirty();
 	}
 
 	// If the visible object is billboarded, then orientate it towards the camera
@@ -146,84 +224,168 @@ bool Visible::OnPreRender(SceneContext * context)
 		return false;
 */
 
-	// Only recalculate the world view matrix if we're dirty
-	if ( m_isDirty || ( !m_parent.expired() && m_parent.lock()->isDirty() ) || context->currentCamera->isDirty() )
-	{
-		// If we have a parent, transform our WTM relative to our parent's
-		if ( !m_parent.expired() )
-		{
-			// Get the parent
-			shared_ptr<VisNode> spParent = m_parent.lock();
-
-			// Multiply this World View Matrix by the parent's matrix
-			// to get the concatenated version
-			Matrix4 parentRotationMatrix;
-			spParent->getRotation().toMatrix( parentRotationMatrix );
-			Matrix4 localRotationMatrix;
-			m_rotation.toMatrix( localRotationMatrix );
-
-			m_worldViewMatrix = parentRotationMatrix.transpose() * localRotationMatrix;
-			m_worldViewMatrix.pos = spParent->m_worldViewMatrix.pos + 
-				( m_translation * spParent->m_worldViewMatrix );
-		}
-		// Otherwise store our translation and rotation in the WTM
-		else
-		{
-			// Store the rotation matrix
-			m_rotation.toMatrix( m_worldViewMatrix );
-
-			// Add the translation to the matrix
-			m_worldViewMatrix.pos = m_translation;
-
-			// Apply the uniform local scale to the matrix
-			// TODO: Currently, the scale skews the rotation, we're figure it out and fix it later.
-			//		m_worldViewMatrix.m[0][0] = m_scale;
-			//		m_worldViewMatrix.m[1][1] = m_scale;
-			//		m_worldViewMatrix.m[2][2] = m_scale;
-		}
-
-		// Now that this object is in world space, transform it into
-		// view (camera) space.
-		m_worldViewMatrix *= context->currentCamera->getWorldMatrix();
-
-		// Update the world bounds, which is basically the local bounds
-		// transformed by our world matrix
-		m_worldBound = m_localBound;
-		m_worldBound.transform( m_worldViewMatrix );
-
-		// If this Visible Object has a light associated with it,
-		// update it's position with our world position
-		if ( m_light ) {
-			m_light->setPosition( m_worldViewMatrix.pos );
-
-			// Also, if necessary, enlarge the radius of the world bounds
-			// to incorporate the light range. This is because the light
-			// will not affect the scene if this object is culled out.
-			if ( m_worldBound.getRadius() < m_light->getRange() )
-				m_worldBound.m_radius += m_light->getRange();
-		}
-	}
+	// Only recalculate the world matrix and bounds if we (or an ancestor) have moved.
+	// Camera motion doesn't affect them, because the culling is done in world space.
+	updateWorldTransform();
+
+	// The light's position is kept in view space, so it must be updated
+	// even if this object is culled
+	if ( m_light )
+		updateWorldViewTransform( context );
+
+	// The scene graph may have already culled our bounds along with our siblings
+	if ( context->currentPlaneMask & FRUSTUM_PLANE_MASK_CULLED )
+		return false;
 
-	// Perform frustum intersection culling. This must be done after the world bounds has been transformed
+	// Perform frustum intersection culling. This must be done after the world bounds has been transformed.
+	// Only the planes our parent intersects are tested, if there are none left we're fully visible.
+	m_cullPlaneMask = context->currentPlaneMask & FRUSTUM_PLANE_MASK_ALL;
 	if ( context->debugOutput->getEnableFrustumCulling() && 
 		 m_worldBound.getRadius() &&							// If this visible object's radius is 0, assume it is always visible
-		 !context->currentCamera->Cull( m_worldBound ) )
+		 m_cullPlaneMask &&
+		 !( context->currentPlaneMask & FRUSTUM_PLANE_MASK_TESTED ) &&
+		 !context->currentCamera->Cull( m_worldBound, m_cullPlaneMask, m_lastCullPlane ) )
+		return false;
+
+	// Long thin objects have a loose bounding sphere, so the oriented box is tested against
+	// the planes the sphere intersects. Objects with a light are skipped, because only their
+	// sphere is enlarged to cover the light range.
+	if ( m_cullVolume == CULL_ORIENTED_BOX &&
+		 context->debugOutput->getEnableFrustumCulling() &&
+		 m_cullPlaneMask &&
+		 m_worldBox.isValid() &&
+		 !m_light &&
+		 !context->currentCamera->Cull( m_worldBox, m_cullPlaneMask, m_lastCullPlane ) )
 		return false;
 
+	// Now that we know the object is visible, transform it into view (camera) space
+	updateWorldViewTransform( context );
+
 	// Store our frame index
 	m_frameCount = context->frameCount;
 
 	return true;
 }
 
+//
+// updateWorldTransform
+//
+bool Visible::updateWorldTransform()
+{
+	shared_ptr<VisNode> spParent = m_parent.lock();
+
+	// Only recalculate the world matrix if we're dirty or our parent has moved
+	if ( !m_isDirty && ( !spParent || spParent->m_worldRevision == m_parentRevision ) )
+	{
+		// The local bounds may have changed without moving the object
+		if ( m_isBoundDirty ) updateWorldBound();
+		return false;
+	}
+
+	// If we have a parent, transform our WTM relative to our parent's
+	if ( spParent )
+	{
+		// Multiply this World Matrix by the parent's matrix
+		// to get the concatenated version
+		Matrix4 parentRotationMatrix;
+		spParent->getRotation().toMatrix( parentRotationMatrix );
+		Matrix4 localRotationMatrix;
+		m_rotation.toMatrix( localRotationMatrix );
+
+		m_worldMatrix = parentRotationMatrix.transpose() * localRotationMatrix;
+		m_worldMatrix.pos = spParent->m_worldMatrix.pos + 
+			( m_translation * spParent->m_worldMatrix );
+
+		// Remember which version of our parent's matrix we're relative to
+		m_parentRevision = spParent->m_worldRevision;
+	}
+	// Otherwise store our translation and rotation in the WTM
+	else
+	{
+		// Store the rotation matrix
+		m_rotation.toMatrix( m_worldMatrix );
+
+		// Add the translation to the matrix
+		m_worldMatrix.pos = m_translation;
+
+		// Apply the uniform local scale to the matrix
+		// TODO: Currently, the scale skews the rotation, we're figure it out and fix it later.
+		//		m_worldMatrix.m[0][0] = m_scale;
+		//		m_worldMatrix.m[1][1] = m_scale;
+		//		m_worldMatrix.m[2][2] = m_scale;
+	}
+
+	// Our children will notice the new revision and recalculate their own matrices
+	m_worldRevision++;
+	m_isDirty = false;
+
+	// Update the world bounds to follow the new world matrix
+	updateWorldBound();
+
+	return true;
+}
+
+//
+// updateWorldBound
+//
+void Visible::updateWorldBound()
+{
+	// Update the world bounds, which is basically the local bounds
+	// transformed by our world matrix
+	m_worldBound = m_localBound;
+	m_worldBound.transform( m_worldMatrix );
+
+	// The oriented box is only transformed if it's used for culling
+	if ( m_cullVolume == CULL_ORIENTED_BOX )
+	{
+		m_worldBox = m_localBox;
+		m_worldBox.transform( m_worldMatrix );
+	}
+
+	// If necessary, enlarge the radius of the world bounds to incorporate
+	// the light range. This is because the light will not affect the scene
+	// if this object is culled out.
+	if ( m_light && m_worldBound.getRadius() < m_light->getRange() )
+		m_worldBound.m_radius += m_light->getRange();
+
+	m_isBoundDirty = false;
+
+	// Move our entry in the spatial index along with the bounds
+	if ( m_spatialIndex )
+		m_spatialIndex->update( this );
+}
+
+//
+// updateWorldViewTransform
+//
+void Visible::updateWorldViewTransform( SceneContext * context )
+{
+	const Camera * pCamera = context->currentCamera;
+
+	// Only concatenate the view matrix if the camera or our world matrix has changed
+	if ( m_worldViewRevision == m_worldRevision && m_viewRevision == pCamera->getViewRevision() )
+		return;
+
+	// Transform the object from world space into view (camera) space
+	m_worldViewMatrix = m_worldMatrix;
+	m_worldViewMatrix *= pCamera->getWorldMatrix();
+
+	m_worldViewRevision = m_worldRevision;
+	m_viewRevision = pCamera->getViewRevision();
+
+	// If this Visible Object has a light associated with it,
+	// update it's position with our view space position
+	if ( m_light )
+		m_light->setPosition( m_worldViewMatrix.pos );
+}
+
 //
 // OnPostRender
 //
 bool Visible::OnPostRender(SceneContext * context)
 {
-	// Undirty ourselves. Note this is done AFTER OnPreRender(), otherwise,
-	// children Visible objects will not know to recalculate the WTM because
-	// their parent is dirty.
+	// Undirty ourselves. The world matrix was already updated during OnPreRender(),
+	// the children track our changes through the world revision.
 	m_isDirty = false;
 
 	return true;
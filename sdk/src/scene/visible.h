@@ -27,6 +27,8 @@ class kostream;
 struct Material;
 class Light;
 class Animation;
+class SpatialIndex;
+struct Geometry;
 
 ///
 /// Visible
@@ -40,6 +42,19 @@ class Visible
 	KDECLARE_STREAM(Visible)
 	KDECLARE_SCRIPT;
 
+	friend class SpatialIndex;
+
+public:
+	///
+	/// CullVolume
+	/// The bounding volume which is tested against the camera's frustum
+	///
+	enum CullVolume
+	{
+		CULL_SPHERE,			/// Only the bounding sphere is tested (default)
+		CULL_ORIENTED_BOX,		/// The oriented box is tested against the planes the sphere intersects
+	};
+
 public:
 	/// Constructor
 	Visible();
@@ -47,29 +62,40 @@ public:
 	/// Constructor which takes a parent
 	Visible( shared_ptr<VisNode> parent);
 
+	/// Destructor (unregisters the object from its spatial index)
+	virtual ~Visible();
+
 	/// Sets the parent
-	void setParent( shared_ptr<VisNode> parent )		{ m_parent = parent; }
+	void setParent( shared_ptr<VisNode> parent )		{ m_parent = parent; setDirty(); }
 
-	/// Sets whether the object is visible
-	void setVisible(bool bOn)							{ m_isVisible = bOn; }
+	/// Sets whether the object is visible. The subtree of a hidden node is
+	/// removed from the spatial index.
+	void setVisible(bool bOn);
 
-	/// Sets whether the object is dirty (update of the world matrix is necessary)
-	void setDirty()										{ m_isDirty = true; }
+	/// Sets whether the object is dirty (update of the world matrix is necessary).
+	/// The object's spatial index is told that it has moved.
+	void setDirty();
 
 	/// Sets the translation
-	void setTranslation(const Point3 & trans)			{ m_translation = trans; m_isDirty = true; }
+	void setTranslation(const Point3 & trans)			{ m_translation = trans; setDirty(); }
 
 	/// Sets the rotation
-	void setRotation(const Quaternion & rot)			{ m_rotation = rot; m_isDirty = true; }
+	void setRotation(const Quaternion & rot)			{ m_rotation = rot; setDirty(); }
 
 	/// Sets the transformation
 	void setTransform(const Point3 & trans, const Quaternion & rot);
 
 	/// Sets the scale
-	void setScale(float scale)							{ m_scale = scale; m_isDirty = true; }
+	void setScale(float scale)							{ m_scale = scale; setDirty(); }
 
 	/// Sets the local bounds
-	void setBound(const Bound & bv)						{ m_localBound = bv; }
+	void setBound(const Bound & bv)						{ m_localBound = bv; setBoundDirty(); }
+
+	/// Sets the local oriented box (only used by the CULL_ORIENTED_BOX cull volume)
+	void setOrientedBound(const OrientedBox & box)		{ m_localBox = box; setBoundDirty(); }
+
+	/// Sets which bounding volume is used for frustum culling
+	void setCullVolume(CullVolume volume)				{ m_cullVolume = volume; setBoundDirty(); }
 
 	/// Is this object visible?
 	bool isVisible() const								{ return m_isVisible; }
@@ -77,6 +103,9 @@ public:
 	/// Is the bounds dirty (used to recalculate the world matrix)
 	bool isDirty() const								{ return m_isDirty; }
 
+	/// Is this object a VisNode (which contains children)?
+	bool isNode() const									{ return m_isNode; }
+
 	/// Returns the parent
 	shared_ptr<VisNode> getParent()						{ return m_parent.lock(); }
 
@@ -89,15 +118,36 @@ public:
 	/// Returns the local scale
 	float getScale() const								{ return m_scale; }
 
-	/// Returns the world matrix
+	/// Returns the world view matrix (the world matrix concatenated with the camera's
+	/// view matrix). This is the matrix used to render the object.
 	const Matrix4 & getWorldMatrix() const				{ return m_worldViewMatrix; }
 
+	/// Returns the world matrix (without the camera's view matrix)
+	const Matrix4 & getWorldTransform() const			{ return m_worldMatrix; }
+
 	/// Returns the local bounds
 	const Bound & getLocalBound() const					{ return m_localBound; }
 
-	/// Returns the world bounds
+	/// Returns the world bounds (in world space, not view space)
 	const Bound & getWorldBound() const					{ return m_worldBound; }
 
+	/// Returns the spatial index the object is part of (or NULL)
+	SpatialIndex * getSpatialIndex() const				{ return m_spatialIndex; }
+
+	/// Returns the local oriented box
+	const OrientedBox & getLocalOrientedBound() const	{ return m_localBox; }
+
+	/// Returns the world oriented box (only updated for the CULL_ORIENTED_BOX cull volume)
+	const OrientedBox & getWorldOrientedBound() const	{ return m_worldBox; }
+
+	/// Returns which bounding volume is used for frustum culling
+	CullVolume getCullVolume() const					{ return m_cullVolume; }
+
+	/// Returns the frustum planes which intersect the world bounds (the planes
+	/// which the bounds are fully inside of are cleared). This is computed during
+	/// OnPreRender() and is passed to the children for hierarchical culling.
+	unsigned int getCullPlaneMask() const				{ return m_cullPlaneMask; }
+
 	/// Sets the material
 	void setMaterial( shared_ptr<Material> material )	{ m_material = material; }
 
@@ -125,6 +175,20 @@ public:
 	/// Gets whether the visible object is billboarded
 	bool getBillboard() const							{ return m_isBillboard; }
 
+	/// Sets whether this visible object hides the objects behind it, when the scene graph's
+	/// occlusion culling is enabled. Occluders are never occlusion culled themselves.
+	void setOccluder( bool enable )						{ m_isOccluder = enable; }
+
+	/// Gets whether this visible object is an occluder
+	bool getOccluder() const							{ return m_isOccluder; }
+
+	/// Sets a low polygon stand-in rasterized in place of the object when it's an occluder.
+	/// It must not extend beyond the object, or it would hide what the object doesn't.
+	void setOccluderGeometry( shared_ptr<Geometry> geometry )	{ m_occluderGeometry = geometry; }
+
+	/// Returns the geometry rasterized when the object is an occluder (in object space)
+	virtual shared_ptr<Geometry> getOccluderGeometry()	{ return m_occluderGeometry; }
+
 public:
 	/// This event is called when the visible object is initially attached to
 	/// the scene. Use this event to process one-time initialization, like
@@ -138,6 +202,13 @@ public:
 	/// This event is called when the visible object needs to update itself.
 	/// Usually, this involves transforming the bounds and coordinates from local
 	/// into world space. Note, this happens before the render.
+	///
+	/// When the scene graph's parallel update is enabled, this may be called on a worker
+	/// thread, concurrently with other objects. It may then only modify this object (and
+	/// its children, for a node), read the context and read other objects' states which
+	/// nobody modifies during the update, such as the camera and the rigid bodies. It must
+	/// not attach or detach nodes, or touch the renderer. An animation must not be shared
+	/// by several objects.
 	virtual bool OnUpdate(SceneContext * context);
 
 	/// This event is called before rendering but after updating.
@@ -160,6 +231,26 @@ public:
 	/// the only action this function needs to do is draw the shadow volume
 	virtual bool OnRenderShadow( SceneContext * context )						{ return true; }
 
+public:
+	/// Recalculates the world matrix and world bounds if this object or its parent
+	/// has moved since the last update. Returns true if the world matrix has changed.
+	/// The scene graph calls this to gather the world bounds before culling them in batches.
+	bool updateWorldTransform();
+
+protected:
+
+	/// Marks the world bounds as outdated, while the world matrix isn't.
+	/// The object's spatial index is told that it has moved.
+	void setBoundDirty();
+
+	/// Recalculates the world bounds from the local bounds and the world matrix,
+	/// and updates the object's entry in its spatial index
+	void updateWorldBound();
+
+	/// Concatenates the world matrix with the current camera's view matrix, if either
+	/// has changed since the last time this object was rendered.
+	void updateWorldViewTransform( SceneContext * context );
+
 protected:
 	/// Parential relationship
 	weak_ptr<VisNode>		m_parent;
@@ -171,6 +262,10 @@ protected:
 	/// (usually due to translation or rotation of the object).
 	bool					m_isDirty;
 
+	/// Flag which is set by VisNode, so the scene traversal can identify nodes
+	/// without a dynamic cast
+	bool					m_isNode;
+
 	/// Incremental frame count which is used so that the object isn't
 	/// rendered multiple times. This number is seeded by the Scene Graph.
 	int						m_frameCount;
@@ -190,10 +285,33 @@ protected:
 	float					m_scale;
 
 	/// Matrix which is calculated using local transform and parent relationships.
-	/// It is a concatenation of this modified local matrix, multiplied by the view matrix
-	/// (taken from the active camera)
+	/// It is only recalculated when this object or one of its ancestors moves.
+	Matrix4					m_worldMatrix;
+
+	/// The world matrix multiplied by the view matrix (taken from the active camera)
 	Matrix4					m_worldViewMatrix;
 
+	/// Incremented every time the world matrix is recalculated. Children compare this
+	/// against their cached copy to know when their parent has moved.
+	unsigned int			m_worldRevision;
+
+	/// The parent's world revision used to calculate our world matrix
+	unsigned int			m_parentRevision;
+
+	/// The world and camera revisions used to calculate the world view matrix
+	unsigned int			m_worldViewRevision;
+	unsigned int			m_viewRevision;
+
+	/// Flag used to determine whether the world bounds must be recalculated,
+	/// because the local bounds have changed
+	bool					m_isBoundDirty;
+
+	/// Frustum planes which intersect the world bounds, from the last culling test
+	unsigned int			m_cullPlaneMask;
+
+	/// Frustum plane which culled this object last time (tested first next time)
+	unsigned int			m_lastCullPlane;
+
 	/// Local Bounds of the Visible Object (used for culling).
 	Bound					m_localBound;
 
@@ -201,6 +319,14 @@ protected:
 	/// by the Visible Object's world transformations.
 	Bound					m_worldBound;
 
+	/// Which bounding volume is used for frustum culling
+	CullVolume				m_cullVolume;
+
+	/// Local and world oriented boxes of the Visible Object. The sphere is always
+	/// tested first, the box only refines the test when CULL_ORIENTED_BOX is used.
+	OrientedBox				m_localBox;
+	OrientedBox				m_worldBox;
+
 	/// Material which determines the material properties of this visible object
 	shared_ptr<Material>	m_material;
 
@@ -215,6 +341,16 @@ protected:
 
 	/// Determines whether the visible object is billboarded each frame
 	bool					m_isBillboard;
+
+	/// Does this visible object hide the objects behind it, and its optional stand-in geometry
+	bool					m_isOccluder;
+	shared_ptr<Geometry>	m_occluderGeometry;
+
+	/// Spatial index the object is part of, its entry in the index, and whether
+	/// the object is queued as moved in the index
+	SpatialIndex *			m_spatialIndex;
+	unsigned int			m_spatialEntry;
+	volatile long			m_spatialMoved;
 };
 
 KIMPLEMENT_STREAM( Visible );
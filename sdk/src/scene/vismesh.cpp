@@ -14,6 +14,7 @@
 #include "katana_base_includes.h"
 #include "visible.h"
 #include "vismesh.h"
+#include "camera.h"
 #include "scenecontext.h"
 #include "engine/debugoutput.h"
 #include "render/rendertypes.h"
@@ -102,6 +103,14 @@ void VisMesh::setGeometry( shared_ptr<Geometry> geometry )
 	m_meshDirty = true;
 }
 
+//
+// getOccluderGeometry
+//
+shared_ptr<Geometry> VisMesh::getOccluderGeometry()
+{
+	return m_occluderGeometry ? m_occluderGeometry : m_geometry;
+}
+
 //
 // OnAttach
 //
@@ -128,7 +137,17 @@ bool VisMesh::OnAttach(SceneContext * context)
 		{
 			// Check if we have bounding information for this visible mesh and generate it if necessary
 			if ( !m_localBound.isValid() )
+			{
 				Geometry::createSphere( m_geometry, m_localBound.m_center, m_localBound.m_radius );
+				setBoundDirty();
+			}
+
+			// Likewise for the oriented box, if it's used for culling
+			if ( m_cullVolume == CULL_ORIENTED_BOX && !m_localBox.isValid() )
+			{
+				Geometry::createOrientedBox( m_geometry, m_localBox );
+				setBoundDirty();
+			}
 
 			// If normal information is needed, and doesn't exist, create it
 			if ( ( ( m_geometry->m_enabledBuffers & NORMALS ) == NORMALS ) && 
@@ -242,11 +261,19 @@ bool VisMesh::OnPostRender(SceneContext * context)
 	// Check whether we have any active lights and a shadow volume
 	if ( context->currentLights.size() && m_shadowVolume )
 	{
-		// We only generate shadows for the primary light
-		shared_ptr<Light> primaryLight = context->currentLights[0];
-
-		// Has this light moved, if so, update the shadow volume
-		if ( primaryLight->getMoved() ) 
+		// We only generate shadows for the primary light, the most significant local light.
+		// The directional and ambient lights come first in the list, but cast no shadow volumes.
+		shared_ptr<Light> primaryLight;
+		for( unsigned int i = 0; i < context->currentLights.size() && !primaryLight; i++ )
+			if ( KIsDerivedFromClass<PointLight>( context->currentLights[i].get() ) )
+				primaryLight = context->currentLights[i];
+
+		// The lights are assigned per object every frame, so the primary light may change
+		// without moving. Update the shadow volume if it's another light, or if the light has moved.
+		const bool lightChanged = primaryLight != m_shadowLight.lock();
+		m_shadowLight = primaryLight;
+
+		if ( primaryLight && ( lightChanged || primaryLight->getMoved() ) )
 		{
 			// Determine the light direction in world space
 			Point3 lightDirectionInWorldSpace = primaryLight->getPosition() - m_worldViewMatrix.pos;
@@ -255,7 +282,8 @@ bool VisMesh::OnPostRender(SceneContext * context)
 			Point3 lightDirectionInObjectSpace = lightDirectionInWorldSpace * Matrix4( m_worldViewMatrix ).inverse().transpose();
 
 			// Update the shadow volume
-			m_shadowVolume->update( lightDirectionInObjectSpace );
+			if ( m_shadowVolume->update( lightDirectionInObjectSpace ) && context->statistics )
+				context->statistics->shadowVolumesRebuiltLastFrame++;
 		}
 	}
 
@@ -445,6 +473,9 @@ void VisMesh::Debug_DrawBounds( SceneContext * context )
 	// Check if the bounds are valid
 	if ( m_worldBound.isValid() )
 	{
+		// The world bounds are in world space, so only the camera's transform applies
+		context->currentRenderer->SetMatrix( MODELVIEW, STORE, context->currentCamera->getWorldMatrix() );
+
 		// Compute the dimensions of our circles
 		float radius = m_worldBound.getRadius();
 		Point3 position = m_worldBound.getCenter();
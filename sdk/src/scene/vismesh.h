@@ -63,6 +63,9 @@ public:
 	/// Replace the internal instance of the geometry with another object
 	void setGeometry( shared_ptr<Geometry> geometry );
 
+	/// Returns the occluder geometry, or the mesh's own geometry if none was set
+	virtual shared_ptr<Geometry> getOccluderGeometry();
+
 protected:
 
 	/// VisMesh will attempt to create the VB specific to the device when it
@@ -111,6 +114,9 @@ protected:
 	/// The shadow volume. This represents the renderable portion of the shadow.
 	shared_ptr<ShadowVolume>	m_shadowVolume;
 
+	/// The light the shadow volume was last built for
+	weak_ptr<Light>				m_shadowLight;
+
 	/// Flag which indicates whether the mesh is dirty, that is,
 	/// whether the mesh geometry must be uploaded to the VB again
 	bool m_meshDirty;
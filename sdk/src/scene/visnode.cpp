@@ -13,6 +13,7 @@
 #include "katana_base_includes.h"
 #include "visible.h"
 #include "visnode.h"
+#include "spatialindex.h"
 #include "camera.h"
 #include "scenecontext.h"
 #include "render/rendertypes.h"
@@ -30,6 +31,7 @@ KIMPLEMENT_RTTI( VisNode, Visible );
 //
 VisNode::VisNode()
 {
+	m_isNode = true;
 }
 
 //
@@ -54,6 +56,10 @@ bool VisNode::attachChild( shared_ptr<Visible> child )
 
 	/// Add it to our node array
 	m_children.push_back( child );
+
+	// If we're part of a spatial index, so is the child
+	if ( m_spatialIndex )
+		m_spatialIndex->insertChild( this, child.get() );
 	
 	return true;
 }
@@ -70,6 +76,10 @@ bool VisNode::detachChild( shared_ptr<Visible> child )
 	{
 		if ( child == (*iter) )
 		{
+			// The child leaves the spatial index along with its subtree
+			if ( child->getSpatialIndex() )
+				child->getSpatialIndex()->removeTree( child.get() );
+
 			// Destroy this object
 			child.reset();
 
@@ -96,6 +106,10 @@ void VisNode::detachAllChildren()
 
 	for( iter = m_children.begin(); iter != m_children.end(); iter++ )
 	{
+		// The child leaves the spatial index along with its subtree
+		if ( (*iter)->getSpatialIndex() )
+			(*iter)->getSpatialIndex()->removeTree( (*iter).get() );
+
 		// Destroy this object
 		(*iter).reset();
 	}
@@ -111,6 +125,10 @@ void VisNode::addState( shared_ptr<RenderState> state )
 {
 	// Add it to the vector of render states
 	m_renderstates.push_back( state );
+
+	// A plain node with render states is registered as a whole in the spatial index
+	if ( m_spatialIndex && m_renderstates.size() == 1 )
+		m_spatialIndex->insert( this );
 }
 
 //
@@ -133,6 +151,10 @@ bool VisNode::removeState( shared_ptr<RenderState> state )
 				std::remove( m_renderstates.begin(), m_renderstates.end(), (*iter) ),
 				m_renderstates.end() );
 
+			// Without render states, the node's children are registered instead
+			if ( m_spatialIndex && m_renderstates.empty() )
+				m_spatialIndex->insert( this );
+
 			// It was found
 			return true;
 		}
@@ -156,7 +178,12 @@ void VisNode::removeAllStates()
 	}
 
 	// Erase all states from the list
+	const bool hadStates = !m_renderstates.empty();
 	m_renderstates.clear();
+
+	// Without render states, the node's children are registered instead
+	if ( m_spatialIndex && hadStates )
+		m_spatialIndex->insert( this );
 }
 
 //
@@ -211,11 +238,21 @@ bool VisNode::OnRender(SceneContext * context)
 bool VisNode::OnPreRender(SceneContext * context)
 {
 	// Clear our local bounds first
-	m_localBound = Bound();
+	Bound localBound;
 
-	// Iterate through the children and expand our visible bounds based on the children
+	// Iterate through the children and expand our visible bounds based on the children.
+	// The children's bounds are offset by their translation, and enlarged so they'll
+	// contain the child regardless of its rotation. This way the children are always
+	// inside our bounds, which hierarchical culling relies on.
 	for( vector< shared_ptr<Visible> >::iterator iter = m_children.begin(); iter != m_children.end(); iter++ )
-		m_localBound.expand( (*iter)->getLocalBound() );
+	{
+		const Bound & childBound = (*iter)->getLocalBound();
+		localBound.expand( Bound( (*iter)->getTranslation(), childBound.getCenter().getLength() + childBound.getRadius() ) );
+	}
+
+	// Only flag the world bounds for an update if our children's bounds have changed
+	if ( localBound.getCenter() != m_localBound.getCenter() || localBound.getRadius() != m_localBound.getRadius() )
+		setBound( localBound );
 
 	// Call the base class to determine if this object is drawable
 	return Visible::OnPreRender( context );
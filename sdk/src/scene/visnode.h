@@ -66,6 +66,9 @@ public:
 	/// Removes all render states
 	void removeAllStates();
 
+	/// Returns whether render states are associated with this node
+	bool hasStates() const										{ return !m_renderstates.empty(); }
+
 public:
 	/// This event is specialized to iterate over the children and call the
 	/// appropiate OnAttach event.
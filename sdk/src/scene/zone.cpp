@@ -11,8 +11,10 @@
 	of triangles in model.
 */
 
+#include "katana_config.h"
 #include "katana_core_includes.h"
 #include "katana_base_includes.h"
+#include "base/profiler.h"
 #include "system/systemfile.h"
 #include "render/rendertypes.h"
 #include "render/render.h"
@@ -120,6 +122,8 @@ bool Zone::preRender( SceneContext * context )
 //
 bool Zone::render( SceneContext * context )
 {
+	KPROFILE( "Zone::render" );
+
 	// Render the vertex buffer if it's available
 	if ( m_vb )
 	{
@@ -136,8 +140,10 @@ bool Zone::render( SceneContext * context )
 		unsigned int uiTotalIndexCount = 0;
 
 		// Recursively check the nodes of the zone for visibility and add their indices
-		// to our destination index buffer for rendering
-		checkAndRenderNodes( context, ROOT_BSP_NODE, pSrcIndexData, pDestIndexData, uiTotalIndexCount );
+		// to our destination index buffer for rendering. The nodes only need to be tested
+		// against the planes which intersect our parent (the BSPScene).
+		checkAndRenderNodes( context, ROOT_BSP_NODE, pSrcIndexData, pDestIndexData, uiTotalIndexCount,
+							 context->currentVisibleObject->getCullPlaneMask() );
 
 		// Unlock our destination index buffer
 		m_ib->Unlock();
@@ -194,7 +200,7 @@ void Zone::debugRender( SceneContext * context )
 //
 void Zone::checkAndRenderNodes( SceneContext * context, unsigned int uiCurrentNodeIndex, 
 								unsigned short * pSrcIndexData, unsigned short * pDestIndexData, 
-								unsigned int & uiTotalIndexCount )
+								unsigned int & uiTotalIndexCount, unsigned int uiPlaneMask )
 {
 	// Retrieve this node by index
 	BSPNode & node = m_bspNodes[uiCurrentNodeIndex];
@@ -207,16 +213,18 @@ void Zone::checkAndRenderNodes( SceneContext * context, unsigned int uiCurrentNo
 	// system is based on it's position (for bounding purposes)
 	Visible * pBSPScene = context->currentVisibleObject;
 
-	// Our world view matrix is the BSPScene's world view matrix multiplied by the scene
-	Matrix4 worldViewMatrix = Matrix4( pBSPScene->getWorldMatrix() ) * camera.getWorldMatrix();
-
-	// Transform the node's bound to world coordinates
-	Bound nodeWorldBound = node.bound;
-	nodeWorldBound.transform( worldViewMatrix );
-
-	// Check whether this node is visible in the frustum. If not
-	// there isn't any need to iterate over the children
-	if ( context->debugOutput->getEnableFrustumCulling() && !camera.Cull( nodeWorldBound ) ) return;
+	// If our parent is fully inside the frustum, so are we (and there's nothing to test)
+	if ( context->debugOutput->getEnableFrustumCulling() && uiPlaneMask )
+	{
+		// Transform the node's bound to world coordinates. The camera culls in world space,
+		// so the view matrix isn't needed
+		Bound nodeWorldBound = node.bound;
+		nodeWorldBound.transform( pBSPScene->getWorldTransform() );
+
+		// Check whether this node is visible in the frustum. If not
+		// there isn't any need to iterate over the children
+		if ( !camera.Cull( nodeWorldBound, uiPlaneMask, node.cullPlane ) ) return;
+	}
 
 	// Is this node a leaf and does it have triangle faces? If so,
 	// add the faces to the destination index buffer
@@ -238,7 +246,7 @@ void Zone::checkAndRenderNodes( SceneContext * context, unsigned int uiCurrentNo
 	else
 	{
 		for( unsigned int uiChildIdx = 0; uiChildIdx < MAX_OCTANTS; uiChildIdx++ )
-			checkAndRenderNodes( context, node.children[uiChildIdx], pSrcIndexData, pDestIndexData, uiTotalIndexCount );
+			checkAndRenderNodes( context, node.children[uiChildIdx], pSrcIndexData, pDestIndexData, uiTotalIndexCount, uiPlaneMask );
 	}
 }
 
@@ -60,10 +60,11 @@ public:
 protected:
 
 	/// Recursively check all the nodes for visibility and add their indices
-	/// to our destination index buffer if so
+	/// to our destination index buffer if so. Only the frustum planes within
+	/// the plane mask are tested, the children of a fully visible node aren't tested.
 	void checkAndRenderNodes( SceneContext * context, unsigned int uiCurrentNodeIndex, 
 							  unsigned short * pSrcIndexData, unsigned short * pDestIndexData, 
-							  unsigned int & uiTotalIndexCount );
+							  unsigned int & uiTotalIndexCount, unsigned int uiPlaneMask );
 
 	/// Recursively renders boxes around the nodes (whether they are visible or not)
 	/// with different colors for node depths
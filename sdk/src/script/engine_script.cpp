@@ -26,6 +26,7 @@
 #include "scene/visnode.h"
 #include "scene/vismesh.h"
 #include "scene/scenecontext.h"
+#include "scene/renderqueue.h"
 #include "scene/scenegraph.h"
 #include "scene/controller.h"
 #include "scene/mousecontroller.h"
@@ -62,6 +63,8 @@ bool Controller::OnRegister( lua_State * env )
 	module( env )
 	[
 		class_< Controller, shared_ptr<Controller> >( "Controller" )
+			.def( "setThreadSafe",		&setThreadSafe )
+			.def( "isThreadSafe",		&isThreadSafe )
 	];
 
 	return true;
@@ -84,6 +87,8 @@ bool GameEngine::OnRegister( lua_State * env )
 			.def( "stepTime",			&stepTime )
 			.def( "getCurrentCamera",	&getCurentCamera )
 			.def( "getCurrentRender",	&getCurrentRender )
+			.def( "setPipelined",		&setPipelined )
+			.def( "getPipelined",		&getPipelined )
 		,
 
 		def( "getEngine", getEngine )
@@ -25,6 +25,7 @@
 #include "scene/visnode.h"
 #include "scene/vismesh.h"
 #include "scene/scenecontext.h"
+#include "scene/renderqueue.h"
 #include "scene/scenegraph.h"
 #include "scene/camera.h"
 
@@ -67,6 +68,22 @@ bool SceneGraph::OnRegister( lua_State * env )
 			.def_readonly( "totalTrianglesRendered",	&SceneStatistics::totalTrianglesRendered )
 			.def_readonly( "fps",						&SceneStatistics::framesPerSecond )
 			.def_readonly( "tps",						&SceneStatistics::trianglesPerSecond )
+			.def_readonly( "objectsCulled",				&SceneStatistics::objectsCulledLastFrame )
+			.def_readonly( "objectsOccluded",			&SceneStatistics::objectsOccludedLastFrame )
+			.def_readonly( "drawCalls",					&SceneStatistics::drawCallsLastFrame )
+			.def_readonly( "primitives",				&SceneStatistics::primitivesLastFrame )
+			.def_readonly( "vertices",					&SceneStatistics::verticesLastFrame )
+			.def_readonly( "bytesUploaded",				&SceneStatistics::bytesUploadedLastFrame )
+			.def_readonly( "stateChanges",				&SceneStatistics::stateChangesLastFrame )
+			.def_readonly( "textureBinds",				&SceneStatistics::textureBindsLastFrame )
+			.def_readonly( "terrainTriangles",			&SceneStatistics::terrainTrianglesLastFrame )
+			.def_readonly( "terrainPatches",			&SceneStatistics::terrainPatchesLastFrame )
+			.def_readonly( "shadowVolumesRebuilt",		&SceneStatistics::shadowVolumesRebuiltLastFrame )
+			.def_readonly( "frameMilliseconds",			&SceneStatistics::frameMilliseconds )
+			.def_readonly( "updateMilliseconds",		&SceneStatistics::updateMilliseconds )
+			.def_readonly( "cullMilliseconds",			&SceneStatistics::cullMilliseconds )
+			.def_readonly( "sortMilliseconds",			&SceneStatistics::sortMilliseconds )
+			.def_readonly( "renderMilliseconds",		&SceneStatistics::renderMilliseconds )
 			,
 			class_< SceneGraph, shared_ptr<SceneGraph> >( "SceneGraph" )
 			.def( "addNode",							&addNode, shared_ptr_policy( _1 ) )
@@ -77,7 +94,21 @@ bool SceneGraph::OnRegister( lua_State * env )
 			.def( "removeAllControllers",				&removeAllControllers )
 			.def( "getRoot",							&getRoot )
 			.def( "setDefaultShader",					&setDefaultShader, shared_ptr_policy( _1 ) )
+			.def( "setParallelUpdate",					&setParallelUpdate )
+			.def( "getParallelUpdate",					&getParallelUpdate )
+			.def( "startRecording",						&startRecording )
+			.def( "stopRecording",						&stopRecording )
+			.def( "isRecording",						&isRecording )
+			.def( "setCullingMode",						&setCullingMode )
+			.def( "getCullingMode",						&getCullingMode )
+			.def( "setOcclusionCulling",				&setOcclusionCulling )
+			.def( "getOcclusionCulling",				&getOcclusionCulling )
 			.property( "stats",							&SceneGraph::getStatistics )
+			.enum_("CullingMode")
+			[
+				value( "CULL_HIERARCHY", CULL_HIERARCHY ),
+				value( "CULL_SPATIAL_INDEX", CULL_SPATIAL_INDEX )
+			]
 			,
 
 			def( "getScene", getScene )
@@ -124,6 +155,17 @@ bool Visible::OnRegister( lua_State * env )
 			.def( "getCastsShadows",	&getCastsShadows )
 			.def( "setBillboard",		&setBillboard )
 			.def( "getBillboard",		&getBillboard )
+			.def( "setOccluder",		&setOccluder )
+			.def( "getOccluder",		&getOccluder )
+			.def( "setOccluderGeometry",	&setOccluderGeometry, shared_ptr_policy( _1 ) )
+			.def( "setCullVolume",		&setCullVolume )
+			.def( "getCullVolume",		&getCullVolume )
+			.def( "setOrientedBound",	&setOrientedBound )
+			.enum_( "CullVolume" )
+			[
+				value( "CULL_SPHERE", CULL_SPHERE ),
+				value( "CULL_ORIENTED_BOX", CULL_ORIENTED_BOX )
+			]
 		,
 		// TODO: This is temporary, we should find a way to upcast objects from lua
 		def( "castVisible", &castVisible ),
@@ -11,12 +11,14 @@
 #include <windows.h>
 #include <luabind/luabind.hpp>
 
+#include "katana_config.h"
 #include "katana_core_includes.h"
 #include "katana_base_includes.h"
 #include "scriptengine.h"
 #include "luahelper.h"
 #include "luaconsole.h"
 #include "base/log.h"
+#include "base/profiler.h"
 
 // Make sure client includes LUA libaries
 #ifdef _DEBUG
@@ -131,6 +133,8 @@ bool ScriptEngine::Terminate()
 //
 bool ScriptEngine::execBuffer( std::string buffer )
 {
+	KPROFILE( "ScriptEngine::execBuffer" );
+
 	// Execute the buffer
 	lua_dostring( GLOBAL_LUA_STATE, buffer.c_str() );
 
@@ -145,6 +149,8 @@ bool ScriptEngine::execFile( const char * file )
 	// Check for empty filename
 	if ( !file || !(*file) ) return false;
 
+	KPROFILE( "ScriptEngine::execFile" );
+
 	// Execute the level file
 	int nResult = lua_dofile( GLOBAL_LUA_STATE, file );
 	if ( nResult != 0 )
@@ -168,6 +174,8 @@ bool ScriptEngine::execFile( const char * file )
 //
 bool ScriptEngine::execFunction( const char * function, int numArgs, ... )
 {
+	KPROFILE( "ScriptEngine::execFunction" );
+
 	int args = 0;
 	int results = 0;
 
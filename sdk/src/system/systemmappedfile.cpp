@@ -0,0 +1,127 @@
+/*
+	Katana Engine
+	Copyright  2001-2004 Eric Bryant, Inc.
+
+	File:		systemmappedfile.cpp
+	Author:		Eric Bryant
+
+	A read-only file mapped into memory. This wraps the Win32 file mapping
+	and POSIX mmap APIs.
+*/
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "katana_core_includes.h"
+#include "systemmappedfile.h"
+
+//
+// Constructor
+//
+SystemMappedFile::SystemMappedFile() :
+	m_data( 0 ),
+	m_size( 0 ),
+	m_handle( 0 )
+{
+}
+
+SystemMappedFile::SystemMappedFile( const char * szFileName ) :
+	m_data( 0 ),
+	m_size( 0 ),
+	m_handle( 0 )
+{
+	openFile( szFileName );
+}
+
+//
+// Destructor
+//
+SystemMappedFile::~SystemMappedFile()
+{
+	closeFile();
+}
+
+//
+// openFile
+//
+bool SystemMappedFile::openFile( const char * szFileName )
+{
+	closeFile();
+
+#ifdef _WIN32
+	HANDLE file = CreateFile( szFileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if ( file == INVALID_HANDLE_VALUE )
+		return false;
+
+	const DWORD size = GetFileSize( file, NULL );
+	if ( size == INVALID_FILE_SIZE || size == 0 )
+	{
+		CloseHandle( file );
+		return false;
+	}
+
+	// The mapping keeps the file open, so its handle isn't needed anymore
+	HANDLE mapping = CreateFileMapping( file, NULL, PAGE_READONLY, 0, 0, NULL );
+	CloseHandle( file );
+	if ( !mapping )
+		return false;
+
+	const void * data = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+	if ( !data )
+	{
+		CloseHandle( mapping );
+		return false;
+	}
+
+	m_handle = mapping;
+#else
+	const int file = open( szFileName, O_RDONLY );
+	if ( file == -1 )
+		return false;
+
+	struct stat status;
+	if ( fstat( file, &status ) != 0 || status.st_size == 0 )
+	{
+		close( file );
+		return false;
+	}
+
+	// The mapping keeps the file open, so its descriptor isn't needed anymore
+	const off_t size = status.st_size;
+	void * data = mmap( 0, size, PROT_READ, MAP_PRIVATE, file, 0 );
+	close( file );
+	if ( data == MAP_FAILED )
+		return false;
+#endif
+
+	m_data = data;
+	m_size = (unsigned int)size;
+
+	return true;
+}
+
+//
+// closeFile
+//
+void SystemMappedFile::closeFile()
+{
+	if ( !m_data )
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile( m_data );
+	CloseHandle( m_handle );
+#else
+	munmap( const_cast<void *>( m_data ), m_size );
+#endif
+
+	m_data = 0;
+	m_size = 0;
+	m_handle = 0;
+}
@@ -0,0 +1,66 @@
+/*
+	Katana Engine
+	Copyright  2001-2004 Eric Bryant, Inc.
+
+	File:		systemmappedfile.h
+	Author:		Eric Bryant
+
+	A read-only file mapped into memory. This wraps the Win32 file mapping
+	and POSIX mmap APIs.
+*/
+
+#ifndef _SYSTEMMAPPEDFILE_H
+#define _SYSTEMMAPPEDFILE_H
+
+namespace Katana
+{
+
+///
+/// SystemMappedFile
+/// The contents of the file are read by the operating system as they're accessed, so only the
+/// parts of a large file which are used take memory. The data is valid until the file is closed.
+///
+class SystemMappedFile
+{
+public:
+	/// Constructor
+	SystemMappedFile();
+
+	/// Constructor which maps the specified file
+	SystemMappedFile( const char * szFileName );
+
+	/// Destructor automatically unmaps the file
+	~SystemMappedFile();
+
+	/// Maps an existing file, unmapping the previous one
+	bool openFile( const char * szFileName );
+
+	/// Unmaps the file
+	void closeFile();
+
+	/// Is the file mapped?
+	bool isValid() const							{ return m_data != 0; }
+
+	/// Returns the contents of the file
+	const void * getData() const					{ return m_data; }
+
+	/// Returns the size of the file, in bytes
+	unsigned int getSize() const					{ return m_size; }
+
+private:
+	/// Non-copyable
+	SystemMappedFile( const SystemMappedFile & );
+	SystemMappedFile & operator=( const SystemMappedFile & );
+
+private:
+	/// Address and size of the mapped contents
+	const void *	m_data;
+	unsigned int	m_size;
+
+	/// The operating system's file mapping (the HANDLE of the mapping object on Win32)
+	void *			m_handle;
+};
+
+}; // Katana
+
+#endif // _SYSTEMMAPPEDFILE_H
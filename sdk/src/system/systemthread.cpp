@@ -0,0 +1,386 @@
+/*
+	Katana Engine
+	Copyright  2001-2004 Eric Bryant, Inc.
+
+	File:		systemthread.cpp
+	Author:		Eric Bryant
+
+	Threads, synchronization objects and atomic operations. These wrap the
+	Win32 and POSIX thread APIs.
+*/
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#else
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <pthread.h>
+#include <semaphore.h>
+#include <sched.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+#include "katana_core_includes.h"
+#include "systemthread.h"
+
+namespace Katana
+{
+
+///
+/// SystemThreadEntry
+/// Platform entry point of the threads
+///
+struct SystemThreadEntry
+{
+#ifdef _WIN32
+	static unsigned __stdcall run( void * data )
+	{
+		SystemThread * thread = reinterpret_cast<SystemThread *>( data );
+		thread->m_function( thread->m_data );
+		return 0;
+	}
+#else
+	static void * run( void * data )
+	{
+		SystemThread * thread = reinterpret_cast<SystemThread *>( data );
+		thread->m_function( thread->m_data );
+		return 0;
+	}
+#endif
+};
+
+}; // Katana
+
+// ----------------------------------------------------
+// SystemMutex
+// ----------------------------------------------------
+
+//
+// Constructor
+//
+SystemMutex::SystemMutex()
+{
+#ifdef _WIN32
+	CRITICAL_SECTION * section = new CRITICAL_SECTION;
+	InitializeCriticalSection( section );
+	m_handle = section;
+#else
+	pthread_mutexattr_t attributes;
+	pthread_mutexattr_init( &attributes );
+	pthread_mutexattr_settype( &attributes, PTHREAD_MUTEX_RECURSIVE );
+
+	pthread_mutex_t * mutex = new pthread_mutex_t;
+	pthread_mutex_init( mutex, &attributes );
+	pthread_mutexattr_destroy( &attributes );
+	m_handle = mutex;
+#endif
+}
+
+//
+// Destructor
+//
+SystemMutex::~SystemMutex()
+{
+#ifdef _WIN32
+	CRITICAL_SECTION * section = reinterpret_cast<CRITICAL_SECTION *>( m_handle );
+	DeleteCriticalSection( section );
+	delete section;
+#else
+	pthread_mutex_t * mutex = reinterpret_cast<pthread_mutex_t *>( m_handle );
+	pthread_mutex_destroy( mutex );
+	delete mutex;
+#endif
+}
+
+//
+// lock
+//
+void SystemMutex::lock()
+{
+#ifdef _WIN32
+	EnterCriticalSection( reinterpret_cast<CRITICAL_SECTION *>( m_handle ) );
+#else
+	pthread_mutex_lock( reinterpret_cast<pthread_mutex_t *>( m_handle ) );
+#endif
+}
+
+//
+// tryLock
+//
+bool SystemMutex::tryLock()
+{
+#ifdef _WIN32
+	return TryEnterCriticalSection( reinterpret_cast<CRITICAL_SECTION *>( m_handle ) ) != 0;
+#else
+	return pthread_mutex_trylock( reinterpret_cast<pthread_mutex_t *>( m_handle ) ) == 0;
+#endif
+}
+
+//
+// unlock
+//
+void SystemMutex::unlock()
+{
+#ifdef _WIN32
+	LeaveCriticalSection( reinterpret_cast<CRITICAL_SECTION *>( m_handle ) );
+#else
+	pthread_mutex_unlock( reinterpret_cast<pthread_mutex_t *>( m_handle ) );
+#endif
+}
+
+// ----------------------------------------------------
+// SystemSemaphore
+// ----------------------------------------------------
+
+//
+// Constructor
+//
+SystemSemaphore::SystemSemaphore( unsigned int initialCount )
+{
+#ifdef _WIN32
+	m_handle = CreateSemaphore( NULL, initialCount, 0x7FFFFFFF, NULL );
+#else
+	sem_t * semaphore = new sem_t;
+	sem_init( semaphore, 0, initialCount );
+	m_handle = semaphore;
+#endif
+}
+
+//
+// Destructor
+//
+SystemSemaphore::~SystemSemaphore()
+{
+#ifdef _WIN32
+	CloseHandle( m_handle );
+#else
+	sem_t * semaphore = reinterpret_cast<sem_t *>( m_handle );
+	sem_destroy( semaphore );
+	delete semaphore;
+#endif
+}
+
+//
+// wait
+//
+void SystemSemaphore::wait()
+{
+#ifdef _WIN32
+	WaitForSingleObject( m_handle, INFINITE );
+#else
+	// Retry if the wait was interrupted by a signal
+	while( sem_wait( reinterpret_cast<sem_t *>( m_handle ) ) != 0 && errno == EINTR )
+		;
+#endif
+}
+
+//
+// signal
+//
+void SystemSemaphore::signal( unsigned int count )
+{
+	if ( !count ) return;
+
+#ifdef _WIN32
+	ReleaseSemaphore( m_handle, count, NULL );
+#else
+	for( unsigned int i = 0; i < count; i++ )
+		sem_post( reinterpret_cast<sem_t *>( m_handle ) );
+#endif
+}
+
+// ----------------------------------------------------
+// SystemThread
+// ----------------------------------------------------
+
+//
+// Constructor
+//
+SystemThread::SystemThread() :
+	m_handle( 0 ),
+	m_function( 0 ),
+	m_data( 0 )
+{
+}
+
+//
+// Destructor
+//
+SystemThread::~SystemThread()
+{
+	join();
+}
+
+//
+// start
+//
+bool SystemThread::start( ThreadFunction function, void * data )
+{
+	if ( m_handle || !function )
+		return false;
+
+	m_function = function;
+	m_data = data;
+
+#ifdef _WIN32
+	m_handle = (void *)_beginthreadex( NULL, 0, SystemThreadEntry::run, this, 0, NULL );
+	return m_handle != 0;
+#else
+	pthread_t * thread = new pthread_t;
+	if ( pthread_create( thread, NULL, SystemThreadEntry::run, this ) != 0 )
+	{
+		delete thread;
+		return false;
+	}
+
+	m_handle = thread;
+	return true;
+#endif
+}
+
+//
+// join
+//
+void SystemThread::join()
+{
+	if ( !m_handle )
+		return;
+
+#ifdef _WIN32
+	WaitForSingleObject( m_handle, INFINITE );
+	CloseHandle( m_handle );
+#else
+	pthread_t * thread = reinterpret_cast<pthread_t *>( m_handle );
+	pthread_join( *thread, NULL );
+	delete thread;
+#endif
+
+	m_handle = 0;
+}
+
+//
+// setAffinity
+//
+bool SystemThread::setAffinity( unsigned int processor )
+{
+	if ( !m_handle || processor >= getProcessorCount() )
+		return false;
+
+#ifdef _WIN32
+	if ( processor >= sizeof(DWORD_PTR) * 8 )
+		return false;
+
+	return SetThreadAffinityMask( m_handle, (DWORD_PTR)1 << processor ) != 0;
+#elif defined(__linux__)
+	cpu_set_t processors;
+	CPU_ZERO( &processors );
+	CPU_SET( processor, &processors );
+
+	return pthread_setaffinity_np( *reinterpret_cast<pthread_t *>( m_handle ), sizeof(processors), &processors ) == 0;
+#else
+	return false;
+#endif
+}
+
+//
+// getProcessorCount
+//
+unsigned int SystemThread::getProcessorCount()
+{
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo( &info );
+	return info.dwNumberOfProcessors ? info.dwNumberOfProcessors : 1;
+#else
+	long count = sysconf( _SC_NPROCESSORS_ONLN );
+	return count > 0 ? (unsigned int)count : 1;
+#endif
+}
+
+//
+// setCurrentAffinity
+//
+bool SystemThread::setCurrentAffinity( unsigned int processor )
+{
+	if ( processor >= getProcessorCount() )
+		return false;
+
+#ifdef _WIN32
+	if ( processor >= sizeof(DWORD_PTR) * 8 )
+		return false;
+
+	return SetThreadAffinityMask( GetCurrentThread(), (DWORD_PTR)1 << processor ) != 0;
+#elif defined(__linux__)
+	cpu_set_t processors;
+	CPU_ZERO( &processors );
+	CPU_SET( processor, &processors );
+
+	return pthread_setaffinity_np( pthread_self(), sizeof(processors), &processors ) == 0;
+#else
+	return false;
+#endif
+}
+
+//
+// yield
+//
+void SystemThread::yield()
+{
+#ifdef _WIN32
+	SwitchToThread();
+#else
+	sched_yield();
+#endif
+}
+
+//
+// Atomic operations
+//
+long SystemThread::atomicIncrement( volatile long * value )
+{
+#ifdef _WIN32
+	return InterlockedIncrement( value );
+#else
+	return __sync_add_and_fetch( value, 1 );
+#endif
+}
+
+long SystemThread::atomicDecrement( volatile long * value )
+{
+#ifdef _WIN32
+	return InterlockedDecrement( value );
+#else
+	return __sync_sub_and_fetch( value, 1 );
+#endif
+}
+
+long SystemThread::atomicAdd( volatile long * value, long amount )
+{
+#ifdef _WIN32
+	return InterlockedExchangeAdd( value, amount ) + amount;
+#else
+	return __sync_add_and_fetch( value, amount );
+#endif
+}
+
+long SystemThread::atomicExchange( volatile long * value, long exchange )
+{
+#ifdef _WIN32
+	return InterlockedExchange( value, exchange );
+#else
+	// The exchange is only an acquire barrier, so make it a full barrier like the others
+	__sync_synchronize();
+	return __sync_lock_test_and_set( value, exchange );
+#endif
+}
+
+long SystemThread::atomicCompareExchange( volatile long * value, long exchange, long comparand )
+{
+#ifdef _WIN32
+	return InterlockedCompareExchange( value, exchange, comparand );
+#else
+	return __sync_val_compare_and_swap( value, comparand, exchange );
+#endif
+}
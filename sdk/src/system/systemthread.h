@@ -0,0 +1,163 @@
+/*
+	Katana Engine
+	Copyright  2001-2004 Eric Bryant, Inc.
+
+	File:		systemthread.h
+	Author:		Eric Bryant
+
+	Threads, synchronization objects and atomic operations. These wrap the
+	Win32 and POSIX thread APIs.
+*/
+
+#ifndef _SYSTEMTHREAD_H
+#define _SYSTEMTHREAD_H
+
+namespace Katana
+{
+
+///
+/// SystemMutex
+/// Mutual exclusion lock. It may be locked recursively by the same thread.
+///
+class SystemMutex
+{
+public:
+	/// Constructor
+	SystemMutex();
+
+	/// Destructor
+	~SystemMutex();
+
+	/// Blocks until the mutex is acquired
+	void lock();
+
+	/// Tries to acquire the mutex without blocking. Returns true if it was acquired.
+	bool tryLock();
+
+	/// Releases the mutex
+	void unlock();
+
+private:
+	/// Non-copyable
+	SystemMutex( const SystemMutex & );
+	SystemMutex & operator=( const SystemMutex & );
+
+private:
+	/// The operating system's mutex (CRITICAL_SECTION or pthread_mutex_t)
+	void *	m_handle;
+};
+
+///
+/// SystemScopedLock
+/// Locks a mutex for the lifetime of the object
+///
+class SystemScopedLock
+{
+public:
+	SystemScopedLock( SystemMutex & mutex ) : m_mutex( mutex )		{ m_mutex.lock(); }
+	~SystemScopedLock()												{ m_mutex.unlock(); }
+
+private:
+	SystemScopedLock & operator=( const SystemScopedLock & );
+
+private:
+	SystemMutex &	m_mutex;
+};
+
+///
+/// SystemSemaphore
+/// Counting semaphore, used to put threads to sleep until there is work for them
+///
+class SystemSemaphore
+{
+public:
+	/// Constructor, which takes the initial count
+	SystemSemaphore( unsigned int initialCount = 0 );
+
+	/// Destructor
+	~SystemSemaphore();
+
+	/// Blocks until the count is positive, then decrements it
+	void wait();
+
+	/// Increments the count by the given amount, waking up as many waiting threads
+	void signal( unsigned int count = 1 );
+
+private:
+	/// Non-copyable
+	SystemSemaphore( const SystemSemaphore & );
+	SystemSemaphore & operator=( const SystemSemaphore & );
+
+private:
+	/// The operating system's semaphore (HANDLE or sem_t)
+	void *	m_handle;
+};
+
+///
+/// SystemThread
+/// An operating system thread
+///
+class SystemThread
+{
+public:
+	/// Thread entry point
+	typedef void (*ThreadFunction)( void * data );
+
+public:
+	/// Constructor
+	SystemThread();
+
+	/// Destructor (joins the thread if it's still running)
+	~SystemThread();
+
+	/// Starts the thread, which calls the function with the data
+	bool start( ThreadFunction function, void * data );
+
+	/// Waits until the thread has returned
+	void join();
+
+	/// Returns whether the thread has been started and not joined
+	bool isRunning() const											{ return m_handle != 0; }
+
+	/// Restricts the thread to run on a single processor. Returns false if the
+	/// operating system doesn't support it, or the processor doesn't exist.
+	bool setAffinity( unsigned int processor );
+
+public:
+	/// Returns the number of processors (logical cores) of the machine
+	static unsigned int getProcessorCount();
+
+	/// Restricts the calling thread to run on a single processor
+	static bool setCurrentAffinity( unsigned int processor );
+
+	/// Gives up the remainder of the calling thread's time slice
+	static void yield();
+
+	/// Atomic operations. They return the new value (except exchange and compareExchange,
+	/// which return the previous value), and act as full memory barriers.
+	static long atomicIncrement( volatile long * value );
+	static long atomicDecrement( volatile long * value );
+	static long atomicAdd( volatile long * value, long amount );
+	static long atomicExchange( volatile long * value, long exchange );
+	static long atomicCompareExchange( volatile long * value, long exchange, long comparand );
+
+private:
+	/// Non-copyable
+	SystemThread( const SystemThread & );
+	SystemThread & operator=( const SystemThread & );
+
+private:
+	/// The operating system's thread (HANDLE or pthread_t)
+	void *			m_handle;
+
+	/// Entry point and its data
+	ThreadFunction	m_function;
+	void *			m_data;
+
+	/// Allows the platform entry point to call the thread function
+	friend struct SystemThreadEntry;
+};
+
+}; // Katana
+
+#endif // _SYSTEMTHREAD_H
@@ -5,10 +5,15 @@
 	File:		systemtimer.cpp
 	Author:		Eric Bryant
 
-	High Resolution Timer
+	High Resolution Timer. It uses the performance counter on Windows,
+	and the monotonic clock (in nanoseconds) elsewhere.
 */
 
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <time.h>
+#endif
 #include "katana_core_includes.h"
 #include "systemtimer.h"
 
@@ -21,12 +26,8 @@ SystemTimer::SystemTimer(bool bStartWatch) :
     m_prevElapsedTicks ( 0 ),
     m_isRunning        ( false )   // set in Start()
 {
-    // Get the timer frequency (ticks per second)
-    LARGE_INTEGER qwTimerFreq;
-    QueryPerformanceFrequency( &qwTimerFreq );
-
-    // Store as period to avoid division in GetElapsed()
-    m_timerPeriod = 1.0f / (float)( qwTimerFreq.QuadPart );
+    // Store the period of the timer frequency to avoid division in GetElapsed()
+    m_timerPeriod = 1.0f / (float)( GetTicksPerSecond() );
 
     if( bStartWatch )
 	{
@@ -46,7 +47,7 @@ void SystemTimer::Start()
 //
 // StartZero
 //
-VOID SystemTimer::StartZero()
+void SystemTimer::StartZero()
 {
     m_prevElapsedTicks = 0;
     m_startTick = GetTicks();
@@ -96,7 +97,7 @@ bool SystemTimer::isRunning() const
 float SystemTimer::GetElapsedSeconds() const
 {
     // Start with any previous time
-    LONGLONG nTotalTicks( m_prevElapsedTicks );
+    kint64 nTotalTicks( m_prevElapsedTicks );
 
     // If the watch is running, add the time since the last start
     if( m_isRunning )
@@ -122,10 +123,37 @@ float SystemTimer::GetElapsedMilliseconds() const
 //
 // GetTicks
 //
-__int64 SystemTimer::GetTicks() const
+kint64 SystemTimer::GetTicks()
 {
+#ifdef _WIN32
     // Grab the current tick count
     LARGE_INTEGER qwCurrTicks;
     QueryPerformanceCounter( &qwCurrTicks );
     return( qwCurrTicks.QuadPart );
+#else
+    // The monotonic clock isn't affected by changes of the system time
+    struct timespec now;
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return( (kint64)now.tv_sec * 1000000000 + now.tv_nsec );
+#endif
+}
+
+//
+// GetTicksPerSecond
+//
+kint64 SystemTimer::GetTicksPerSecond()
+{
+#ifdef _WIN32
+    // The frequency is fixed while the system is running, so it's only queried once
+    static kint64 frequency = 0;
+    if ( !frequency )
+    {
+        LARGE_INTEGER qwTimerFreq;
+        QueryPerformanceFrequency( &qwTimerFreq );
+        frequency = qwTimerFreq.QuadPart;
+    }
+    return( frequency );
+#else
+    return( 1000000000 );
+#endif
 }
\ No newline at end of file
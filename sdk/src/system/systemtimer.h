@@ -5,7 +5,8 @@
 	File:		systemtimer.h
 	Author:		Eric Bryant
 
-	High Resolution Timer
+	High Resolution Timer. It uses the performance counter on Windows,
+	and the monotonic clock (in nanoseconds) elsewhere.
 */
 
 #ifndef _SYSTEMTIMER_H
@@ -44,21 +45,19 @@ public:
 	/// Elapses milliseconds since timer was reset
     float GetElapsedMilliseconds() const;
 
-private:
-
-#ifdef _WIN32
+public:
 	/// Get high-resolution timer
-    __int64 GetTicks() const;
-#endif
+    static kint64 GetTicks();
+
+	/// Returns the frequency of the high-resolution timer (ticks per second)
+    static kint64 GetTicksPerSecond();
 
 private:
     float	m_timerPeriod;        /// Seconds per tick (1/Hz)
     bool	m_isRunning;          /// True if watch is running
 
-#ifdef _WIN32
-    __int64	m_startTick;          /// Time watch last started/reset
-    __int64	m_prevElapsedTicks;   /// Time watch was previously running
-#endif
+    kint64	m_startTick;          /// Time watch last started/reset
+    kint64	m_prevElapsedTicks;   /// Time watch was previously running
 };
 
 } // Katana